@@ -0,0 +1,134 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "engine/CostFactorCalibration.h"
+#include "engine/Engine.h"
+#include "index/Index.h"
+
+using std::cerr;
+using std::cout;
+using std::endl;
+using std::string;
+
+#define EMPH_ON "\033[1m"
+#define EMPH_OFF "\033[22m"
+
+// Available options.
+struct option options[] = {{"help", no_argument, NULL, 'h'},
+                           {"index", required_argument, NULL, 'i'},
+                           {"on-disk-literals", no_argument, NULL, 'l'},
+                           {"output", required_argument, NULL, 'o'},
+                           {"repetitions", required_argument, NULL, 'r'},
+                           {"text", no_argument, NULL, 't'},
+                           {NULL, 0, NULL, 0}};
+
+void printUsage(char* execName) {
+  std::ios coutState(nullptr);
+  coutState.copyfmt(cout);
+  cout << std::setfill(' ') << std::left;
+
+  cout << "Usage: " << execName << " -i <index> [OPTIONS]" << endl << endl;
+  cout << "Options" << endl;
+  cout << "  " << std::setw(20) << "h, help" << std::setw(1) << "    "
+       << "Show this help and exit." << endl;
+  cout << "  " << std::setw(20) << "i, index" << std::setw(1) << "    "
+       << "The location of the index files." << endl;
+  cout << "  " << std::setw(20) << "l, on-disk-literals" << std::setw(1)
+       << "    "
+       << "Indicates that the literals can be found on disk with the index."
+       << endl;
+  cout << "  " << std::setw(20) << "o, output" << std::setw(1) << "    "
+       << "File to write the cost factors to, default: "
+       << "cost_factors.calibrated.tsv" << endl;
+  cout << "  " << std::setw(20) << "r, repetitions" << std::setw(1) << "    "
+       << "How often each operation is timed, default: 3" << endl;
+  cout << "  " << std::setw(20) << "t, text" << std::setw(1) << "    "
+       << "Also calibrate the text operations on the text index." << endl;
+  cout.copyfmt(coutState);
+}
+
+// Main function.
+int main(int argc, char** argv) {
+  string indexName = "";
+  string outputFileName = "cost_factors.calibrated.tsv";
+  size_t nofRepetitions = 3;
+  bool onDiskLiterals = false;
+  bool text = false;
+
+  optind = 1;
+  // Process command line arguments.
+  while (true) {
+    int c = getopt_long(argc, argv, "hi:lo:r:t", options, NULL);
+    if (c == -1) break;
+    switch (c) {
+      case 'h':
+        printUsage(argv[0]);
+        exit(0);
+        break;
+      case 'i':
+        indexName = optarg;
+        break;
+      case 'l':
+        onDiskLiterals = true;
+        break;
+      case 'o':
+        outputFileName = optarg;
+        break;
+      case 'r':
+        nofRepetitions = static_cast<size_t>(atol(optarg));
+        break;
+      case 't':
+        text = true;
+        break;
+      default:
+        cout << endl
+             << "! ERROR in processing options (getopt returned '" << c
+             << "' = 0x" << std::setbase(16) << c << ")" << endl
+             << endl;
+        printUsage(argv[0]);
+        exit(1);
+    }
+  }
+
+  if (indexName.size() == 0) {
+    cerr << "Missing required argument --index (-i)..." << endl;
+    printUsage(argv[0]);
+    exit(1);
+  }
+
+  std::cout << std::endl
+            << EMPH_ON << "CostFactorCalibrationMain, version " << __DATE__
+            << " " << __TIME__ << EMPH_OFF << std::endl
+            << std::endl;
+
+  try {
+    Engine engine;
+    Index index;
+    index.setOnDiskLiterals(onDiskLiterals);
+    index.createFromOnDiskIndex(indexName, false);
+    if (text) {
+      index.addTextFromOnDiskIndex();
+    }
+
+    QueryExecutionContext qec(index, engine);
+    CostFactorCalibration calibration(&qec, nofRepetitions);
+    calibration.run();
+    calibration.writeToFile(outputFileName);
+    cout << "Wrote the cost factors to " << outputFileName
+         << ", pass them to SparqlEngineMain with --cost-factors." << endl;
+  } catch (const std::exception& e) {
+    cout << string("Caught exceptions: ") + e.what() << std::endl;
+    return 1;
+  } catch (ad_semsearch::Exception& e) {
+    cout << e.getFullErrorMessage() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
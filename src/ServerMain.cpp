@@ -25,14 +25,21 @@ using std::vector;
 
 // Available options.
 struct option options[] = {{"all-permutations", no_argument, NULL, 'a'},
+                           {"cache-memory", required_argument, NULL, 'c'},
+                           {"cache-policy", required_argument, NULL, 'C'},
                            {"help", no_argument, NULL, 'h'},
                            {"index", required_argument, NULL, 'i'},
                            {"worker-threads", required_argument, NULL, 'j'},
                            {"on-disk-literals", no_argument, NULL, 'l'},
+                           {"memory-limit", required_argument, NULL, 'm'},
                            {"port", required_argument, NULL, 'p'},
                            {"patterns", no_argument, NULL, 'P'},
+                           {"timeout", required_argument, NULL, 's'},
+                           {"sort-memory", required_argument, NULL, 'S'},
+                           {"sort-directory", required_argument, NULL, 'T'},
                            {"text", no_argument, NULL, 't'},
                            {"unopt-optional", no_argument, NULL, 'u'},
+                           {"query-workers", required_argument, NULL, 'w'},
                            {NULL, 0, NULL, 0}};
 
 void printUsage(char* execName) {
@@ -46,6 +53,12 @@ void printUsage(char* execName) {
   cout << "  " << std::setw(20) << "a, all-permutations" << std::setw(1)
        << "    "
        << "Load all six permuations of the index instead of only two." << endl;
+  cout << "  " << std::setw(20) << "c, cache-memory" << std::setw(1) << "    "
+       << "Limit for the memory of all cached results in GB (default "
+       << DEFAULT_CACHE_MEMORY_IN_GB << ")." << endl;
+  cout << "  " << std::setw(20) << "C, cache-policy" << std::setw(1) << "    "
+       << "Which cached results to evict first: lru (default) or gdsf, "
+       << "which keeps results that were expensive to compute." << endl;
   cout << "  " << std::setw(20) << "h, help" << std::setw(1) << "    "
        << "Show this help and exit." << endl;
   cout << "  " << std::setw(20) << "i, index" << std::setw(1) << "    "
@@ -54,10 +67,23 @@ void printUsage(char* execName) {
        << "    "
        << "Indicates that the literals can be found on disk with the index."
        << endl;
+  cout << "  " << std::setw(20) << "m, memory-limit" << std::setw(1) << "    "
+       << "Limit for the memory of the results of a single query in GB "
+       << "(default " << DEFAULT_MEMORY_LIMIT_PER_QUERY_IN_GB << ")." << endl;
   cout << "  " << std::setw(20) << "p, port" << std::setw(1) << "    "
        << "The port on which to run the web interface." << endl;
   cout << "  " << std::setw(20) << "P, patterns" << std::setw(1) << "    "
        << "Use relation patterns for fast ql:has-relation queries." << endl;
+  cout << "  " << std::setw(20) << "s, timeout" << std::setw(1) << "    "
+       << "Time limit for a single query in seconds (default "
+       << DEFAULT_QUERY_TIMEOUT_IN_SECONDS << ")." << endl;
+  cout << "  " << std::setw(20) << "S, sort-memory" << std::setw(1) << "    "
+       << "Memory for sorting in GB, larger inputs are sorted on disk "
+       << "(default " << DEFAULT_SORT_MEMORY_IN_GB << ")." << endl;
+  cout << "  " << std::setw(20) << "T, sort-directory" << std::setw(1)
+       << "    "
+       << "Directory for the temporary files of sorts on disk (default "
+       << DEFAULT_SORT_DIRECTORY << ")." << endl;
   cout << "  " << std::setw(20) << "t, text" << std::setw(1) << "    "
        << "Enables the usage of text." << endl;
   cout << "  " << std::setw(20) << "j, worker-threads" << std::setw(1) << "    "
@@ -65,6 +91,10 @@ void printUsage(char* execName) {
   cout << "  " << std::setw(20) << "u, unopt-optional" << std::setw(1) << "    "
        << "Always place optional joins at the root of the query execution tree."
        << endl;
+  cout << "  " << std::setw(20) << "w, query-workers" << std::setw(1) << "    "
+       << "Number of threads shared by all queries to compute independent "
+       << "parts of a query (default: the hardware threads not used by the "
+       << "worker threads)." << endl;
   cout.copyfmt(coutState);
 }
 
@@ -87,11 +117,19 @@ int main(int argc, char** argv) {
   int port = -1;
   int numThreads = 1;
   bool usePatterns = false;
+  size_t memoryLimitInGB = DEFAULT_MEMORY_LIMIT_PER_QUERY_IN_GB;
+  double timeout = DEFAULT_QUERY_TIMEOUT_IN_SECONDS;
+  size_t sortMemoryInGB = DEFAULT_SORT_MEMORY_IN_GB;
+  string sortDirectory = DEFAULT_SORT_DIRECTORY;
+  size_t cacheMemoryInGB = DEFAULT_CACHE_MEMORY_IN_GB;
+  string cachePolicy = "lru";
+  int queryWorkers = -1;
 
   optind = 1;
   // Process command line arguments.
   while (true) {
-    int c = getopt_long(argc, argv, "i:p:j:tlauhPm", options, NULL);
+    int c = getopt_long(argc, argv, "i:p:j:tlauhPm:s:S:T:c:C:w:", options,
+                        NULL);
     if (c == -1) break;
     switch (c) {
       case 'i':
@@ -118,6 +156,27 @@ int main(int argc, char** argv) {
       case 'u':
         optimizeOptionals = false;
         break;
+      case 'm':
+        memoryLimitInGB = static_cast<size_t>(atol(optarg));
+        break;
+      case 's':
+        timeout = atof(optarg);
+        break;
+      case 'S':
+        sortMemoryInGB = static_cast<size_t>(atol(optarg));
+        break;
+      case 'T':
+        sortDirectory = optarg;
+        break;
+      case 'c':
+        cacheMemoryInGB = static_cast<size_t>(atol(optarg));
+        break;
+      case 'C':
+        cachePolicy = optarg;
+        break;
+      case 'w':
+        queryWorkers = atoi(optarg);
+        break;
       case 'h':
         printUsage(argv[0]);
         exit(0);
@@ -151,7 +210,14 @@ int main(int argc, char** argv) {
   cout << "Set locale LC_CTYPE to: " << locale << endl;
 
   try {
-    Server server(port, numThreads);
+    Server server(port, numThreads, memoryLimitInGB << 30, timeout);
+    server.setSortOptions(sortMemoryInGB << 30, sortDirectory);
+    server.setCacheMemory(cacheMemoryInGB << 30);
+    server.setCacheEvictionPolicy(
+        ad_utility::evictionPolicyFromString(cachePolicy));
+    if (queryWorkers >= 0) {
+      server.setNofQueryWorkers(queryWorkers);
+    }
     server.initialize(index, text, allPermutations, onDiskLiterals,
                       optimizeOptionals, usePatterns);
     server.run();
@@ -25,6 +25,7 @@ using std::string;
 
 // Available options.
 struct option options[] = {{"all-permutations", no_argument, NULL, 'a'},
+                           {"analyze", no_argument, NULL, 'A'},
                            {"cost-factors", required_argument, NULL, 'c'},
                            {"help", no_argument, NULL, 'h'},
                            {"index", required_argument, NULL, 'i'},
@@ -34,10 +35,11 @@ struct option options[] = {{"all-permutations", no_argument, NULL, 'a'},
                            {"queryfile", required_argument, NULL, 'q'},
                            {"text", no_argument, NULL, 't'},
                            {"unopt-optional", no_argument, NULL, 'u'},
+                           {"workers", required_argument, NULL, 'w'},
                            {NULL, 0, NULL, 0}};
 
 void processQuery(QueryExecutionContext& qec, const string& query,
-                  bool optimizeOptionals);
+                  bool optimizeOptionals, bool analyze);
 void printUsage(char* execName);
 
 void printUsage(char* execName) {
@@ -50,6 +52,8 @@ void printUsage(char* execName) {
   cout << "  " << std::setw(20) << "a, all-permutations" << std::setw(1)
        << "    "
        << "Load all six permuations of the index instead of only two." << endl;
+  cout << "  " << std::setw(20) << "A, analyze" << std::setw(1) << "    "
+       << "Print the runtime information of all operations as JSON." << endl;
   cout << "  " << std::setw(20) << "c, cost-factors" << std::setw(1) << "    "
        << "Path to a file containing cost factors." << endl;
   cout << "  " << std::setw(20) << "h, help" << std::setw(1) << "    "
@@ -70,6 +74,9 @@ void printUsage(char* execName) {
        << "Enables the usage of text." << endl;
   cout << "  " << std::setw(20) << "u, unopt-optional" << std::setw(1) << "    "
        << "Always execute optional joins last." << endl;
+  cout << "  " << std::setw(20) << "w, workers" << std::setw(1) << "    "
+       << "Number of additional threads that compute independent parts of a "
+       << "query (default: one per hardware thread)." << endl;
   cout.copyfmt(coutState);
 }
 
@@ -92,11 +99,13 @@ int main(int argc, char** argv) {
   bool allPermutations = false;
   bool optimizeOptionals = true;
   bool usePatterns = false;
+  bool analyze = false;
+  int nofWorkers = -1;
 
   optind = 1;
   // Process command line arguments.
   while (true) {
-    int c = getopt_long(argc, argv, "q:Ii:tc:lahuP", options, NULL);
+    int c = getopt_long(argc, argv, "q:Ii:tc:laAhuPw:", options, NULL);
     if (c == -1) break;
     switch (c) {
       case 'q':
@@ -120,6 +129,9 @@ int main(int argc, char** argv) {
       case 'a':
         allPermutations = true;
         break;
+      case 'A':
+        analyze = true;
+        break;
       case 'h':
         printUsage(argv[0]);
         exit(0);
@@ -130,6 +142,9 @@ int main(int argc, char** argv) {
       case 'P':
         usePatterns = true;
         break;
+      case 'w':
+        nofWorkers = atoi(optarg);
+        break;
       default:
         cout << endl
              << "! ERROR in processing options (getopt returned '" << c
@@ -163,6 +178,9 @@ int main(int argc, char** argv) {
     }
 
     QueryExecutionContext qec(index, engine);
+    if (nofWorkers >= 0) {
+      qec.setNofWorkers(static_cast<size_t>(nofWorkers));
+    }
     if (costFactosFileName.size() > 0) {
       qec.readCostFactorsFromTSVFile(costFactosFileName);
     }
@@ -188,13 +206,13 @@ int main(int argc, char** argv) {
         if (os.str() == "") {
           return 0;
         }
-        processQuery(qec, os.str(), optimizeOptionals);
+        processQuery(qec, os.str(), optimizeOptionals, analyze);
       }
     } else {
       std::ifstream qf(queryfile);
       string line;
       while (std::getline(qf, line)) {
-        processQuery(qec, line, optimizeOptionals);
+        processQuery(qec, line, optimizeOptionals, analyze);
       }
     }
   } catch (const std::exception& e) {
@@ -208,7 +226,7 @@ int main(int argc, char** argv) {
 }
 
 void processQuery(QueryExecutionContext& qec, const string& query,
-                  bool optimizeOptionals) {
+                  bool optimizeOptionals, bool analyze) {
   ad_utility::Timer t;
   t.start();
   SparqlParser sp;
@@ -219,7 +237,8 @@ void processQuery(QueryExecutionContext& qec, const string& query,
   timer.start();
   auto qet = qp.createExecutionTree(pq);
   timer.stop();
-  LOG(INFO) << "Time to create Execution Tree: " << timer.msecs() << "ms\n";
+  LOG(INFO) << "Time to create Execution Tree: " << timer.msecs() << "ms ("
+            << qp.getPlanningAlgorithmName() << ")\n";
   LOG(INFO) << "Execution Tree: " << qet.asString() << "ms\n";
   size_t limit = MAX_NOF_ROWS_IN_RESULT;
   size_t offset = 0;
@@ -229,13 +248,24 @@ void processQuery(QueryExecutionContext& qec, const string& query,
   if (pq._offset.size() > 0) {
     offset = static_cast<size_t>(atol(pq._offset.c_str()));
   }
-  qet.writeResultToStream(cout, pq._selectedVariables, limit, offset);
+  // A limited result may only have been computed up to offset + limit rows,
+  // then the number of all matches is not known.
+  size_t numMatches =
+      qet.writeResultToStream(cout, pq._selectedVariables, limit, offset);
   t.stop();
   std::cout << "\nDone. Time: " << t.usecs() / 1000.0 << " ms\n";
-  size_t numMatches = qet.getResult()->size();
-  std::cout << "\nNumber of matches (no limit): " << numMatches << "\n";
-  size_t effectiveLimit =
-      atoi(pq._limit.c_str()) > 0 ? atoi(pq._limit.c_str()) : numMatches;
-  std::cout << "\nNumber of matches (limit): "
-            << std::min(numMatches, effectiveLimit) << "\n";
+  std::cout << "\nNumber of matches (no limit): ";
+  if (limit < MAX_NOF_ROWS_IN_RESULT &&
+      offset + limit < MAX_NOF_ROWS_IN_RESULT && numMatches >= offset + limit) {
+    std::cout << "at least ";
+  }
+  std::cout << numMatches << "\n";
+  size_t nofWritten = numMatches > offset ? numMatches - offset : 0;
+  std::cout << "\nNumber of matches (limit): " << std::min(nofWritten, limit)
+            << "\n";
+  if (analyze) {
+    std::cout << "\nRuntime information:\n";
+    qet.getRuntimeInfo().writeJson(std::cout);
+    std::cout << "\n";
+  }
 }
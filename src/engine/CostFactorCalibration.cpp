@@ -0,0 +1,367 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include "./CostFactorCalibration.h"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include "../util/Exception.h"
+#include "../util/Log.h"
+#include "../util/Timer.h"
+#include "./Filter.h"
+#include "./IndexScan.h"
+#include "./Join.h"
+#include "./Sort.h"
+#include "./TextOperationWithFilter.h"
+
+namespace {
+// Sizes of the predicates on which the operations are measured.
+const vector<size_t> TARGET_SIZES = {1000, 10000, 100000, 1000000, 10000000};
+// Number of subjects for which a scan with bound subject is timed.
+const size_t NOF_RANDOM_ACCESSES = 100;
+// The join of two predicates is skipped if its result would be larger than
+// this factor times the size of its inputs.
+const size_t MAX_JOIN_GROWTH = 10;
+// Number of words of the text vocabulary among which the calibration words
+// are chosen.
+const size_t NOF_CANDIDATE_WORDS = 1000;
+}  // namespace
+
+// _____________________________________________________________________________
+CostFactorCalibration::CostFactorCalibration(QueryExecutionContext* qec,
+                                             size_t nofRepetitions)
+    : _qec(qec), _nofRepetitions(std::max<size_t>(1, nofRepetitions)) {}
+
+// _____________________________________________________________________________
+void CostFactorCalibration::run() {
+  vector<string> predicates = choosePredicates(
+      _qec->getIndex().getPredicateSizes(), TARGET_SIZES);
+  if (predicates.empty()) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "The index does not contain any triples to calibrate with.");
+  }
+  for (const string& predicate : predicates) {
+    LOG(INFO) << "Measuring the operations on predicate " << predicate
+              << std::endl;
+    measurePredicate(predicate);
+    _qec->clearCache();
+  }
+  for (size_t i = 0; i < predicates.size(); ++i) {
+    for (size_t j = i + 1; j < predicates.size(); ++j) {
+      measureJoin(predicates[i], predicates[j]);
+      _qec->clearCache();
+    }
+  }
+  vector<string> words = choosePredicates(getWordSizes(), TARGET_SIZES);
+  for (const string& predicate : predicates) {
+    if (words.empty()) {
+      break;
+    }
+    LOG(INFO) << "Measuring the text operations filtered by predicate "
+              << predicate << std::endl;
+    std::shared_ptr<QueryExecutionTree> scan = makeScan(predicate, "");
+    scan->getResult();
+    for (const string& word : words) {
+      measureTextOperation(word, scan);
+    }
+    _qec->clearCache();
+  }
+  computeCostFactors();
+}
+
+// _____________________________________________________________________________
+void CostFactorCalibration::writeToFile(const string& fileName) const {
+  std::ofstream out(fileName.c_str());
+  if (!out) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "Could not open " + fileName + " for writing.");
+  }
+  for (const auto& factor : _costFactors) {
+    out << factor.first << '\t' << factor.second << '\n';
+  }
+}
+
+// _____________________________________________________________________________
+double CostFactorCalibration::fitCoefficient(
+    const vector<Measurement>& measurements) {
+  double workTimesSeconds = 0;
+  double workSquared = 0;
+  for (const Measurement& m : measurements) {
+    workTimesSeconds += m._work * m._seconds;
+    workSquared += m._work * m._work;
+  }
+  if (workSquared == 0) {
+    return 0;
+  }
+  return workTimesSeconds / workSquared;
+}
+
+// _____________________________________________________________________________
+pair<double, double> CostFactorCalibration::fitCoefficients(
+    const vector<TwoTermMeasurement>& measurements) {
+  // Solves the normal equations of the fit.
+  double w11 = 0;
+  double w12 = 0;
+  double w22 = 0;
+  double w1s = 0;
+  double w2s = 0;
+  for (const TwoTermMeasurement& m : measurements) {
+    w11 += m._work1 * m._work1;
+    w12 += m._work1 * m._work2;
+    w22 += m._work2 * m._work2;
+    w1s += m._work1 * m._seconds;
+    w2s += m._work2 * m._seconds;
+  }
+  double determinant = w11 * w22 - w12 * w12;
+  if (determinant <= 1e-9 * w11 * w22) {
+    return pair<double, double>(0, 0);
+  }
+  return pair<double, double>((w1s * w22 - w2s * w12) / determinant,
+                              (w2s * w11 - w1s * w12) / determinant);
+}
+
+// _____________________________________________________________________________
+vector<string> CostFactorCalibration::choosePredicates(
+    const vector<pair<string, size_t>>& predicateSizes,
+    const vector<size_t>& targetSizes) {
+  vector<string> chosen;
+  vector<bool> used(predicateSizes.size(), false);
+  for (size_t target : targetSizes) {
+    // Sizes are compared on a logarithmic scale.
+    size_t best = predicateSizes.size();
+    double bestDistance = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < predicateSizes.size(); ++i) {
+      if (used[i] || predicateSizes[i].second == 0) {
+        continue;
+      }
+      double distance = std::fabs(std::log(double(predicateSizes[i].second)) -
+                                  std::log(double(target)));
+      if (distance < bestDistance) {
+        best = i;
+        bestDistance = distance;
+      }
+    }
+    if (best < predicateSizes.size()) {
+      used[best] = true;
+      chosen.push_back(predicateSizes[best].first);
+    }
+  }
+  return chosen;
+}
+
+// _____________________________________________________________________________
+void CostFactorCalibration::measurePredicate(const string& predicate) {
+  std::shared_ptr<QueryExecutionTree> scan = makeScan(predicate, "");
+  size_t n = 0;
+  double seconds = time(scan, &n);
+  _scans.emplace_back(n, seconds);
+  if (n == 0) {
+    return;
+  }
+
+  auto sort = std::make_shared<QueryExecutionTree>(_qec);
+  sort->setOperation(QueryExecutionTree::SORT,
+                     std::make_shared<Sort>(_qec, scan, 1));
+  size_t resultSize = 0;
+  seconds = time(sort, &resultSize);
+  double levels = std::max(2.0, std::log2(double(n)));
+  _sorts.emplace_back(n * levels, seconds);
+
+  auto filter = std::make_shared<QueryExecutionTree>(_qec);
+  filter->setOperation(
+      QueryExecutionTree::FILTER,
+      std::make_shared<Filter>(_qec, scan, SparqlFilter::NE, 0, 1));
+  seconds = time(filter, &resultSize);
+  _filters.emplace_back(n + resultSize, seconds);
+
+  // The scan is sorted by subject, which gives the subjects for the scans
+  // with bound subject.
+  shared_ptr<const ResultTable> rows = scan->getResult();
+  const auto& data =
+      *static_cast<vector<array<Id, 2>>*>(rows->_fixedSizeData);
+  vector<Id> subjects;
+  size_t step = std::max<size_t>(1, n / NOF_RANDOM_ACCESSES);
+  for (size_t i = 0; i < data.size();) {
+    size_t j = i;
+    while (j < data.size() && data[j][0] == data[i][0]) {
+      ++j;
+    }
+    if (subjects.size() < NOF_RANDOM_ACCESSES &&
+        i / step >= subjects.size()) {
+      subjects.push_back(data[i][0]);
+    }
+    i = j;
+  }
+
+  for (Id subject : subjects) {
+    auto boundScan =
+        makeScan(predicate, _qec->getIndex().idToString(subject));
+    seconds = time(boundScan, &resultSize);
+    _randomAccesses.emplace_back(resultSize, seconds);
+  }
+}
+
+// _____________________________________________________________________________
+void CostFactorCalibration::measureJoin(const string& predicate1,
+                                        const string& predicate2) {
+  std::shared_ptr<QueryExecutionTree> scan1 = makeScan(predicate1, "");
+  std::shared_ptr<QueryExecutionTree> scan2 = makeScan(predicate2, "");
+  // Both scans are sorted by subject, which gives the size of their join.
+  shared_ptr<const ResultTable> rows1 = scan1->getResult();
+  shared_ptr<const ResultTable> rows2 = scan2->getResult();
+  const auto& data1 =
+      *static_cast<vector<array<Id, 2>>*>(rows1->_fixedSizeData);
+  const auto& data2 =
+      *static_cast<vector<array<Id, 2>>*>(rows2->_fixedSizeData);
+  size_t joinSize = 0;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < data1.size() && j < data2.size()) {
+    if (data1[i][0] < data2[j][0]) {
+      ++i;
+    } else if (data2[j][0] < data1[i][0]) {
+      ++j;
+    } else {
+      Id subject = data1[i][0];
+      size_t n1 = 0;
+      size_t n2 = 0;
+      for (; i < data1.size() && data1[i][0] == subject; ++i) {
+        ++n1;
+      }
+      for (; j < data2.size() && data2[j][0] == subject; ++j) {
+        ++n2;
+      }
+      joinSize += n1 * n2;
+    }
+  }
+
+  size_t n = data1.size() + data2.size();
+  if (joinSize == 0 || joinSize > MAX_JOIN_GROWTH * n) {
+    LOG(INFO) << "Skipping the join of " << predicate1 << " and "
+              << predicate2 << ", its result would have " << joinSize
+              << " rows." << std::endl;
+    return;
+  }
+  // Restricting a scan to the join keys would read it while timing instead
+  // of taking it from the cache, and galloping is not what the factor models.
+  auto joinOperation = std::make_shared<Join>(_qec, scan1, scan2, 0, 0);
+  joinOperation->setMergeOnly(true);
+  auto join = std::make_shared<QueryExecutionTree>(_qec);
+  join->setOperation(QueryExecutionTree::JOIN, joinOperation);
+  size_t resultSize = 0;
+  double seconds = time(join, &resultSize);
+  _joins.emplace_back(n + resultSize, seconds);
+}
+
+// _____________________________________________________________________________
+void CostFactorCalibration::measureTextOperation(
+    const string& word, const std::shared_ptr<QueryExecutionTree>& scan) {
+  auto text = std::make_shared<QueryExecutionTree>(_qec);
+  text->setOperation(
+      QueryExecutionTree::TEXT_WITH_FILTER,
+      std::make_shared<TextOperationWithFilter>(_qec, word, 1, scan, 0));
+  size_t resultSize = 0;
+  double seconds = time(text, &resultSize);
+  _textOperations.emplace_back(resultSize, scan->getResult()->size(),
+                               seconds);
+}
+
+// _____________________________________________________________________________
+vector<pair<string, size_t>> CostFactorCalibration::getWordSizes() const {
+  const Index& index = _qec->getIndex();
+  size_t nofWords = index.getTextVocab().size();
+  vector<pair<string, size_t>> sizes;
+  size_t step = std::max<size_t>(1, nofWords / NOF_CANDIDATE_WORDS);
+  for (size_t i = 0; i < nofWords; i += step) {
+    const string& word = index.getTextVocab()[i];
+    sizes.emplace_back(word, index.getSizeEstimate(word));
+  }
+  return sizes;
+}
+
+// _____________________________________________________________________________
+double CostFactorCalibration::time(
+    const std::shared_ptr<QueryExecutionTree>& tree, size_t* resultSize) {
+  double fastest = std::numeric_limits<double>::max();
+  for (size_t i = 0; i < _nofRepetitions; ++i) {
+    _qec->getQueryTreeCache().erase(tree->asString());
+    ad_utility::Timer timer;
+    timer.start();
+    shared_ptr<const ResultTable> result = tree->getResult();
+    timer.stop();
+    fastest = std::min(fastest, timer.usecs() / 1000000.0);
+    *resultSize = result->size();
+  }
+  return fastest;
+}
+
+// _____________________________________________________________________________
+std::shared_ptr<QueryExecutionTree> CostFactorCalibration::makeScan(
+    const string& predicate, const string& subject) {
+  auto scan = std::make_shared<IndexScan>(
+      _qec, subject.empty() ? IndexScan::PSO_FREE_S : IndexScan::PSO_BOUND_S);
+  scan->setPredicate(predicate);
+  auto tree = std::make_shared<QueryExecutionTree>(_qec);
+  tree->setOperation(QueryExecutionTree::SCAN, scan);
+  if (subject.empty()) {
+    tree->setVariableColumn("?s", 0);
+    tree->setVariableColumn("?o", 1);
+  } else {
+    scan->setSubject(subject);
+    tree->setVariableColumn("?o", 0);
+  }
+  return tree;
+}
+
+// _____________________________________________________________________________
+void CostFactorCalibration::computeCostFactors() {
+  _costFactors.clear();
+  double secondsPerRow = fitCoefficient(_scans);
+  if (secondsPerRow <= 0) {
+    AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+             "The scans were too fast to be measured, "
+             "use a larger index for the calibration.");
+  }
+  LOG(INFO) << "Scanning one row takes " << secondsPerRow * 1e9 << " ns"
+            << std::endl;
+  if (!_joins.empty()) {
+    _costFactors["JOIN_COST_PER_ROW"] =
+        fitCoefficient(_joins) / secondsPerRow;
+  }
+  if (!_sorts.empty()) {
+    _costFactors["SORT_COST_PER_ROW_AND_LEVEL"] =
+        fitCoefficient(_sorts) / secondsPerRow;
+  }
+  if (!_filters.empty()) {
+    _costFactors["FILTER_COST_PER_ROW"] =
+        fitCoefficient(_filters) / secondsPerRow;
+  }
+  if (!_randomAccesses.empty()) {
+    // What a scan with bound subject takes beyond reading its rows.
+    double overhead = 0;
+    for (const Measurement& m : _randomAccesses) {
+      overhead += m._seconds - m._work * secondsPerRow;
+    }
+    overhead /= _randomAccesses.size();
+    _costFactors["DISK_RANDOM_ACCESS_COST"] =
+        std::max(0.0, overhead / secondsPerRow);
+  }
+  if (!_textOperations.empty()) {
+    // The cost estimate of a text operation with a filter is FILTER_PUNISH
+    // times the result rows plus HASH_MAP_OPERATION_COST times the filter
+    // rows.
+    pair<double, double> c = fitCoefficients(_textOperations);
+    if (c.first > 0 && c.second > 0) {
+      _costFactors["FILTER_PUNISH"] = c.first / secondsPerRow;
+      _costFactors["HASH_MAP_OPERATION_COST"] = c.second / c.first;
+    } else {
+      LOG(WARN) << "Could not fit the cost of the text operations, "
+                << "keeping FILTER_PUNISH and HASH_MAP_OPERATION_COST."
+                << std::endl;
+    }
+  }
+  for (const auto& factor : _costFactors) {
+    LOG(INFO) << factor.first << ": " << factor.second << std::endl;
+  }
+}
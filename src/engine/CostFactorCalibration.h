@@ -0,0 +1,112 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./QueryExecutionContext.h"
+#include "./QueryExecutionTree.h"
+
+using std::pair;
+using std::string;
+using std::vector;
+
+// Derives the cost factors of the query planner from measurements on the
+// loaded index. Scans, sorts, filters and joins are timed on predicates of
+// different sizes and the time per unit of work is fitted for each of them.
+// If a text index is loaded, text operations with a filter are timed on words
+// of different sizes as well.
+// All factors are relative to the time it takes to scan one row, which is the
+// unit of the cost estimates.
+class CostFactorCalibration {
+ public:
+  // The time an operation took for some amount of work, counted in the same
+  // way as by its cost estimate.
+  struct Measurement {
+    Measurement(double work, double seconds)
+        : _work(work), _seconds(seconds) {}
+    double _work;
+    double _seconds;
+  };
+
+  // The same for an operation whose cost estimate is the sum of two kinds of
+  // work with different costs.
+  struct TwoTermMeasurement {
+    TwoTermMeasurement(double work1, double work2, double seconds)
+        : _work1(work1), _work2(work2), _seconds(seconds) {}
+    double _work1;
+    double _work2;
+    double _seconds;
+  };
+
+  // Each operation is timed nofRepetitions times, the fastest run counts.
+  CostFactorCalibration(QueryExecutionContext* qec, size_t nofRepetitions);
+
+  void run();
+
+  const std::map<string, double>& getCostFactors() const {
+    return _costFactors;
+  }
+
+  // Writes one "KEY<tab>value" line per cost factor, the format read by
+  // QueryExecutionContext::readCostFactorsFromTSVFile.
+  void writeToFile(const string& fileName) const;
+
+  // Least squares fit of seconds = coefficient * work. Returns 0 if there is
+  // no measurement with positive work.
+  static double fitCoefficient(const vector<Measurement>& measurements);
+
+  // Least squares fit of seconds = c1 * work1 + c2 * work2. Returns (0, 0) if
+  // the two kinds of work cannot be told apart in the measurements.
+  static pair<double, double> fitCoefficients(
+      const vector<TwoTermMeasurement>& measurements);
+
+  // For each of the target sizes the predicate whose size is closest to it.
+  // Every predicate is chosen at most once. Also used to choose words.
+  static vector<string> choosePredicates(
+      const vector<pair<string, size_t>>& predicateSizes,
+      const vector<size_t>& targetSizes);
+
+ private:
+  void measurePredicate(const string& predicate);
+
+  // Joins the predicates on their subjects, if they have subjects in common
+  // and the result does not get too large.
+  void measureJoin(const string& predicate1, const string& predicate2);
+
+  // Runs a text operation for the word, filtered by the subjects of the scan,
+  // whose result has to be computed already.
+  void measureTextOperation(const string& word,
+                            const std::shared_ptr<QueryExecutionTree>& scan);
+
+  // Words of the text index with their number of postings. Only a sample of
+  // the text vocabulary is considered.
+  vector<pair<string, size_t>> getWordSizes() const;
+
+  // Computes the result of the root operation of tree, which is not taken
+  // from the cache. The results of the children are, so they do not count.
+  double time(const std::shared_ptr<QueryExecutionTree>& tree,
+              size_t* resultSize);
+
+  std::shared_ptr<QueryExecutionTree> makeScan(const string& predicate,
+                                               const string& subject);
+
+  void computeCostFactors();
+
+  QueryExecutionContext* _qec;
+  size_t _nofRepetitions;
+
+  vector<Measurement> _scans;
+  vector<Measurement> _sorts;
+  vector<Measurement> _filters;
+  vector<Measurement> _joins;
+  // The work is the number of result rows and of filter rows.
+  vector<TwoTermMeasurement> _textOperations;
+  // Scans with a bound subject, the work is the number of rows.
+  vector<Measurement> _randomAccesses;
+
+  std::map<string, double> _costFactors;
+};
@@ -14,14 +14,26 @@ CountAvailablePredicates::CountAvailablePredicates(
       _predicateVarName("predicate"),
       _countVarName("cont") {}
 
+// _____________________________________________________________________________
+CountAvailablePredicates::CountAvailablePredicates(QueryExecutionContext* qec)
+    : Operation(qec),
+      _subtree(nullptr),
+      _subjectColumnIndex(0),
+      _predicateVarName("predicate"),
+      _countVarName("cont") {}
+
 // _____________________________________________________________________________
 string CountAvailablePredicates::asString(size_t indent) const {
   std::ostringstream os;
   for (size_t i = 0; i < indent; ++i) {
     os << " ";
   }
-  os << "COUNT_AVAILABLE_PREDICATES (col " << _subjectColumnIndex << ")\n"
-     << _subtree->asString(indent);
+  if (!_subtree) {
+    os << "COUNT_AVAILABLE_PREDICATES for all entities";
+  } else {
+    os << "COUNT_AVAILABLE_PREDICATES (col " << _subjectColumnIndex << ")\n"
+       << _subtree->asString(indent);
+  }
   return os.str();
 }
 
@@ -69,6 +81,9 @@ float CountAvailablePredicates::getMultiplicity(size_t col) {
 size_t CountAvailablePredicates::getSizeEstimate() {
   // There is no easy way of computing the size estimate, but it should also
   // not be used, as this operation should not be used within the optimizer.
+  if (!_subtree) {
+    return getIndex().getFullPredicateCounts().size();
+  }
   return _subtree->getSizeEstimate();
 }
 
@@ -90,6 +105,15 @@ void CountAvailablePredicates::computeResult(ResultTable* result) const {
   result->_resultTypes.push_back(ResultTable::ResultType::KB);
   result->_resultTypes.push_back(ResultTable::ResultType::VERBATIM);
 
+  if (!_subtree) {
+    // The counts for all entities are precomputed by the index.
+    const vector<array<Id, 2>>& counts =
+        _executionContext->getIndex().getFullPredicateCounts();
+    *static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData) = counts;
+    result->finish();
+    return;
+  }
+
   const std::vector<PatternID>& hasPattern =
       _executionContext->getIndex().getHasPattern();
   const CompactStringVector<Id, Id>& hasRelation =
@@ -99,37 +123,43 @@ void CountAvailablePredicates::computeResult(ResultTable* result) const {
 
   std::shared_ptr<const ResultTable> subresult = _subtree->getResult();
 
-  if (result->_nofColumns > 5) {
+  if (subresult->_nofColumns > 5) {
     Engine::computePatternTrick<vector<Id>>(
         &subresult->_varSizeData,
         static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData), hasPattern,
-        hasRelation, patterns, _subjectColumnIndex);
+        hasRelation, patterns, _subjectColumnIndex, getCancellationHandle(),
+        getTaskScheduler());
   } else {
     if (subresult->_nofColumns == 1) {
       Engine::computePatternTrick<array<Id, 1>>(
           static_cast<vector<array<Id, 1>>*>(subresult->_fixedSizeData),
           static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
-          hasPattern, hasRelation, patterns, _subjectColumnIndex);
+          hasPattern, hasRelation, patterns, _subjectColumnIndex,
+          getCancellationHandle(), getTaskScheduler());
     } else if (subresult->_nofColumns == 2) {
       Engine::computePatternTrick<array<Id, 2>>(
           static_cast<vector<array<Id, 2>>*>(subresult->_fixedSizeData),
           static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
-          hasPattern, hasRelation, patterns, _subjectColumnIndex);
+          hasPattern, hasRelation, patterns, _subjectColumnIndex,
+          getCancellationHandle(), getTaskScheduler());
     } else if (subresult->_nofColumns == 3) {
       Engine::computePatternTrick<array<Id, 3>>(
           static_cast<vector<array<Id, 3>>*>(subresult->_fixedSizeData),
           static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
-          hasPattern, hasRelation, patterns, _subjectColumnIndex);
+          hasPattern, hasRelation, patterns, _subjectColumnIndex,
+          getCancellationHandle(), getTaskScheduler());
     } else if (subresult->_nofColumns == 4) {
       Engine::computePatternTrick<array<Id, 4>>(
           static_cast<vector<array<Id, 4>>*>(subresult->_fixedSizeData),
           static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
-          hasPattern, hasRelation, patterns, _subjectColumnIndex);
+          hasPattern, hasRelation, patterns, _subjectColumnIndex,
+          getCancellationHandle(), getTaskScheduler());
     } else if (subresult->_nofColumns == 5) {
       Engine::computePatternTrick<array<Id, 5>>(
           static_cast<vector<array<Id, 5>>*>(subresult->_fixedSizeData),
           static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
-          hasPattern, hasRelation, patterns, _subjectColumnIndex);
+          hasPattern, hasRelation, patterns, _subjectColumnIndex,
+          getCancellationHandle(), getTaskScheduler());
     }
   }
   result->finish();
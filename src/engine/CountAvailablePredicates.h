@@ -24,8 +24,13 @@ using std::vector;
 // count of how many of the input entities fulfill that requirement for that
 // predicate. This operation requires the use of the usePatterns option both
 // when building as well as when loading the index.
+// Without a subtree the predicates of all entities are counted. These counts
+// are precomputed when building the index and only looked up.
 class CountAvailablePredicates : public Operation {
  public:
+  // Counts the predicates of all entities in the index.
+  explicit CountAvailablePredicates(QueryExecutionContext* qec);
+
   CountAvailablePredicates(QueryExecutionContext* qec,
                            std::shared_ptr<QueryExecutionTree> subtree,
                            size_t subjectColumnIndex);
@@ -38,9 +43,25 @@ class CountAvailablePredicates : public Operation {
 
   std::unordered_map<string, size_t> getVariableColumns() const;
 
-  virtual void setTextLimit(size_t limit) { _subtree->setTextLimit(limit); }
-
-  virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
+  virtual void setTextLimit(size_t limit) {
+    if (_subtree) {
+      _subtree->setTextLimit(limit);
+    }
+  }
+
+  virtual bool knownEmptyResult() {
+    if (!_subtree) {
+      return getIndex().getFullPredicateCounts().empty();
+    }
+    return _subtree->knownEmptyResult();
+  }
+
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    if (!_subtree) {
+      return vector<QueryExecutionTree*>();
+    }
+    return {_subtree.get()};
+  }
 
   virtual float getMultiplicity(size_t col);
 
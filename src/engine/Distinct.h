@@ -29,6 +29,10 @@ class Distinct : public Operation {
 
   virtual size_t resultSortedOn() const { return _subtree->resultSortedOn(); }
 
+  virtual vector<size_t> resultSortedOnColumns() const {
+    return _subtree->resultSortedOnColumns();
+  }
+
   virtual void setTextLimit(size_t limit) { _subtree->setTextLimit(limit); }
 
   virtual size_t getSizeEstimate() { return _subtree->getSizeEstimate(); }
@@ -43,6 +47,10 @@ class Distinct : public Operation {
 
   virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
  private:
   std::shared_ptr<QueryExecutionTree> _subtree;
   vector<size_t> _keepIndices;
@@ -5,15 +5,20 @@
 
 #include <algorithm>
 #include <array>
+#include <functional>
 #include <iomanip>
+#include <unordered_set>
 #include <vector>
 
 #include "../global/Constants.h"
 #include "../global/Id.h"
 #include "../global/Pattern.h"
+#include "../util/CancellationHandle.h"
 #include "../util/Exception.h"
 #include "../util/HashMap.h"
+#include "../util/Intersection.h"
 #include "../util/Log.h"
+#include "../util/TaskScheduler.h"
 #include "./IndexSequence.h"
 
 using std::array;
@@ -95,25 +100,40 @@ class Engine {
   static vector<array<E, N>> filterRelationWithSingleId(
       const vector<array<E, N>>& relation, E entityId, size_t checkColumn);
 
+  // The long running functions below optionally take the cancellation handle
+  // of the query, which they check periodically. The joins return the name of
+  // the algorithm they used (e.g. "merge") for the runtime information. They
+  // always merge the inputs if allowGalloping is false.
   template <typename E, size_t N, size_t M>
-  static void join(const vector<array<E, N>>& a, size_t joinColumn1,
-                   const vector<array<E, M>>& b, size_t joinColumn2,
-                   vector<array<E, (N + M - 1)>>* result);
+  static const char* join(
+      const vector<array<E, N>>& a, size_t joinColumn1,
+      const vector<array<E, M>>& b, size_t joinColumn2,
+      vector<array<E, (N + M - 1)>>* result,
+      const ad_utility::CancellationHandle* cancellation = nullptr,
+      bool allowGalloping = true);
 
   template <typename E, typename A, typename B>
-  static void join(const A& a, size_t jc1, const B& b, size_t jc2,
-                   vector<vector<E>>* result);
+  static const char* join(
+      const A& a, size_t jc1, const B& b, size_t jc2, vector<vector<E>>* result,
+      const ad_utility::CancellationHandle* cancellation = nullptr,
+      bool allowGalloping = true);
 
   template <typename E, typename A>
-  static void selfJoin(const A& a, size_t jc, vector<vector<E>>* result);
+  static void selfJoin(
+      const A& a, size_t jc, vector<vector<E>>* result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
   template <typename E, size_t N, typename Comp>
-  static void filter(const vector<array<E, N>>& v, const Comp& comp,
-                     vector<array<E, N>>* result) {
+  static void filter(
+      const vector<array<E, N>>& v, const Comp& comp,
+      vector<array<E, N>>* result,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
     AD_CHECK(result);
     AD_CHECK(result->size() == 0);
     LOG(DEBUG) << "Filtering " << v.size() << " elements.\n";
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
     for (const auto& e : v) {
+      checkpoint();
       if (comp(e)) {
         result->push_back(e);
       }
@@ -122,12 +142,15 @@ class Engine {
   }
 
   template <typename E, typename Comp>
-  static void filter(const vector<vector<E>>& v, const Comp& comp,
-                     vector<vector<E>>* result) {
+  static void filter(
+      const vector<vector<E>>& v, const Comp& comp, vector<vector<E>>* result,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
     AD_CHECK(result);
     AD_CHECK(result->size() == 0);
     LOG(DEBUG) << "Filtering " << v.size() << " elements.\n";
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
     for (const auto& e : v) {
+      checkpoint();
       if (comp(e)) {
         result->push_back(e);
       }
@@ -136,8 +159,10 @@ class Engine {
   }
 
   template <typename T>
-  static void filter(const vector<T>& v, size_t fc1, size_t fc2,
-                     const vector<array<Id, 2>>& filter, vector<T>* result) {
+  static void filter(
+      const vector<T>& v, size_t fc1, size_t fc2,
+      const vector<array<Id, 2>>& filter, vector<T>* result,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
     AD_CHECK(result);
     AD_CHECK(result->size() == 0);
     LOG(DEBUG) << "Filtering " << v.size()
@@ -149,97 +174,95 @@ class Engine {
       return;
     }
 
-    // Cast away constness so we can add sentinels that will be removed
-    // in the end and create and add those sentinels.
-    vector<T>& l1 = const_cast<vector<T>&>(v);
-    vector<array<Id, 2>>& l2 = const_cast<vector<array<Id, 2>>&>(filter);
-
-    Id sent1 = std::numeric_limits<Id>::max();
-    Id sent2 = std::numeric_limits<Id>::max() - 1;
-    Id sentMatch = std::numeric_limits<Id>::max() - 2;
-    auto elem1 = l1[0];
-    auto elem2 = l2[0];
-    auto match1 = l1[0];
-    auto match2 = l2[0];
-
-    match1[fc1] = sentMatch;
-    match1[fc2] = sentMatch;
-    match2[0] = sentMatch;
-    match2[1] = sentMatch;
-    elem1[fc1] = sent1;
-    elem2[0] = sent2;
-    l1.push_back(match1);
-    l2.push_back(match2);
-    l1.push_back(elem1);
-    l2.push_back(elem2);
-    // Intersect both lists.
-    size_t i = 0;
-    size_t j = 0;
-
-    while (l1[i][fc1] < sent1) {
-      while (l1[i][fc1] < l2[j][0]) {
-        ++i;
-      }
-      while (l2[j][0] < l1[i][fc1]) {
-        ++j;
-      }
-      while (l1[i][fc1] == l2[j][0]) {
-        // fc1 match, create cross-product
-        // Check fc2
-        if (l1[i][fc2] == l2[j][1]) {
-          result->push_back(l1[i]);
-          ++i;
-          if (i == l1.size()) break;
-        } else if (l1[i][fc2] < l2[j][1]) {
-          ++i;
-          if (i == l1.size()) break;
-        } else {
-          ++j;
-          if (j == l2.size()) break;
-        }
-      }
-    }
-
-    // Remove sentinels
-    l1.resize(l1.size() - 2);
-    l2.resize(l2.size() - 2);
-    result->pop_back();
+    // The inputs are usually cached results, which are shared with other
+    // queries and must not be modified. Within a range of equal values in
+    // the first column both are sorted by the second column.
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
+    ad_utility::forEachMatch(
+        ad_utility::column(v, fc1), ad_utility::IdColumn(filter, 0),
+        [&v, fc2, &filter, result, &checkpoint](size_t beginV, size_t endV,
+                                                 size_t beginF, size_t endF) {
+          size_t i = beginV;
+          size_t j = beginF;
+          while (i < endV && j < endF) {
+            checkpoint();
+            if (v[i][fc2] == filter[j][1]) {
+              result->push_back(v[i]);
+              ++i;
+            } else if (v[i][fc2] < filter[j][1]) {
+              ++i;
+            } else {
+              ++j;
+            }
+          }
+        },
+        [&checkpoint] { checkpoint(); });
 
     LOG(DEBUG) << "Filter done, size now: " << result->size() << " elements.\n";
   }
 
   template <typename E, size_t N>
-  static void sort(vector<array<E, N>>& tab, size_t keyColumn) {
-    LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
-    std::sort(tab.begin(), tab.end(),
-              [&keyColumn](const array<E, N>& a, const array<E, N>& b) {
-                return a[keyColumn] < b[keyColumn];
-              });
-    LOG(DEBUG) << "Sort done.\n";
+  static void sort(
+      vector<array<E, N>>& tab, size_t keyColumn,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
+    sort(tab,
+         [&keyColumn](const array<E, N>& a, const array<E, N>& b) {
+           return a[keyColumn] < b[keyColumn];
+         },
+         cancellation);
   }
 
   template <typename E>
-  static void sort(vector<vector<E>>& tab, size_t keyColumn) {
-    LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
-    std::sort(tab.begin(), tab.end(),
-              [&keyColumn](const vector<E>& a, const vector<E>& b) {
-                return a[keyColumn] < b[keyColumn];
-              });
-    LOG(DEBUG) << "Sort done.\n";
+  static void sort(
+      vector<vector<E>>& tab, size_t keyColumn,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
+    sort(tab,
+         [&keyColumn](const vector<E>& a, const vector<E>& b) {
+           return a[keyColumn] < b[keyColumn];
+         },
+         cancellation);
   }
 
   template <typename E, size_t N, typename C>
-  static void sort(vector<array<E, N>>& tab, C comp) {
-    LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
-    std::sort(tab.begin(), tab.end(), comp);
-    LOG(DEBUG) << "Sort done.\n";
+  static void sort(
+      vector<array<E, N>>& tab, C comp,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
+    doSort(tab, comp, cancellation);
   }
 
   template <typename E, typename C>
-  static void sort(vector<vector<E>>& tab, C comp) {
-    LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
-    std::sort(tab.begin(), tab.end(), comp);
-    LOG(DEBUG) << "Sort done.\n";
+  static void sort(
+      vector<vector<E>>& tab, C comp,
+      const ad_utility::CancellationHandle* cancellation = nullptr) {
+    doSort(tab, comp, cancellation);
+  }
+
+  // Writes the k smallest rows of tab according to comp to result, in sorted
+  // order. Keeps a bounded max-heap of the best rows seen so far, which takes
+  // O(n log k) time and O(k) extra space instead of sorting a full copy.
+  template <typename R, typename C>
+  static void topK(const vector<R>& tab, C comp, size_t k,
+                   vector<R>* result) {
+    LOG(DEBUG) << "Selecting top " << k << " of " << tab.size()
+               << " elements.\n";
+    result->clear();
+    if (k == 0) {
+      return;
+    }
+    result->reserve(std::min(k, tab.size()));
+    ad_utility::GrowingMemory::updateCurrent();
+    for (const auto& row : tab) {
+      if (result->size() < k) {
+        result->push_back(row);
+        std::push_heap(result->begin(), result->end(), comp);
+      } else if (comp(row, result->front())) {
+        std::pop_heap(result->begin(), result->end(), comp);
+        result->back() = row;
+        std::push_heap(result->begin(), result->end(), comp);
+      }
+    }
+    std::sort_heap(result->begin(), result->end(), comp);
+    LOG(DEBUG) << "Top-k selection done.\n";
   }
 
   template <typename E, size_t N>
@@ -346,6 +369,78 @@ class Engine {
     }
   }
 
+  // Removes rows with equal values in the keepIndices columns, keeping the
+  // first occurrence of each. In contrast to distinct the input does not
+  // have to be sorted, and the order of the input is preserved. Large inputs
+  // are split into hash partitions that are processed in parallel.
+  template <typename R>
+  static void hashDistinct(
+      const vector<R>& v, const vector<size_t>& keepIndices,
+      vector<R>* result,
+      ad_utility::TaskScheduler& scheduler = ad_utility::TaskScheduler::get()) {
+    size_t nofPartitions = std::max(
+        size_t(1), std::min(scheduler.getNofWorkers(),
+                            v.size() / HASH_DISTINCT_PARTITION_MIN_SIZE));
+    hashDistinct(v, keepIndices, nofPartitions, result, scheduler);
+  }
+
+  template <typename R>
+  static void hashDistinct(
+      const vector<R>& v, const vector<size_t>& keepIndices,
+      size_t nofPartitions, vector<R>* result,
+      ad_utility::TaskScheduler& scheduler = ad_utility::TaskScheduler::get()) {
+    LOG(DEBUG) << "Hash distinct on " << v.size() << " elements in "
+               << nofPartitions << " partitions.\n";
+    AD_CHECK_GT(nofPartitions, 0u);
+    vector<size_t> hashes(v.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+      size_t h = 0;
+      for (size_t col : keepIndices) {
+        h ^= std::hash<Id>()(v[i][col]) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      }
+      hashes[i] = h;
+    }
+    auto hashRow = [&hashes](size_t i) { return hashes[i]; };
+    auto equalRows = [&v, &keepIndices](size_t a, size_t b) {
+      for (size_t col : keepIndices) {
+        if (v[a][col] != v[b][col]) {
+          return false;
+        }
+      }
+      return true;
+    };
+    // Rows with equal keys always end up in the same partition, hence each
+    // partition can be deduplicated independently. The rows of a partition
+    // are listed in input order, so the first occurrence is kept.
+    vector<vector<size_t>> rowsOfPartition(nofPartitions);
+    for (size_t i = 0; i < v.size(); ++i) {
+      rowsOfPartition[hashes[i] % nofPartitions].push_back(i);
+    }
+    // Not a vector<bool>, the partitions write to it concurrently.
+    vector<char> keep(v.size(), 0);
+    vector<std::function<void()>> partitions;
+    for (size_t p = 0; p < nofPartitions; ++p) {
+      partitions.push_back([&, p] {
+        const vector<size_t>& rows = rowsOfPartition[p];
+        std::unordered_set<size_t, decltype(hashRow), decltype(equalRows)>
+            seen(rows.size(), hashRow, equalRows);
+        for (size_t i : rows) {
+          if (seen.insert(i).second) {
+            keep[i] = 1;
+          }
+        }
+      });
+    }
+    scheduler.runInParallel(partitions);
+    result->clear();
+    for (size_t i = 0; i < v.size(); ++i) {
+      if (keep[i]) {
+        result->push_back(v[i]);
+      }
+    }
+    LOG(DEBUG) << "Hash distinct done.\n";
+  }
+
   /**
    * @brief This struct creates a result row of the correct size
    */
@@ -498,143 +593,102 @@ class Engine {
       return;
     }
 
-    // Cast away constness so we can add sentinels that will be removed
-    // in the end and create and add those sentinels.
-    A& l1 = const_cast<A&>(a);
-    B& l2 = const_cast<B&>(b);
-    Id sentVal = std::numeric_limits<Id>::max() - 1;
-    auto v1 = l1[0];
-    auto v2 = l2[0];
-    for (size_t i = 0; i < v1.size(); i++) {
-      v1[i] = sentVal;
-    }
-    for (size_t i = 0; i < v2.size(); i++) {
-      v2[i] = sentVal;
-    }
-    l1.push_back(v1);
-    l2.push_back(v2);
-
-    bool matched = false;
-    size_t ia = 0, ib = 0;
-    while (ia < a.size() - 1 && ib < b.size() - 1) {
-      // Join columns 0 are the primary sort columns
-      while (a[ia][joinColumns[0][0]] < b[ib][joinColumns[0][1]]) {
-        if (bOptional) {
-          R res = newOptionalResult<R, K>()(resultSize);
-          createOptionalResult<A, B, R, false, true>(
-              &a[ia], nullptr, a[ia].size(), joinColumnBitmap_a,
-              joinColumnBitmap_b, joinColumnAToB, resultSize, res);
-          result->push_back(res);
+    // Both inputs are sorted by their join columns, in the order given by
+    // joinColumns. Returns whether row ia of a comes before (-1), after (1)
+    // or joins with (0) row ib of b.
+    auto compare = [&a, &b, &joinColumns](size_t ia, size_t ib) {
+      for (const array<size_t, 2>& jc : joinColumns) {
+        if (a[ia][jc[0]] < b[ib][jc[1]]) {
+          return -1;
+        }
+        if (b[ib][jc[1]] < a[ia][jc[0]]) {
+          return 1;
         }
-        ia++;
       }
-      while (b[ib][joinColumns[0][1]] < a[ia][joinColumns[0][0]]) {
-        if (aOptional) {
-          R res = newOptionalResult<R, K>()(resultSize);
-          createOptionalResult<A, B, R, true, false>(
-              nullptr, &b[ib], a[ia].size(), joinColumnBitmap_a,
-              joinColumnBitmap_b, joinColumnAToB, resultSize, res);
-          result->push_back(res);
+      return 0;
+    };
+    auto sameKeyA = [&a, &joinColumns](size_t i, size_t j) {
+      for (const array<size_t, 2>& jc : joinColumns) {
+        if (a[i][jc[0]] != a[j][jc[0]]) {
+          return false;
         }
-        ib++;
       }
-
-      // check if the rest of the join columns also match
-      matched = true;
-      for (size_t joinColIndex = 0; joinColIndex < joinColumns.size();
-           joinColIndex++) {
-        const array<size_t, 2>& joinColumn = joinColumns[joinColIndex];
-        if (a[ia][joinColumn[0]] < b[ib][joinColumn[1]]) {
-          if (bOptional) {
-            R res = newOptionalResult<R, K>()(resultSize);
-            createOptionalResult<A, B, R, false, true>(
-                &a[ia], nullptr, a[ia].size(), joinColumnBitmap_a,
-                joinColumnBitmap_b, joinColumnAToB, resultSize, res);
-            result->push_back(res);
-          }
-          ia++;
-          matched = false;
-          break;
+      return true;
+    };
+    auto sameKeyB = [&b, &joinColumns](size_t i, size_t j) {
+      for (const array<size_t, 2>& jc : joinColumns) {
+        if (b[i][jc[1]] != b[j][jc[1]]) {
+          return false;
+        }
+      }
+      return true;
+    };
+    auto addOnlyA = [&](size_t ia) {
+      R res = newOptionalResult<R, K>()(resultSize);
+      createOptionalResult<A, B, R, false, true>(
+          &a[ia], nullptr, a[ia].size(), joinColumnBitmap_a,
+          joinColumnBitmap_b, joinColumnAToB, resultSize, res);
+      result->push_back(res);
+    };
+    auto addOnlyB = [&](size_t ib) {
+      R res = newOptionalResult<R, K>()(resultSize);
+      createOptionalResult<A, B, R, true, false>(
+          nullptr, &b[ib], a[0].size(), joinColumnBitmap_a,
+          joinColumnBitmap_b, joinColumnAToB, resultSize, res);
+      result->push_back(res);
+    };
+
+    // The inputs are usually cached results, which are shared with other
+    // queries, hence the merge does not use sentinels.
+    size_t ia = 0;
+    size_t ib = 0;
+    while (ia < a.size() && ib < b.size()) {
+      int cmp = compare(ia, ib);
+      if (cmp < 0) {
+        if (bOptional) {
+          addOnlyA(ia);
         }
-        if (b[ib][joinColumn[1]] < a[ia][joinColumn[0]]) {
-          if (aOptional) {
+        ++ia;
+      } else if (cmp > 0) {
+        if (aOptional) {
+          addOnlyB(ib);
+        }
+        ++ib;
+      } else {
+        // Cross product of the rows with the same values in all join
+        // columns.
+        size_t endA = ia + 1;
+        while (endA < a.size() && sameKeyA(ia, endA)) {
+          ++endA;
+        }
+        size_t endB = ib + 1;
+        while (endB < b.size() && sameKeyB(ib, endB)) {
+          ++endB;
+        }
+        for (size_t i = ia; i < endA; ++i) {
+          for (size_t j = ib; j < endB; ++j) {
             R res = newOptionalResult<R, K>()(resultSize);
-            createOptionalResult<A, B, R, true, false>(
-                nullptr, &b[ib], a[ia].size(), joinColumnBitmap_a,
+            createOptionalResult<A, B, R, false, false>(
+                &a[i], &b[j], a[i].size(), joinColumnBitmap_a,
                 joinColumnBitmap_b, joinColumnAToB, resultSize, res);
             result->push_back(res);
           }
-          ib++;
-          matched = false;
-          break;
-        }
-      }
-
-      // Compute the cross product of the row in a and all matching
-      // rows in b.
-      while (matched && ia < a.size() && ib < b.size()) {
-        // used to reset ib if another cross product needs to be computed
-        size_t initIb = ib;
-
-        while (matched) {
-          R res = newOptionalResult<R, K>()(resultSize);
-          createOptionalResult<A, B, R, false, false>(
-              &a[ia], &b[ib], a[ia].size(), joinColumnBitmap_a,
-              joinColumnBitmap_b, joinColumnAToB, resultSize, res);
-          result->push_back(res);
-          ib++;
-
-          // do the rows still match?
-          for (const array<size_t, 2>& jc : joinColumns) {
-            if (ib == b.size() || a[ia][jc[0]] != b[ib][jc[1]]) {
-              matched = false;
-              break;
-            }
-          }
-        }
-        ia++;
-        // Check if the next row in a also matches the initial row in b
-        matched = true;
-        for (const array<size_t, 2>& jc : joinColumns) {
-          if (ia == a.size() || a[ia][jc[0]] != b[initIb][jc[1]]) {
-            matched = false;
-            break;
-          }
-        }
-        // If they match reset ib and compute another cross product
-        if (matched) {
-          ib = initIb;
         }
+        ia = endA;
+        ib = endB;
       }
     }
 
-    // remove the sentinels
-    l1.pop_back();
-    l2.pop_back();
-    if (result->back()[joinColumns[0][0]] == sentVal) {
-      result->pop_back();
-    }
-
     // If the table of which we reached the end is optional, add all entries
     // of the other table.
-    if (aOptional && ib < b.size()) {
-      while (ib < b.size()) {
-        R res = newOptionalResult<R, K>()(resultSize);
-        createOptionalResult<A, B, R, true, false>(
-            nullptr, &b[ib], a[0].size(), joinColumnBitmap_a,
-            joinColumnBitmap_b, joinColumnAToB, resultSize, res);
-        result->push_back(res);
-        ++ib;
+    if (aOptional) {
+      for (; ib < b.size(); ++ib) {
+        addOnlyB(ib);
       }
     }
-    if (bOptional && ia < a.size()) {
-      while (ia < a.size()) {
-        R res = newOptionalResult<R, K>()(resultSize);
-        createOptionalResult<A, B, R, false, true>(
-            &a[ia], nullptr, a[ia].size(), joinColumnBitmap_a,
-            joinColumnBitmap_b, joinColumnAToB, resultSize, res);
-        result->push_back(res);
-        ++ia;
+    if (bOptional) {
+      for (; ia < a.size(); ++ia) {
+        addOnlyA(ia);
       }
     }
   }
@@ -642,9 +696,9 @@ class Engine {
   /**
    * @brief Computes all relations that have one of input[inputCol]'s entities
    *        as a subject and counts the number of their occurrences.
-   * @param input The input table of entity ids
+   * @param input The input table of entity ids, sorted by the subjects
    * @param result A table with two columns, one for predicate ids,
-   *               one for counts
+   *               one for counts, sorted by the predicate ids
    * @param hasPattern A mapping from entity ids to pattern ids (or NO_PATTERN)
    * @param hasRelation A mapping from entity ids to sets of relations
    * @param patterns A mapping from pattern ids to patterns
@@ -657,21 +711,165 @@ class Engine {
       const vector<PatternID>& hasPattern,
       const CompactStringVector<Id, Id>& hasRelation,
       const CompactStringVector<size_t, Id>& patterns,
-      const size_t subjectColumn) {
-    ad_utility::HashMap<Id, size_t> predicateCounts;
-    ad_utility::HashMap<size_t, size_t> patternCounts;
-    size_t posInput = 0;
-    size_t lastSubject = ID_NO_VALUE;
-    while (posInput < input->size()) {
-      while ((*input)[posInput][subjectColumn] == lastSubject &&
-             posInput < input->size()) {
-        posInput++;
+      const size_t subjectColumn,
+      const ad_utility::CancellationHandle* cancellation = nullptr,
+      ad_utility::TaskScheduler& scheduler = ad_utility::TaskScheduler::get()) {
+    size_t nofPartitions = std::max(
+        size_t(1), std::min(scheduler.getNofWorkers(),
+                            input->size() / PATTERN_TRICK_PARTITION_MIN_SIZE));
+    computePatternTrick(input, result, hasPattern, hasRelation, patterns,
+                        subjectColumn, nofPartitions, cancellation,
+                        scheduler);
+  }
+
+  // As above, but the input is split into nofPartitions ranges that are
+  // counted in parallel.
+  template <typename A>
+  static void computePatternTrick(
+      const vector<A>* input, vector<array<Id, 2>>* result,
+      const vector<PatternID>& hasPattern,
+      const CompactStringVector<Id, Id>& hasRelation,
+      const CompactStringVector<size_t, Id>& patterns,
+      const size_t subjectColumn, size_t nofPartitions,
+      const ad_utility::CancellationHandle* cancellation = nullptr,
+      ad_utility::TaskScheduler& scheduler = ad_utility::TaskScheduler::get()) {
+    LOG(DEBUG) << "Pattern trick on " << input->size() << " elements in "
+               << nofPartitions << " partitions.\n";
+    AD_CHECK_GT(nofPartitions, 0u);
+    // Every partition starts with a new subject, so that each subject is
+    // counted exactly once.
+    vector<size_t> bounds(nofPartitions + 1, input->size());
+    bounds[0] = 0;
+    for (size_t p = 1; p < nofPartitions; ++p) {
+      size_t pos =
+          std::max(bounds[p - 1], input->size() / nofPartitions * p);
+      while (pos > 0 && pos < input->size() &&
+             (*input)[pos][subjectColumn] ==
+                 (*input)[pos - 1][subjectColumn]) {
+        ++pos;
+      }
+      bounds[p] = pos;
+    }
+
+    vector<ad_utility::HashMap<Id, size_t>> predicateCounts(nofPartitions);
+    ad_utility::HashMap<Id, size_t>& totalCounts = predicateCounts[0];
+    // Pattern ids are dense, counting them in arrays saves a hash map lookup
+    // per subject. This only pays off if there are not too many patterns
+    // compared to the input, the arrays have to be initialized and merged.
+    if (input->size() * PATTERN_TRICK_DENSE_RATIO >= patterns.size()) {
+      vector<vector<size_t>> patternCounts(nofPartitions);
+      for (auto& counts : patternCounts) {
+        counts.resize(patterns.size(), 0);
+      }
+      countPatternsInParallel(*input, bounds, hasPattern, hasRelation,
+                              subjectColumn, &patternCounts, &predicateCounts,
+                              cancellation, scheduler);
+      vector<size_t>& total = patternCounts[0];
+      for (size_t p = 1; p < nofPartitions; ++p) {
+        for (size_t i = 0; i < total.size(); ++i) {
+          total[i] += patternCounts[p][i];
+        }
+      }
+      for (size_t i = 0; i < total.size(); ++i) {
+        if (total[i] > 0) {
+          addPatternCount(patterns[i], total[i], &totalCounts);
+        }
+      }
+    } else {
+      vector<ad_utility::HashMap<size_t, size_t>> patternCounts(nofPartitions);
+      countPatternsInParallel(*input, bounds, hasPattern, hasRelation,
+                              subjectColumn, &patternCounts, &predicateCounts,
+                              cancellation, scheduler);
+      for (const auto& counts : patternCounts) {
+        for (const auto& it : counts) {
+          addPatternCount(patterns[it.first], it.second, &totalCounts);
+        }
+      }
+    }
+    for (size_t p = 1; p < nofPartitions; ++p) {
+      for (const auto& it : predicateCounts[p]) {
+        totalCounts[it.first] += it.second;
+      }
+    }
+    result->reserve(totalCounts.size());
+    ad_utility::GrowingMemory::updateCurrent();
+    for (const auto& it : totalCounts) {
+      result->push_back(array<Id, 2>{{it.first, static_cast<Id>(it.second)}});
+    }
+    std::sort(result->begin(), result->end(),
+              [](const array<Id, 2>& a, const array<Id, 2>& b) {
+                return a[0] < b[0];
+              });
+    LOG(DEBUG) << "Pattern trick done.\n";
+  }
+
+ private:
+  // The name of a strategy of forEachMatch for the runtime information. In a
+  // join a is the left and b the right input.
+  static const char* joinAlgorithmName(
+      ad_utility::IntersectionStrategy strategy) {
+    switch (strategy) {
+      case ad_utility::GALLOP_A:
+        return "gallop through left";
+      case ad_utility::GALLOP_B:
+        return "gallop through right";
+      case ad_utility::MERGE:
+        break;
+    }
+    return "merge";
+  }
+
+  // Counts the patterns of the subjects in the partitions of input given by
+  // bounds in parallel. Subjects without a pattern have their predicates
+  // counted directly. PatternCounts is either a dense array or a hash map.
+  template <typename A, typename PatternCounts>
+  static void countPatternsInParallel(
+      const vector<A>& input, const vector<size_t>& bounds,
+      const vector<PatternID>& hasPattern,
+      const CompactStringVector<Id, Id>& hasRelation,
+      const size_t subjectColumn, vector<PatternCounts>* patternCounts,
+      vector<ad_utility::HashMap<Id, size_t>>* predicateCounts,
+      const ad_utility::CancellationHandle* cancellation,
+      ad_utility::TaskScheduler& scheduler) {
+    vector<std::function<void()>> partitions;
+    for (size_t p = 0; p + 1 < bounds.size(); ++p) {
+      partitions.push_back([&, p] {
+        countPatterns(input, bounds[p], bounds[p + 1], hasPattern,
+                      hasRelation, subjectColumn, &(*patternCounts)[p],
+                      &(*predicateCounts)[p], cancellation);
+      });
+    }
+    scheduler.runInParallel(partitions);
+  }
+
+  template <typename A, typename PatternCounts>
+  static void countPatterns(
+      const vector<A>& input, size_t begin, size_t end,
+      const vector<PatternID>& hasPattern,
+      const CompactStringVector<Id, Id>& hasRelation,
+      const size_t subjectColumn, PatternCounts* patternCounts,
+      ad_utility::HashMap<Id, size_t>* predicateCounts,
+      const ad_utility::CancellationHandle* cancellation) {
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
+    Id lastSubject = ID_NO_VALUE;
+    for (size_t pos = begin; pos < end; ++pos) {
+      checkpoint();
+      // The lookups in hasPattern are random accesses into a large array,
+      // fetch the entries needed a few subjects ahead.
+      if (pos + PATTERN_TRICK_PREFETCH_DISTANCE < end) {
+        Id ahead = input[pos + PATTERN_TRICK_PREFETCH_DISTANCE][subjectColumn];
+        if (ahead < hasPattern.size()) {
+          prefetch(&hasPattern[ahead]);
+        }
+      }
+      Id subject = input[pos][subjectColumn];
+      if (subject == lastSubject) {
+        continue;
       }
-      size_t subject = (*input)[posInput][subjectColumn];
       lastSubject = subject;
       if (subject < hasPattern.size() && hasPattern[subject] != NO_PATTERN) {
         // The subject matches a pattern
-        patternCounts[hasPattern[subject]]++;
+        (*patternCounts)[hasPattern[subject]]++;
       } else if (subject < hasRelation.size()) {
         // The subject does not match a pattern
         size_t numPredicates;
@@ -679,12 +877,7 @@ class Engine {
         std::tie(predicateData, numPredicates) = hasRelation[subject];
         if (numPredicates > 0) {
           for (size_t i = 0; i < numPredicates; i++) {
-            auto it = predicateCounts.find(predicateData[i]);
-            if (it == predicateCounts.end()) {
-              predicateCounts[predicateData[i]] = 1;
-            } else {
-              it->second++;
-            }
+            (*predicateCounts)[predicateData[i]]++;
           }
         } else {
           LOG(TRACE) << "No pattern or has-relation entry found for entity "
@@ -696,21 +889,45 @@ class Engine {
                       "(its id is to high)."
                    << std::endl;
       }
-      posInput++;
     }
-    for (const auto& it : patternCounts) {
-      std::pair<Id*, size_t> pattern = patterns[it.first];
-      for (size_t i = 0; i < pattern.second; i++) {
-        predicateCounts[pattern.first[i]] += it.second;
-      }
+  }
+
+  // Adds count to the counts of all predicates of the pattern.
+  static void addPatternCount(const std::pair<Id*, size_t>& pattern,
+                              size_t count,
+                              ad_utility::HashMap<Id, size_t>* counts) {
+    for (size_t i = 0; i < pattern.second; i++) {
+      (*counts)[pattern.first[i]] += count;
     }
-    result->reserve(predicateCounts.size());
-    for (const auto& it : predicateCounts) {
-      result->push_back(array<Id, 2>{it.first, static_cast<Id>(it.second)});
+  }
+
+  static void prefetch(const void* address) {
+#if defined(__GNUC__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+  }
+
+  template <typename R, typename C>
+  static void doSort(vector<R>& tab, C comp,
+                     const ad_utility::CancellationHandle* cancellation) {
+    LOG(DEBUG) << "Sorting " << tab.size() << " elements.\n";
+    if (!cancellation) {
+      std::sort(tab.begin(), tab.end(), comp);
+    } else {
+      // The comparator is copied by std::sort, all copies share the
+      // checkpoint. Leaves tab in an unspecified order when cancelled.
+      ad_utility::CancellationCheckpoint checkpoint(cancellation);
+      std::sort(tab.begin(), tab.end(),
+                [&comp, &checkpoint](const R& a, const R& b) {
+                  checkpoint();
+                  return comp(a, b);
+                });
     }
+    LOG(DEBUG) << "Sort done.\n";
   }
 
- private:
   template <typename E, size_t N, size_t I>
   static vector<array<E, N>> doFilterRelationWithSingleId(
       const vector<array<E, N>>& relation, E entityId) {
@@ -732,187 +949,66 @@ class Engine {
   }
 
   template <typename E, size_t N, size_t I, size_t M, size_t J>
-  static void doJoin(const vector<array<E, N>>& a, const vector<array<E, M>>& b,
-                     vector<array<E, (N + M - 1)>>* result) {
+  static const char* doJoin(
+      const vector<array<E, N>>& a, const vector<array<E, M>>& b,
+      vector<array<E, (N + M - 1)>>* result,
+      const ad_utility::CancellationHandle* cancellation, bool allowGalloping) {
     LOG(DEBUG) << "Performing join between two fixed width tables.\n";
     LOG(DEBUG) << "A: witdth = " << N << ", size = " << a.size() << "\n";
     LOG(DEBUG) << "B: witdth = " << M << ", size = " << b.size() << "\n";
 
-    // Typedefs can hopefully prevent insanity. Read as:
-    // "Tuple 1", "Tuple 2", "Tuple for Result", etc.
-    typedef array<E, N> T1;
-    typedef array<E, M> T2;
-    typedef vector<T1> V1;
-    typedef vector<T2> V2;
-
     // Check trivial case.
     if (a.size() == 0 || b.size() == 0) {
-      return;
+      return "none";
     }
-    // Check for possible self join (dangerous with sentinels).
+    // Check for possible self join.
     if (N == M) {
       if (reinterpret_cast<uintptr_t>(&a) == reinterpret_cast<uintptr_t>(&b)) {
         AD_CHECK_EQ(I, J);
         doSelfJoin<E, N, I>(
-            a, reinterpret_cast<vector<array<E, (N + N - 1)>>*>(result));
-        return;
+            a, reinterpret_cast<vector<array<E, (N + N - 1)>>*>(result),
+            cancellation);
+        return "self join";
       }
     }
 
-    // Cast away constness so we can add sentinels that will be removed
-    // in the end and create and add those sentinels.
-    V1& l1 = const_cast<V1&>(a);
-    V2& l2 = const_cast<V2&>(b);
-
-    E sent1 = std::numeric_limits<E>::max();
-    E sent2 = std::numeric_limits<E>::max() - 1;
-    E sentMatch = std::numeric_limits<E>::max() - 2;
-    auto elem1 = l1[0];
-    auto elem2 = l2[0];
-    auto match1 = l1[0];
-    auto match2 = l2[0];
-
-    match1[I] = sentMatch;
-    match2[J] = sentMatch;
-    elem1[I] = sent1;
-    elem2[J] = sent2;
-    l1.push_back(match1);
-    l2.push_back(match2);
-    l1.push_back(elem1);
-    l2.push_back(elem2);
-
-    // Cannot just switch l1 and l2 around because the order of
-    // items in the result tuples is important.
-    if (l1.size() / l2.size() > GALLOP_THRESHOLD) {
-      doGallopInnerJoinLeftLarge<E, N, I, M, J>(l1, l2, result);
-    } else if (l2.size() / l1.size() > GALLOP_THRESHOLD) {
-      doGallopInnerJoinRightLarge<E, N, I, M, J>(l1, l2, result);
-    } else {
-      // Intersect both lists.
-      size_t i = 0;
-      size_t j = 0;
-      while (l1[i][I] < sent1) {
-        while (l1[i][I] < l2[j][J]) {
-          ++i;
-        }
-        while (l2[j][J] < l1[i][I]) {
-          ++j;
-        }
-        while (l1[i][I] == l2[j][J]) {
-          // In case of match, create cross-product
-          // Always fix l1 and go through l2.
-          size_t keepJ = j;
-          while (l1[i][I] == l2[j][J]) {
-            result->emplace_back(joinTuples(
-                l1[i], l2[j], GenSeq<N>(), GenSeqLo<M, (J < M ? J : M - 1)>()));
-            ++j;
-          }
-          ++i;
-          // If the next i is still the same, reset j.
-          if (l1[i][I] == l2[keepJ][J]) {
-            j = keepJ;
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
+    ad_utility::IntersectionStrategy strategy =
+        allowGalloping
+            ? ad_utility::chooseIntersectionStrategy(a.size(), b.size())
+            : ad_utility::MERGE;
+    ad_utility::forEachMatch(
+        ad_utility::IdColumn(a, I), ad_utility::IdColumn(b, J), strategy,
+        [&a, &b, result, &checkpoint](size_t beginA, size_t endA,
+                                      size_t beginB, size_t endB) {
+          // Cross-product of the rows with the same join value.
+          for (size_t i = beginA; i < endA; ++i) {
+            for (size_t j = beginB; j < endB; ++j) {
+              checkpoint();
+              result->emplace_back(
+                  joinTuples(a[i], b[j], GenSeq<N>(),
+                             GenSeqLo<M, (J < M ? J : M - 1)>()));
+            }
           }
-        }
-      }
-    }
-    // Remove sentinels
-    l1.resize(l1.size() - 2);
-    l2.resize(l2.size() - 2);
-    result->pop_back();
+        },
+        [&checkpoint] { checkpoint(); });
 
     LOG(DEBUG) << "Join done.\n";
     LOG(DEBUG) << "Result: width = " << (N + M - 1)
                << ", size = " << result->size() << "\n";
+    return joinAlgorithmName(strategy);
   }
 
-  template <typename E, size_t N, size_t I, size_t M, size_t J>
-  static void doGallopInnerJoinRightLarge(
-      const vector<array<E, N>>& l1, const vector<array<E, M>>& l2,
-      vector<array<E, (N + M - 1)>>* result) {
-    LOG(DEBUG) << "Galloping case.\n";
-    size_t i = 0;
-    size_t j = 0;
-    E sent1 = std::numeric_limits<E>::max();
-    while (l1[i][I] < sent1) {
-      while (l1[i][I] < l2[j][J]) {
-        ++i;
-      }
-      if (l2[j][J] < l1[i][I]) {
-        array<E, M> val;
-        val[J] = l1[i][I];
-        j = std::lower_bound(
-                l2.begin() + j, l2.end(), val,
-                [](const array<E, M>& l, const array<E, M>& r) -> bool {
-                  return l[J] < r[J];
-                }) -
-            l2.begin();
-      }
-      while (l1[i][I] == l2[j][J]) {
-        // In case of match, create cross-product
-        // Always fix l1 and go through l2.
-        size_t keepJ = j;
-        while (l1[i][I] == l2[j][J]) {
-          result->emplace_back(joinTuples(l1[i], l2[j], GenSeq<N>(),
-                                          GenSeqLo<M, (J < M ? J : M - 1)>()));
-          ++j;
-        }
-        ++i;
-        // If the next i is still the same, reset j.
-        if (l1[i][I] == l2[keepJ][J]) {
-          j = keepJ;
-        }
-      }
-    }
-  };
-
-  template <typename E, size_t N, size_t I, size_t M, size_t J>
-  static void doGallopInnerJoinLeftLarge(
-      const vector<array<E, N>>& l1, const vector<array<E, M>>& l2,
-      vector<array<E, (N + M - 1)>>* result) {
-    LOG(DEBUG) << "Galloping case.\n";
-    size_t i = 0;
-    size_t j = 0;
-    E sent1 = std::numeric_limits<E>::max();
-    while (l1[i][I] < sent1) {
-      if (l2[j][J] > l1[i][I]) {
-        array<E, N> val;
-        val[I] = l2[j][J];
-        i = std::lower_bound(
-                l1.begin() + i, l1.end(), val,
-                [](const array<E, N>& l, const array<E, N>& r) -> bool {
-                  return l[I] < r[I];
-                }) -
-            l1.begin();
-      }
-      while (l1[i][I] > l2[j][J]) {
-        ++j;
-      }
-      while (l1[i][I] == l2[j][J]) {
-        // In case of match, create cross-product
-        // Always fix l1 and go through l2.
-        size_t keepJ = j;
-        while (l1[i][I] == l2[j][J]) {
-          result->emplace_back(joinTuples(l1[i], l2[j], GenSeq<N>(),
-                                          GenSeqLo<M, (J < M ? J : M - 1)>()));
-          ++j;
-        }
-        ++i;
-        // If the next i is still the same, reset j.
-        if (l1[i][I] == l2[keepJ][J]) {
-          j = keepJ;
-        }
-      }
-    }
-  };
-
   template <typename E, size_t N, size_t I>
   static void doSelfJoin(const vector<array<E, N>>& v,
-                         vector<array<E, N + N - 1>>* result) {
+                         vector<array<E, N + N - 1>>* result,
+                         const ad_utility::CancellationHandle* cancellation) {
     LOG(DEBUG) << "Performing self join on fixed width tables.\n";
     LOG(DEBUG) << "TAB: witdth = " << N << ", size = " << v.size() << "\n";
 
     // Always detect ranges of equal join col values and then
     // build a cross product for each range.
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
     size_t i = 0;
     while (i < v.size()) {
       const auto& val = v[i][I];
@@ -924,6 +1020,7 @@ class Engine {
       // v[i][I] is now != val and read to be the next one.
       for (size_t j = from; j < i; ++j) {
         for (size_t k = from; k < i; ++k) {
+          checkpoint();
           result->emplace_back(joinTuples(v[j], v[k], GenSeq<N>(),
                                           GenSeqLo<N, (I < N ? I : N - 1)>()));
         }
@@ -937,89 +1034,58 @@ class Engine {
 };
 
 template <typename E, typename A, typename B>
-void Engine::join(const A& a, size_t jc1, const B& b, size_t jc2,
-                  vector<vector<E>>* result) {
+const char* Engine::join(const A& a, size_t jc1, const B& b, size_t jc2,
+                         vector<vector<E>>* result,
+                         const ad_utility::CancellationHandle* cancellation,
+                         bool allowGalloping) {
   LOG(DEBUG) << "Performing join that leads to var size rows.\n";
   LOG(DEBUG) << "A: size = " << a.size() << "\n";
   LOG(DEBUG) << "B: size = " << b.size() << "\n";
 
   // Check trivial case.
   if (a.size() == 0 || b.size() == 0) {
-    return;
+    return "none";
   }
-  // Check for possible self join (dangerous with sentinels).
+  // Check for possible self join.
   if (reinterpret_cast<uintptr_t>(&a) == reinterpret_cast<uintptr_t>(&b)) {
     AD_CHECK_EQ(jc1, jc2)
-    selfJoin(a, jc1, result);
-    return;
+    selfJoin(a, jc1, result, cancellation);
+    return "self join";
   }
 
-  // Cast away constness so we can add sentinels that will be removed
-  // in the end and create and add those sentinels.
-  A& l1 = const_cast<A&>(a);
-  B& l2 = const_cast<B&>(b);
-  E sent1 = std::numeric_limits<E>::max();
-  E sent2 = std::numeric_limits<E>::max() - 1;
-  E sentMatch = std::numeric_limits<E>::max() - 2;
-  auto elem1 = l1[0];
-  auto elem2 = l2[0];
-  auto match1 = l1[0];
-  auto match2 = l2[0];
-
-  match1[jc1] = sentMatch;
-  match2[jc2] = sentMatch;
-  elem1[jc1] = sent1;
-  elem2[jc2] = sent2;
-  l1.push_back(match1);
-  l2.push_back(match2);
-  l1.push_back(elem1);
-  l2.push_back(elem2);
-
-  // Intersect both lists.
-  // TODO: Improve the start by a binary search in the bigger list.
-  // This could set the index in the smaller list to >= 0.
-  size_t i = 0;
-  size_t j = 0;
-
-  while (l1[i][jc1] < sent1) {
-    while (l2[j][jc2] < l1[i][jc1]) {
-      ++j;
-    }
-    while (l1[i][jc1] < l2[j][jc2]) {
-      ++i;
-    }
-    while (l1[i][jc1] == l2[j][jc2]) {
-      // In case of match, create cross-product
-      // Always fix l1 and go through l2.
-      size_t keepJ = j;
-      while (l1[i][jc1] == l2[j][jc2]) {
-        result->emplace_back(joinTuplesInVec<Id>(l1[i], l2[j], jc2));
-        ++j;
-      }
-      ++i;
-      // If the next i is still the same, reset j.
-      if (l1[i][jc1] == l2[keepJ][jc2]) {
-        j = keepJ;
-      }
-    }
-  }
-
-  // Remove sentinels
-  l1.resize(l1.size() - 2);
-  l2.resize(l2.size() - 2);
-  result->resize(result->size() - 1);
+  ad_utility::CancellationCheckpoint checkpoint(cancellation);
+  ad_utility::IntersectionStrategy strategy =
+      allowGalloping
+          ? ad_utility::chooseIntersectionStrategy(a.size(), b.size())
+          : ad_utility::MERGE;
+  ad_utility::forEachMatch(
+      ad_utility::column(a, jc1), ad_utility::column(b, jc2), strategy,
+      [&a, &b, jc2, result, &checkpoint](size_t beginA, size_t endA,
+                                         size_t beginB, size_t endB) {
+        // Cross-product of the rows with the same join value.
+        for (size_t i = beginA; i < endA; ++i) {
+          for (size_t j = beginB; j < endB; ++j) {
+            checkpoint();
+            result->emplace_back(joinTuplesInVec<E>(a[i], b[j], jc2));
+          }
+        }
+      },
+      [&checkpoint] { checkpoint(); });
 
   LOG(DEBUG) << "Join done.\n";
   LOG(DEBUG) << "Result: size = " << result->size() << "\n";
+  return joinAlgorithmName(strategy);
 }
 
 template <typename E, typename A>
-void Engine::selfJoin(const A& v, size_t jc, vector<vector<E>>* result) {
+void Engine::selfJoin(const A& v, size_t jc, vector<vector<E>>* result,
+                      const ad_utility::CancellationHandle* cancellation) {
   LOG(DEBUG) << "Performing self join on var width table.\n";
   LOG(DEBUG) << "TAB: size = " << v.size() << "\n";
 
   // Always detect ranges of equal join col values and then
   // build a cross product for each range.
+  ad_utility::CancellationCheckpoint checkpoint(cancellation);
   size_t i = 0;
   while (i < v.size()) {
     const auto& val = v[i][jc];
@@ -1031,6 +1097,7 @@ void Engine::selfJoin(const A& v, size_t jc, vector<vector<E>>* result) {
     // v[i][I] is now != val and read to be the next one.
     for (size_t j = from; j < i; ++j) {
       for (size_t k = from; k < i; ++k) {
+        checkpoint();
         result->emplace_back(joinTuplesInVec<E>(v[j], v[k], jc));
       }
     }
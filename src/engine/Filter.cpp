@@ -71,6 +71,45 @@ string Filter::asString(size_t indent) const {
   return os.str();
 }
 
+// _____________________________________________________________________________
+shared_ptr<ResultIterator> Filter::getResultIterator(bool cacheResult) const {
+  shared_ptr<const ResultTable> cached = getCachedResult();
+  if (cached) {
+    return iterateCachedResult(cached);
+  }
+  if (_type == SparqlFilter::LANG_MATCHES &&
+      _rhsInd != std::numeric_limits<size_t>::max()) {
+    return Operation::getResultIterator(cacheResult);
+  }
+  return recordRuntimeInfo(std::make_shared<FilterResultIterator>(
+      _subtree->getRootOperation()->getResultIterator(cacheResult),
+      [this](const Id* row) { return matches(row); }));
+}
+
+// _____________________________________________________________________________
+bool Filter::matches(const Id* row) const {
+  Id lhs = row[_lhsInd];
+  Id rhs = _rhsInd == std::numeric_limits<size_t>::max() ? _rhsId
+                                                          : row[_rhsInd];
+  switch (_type) {
+    case SparqlFilter::EQ:
+      return lhs == rhs;
+    case SparqlFilter::NE:
+      return lhs != rhs;
+    case SparqlFilter::LT:
+      return lhs < rhs;
+    case SparqlFilter::LE:
+      return lhs <= rhs;
+    case SparqlFilter::GT:
+      return lhs > rhs;
+    case SparqlFilter::GE:
+      return lhs >= rhs;
+    case SparqlFilter::LANG_MATCHES:
+      return ad_utility::endsWith(getIndex().idToString(lhs), _rhsString);
+  }
+  return false;
+}
+
 // _____________________________________________________________________________
 void Filter::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "Getting sub-result for Filter result computation..." << endl;
@@ -95,32 +134,32 @@ void Filter::computeResult(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] == e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] != e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] < e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] <= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] > e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] >= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
@@ -138,32 +177,32 @@ void Filter::computeResult(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] == e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] != e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] < e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] <= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] > e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] >= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
@@ -181,32 +220,32 @@ void Filter::computeResult(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] == e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] != e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] < e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] <= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] > e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] >= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
@@ -224,32 +263,32 @@ void Filter::computeResult(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] == e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] != e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] < e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] <= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] > e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] >= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
@@ -267,32 +306,32 @@ void Filter::computeResult(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] == e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] != e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] < e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] <= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] > e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
                              [&l, &r](const RT& e) { return e[l] >= e[r]; },
-                             res);
+                             res, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
@@ -308,32 +347,32 @@ void Filter::computeResult(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] == e[r]; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] != e[r]; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] < e[r]; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] <= e[r]; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] > e[r]; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] >= e[r]; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           AD_THROW(ad_semsearch::Exception::NOT_YET_IMPLEMENTED,
@@ -363,27 +402,33 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
       switch (_type) {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] == r; }, res);
+                             [&l, &r](const RT& e) { return e[l] == r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] != r; }, res);
+                             [&l, &r](const RT& e) { return e[l] != r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] < r; }, res);
+                             [&l, &r](const RT& e) { return e[l] < r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] <= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] <= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] > r; }, res);
+                             [&l, &r](const RT& e) { return e[l] > r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] >= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] >= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
@@ -392,7 +437,7 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
                                    getIndex().idToString(e[l]),
                                    this->_rhsString);
                              },
-                             res);
+                             res, getCancellationHandle());
           break;
       }
       break;
@@ -404,27 +449,33 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
       switch (_type) {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] == r; }, res);
+                             [&l, &r](const RT& e) { return e[l] == r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] != r; }, res);
+                             [&l, &r](const RT& e) { return e[l] != r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] < r; }, res);
+                             [&l, &r](const RT& e) { return e[l] < r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] <= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] <= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] > r; }, res);
+                             [&l, &r](const RT& e) { return e[l] > r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] >= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] >= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
@@ -433,7 +484,7 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
                                    getIndex().idToString(e[l]),
                                    this->_rhsString);
                              },
-                             res);
+                             res, getCancellationHandle());
           break;
       }
       break;
@@ -445,27 +496,33 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
       switch (_type) {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] == r; }, res);
+                             [&l, &r](const RT& e) { return e[l] == r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] != r; }, res);
+                             [&l, &r](const RT& e) { return e[l] != r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] < r; }, res);
+                             [&l, &r](const RT& e) { return e[l] < r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] <= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] <= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] > r; }, res);
+                             [&l, &r](const RT& e) { return e[l] > r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] >= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] >= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
@@ -474,7 +531,7 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
                                    getIndex().idToString(e[l]),
                                    this->_rhsString);
                              },
-                             res);
+                             res, getCancellationHandle());
           break;
       }
       break;
@@ -486,27 +543,33 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
       switch (_type) {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] == r; }, res);
+                             [&l, &r](const RT& e) { return e[l] == r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] != r; }, res);
+                             [&l, &r](const RT& e) { return e[l] != r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] < r; }, res);
+                             [&l, &r](const RT& e) { return e[l] < r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] <= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] <= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] > r; }, res);
+                             [&l, &r](const RT& e) { return e[l] > r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] >= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] >= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
@@ -515,7 +578,7 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
                                    getIndex().idToString(e[l]),
                                    this->_rhsString);
                              },
-                             res);
+                             res, getCancellationHandle());
           break;
       }
       break;
@@ -527,27 +590,33 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
       switch (_type) {
         case SparqlFilter::EQ:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] == r; }, res);
+                             [&l, &r](const RT& e) { return e[l] == r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] != r; }, res);
+                             [&l, &r](const RT& e) { return e[l] != r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] < r; }, res);
+                             [&l, &r](const RT& e) { return e[l] < r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] <= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] <= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] > r; }, res);
+                             [&l, &r](const RT& e) { return e[l] > r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
-                             [&l, &r](const RT& e) { return e[l] >= r; }, res);
+                             [&l, &r](const RT& e) { return e[l] >= r; }, res,
+                             getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           getEngine().filter(*static_cast<vector<RT>*>(subRes->_fixedSizeData),
@@ -556,7 +625,7 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
                                    getIndex().idToString(e[l]),
                                    this->_rhsString);
                              },
-                             res);
+                             res, getCancellationHandle());
           break;
       }
       break;
@@ -567,32 +636,32 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
         case SparqlFilter::EQ:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] == r; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::NE:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] != r; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::LT:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] < r; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::LE:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] <= r; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::GT:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] > r; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::GE:
           getEngine().filter(subRes->_varSizeData,
                              [&l, &r](const RT& e) { return e[l] >= r; },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
         case SparqlFilter::LANG_MATCHES:
           getEngine().filter(subRes->_varSizeData,
@@ -601,7 +670,7 @@ void Filter::computeResultFixedValue(ResultTable* result) const {
                                    getIndex().idToString(e[l]),
                                    this->_rhsString);
                              },
-                             &result->_varSizeData);
+                             &result->_varSizeData, getCancellationHandle());
           break;
       }
       break;
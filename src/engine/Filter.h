@@ -28,6 +28,10 @@ class Filter : public Operation {
 
   virtual size_t resultSortedOn() const { return _subtree->resultSortedOn(); }
 
+  virtual vector<size_t> resultSortedOnColumns() const {
+    return _subtree->resultSortedOnColumns();
+  }
+
   virtual void setTextLimit(size_t limit) { _subtree->setTextLimit(limit); }
 
   virtual size_t getSizeEstimate() {
@@ -54,7 +58,13 @@ class Filter : public Operation {
   }
 
   virtual size_t getCostEstimate() {
-    return getSizeEstimate() + _subtree->getSizeEstimate() +
+    double costPerRow =
+        _executionContext
+            ? _executionContext->getCostFactor("FILTER_COST_PER_ROW")
+            : 1;
+    return static_cast<size_t>(
+               costPerRow *
+               (getSizeEstimate() + _subtree->getSizeEstimate())) +
            _subtree->getCostEstimate();
   }
 
@@ -64,10 +74,17 @@ class Filter : public Operation {
 
   virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
   virtual float getMultiplicity(size_t col) {
     return _subtree->getMultiplicity(col);
   }
 
+  virtual shared_ptr<ResultIterator> getResultIterator(
+      bool cacheResult = true) const;
+
  private:
   std::shared_ptr<QueryExecutionTree> _subtree;
   SparqlFilter::FilterType _type;
@@ -79,4 +96,7 @@ class Filter : public Operation {
   virtual void computeResult(ResultTable* result) const;
 
   void computeResultFixedValue(ResultTable* result) const;
+
+  // True iff the given row of the subtree's result passes the filter.
+  bool matches(const Id* row) const;
 };
@@ -3,6 +3,7 @@
 // Author: Florian Kramer (florian.kramer@mail.uni-freiburg.de)
 
 #include "GroupBy.h"
+#include <algorithm>
 
 #include "../index/Index.h"
 #include "../util/Conversions.h"
@@ -538,7 +539,8 @@ void doGroupBy(const vector<A>* input,
                const vector<size_t>& groupByCols,
                const vector<GroupBy::Aggregate>& aggregates, vector<R>* result,
                const ResultTable* inTable, ResultTable* outTable,
-               const Index& index) {
+               const Index& index,
+               const ad_utility::CancellationHandle* cancellation) {
   if (input->size() == 0) {
     return;
   }
@@ -566,7 +568,9 @@ void doGroupBy(const vector<A>* input,
   }
   size_t blockStart = 0;
   size_t blockEnd = 0;
+  ad_utility::CancellationCheckpoint checkpoint(cancellation);
   for (size_t pos = 1; pos < input->size(); pos++) {
+    checkpoint();
     bool rowMatchesCurrentBlock = true;
     for (size_t i = 0; i < currentGroupBlock.size(); i++) {
       if ((*input)[pos][currentGroupBlock[i].first] !=
@@ -622,26 +626,30 @@ struct callDoGroupBy {
                    const vector<size_t>& groupByCols,
                    const vector<GroupBy::Aggregate>& aggregates,
                    ResultTable* result, ResultTable* outTable,
-                   const Index& index) {
+                   const Index& index,
+                   const ad_utility::CancellationHandle* cancellation) {
     if (InputColCount == inputColCount) {
       if (resultColCount == ResultColCount) {
-        result->_fixedSizeData = new vector<array<Id, ResultColCount>>();
+        // The result may already contain the groups of a previous chunk.
+        if (!result->_fixedSizeData) {
+          result->_fixedSizeData = new vector<array<Id, ResultColCount>>();
+        }
         doGroupBy<array<Id, InputColCount>, array<Id, ResultColCount>>(
             static_cast<vector<array<Id, InputColCount>>*>(
                 subresult->_fixedSizeData),
             inputTypes, groupByCols, aggregates,
             static_cast<vector<array<Id, ResultColCount>>*>(
                 result->_fixedSizeData),
-            subresult.get(), outTable, index);
+            subresult.get(), outTable, index, cancellation);
       } else {
         callDoGroupBy<InputColCount, ResultColCount + 1>::call(
             inputColCount, resultColCount, subresult, inputTypes, groupByCols,
-            aggregates, result, outTable, index);
+            aggregates, result, outTable, index, cancellation);
       }
     } else {
       callDoGroupBy<InputColCount + 1, ResultColCount>::call(
           inputColCount, resultColCount, subresult, inputTypes, groupByCols,
-          aggregates, result, outTable, index);
+          aggregates, result, outTable, index, cancellation);
     }
   }
 };
@@ -654,18 +662,21 @@ struct callDoGroupBy<6, ResultColCount> {
                    const vector<size_t>& groupByCols,
                    const vector<GroupBy::Aggregate>& aggregates,
                    ResultTable* result, ResultTable* outTable,
-                   const Index& index) {
+                   const Index& index,
+                   const ad_utility::CancellationHandle* cancellation) {
     if (resultColCount == ResultColCount) {
-      result->_fixedSizeData = new vector<array<Id, ResultColCount>>();
+      if (!result->_fixedSizeData) {
+        result->_fixedSizeData = new vector<array<Id, ResultColCount>>();
+      }
       doGroupBy<vector<Id>, array<Id, ResultColCount>>(
           &subresult->_varSizeData, inputTypes, groupByCols, aggregates,
           static_cast<vector<array<Id, ResultColCount>>*>(
               result->_fixedSizeData),
-          subresult.get(), outTable, index);
+          subresult.get(), outTable, index, cancellation);
     } else {
       callDoGroupBy<6, ResultColCount + 1>::call(
           inputColCount, resultColCount, subresult, inputTypes, groupByCols,
-          aggregates, result, outTable, index);
+          aggregates, result, outTable, index, cancellation);
     }
   }
 };
@@ -678,7 +689,8 @@ struct callDoGroupBy<InputColCount, 6> {
                    const vector<size_t>& groupByCols,
                    const vector<GroupBy::Aggregate>& aggregates,
                    ResultTable* result, ResultTable* outTable,
-                   const Index& index) {
+                   const Index& index,
+                   const ad_utility::CancellationHandle* cancellation) {
     // avoid the quite numerous warnings about unused parameters
     (void)inputColCount;
     (void)resultColCount;
@@ -686,7 +698,7 @@ struct callDoGroupBy<InputColCount, 6> {
         static_cast<vector<array<Id, InputColCount>>*>(
             subresult->_fixedSizeData),
         inputTypes, groupByCols, aggregates, &result->_varSizeData,
-        subresult.get(), outTable, index);
+        subresult.get(), outTable, index, cancellation);
   }
 };
 
@@ -698,16 +710,76 @@ struct callDoGroupBy<6, 6> {
                    const vector<size_t>& groupByCols,
                    const vector<GroupBy::Aggregate>& aggregates,
                    ResultTable* result, ResultTable* outTable,
-                   const Index& index) {
+                   const Index& index,
+                   const ad_utility::CancellationHandle* cancellation) {
     // avoid the quite numerous warnings about unused parameters
     (void)inputColCount;
     (void)resultColCount;
     doGroupBy<vector<Id>, vector<Id>>(
         &subresult->_varSizeData, inputTypes, groupByCols, aggregates,
-        &result->_varSizeData, subresult.get(), outTable, index);
+        &result->_varSizeData, subresult.get(), outTable, index,
+        cancellation);
   }
 };
 
+// _____________________________________________________________________________
+// Groups the rows of input, which are sorted by the group by columns, while
+// they are streamed, so that the input is never materialized completely. The
+// rows are collected in chunks of about chunkMemory bytes that end at group
+// boundaries and each chunk is grouped by doGroupBy.
+static void groupChunkwise(ResultIterator* input,
+                           const vector<ResultTable::ResultType>& inputTypes,
+                           const vector<size_t>& groupByCols,
+                           const vector<GroupBy::Aggregate>& aggregates,
+                           size_t chunkMemory, ResultTable* result,
+                           const Index& index,
+                           const ad_utility::CancellationHandle* cancellation) {
+  size_t width = input->width();
+  size_t rowsPerChunk =
+      std::max<size_t>(1, chunkMemory / (width * sizeof(Id)));
+  createRowStorage(result);
+  vector<Id> rows;
+  // The index of the first row of the last group in rows.
+  size_t groupStart = 0;
+
+  // Groups the first nofRows rows and removes them.
+  auto groupRows = [&](size_t nofRows) {
+    std::shared_ptr<ResultTable> chunk = std::make_shared<ResultTable>();
+    chunk->_nofColumns = width;
+    chunk->_resultTypes = inputTypes;
+    createRowStorage(chunk.get());
+    for (size_t i = 0; i < nofRows; ++i) {
+      appendRow(chunk.get(), &rows[i * width]);
+    }
+    rows.erase(rows.begin(), rows.begin() + nofRows * width);
+    groupStart = 0;
+    callDoGroupBy<1, 1>::call(width, aggregates.size(), chunk, inputTypes,
+                              groupByCols, aggregates, result, result, index,
+                              cancellation);
+  };
+
+  ResultBlock block(width);
+  while (input->nextBlock(&block)) {
+    for (size_t i = 0; i < block.size(); ++i) {
+      size_t last = rows.size();
+      rows.insert(rows.end(), block[i], block[i] + width);
+      for (size_t col : groupByCols) {
+        if (last > 0 && rows[last - width + col] != rows[last + col]) {
+          groupStart = last / width;
+          break;
+        }
+      }
+    }
+    // The last group may continue in the next block.
+    if (rows.size() / width >= rowsPerChunk && groupStart > 0) {
+      groupRows(groupStart);
+    }
+  }
+  if (!rows.empty()) {
+    groupRows(rows.size() / width);
+  }
+}
+
 void GroupBy::computeResult(ResultTable* result) const {
   std::vector<size_t> groupByColumns;
 
@@ -865,7 +937,36 @@ void GroupBy::computeResult(ResultTable* result) const {
     }
   }
 
-  std::shared_ptr<const ResultTable> subresult = _subtree->getResult();
+  std::vector<size_t> groupByCols;
+  groupByCols.reserve(_groupByVariables.size());
+  for (const string& var : _groupByVariables) {
+    groupByCols.push_back(subtreeVarCols[var]);
+  }
+
+  // Inputs that are too large to be sorted in memory are grouped while they
+  // are streamed from the subtree, which sorts them externally. This is only
+  // possible if there are groups and the input has no local vocabulary.
+  shared_ptr<ResultIterator> input;
+  std::shared_ptr<const ResultTable> subresult;
+  std::vector<ResultTable::ResultType> inputResultTypes;
+  if (!groupByCols.empty() &&
+      needsExternalSort(_subtree->getRootOperation())) {
+    input = _subtree->getRootOperation()->getResultIterator(false);
+    inputResultTypes = input->getResultTypes();
+    if (std::find(inputResultTypes.begin(), inputResultTypes.end(),
+                  ResultTable::ResultType::LOCAL_VOCAB) !=
+        inputResultTypes.end()) {
+      input.reset();
+    }
+  }
+  if (!input) {
+    subresult = _subtree->getResult();
+    inputResultTypes.clear();
+    inputResultTypes.reserve(subresult->_nofColumns);
+    for (size_t i = 0; i < subresult->_nofColumns; i++) {
+      inputResultTypes.push_back(subresult->getResultType(i));
+    }
+  }
 
   // populate the result type vector
   result->_resultTypes.resize(result->_nofColumns);
@@ -881,16 +982,13 @@ void GroupBy::computeResult(ResultTable* result) const {
         result->_resultTypes[i] = ResultTable::ResultType::LOCAL_VOCAB;
         break;
       case AggregateType::MAX:
-        result->_resultTypes[i] =
-            subresult->getResultType(aggregates[i]._inCol);
+        result->_resultTypes[i] = inputResultTypes[aggregates[i]._inCol];
         break;
       case AggregateType::MIN:
-        result->_resultTypes[i] =
-            subresult->getResultType(aggregates[i]._inCol);
+        result->_resultTypes[i] = inputResultTypes[aggregates[i]._inCol];
         break;
       case AggregateType::SAMPLE:
-        result->_resultTypes[i] =
-            subresult->getResultType(aggregates[i]._inCol);
+        result->_resultTypes[i] = inputResultTypes[aggregates[i]._inCol];
         break;
       case AggregateType::SUM:
         result->_resultTypes[i] = ResultTable::ResultType::FLOAT;
@@ -900,27 +998,31 @@ void GroupBy::computeResult(ResultTable* result) const {
     }
   }
 
-  std::vector<size_t> groupByCols;
-  groupByCols.reserve(_groupByVariables.size());
-  for (const string& var : _groupByVariables) {
-    groupByCols.push_back(subtreeVarCols[var]);
-  }
-
-  std::vector<ResultTable::ResultType> inputResultTypes;
-  inputResultTypes.reserve(subresult->_nofColumns);
-  for (size_t i = 0; i < subresult->_nofColumns; i++) {
-    inputResultTypes.push_back(subresult->getResultType(i));
-  }
-
-  callDoGroupBy<1, 1>::call(subresult->_nofColumns, aggregates.size(),
-                            subresult, inputResultTypes, groupByCols,
-                            aggregates, result, result, getIndex());
-
-  // Free the user data used by GROUP_CONCAT aggregates.
-  for (Aggregate& a : aggregates) {
-    if (a._type == AggregateType::GROUP_CONCAT) {
-      delete static_cast<std::string*>(a._userData);
+  // Free the user data used by GROUP_CONCAT aggregates, also if the query
+  // is cancelled.
+  auto freeUserData = [&aggregates]() {
+    for (Aggregate& a : aggregates) {
+      if (a._type == AggregateType::GROUP_CONCAT) {
+        delete static_cast<std::string*>(a._userData);
+      }
+    }
+  };
+  try {
+    if (input) {
+      LOG(DEBUG) << "Grouping the streamed input chunk by chunk..." << endl;
+      groupChunkwise(input.get(), inputResultTypes, groupByCols, aggregates,
+                     getExecutionContext()->getSortMemory(), result,
+                     getIndex(), getCancellationHandle());
+    } else {
+      callDoGroupBy<1, 1>::call(subresult->_nofColumns, aggregates.size(),
+                                subresult, inputResultTypes, groupByCols,
+                                aggregates, result, result, getIndex(),
+                                getCancellationHandle());
     }
+  } catch (...) {
+    freeUserData();
+    throw;
   }
+  freeUserData();
   result->finish();
 }
@@ -72,6 +72,10 @@ class GroupBy : public Operation {
 
   virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
   virtual float getMultiplicity(size_t col);
 
   virtual size_t getSizeEstimate();
@@ -112,4 +116,5 @@ void doGroupBy(const vector<A>* input,
                const vector<size_t>& groupByCols,
                const vector<GroupBy::Aggregate>& aggregates, vector<R>* result,
                const ResultTable* inTable, ResultTable* outTable,
-               const Index& index);
+               const Index& index,
+               const ad_utility::CancellationHandle* cancellation = nullptr);
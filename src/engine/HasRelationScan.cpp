@@ -299,6 +299,7 @@ void HasRelationScan::computeFullScan(
       new std::vector<std::array<Id, 2>>();
   result->_fixedSizeData = fixedSizeData;
   fixedSizeData->reserve(resultSize);
+  ad_utility::GrowingMemory::updateCurrent();
 
   size_t id = 0;
   while (id < hasPattern.size() || id < hasRelation.size()) {
@@ -40,6 +40,13 @@ class HasRelationScan : public Operation {
 
   virtual bool knownEmptyResult();
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    if (!_subtree) {
+      return vector<QueryExecutionTree*>();
+    }
+    return {_subtree.get()};
+  }
+
   virtual float getMultiplicity(size_t col);
 
   virtual size_t getSizeEstimate();
@@ -0,0 +1,104 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include "./HashDistinct.h"
+#include <sstream>
+#include "./QueryExecutionTree.h"
+
+using std::string;
+
+// _____________________________________________________________________________
+size_t HashDistinct::getResultWidth() const {
+  return _subtree->getResultWidth();
+}
+
+// _____________________________________________________________________________
+HashDistinct::HashDistinct(QueryExecutionContext* qec,
+                           std::shared_ptr<QueryExecutionTree> subtree,
+                           const vector<size_t>& keepIndices)
+    : Operation(qec), _subtree(subtree), _keepIndices(keepIndices) {}
+
+// _____________________________________________________________________________
+string HashDistinct::asString(size_t indent) const {
+  std::ostringstream os;
+  for (size_t i = 0; i < indent; ++i) {
+    os << " ";
+  }
+  os << "HashDistinct " << _subtree->asString(indent) << "\n";
+  for (size_t i = 0; i < indent; ++i) {
+    os << " ";
+  }
+  os << "on ";
+  for (size_t col : _keepIndices) {
+    os << col << " ";
+  }
+  return os.str();
+}
+
+// _____________________________________________________________________________
+void HashDistinct::computeResult(ResultTable* result) const {
+  LOG(DEBUG) << "Getting sub-result for hash distinct result computation..."
+             << endl;
+  shared_ptr<const ResultTable> subRes = _subtree->getResult();
+  LOG(DEBUG) << "Hash distinct result computation..." << endl;
+  result->_nofColumns = subRes->_nofColumns;
+  result->_sortedBy = subRes->_sortedBy;
+  result->_resultTypes.insert(result->_resultTypes.end(),
+                              subRes->_resultTypes.begin(),
+                              subRes->_resultTypes.end());
+  result->_localVocab = subRes->_localVocab;
+  switch (subRes->_nofColumns) {
+    case 1: {
+      typedef array<Id, 1> RT;
+      auto res = new vector<RT>();
+      result->_fixedSizeData = res;
+      getEngine().hashDistinct(
+          *static_cast<vector<RT>*>(subRes->_fixedSizeData), _keepIndices,
+          res, getTaskScheduler());
+      break;
+    }
+    case 2: {
+      typedef array<Id, 2> RT;
+      auto res = new vector<RT>();
+      result->_fixedSizeData = res;
+      getEngine().hashDistinct(
+          *static_cast<vector<RT>*>(subRes->_fixedSizeData), _keepIndices,
+          res, getTaskScheduler());
+      break;
+    }
+    case 3: {
+      typedef array<Id, 3> RT;
+      auto res = new vector<RT>();
+      result->_fixedSizeData = res;
+      getEngine().hashDistinct(
+          *static_cast<vector<RT>*>(subRes->_fixedSizeData), _keepIndices,
+          res, getTaskScheduler());
+      break;
+    }
+    case 4: {
+      typedef array<Id, 4> RT;
+      auto res = new vector<RT>();
+      result->_fixedSizeData = res;
+      getEngine().hashDistinct(
+          *static_cast<vector<RT>*>(subRes->_fixedSizeData), _keepIndices,
+          res, getTaskScheduler());
+      break;
+    }
+    case 5: {
+      typedef array<Id, 5> RT;
+      auto res = new vector<RT>();
+      result->_fixedSizeData = res;
+      getEngine().hashDistinct(
+          *static_cast<vector<RT>*>(subRes->_fixedSizeData), _keepIndices,
+          res, getTaskScheduler());
+      break;
+    }
+    default: {
+      getEngine().hashDistinct(subRes->_varSizeData, _keepIndices,
+                               &result->_varSizeData, getTaskScheduler());
+      break;
+    }
+  }
+  result->finish();
+  LOG(DEBUG) << "Hash distinct result computation done." << endl;
+}
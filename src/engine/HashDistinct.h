@@ -0,0 +1,56 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <vector>
+
+#include "./Operation.h"
+#include "./QueryExecutionTree.h"
+
+using std::vector;
+
+// Distinct that does not require its input to be sorted on the distinct
+// columns. Rows are deduplicated with a hash set (in parallel for large
+// inputs), which is cheaper than sorting the input first. The order of the
+// input is preserved.
+class HashDistinct : public Operation {
+ public:
+  virtual size_t getResultWidth() const;
+
+ public:
+  HashDistinct(QueryExecutionContext* qec,
+               std::shared_ptr<QueryExecutionTree> subtree,
+               const vector<size_t>& keepIndices);
+
+  virtual string asString(size_t indent = 0) const;
+
+  virtual size_t resultSortedOn() const { return _subtree->resultSortedOn(); }
+
+  virtual vector<size_t> resultSortedOnColumns() const {
+    return _subtree->resultSortedOnColumns();
+  }
+
+  virtual void setTextLimit(size_t limit) { _subtree->setTextLimit(limit); }
+
+  virtual size_t getSizeEstimate() { return _subtree->getSizeEstimate(); }
+
+  virtual size_t getCostEstimate() {
+    return getSizeEstimate() + _subtree->getCostEstimate();
+  }
+
+  virtual float getMultiplicity(size_t col) {
+    return _subtree->getMultiplicity(col);
+  }
+
+  virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
+
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
+ private:
+  std::shared_ptr<QueryExecutionTree> _subtree;
+  vector<size_t> _keepIndices;
+
+  virtual void computeResult(ResultTable* result) const;
+};
@@ -64,6 +64,9 @@ string IndexScan::asString(size_t indent) const {
       os << "SCAN FOR FULL INDEX OPS (DUMMY OPERATION)";
       break;
   }
+  if (!_filter.empty()) {
+    os << " with FILTER " << _filter.asString();
+  }
   return os.str();
 }
 
@@ -93,6 +96,34 @@ size_t IndexScan::getResultWidth() const {
   }
 }
 
+// _____________________________________________________________________________
+bool IndexScan::addFilter(size_t column, SparqlFilter::FilterType type,
+                          Id value) {
+  if (column >= getResultWidth() || getResultWidth() == 3) {
+    return false;
+  }
+  return _filter.add(column, type, value);
+}
+
+// _____________________________________________________________________________
+shared_ptr<const ResultTable> IndexScan::getResultForKeys(
+    size_t column, std::shared_ptr<const JoinKeyFilter> keys) const {
+  shared_ptr<const ResultTable> cached = getCachedResult();
+  if (cached) {
+    return cached;
+  }
+  LOG(DEBUG) << "IndexScan restricted to " << keys->asString() << "\n";
+  IndexScan restricted(*this);
+  restricted._filter.setJoinKeys(column, keys);
+  std::shared_ptr<ResultTable> result = std::make_shared<ResultTable>();
+  ResultTable* table = result.get();
+  ad_utility::GrowingMemory growingResult(
+      getExecutionContext()->getQueryMemoryTracker().get(),
+      [table]() { return table->getMinMemoryUsage(); });
+  restricted.computeResult(table);
+  return trackResultMemory(result, &growingResult);
+}
+
 // _____________________________________________________________________________
 void IndexScan::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "IndexScan result computation...\n";
@@ -145,7 +176,8 @@ void IndexScan::computePSOboundS(ResultTable* result) const {
   result->_fixedSizeData = new vector<array<Id, 1>>();
   _executionContext->getIndex().scanPSO(
       _predicate, _subject,
-      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -157,7 +189,8 @@ void IndexScan::computePSOfreeS(ResultTable* result) const {
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
   _executionContext->getIndex().scanPSO(
-      _predicate, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      _predicate, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -169,7 +202,8 @@ void IndexScan::computePOSboundO(ResultTable* result) const {
   result->_fixedSizeData = new vector<array<Id, 1>>();
   _executionContext->getIndex().scanPOS(
       _predicate, _object,
-      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -181,7 +215,8 @@ void IndexScan::computePOSfreeO(ResultTable* result) const {
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
   _executionContext->getIndex().scanPOS(
-      _predicate, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      _predicate, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -203,7 +238,8 @@ void IndexScan::computeSPOfreeP(ResultTable* result) const {
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
   _executionContext->getIndex().scanSPO(
-      _subject, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      _subject, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -215,7 +251,8 @@ void IndexScan::computeSOPboundO(ResultTable* result) const {
   result->_fixedSizeData = new vector<array<Id, 1>>();
   _executionContext->getIndex().scanSOP(
       _subject, _object,
-      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+      static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -227,7 +264,8 @@ void IndexScan::computeSOPfreeO(ResultTable* result) const {
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
   _executionContext->getIndex().scanSOP(
-      _subject, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      _subject, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -239,7 +277,8 @@ void IndexScan::computeOPSfreeP(ResultTable* result) const {
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
   _executionContext->getIndex().scanOPS(
-      _object, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      _object, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
@@ -251,7 +290,8 @@ void IndexScan::computeOSPfreeS(ResultTable* result) const {
   result->_sortedBy = 0;
   result->_fixedSizeData = new vector<array<Id, 2>>();
   _executionContext->getIndex().scanOSP(
-      _object, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      _object, static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+      _filter);
   result->finish();
 }
 
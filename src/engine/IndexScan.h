@@ -4,6 +4,7 @@
 #pragma once
 
 #include <string>
+#include "../index/ScanFilter.h"
 #include "../util/Conversions.h"
 #include "./Operation.h"
 
@@ -50,22 +51,67 @@ class IndexScan : public Operation {
     }
   }
 
+  // Restricts the values of one result column to those matching the
+  // given comparison with a constant id. The filter is evaluated while the
+  // relation is read. Returns false if the filter could not be added, in
+  // which case it has to be applied by a separate Filter operation.
+  bool addFilter(size_t column, SparqlFilter::FilterType type, Id value);
+
+  const ScanFilter& getFilter() const { return _filter; }
+
+  // Computes the result restricted to rows whose value in the given column
+  // may be one of the keys (rows without such a value may remain). The
+  // restriction is applied while reading. Such a partial result is not
+  // cached, but a cached full result is returned if present.
+  shared_ptr<const ResultTable> getResultForKeys(
+      size_t column, std::shared_ptr<const JoinKeyFilter> keys) const;
+
+  // The number of rows the scan reads, from the metadata of the relation in
+  // the index. A filter does not reduce it, it only drops rows while reading.
+  // Only defined for scans with a result width of at least two.
+  size_t getRelationSize() { return getUnfilteredSizeEstimate(); }
+
   virtual size_t getResultWidth() const;
 
   virtual size_t resultSortedOn() const { return 0; }
 
+  // The rows come from a permutation and are sorted by all columns.
+  virtual vector<size_t> resultSortedOnColumns() const {
+    vector<size_t> cols;
+    for (size_t i = 0; i < getResultWidth(); ++i) {
+      cols.push_back(i);
+    }
+    return cols;
+  }
+
   virtual void setTextLimit(size_t) {
     // Do nothing.
   }
 
   virtual size_t getSizeEstimate() {
-    if (_sizeEstimate == std::numeric_limits<size_t>::max()) {
-      _sizeEstimate = computeSizeEstimate();
+    if (_filter.empty()) {
+      return getUnfilteredSizeEstimate();
     }
-    return _sizeEstimate;
+    // Same heuristics as for a Filter with a fixed right hand side.
+    if (_filter.acceptsNothing()) {
+      return 0;
+    }
+    if (_filter.isEquality()) {
+      return getUnfilteredSizeEstimate() / 1000;
+    }
+    if (_filter.isRange()) {
+      return getUnfilteredSizeEstimate() / 50;
+    }
+    return getUnfilteredSizeEstimate();
   }
 
-  virtual size_t getCostEstimate() { return getSizeEstimate(); }
+  // The whole relation has to be read even if a filter is present.
+  virtual size_t getCostEstimate() {
+    if (_filter.empty()) {
+      return getSizeEstimate();
+    }
+    return getUnfilteredSizeEstimate() + getSizeEstimate();
+  }
 
   void determineMultiplicities();
 
@@ -79,7 +125,9 @@ class IndexScan : public Operation {
 
   void precomputeSizeEstimate() { _sizeEstimate = computeSizeEstimate(); }
 
-  virtual bool knownEmptyResult() { return getSizeEstimate() == 0; }
+  virtual bool knownEmptyResult() {
+    return getUnfilteredSizeEstimate() == 0 || _filter.acceptsNothing();
+  }
 
   ScanType getType() const { return _type; }
 
@@ -90,6 +138,14 @@ class IndexScan : public Operation {
   string _object;
   size_t _sizeEstimate;
   vector<float> _multiplicity;
+  ScanFilter _filter;
+
+  size_t getUnfilteredSizeEstimate() {
+    if (_sizeEstimate == std::numeric_limits<size_t>::max()) {
+      _sizeEstimate = computeSizeEstimate();
+    }
+    return _sizeEstimate;
+  }
 
   virtual void computeResult(ResultTable* result) const;
 
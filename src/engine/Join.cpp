@@ -27,6 +27,7 @@ Join::Join(QueryExecutionContext* qec, std::shared_ptr<QueryExecutionTree> t1,
     _rightJoinCol = t1JoinCol;
   }
   _keepJoinColumn = keepJoinColumn;
+  _mergeOnly = false;
   _sizeEstimate = 0;
   _sizeEstimateComputed = false;
   _multiplicities.clear();
@@ -48,6 +49,23 @@ string Join::asString(size_t indent) const {
   return os.str();
 }
 
+// _____________________________________________________________________________
+shared_ptr<ResultIterator> Join::getResultIterator(bool cacheResult) const {
+  shared_ptr<const ResultTable> cached = getCachedResult();
+  if (cached) {
+    return iterateCachedResult(cached);
+  }
+  // Joins with a dummy scan the relation for each join value, this is only
+  // implemented on materialized results.
+  if (isFullScanDummy(_left) || isFullScanDummy(_right) || !_keepJoinColumn) {
+    return Operation::getResultIterator(cacheResult);
+  }
+  return recordRuntimeInfo(std::make_shared<MergeJoinResultIterator>(
+      _left->getRootOperation()->getResultIterator(cacheResult),
+      _right->getRootOperation()->getResultIterator(cacheResult), _leftJoinCol,
+      _rightJoinCol));
+}
+
 // _____________________________________________________________________________
 void Join::computeResult(ResultTable* result) const {
   LOG(DEBUG) << "Getting sub-results for join result computation..." << endl;
@@ -82,11 +100,41 @@ void Join::computeResult(ResultTable* result) const {
     return;
   }
 
-  shared_ptr<const ResultTable> leftRes =
-      _left->getRootOperation()->getResult();
+  shared_ptr<const ResultTable> leftRes;
+  shared_ptr<const ResultTable> rightRes;
+  if (!_mergeOnly && isLargeScan(_right, _left)) {
+    leftRes = _left->getRootOperation()->getResult();
+    rightRes =
+        computeScanForJoin(*leftRes, _leftJoinCol, _right, _rightJoinCol);
+  } else if (!_mergeOnly && isLargeScan(_left, _right)) {
+    rightRes = _right->getRootOperation()->getResult();
+    leftRes =
+        computeScanForJoin(*rightRes, _rightJoinCol, _left, _leftJoinCol);
+  } else if (isMuchCheaper(_left, _right)) {
+    leftRes = _left->getRootOperation()->getResult();
+    if (leftRes->size() > 0) {
+      rightRes = _right->getRootOperation()->getResult();
+    }
+  } else if (isMuchCheaper(_right, _left)) {
+    rightRes = _right->getRootOperation()->getResult();
+    if (rightRes->size() > 0) {
+      leftRes = _left->getRootOperation()->getResult();
+    }
+  } else {
+    // The subtrees are independent, compute them concurrently.
+    computeChildrenConcurrently(
+        {[this, &leftRes] {
+           leftRes = _left->getRootOperation()->getResult();
+         },
+         [this, &rightRes] {
+           rightRes = _right->getRootOperation()->getResult();
+         }});
+  }
 
-  // Check if we can stop early.
-  if (leftRes->size() == 0) {
+  // Check if we can stop early. One of the results is not computed if the
+  // other one is empty.
+  if (!leftRes || !rightRes || leftRes->size() == 0 ||
+      rightRes->size() == 0) {
     size_t resWidth = leftWidth + rightWidth - 1;
     result->_nofColumns = resWidth;
     result->_resultTypes.resize(result->_nofColumns);
@@ -106,11 +154,6 @@ void Join::computeResult(ResultTable* result) const {
     return;
   }
 
-  shared_ptr<const ResultTable> rightRes =
-      _right->getRootOperation()->getResult();
-
-  LOG(DEBUG) << "Join result computation..." << endl;
-
   AD_CHECK(result);
   AD_CHECK(!result->_fixedSizeData);
 
@@ -126,256 +169,291 @@ void Join::computeResult(ResultTable* result) const {
   }
   result->_sortedBy = _leftJoinCol;
 
+  LOG(DEBUG) << "Join result computation..." << endl;
+  const char* algorithm = "none";
   if (leftWidth == 1) {
     if (rightWidth == 1) {
       result->_fixedSizeData = new vector<array<Id, 1>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 1>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 1>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 2) {
       result->_fixedSizeData = new vector<array<Id, 2>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 1>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 2>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 3) {
       result->_fixedSizeData = new vector<array<Id, 3>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 1>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 3>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 4) {
       result->_fixedSizeData = new vector<array<Id, 4>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 1>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 4>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 5) {
       result->_fixedSizeData = new vector<array<Id, 5>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 1>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 5>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 1>>*>(leftRes->_fixedSizeData),
           _leftJoinCol, rightRes->_varSizeData, _rightJoinCol,
-          &result->_varSizeData);
+          &result->_varSizeData, getCancellationHandle(), !_mergeOnly);
     }
   } else if (leftWidth == 2) {
     if (rightWidth == 1) {
       result->_fixedSizeData = new vector<array<Id, 2>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 2>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 1>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
       ;
     } else if (rightWidth == 2) {
       result->_fixedSizeData = new vector<array<Id, 3>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 2>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 2>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 3) {
       result->_fixedSizeData = new vector<array<Id, 4>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 2>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 3>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 4) {
       result->_fixedSizeData = new vector<array<Id, 5>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 2>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 4>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 5) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 2>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 5>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 2>>*>(leftRes->_fixedSizeData),
           _leftJoinCol, rightRes->_varSizeData, _rightJoinCol,
-          &result->_varSizeData);
+          &result->_varSizeData, getCancellationHandle(), !_mergeOnly);
     }
   } else if (leftWidth == 3) {
     if (rightWidth == 1) {
       result->_fixedSizeData = new vector<array<Id, 3>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 3>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 1>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 2) {
       result->_fixedSizeData = new vector<array<Id, 4>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 3>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 2>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 3) {
       result->_fixedSizeData = new vector<array<Id, 5>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 3>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 3>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 4) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 3>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 4>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 5) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 3>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 5>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 3>>*>(leftRes->_fixedSizeData),
           _leftJoinCol, rightRes->_varSizeData, _rightJoinCol,
-          &result->_varSizeData);
+          &result->_varSizeData, getCancellationHandle(), !_mergeOnly);
     }
   } else if (leftWidth == 4) {
     if (rightWidth == 1) {
       result->_fixedSizeData = new vector<array<Id, 4>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 4>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 1>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 2) {
       result->_fixedSizeData = new vector<array<Id, 5>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 4>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 2>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 3) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 4>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 3>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 4) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 4>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 4>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 5) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 4>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 5>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 4>>*>(leftRes->_fixedSizeData),
           _leftJoinCol, rightRes->_varSizeData, _rightJoinCol,
-          &result->_varSizeData);
+          &result->_varSizeData, getCancellationHandle(), !_mergeOnly);
     }
   } else if (leftWidth == 5) {
     if (rightWidth == 1) {
       result->_fixedSizeData = new vector<array<Id, 5>>();
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 5>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 1>>*>(rightRes->_fixedSizeData),
           _rightJoinCol,
-          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+          static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData),
+          getCancellationHandle(), !_mergeOnly);
     } else if (rightWidth == 2) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 5>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 2>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 3) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 5>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 3>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 4) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 5>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 4>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 5) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 5>>*>(leftRes->_fixedSizeData),
           _leftJoinCol,
           *static_cast<const vector<array<Id, 5>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           *static_cast<const vector<array<Id, 5>>*>(leftRes->_fixedSizeData),
           _leftJoinCol, rightRes->_varSizeData, _rightJoinCol,
-          &result->_varSizeData);
+          &result->_varSizeData, getCancellationHandle(), !_mergeOnly);
     }
   } else {
     if (rightWidth == 1) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           leftRes->_varSizeData, _leftJoinCol,
           *static_cast<const vector<array<Id, 1>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 2) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           leftRes->_varSizeData, _leftJoinCol,
           *static_cast<const vector<array<Id, 2>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 3) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           leftRes->_varSizeData, _leftJoinCol,
           *static_cast<const vector<array<Id, 3>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 4) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           leftRes->_varSizeData, _leftJoinCol,
           *static_cast<const vector<array<Id, 4>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else if (rightWidth == 5) {
-      _executionContext->getEngine().join(
+      algorithm = _executionContext->getEngine().join(
           leftRes->_varSizeData, _leftJoinCol,
           *static_cast<const vector<array<Id, 5>>*>(rightRes->_fixedSizeData),
-          _rightJoinCol, &result->_varSizeData);
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     } else {
-      _executionContext->getEngine().join(leftRes->_varSizeData, _leftJoinCol,
-                                          rightRes->_varSizeData, _rightJoinCol,
-                                          &result->_varSizeData);
+      algorithm = _executionContext->getEngine().join(
+          leftRes->_varSizeData, _leftJoinCol, rightRes->_varSizeData,
+          _rightJoinCol, &result->_varSizeData, getCancellationHandle(),
+          !_mergeOnly);
     }
   }
+  _runtimeInfo.addDetail("algorithm", algorithm);
   result->finish();
-  LOG(DEBUG) << "Join result computation done." << endl;
+  LOG(DEBUG) << "Join result computation done (" << _runtimeInfo.asString()
+             << ")." << endl;
 }
 
 // _____________________________________________________________________________
@@ -461,7 +539,12 @@ size_t Join::getCostEstimate() {
       _executionContext
           ? _executionContext->getCostFactor("DISK_RANDOM_ACCESS_COST")
           : 200000;
-  size_t costJoin;
+  double joinCostPerRow =
+      _executionContext ? _executionContext->getCostFactor("JOIN_COST_PER_ROW")
+                        : 1;
+  size_t costJoin = 0;
+  // The rows the join itself reads and writes.
+  size_t joinRows = getSizeEstimate();
   if (isFullScanDummy(_left)) {
     size_t nofDistinctTabJc = static_cast<size_t>(
         _right->getSizeEstimate() / _right->getMultiplicity(_rightJoinCol));
@@ -477,10 +560,56 @@ size_t Join::getCostEstimate() {
                static_cast<size_t>(diskRandomAccessCost + averageScanSize);
   } else {
     // Normal case:
-    costJoin = _left->getSizeEstimate() + _right->getSizeEstimate();
+    joinRows += _left->getSizeEstimate() + _right->getSizeEstimate();
+  }
+  return static_cast<size_t>(joinCostPerRow * joinRows) +
+         _left->getCostEstimate() + _right->getCostEstimate() + costJoin;
+}
+
+// _____________________________________________________________________________
+bool Join::isLargeScan(std::shared_ptr<QueryExecutionTree> scanTree,
+                       std::shared_ptr<QueryExecutionTree> other) {
+  // Scans of width one are computed when they are planned.
+  if (scanTree->getType() != QueryExecutionTree::SCAN ||
+      scanTree->getResultWidth() != 2) {
+    return false;
+  }
+  size_t relationSize =
+      static_cast<IndexScan*>(scanTree->getRootOperation().get())
+          ->getRelationSize();
+  return relationSize >= ADAPTIVE_JOIN_MIN_SCAN_SIZE &&
+         other->getSizeEstimate() <=
+             relationSize / JOIN_KEY_FILTER_MIN_SIZE_RATIO;
+}
+
+// _____________________________________________________________________________
+bool Join::isMuchCheaper(std::shared_ptr<QueryExecutionTree> tree,
+                         std::shared_ptr<QueryExecutionTree> other) {
+  return tree->getSizeEstimate() == 0 ||
+         tree->getCostEstimate() * SEQUENTIAL_JOIN_COST_RATIO <
+             other->getCostEstimate();
+}
+
+// _____________________________________________________________________________
+shared_ptr<const ResultTable> Join::computeScanForJoin(
+    const ResultTable& keysFrom, size_t keyCol,
+    std::shared_ptr<QueryExecutionTree> scanTree, size_t scanCol) const {
+  IndexScan& scan =
+      *static_cast<IndexScan*>(scanTree->getRootOperation().get());
+  if (keysFrom.size() * JOIN_KEY_FILTER_MIN_SIZE_RATIO >
+      scan.getRelationSize()) {
+    _runtimeInfo.addDetail("scan", "full");
+    return scan.getResult();
+  }
+  _runtimeInfo.addDetail("scan", "restricted to join keys");
+  RowAccess rows(keysFrom);
+  vector<Id> keys;
+  keys.reserve(rows.size());
+  for (size_t i = 0; i < rows.size(); ++i) {
+    keys.push_back(rows[i][keyCol]);
   }
-  return getSizeEstimate() + _left->getCostEstimate() +
-         _right->getCostEstimate() + costJoin;
+  return scan.getResultForKeys(scanCol,
+                               std::make_shared<const JoinKeyFilter>(keys));
 }
 
 // _____________________________________________________________________________
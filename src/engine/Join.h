@@ -48,10 +48,36 @@ class Join : public Operation {
     return _left->knownEmptyResult() || _right->knownEmptyResult();
   }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_left.get(), _right.get()};
+  }
+
   void computeSizeEstimateAndMultiplicities();
 
   virtual float getMultiplicity(size_t col);
 
+  std::shared_ptr<QueryExecutionTree> getLeft() const { return _left; }
+
+  std::shared_ptr<QueryExecutionTree> getRight() const { return _right; }
+
+  size_t getLeftJoinCol() const { return _leftJoinCol; }
+
+  size_t getRightJoinCol() const { return _rightJoinCol; }
+
+  bool keepsJoinColumn() const { return _keepJoinColumn; }
+
+  // Always compute both inputs completely and merge them, instead of
+  // restricting a large scan to the join keys or galloping. The cost estimate
+  // models this case, so it is used to calibrate the cost factors.
+  void setMergeOnly(bool mergeOnly) { _mergeOnly = mergeOnly; }
+
+  bool involvesFullScanDummy() const {
+    return isFullScanDummy(_left) || isFullScanDummy(_right);
+  }
+
+  virtual shared_ptr<ResultIterator> getResultIterator(
+      bool cacheResult = true) const;
+
  private:
   std::shared_ptr<QueryExecutionTree> _left;
   std::shared_ptr<QueryExecutionTree> _right;
@@ -60,6 +86,7 @@ class Join : public Operation {
   size_t _rightJoinCol;
 
   bool _keepJoinColumn;
+  bool _mergeOnly;
 
   bool _sizeEstimateComputed;
   size_t _sizeEstimate;
@@ -75,6 +102,32 @@ class Join : public Operation {
 
   void computeResultForJoinWithFullScanDummy(ResultTable* result) const;
 
+  // Both inputs of a join are sorted on the join column, so they are merged,
+  // or the larger one is galloped through if their actual sizes differ a lot
+  // (see Engine::join). A hash join does not pay off on sorted inputs and is
+  // not offered. Neither the sortedness nor the distribution of the join keys
+  // is taken into account, only the sizes of the inputs.
+
+  // True iff the subtree is a large index scan that is expected to be much
+  // larger than the other subtree, such that restricting it to the join keys
+  // of the other subtree pays off. Then the other subtree is computed first
+  // and its actual size decides whether the scan is restricted.
+  static bool isLargeScan(std::shared_ptr<QueryExecutionTree> scanTree,
+                          std::shared_ptr<QueryExecutionTree> other);
+
+  // True iff the subtree is expected to be empty or much cheaper than the
+  // other one. Then it is computed first, and the other one only if its
+  // result is not empty. Otherwise both are computed concurrently.
+  static bool isMuchCheaper(std::shared_ptr<QueryExecutionTree> tree,
+                            std::shared_ptr<QueryExecutionTree> other);
+
+  // Computes the result of the scan, where keysFrom is the result of the
+  // other input. If the scan is much larger, it only reads rows that match a
+  // join key of keysFrom.
+  shared_ptr<const ResultTable> computeScanForJoin(
+      const ResultTable& keysFrom, size_t keyCol,
+      std::shared_ptr<QueryExecutionTree> scanTree, size_t scanCol) const;
+
   typedef void (Index::*ScanMethodType)(Id, Index::WidthTwoList*) const;
 
   ScanMethodType getScanMethod(
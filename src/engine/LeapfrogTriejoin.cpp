@@ -0,0 +1,285 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include "./LeapfrogTriejoin.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using std::string;
+
+// _____________________________________________________________________________
+LeapfrogTriejoin::LeapfrogTriejoin(
+    QueryExecutionContext* qec,
+    const vector<std::shared_ptr<QueryExecutionTree>>& children,
+    const vector<string>& variableOrder)
+    : Operation(qec), _children(children), _variableOrder(variableOrder) {
+  // Make sure children are ordered so that identical queries can be
+  // identified.
+  std::sort(_children.begin(), _children.end(),
+            [](const std::shared_ptr<QueryExecutionTree>& a,
+               const std::shared_ptr<QueryExecutionTree>& b) {
+              return a->asString() < b->asString();
+            });
+  std::unordered_map<string, size_t> varIndex = getVariableColumns();
+  for (const auto& child : _children) {
+    AD_CHECK_EQ(child->getResultWidth(), 2);
+    array<size_t, 2> cols{{varIndex.size(), varIndex.size()}};
+    for (const auto& vc : child->getVariableColumnMap()) {
+      auto it = varIndex.find(vc.first);
+      if (it != varIndex.end() && vc.second < 2) {
+        cols[vc.second] = it->second;
+      }
+    }
+    if (cols[0] >= cols[1] || cols[1] >= varIndex.size()) {
+      AD_THROW(ad_semsearch::Exception::CHECK_FAILED,
+               "Each input of a leapfrog triejoin needs two distinct "
+               "variables, ordered like the join variables.");
+    }
+    _childColumns.push_back(cols);
+  }
+}
+
+// _____________________________________________________________________________
+string LeapfrogTriejoin::asString(size_t indent) const {
+  std::ostringstream os;
+  for (size_t i = 0; i < indent; ++i) {
+    os << " ";
+  }
+  os << "LEAPFROG_TRIEJOIN on";
+  for (const auto& var : _variableOrder) {
+    os << ' ' << var;
+  }
+  for (size_t i = 0; i < _children.size(); ++i) {
+    os << "\n" << _children[i]->asString(indent) << " vars: ["
+       << _childColumns[i][0] << " & " << _childColumns[i][1] << "]";
+  }
+  return os.str();
+}
+
+// _____________________________________________________________________________
+std::unordered_map<string, size_t> LeapfrogTriejoin::getVariableColumns()
+    const {
+  std::unordered_map<string, size_t> retVal;
+  for (size_t i = 0; i < _variableOrder.size(); ++i) {
+    retVal[_variableOrder[i]] = i;
+  }
+  return retVal;
+}
+
+// _____________________________________________________________________________
+size_t LeapfrogTriejoin::getSizeEstimate() {
+  // Every variable of a cyclic pattern occurs in at least two inputs, hence
+  // weighting each input with 1/2 is a fractional edge cover and the square
+  // root of the product of the input sizes bounds the result size (AGM bound).
+  // This bound is far too pessimistic in practice, so it is only used to
+  // cap the size of the smallest input.
+  double logBound = 0;
+  size_t minSize = std::numeric_limits<size_t>::max();
+  for (auto& child : _children) {
+    size_t size = child->getSizeEstimate();
+    logBound += 0.5 * std::log(std::max(size_t(1), size));
+    minSize = std::min(minSize, size);
+  }
+  if (_children.empty()) {
+    return 0;
+  }
+  double bound = std::exp(logBound);
+  return static_cast<size_t>(std::min(bound, static_cast<double>(minSize)));
+}
+
+// _____________________________________________________________________________
+size_t LeapfrogTriejoin::getCostEstimate() {
+  // Each input is read once, there are no intermediate results.
+  size_t cost = getSizeEstimate();
+  for (auto& child : _children) {
+    cost += child->getSizeEstimate() + child->getCostEstimate();
+  }
+  return cost;
+}
+
+// _____________________________________________________________________________
+float LeapfrogTriejoin::getMultiplicity(size_t col) {
+  if (_multiplicities.empty()) {
+    _multiplicities.resize(getResultWidth(), 1);
+    for (size_t i = 0; i < _children.size(); ++i) {
+      for (size_t c = 0; c < 2; ++c) {
+        size_t var = _childColumns[i][c];
+        _multiplicities[var] =
+            std::max(_multiplicities[var], _children[i]->getMultiplicity(c));
+      }
+    }
+  }
+  return _multiplicities[col];
+}
+
+// _____________________________________________________________________________
+size_t LeapfrogTriejoin::seek(const Cursor& cursor, size_t col, size_t pos,
+                              Id key) {
+  // Galloping search from the current position: the next key usually is
+  // close, which keeps the total work linear in the size of the inputs.
+  const vector<array<Id, 2>>& list = *cursor._list;
+  size_t step = 1;
+  size_t low = pos;
+  size_t high = pos;
+  while (high < cursor._end && list[high][col] < key) {
+    low = high + 1;
+    high += step;
+    step *= 2;
+  }
+  high = std::min(high, cursor._end);
+  return std::lower_bound(list.begin() + low, list.begin() + high, key,
+                          [col](const array<Id, 2>& row, Id k) {
+                            return row[col] < k;
+                          }) -
+         list.begin();
+}
+
+// _____________________________________________________________________________
+template <typename Row>
+void LeapfrogTriejoin::leapfrog(size_t depth,
+                                const Participants& participants,
+                                vector<Cursor>* cursors, vector<Id>* tuple,
+                                vector<Row>* result) {
+  if (depth == participants.size()) {
+    appendRow(*tuple, result);
+    return;
+  }
+  const vector<pair<size_t, size_t>>& parts = participants[depth];
+  vector<size_t> pos(parts.size());
+  for (size_t i = 0; i < parts.size(); ++i) {
+    pos[i] = (*cursors)[parts[i].first]._begin;
+    if (pos[i] >= (*cursors)[parts[i].first]._end) {
+      return;
+    }
+  }
+  while (true) {
+    Id key = 0;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      const Cursor& c = (*cursors)[parts[i].first];
+      key = std::max(key, (*c._list)[pos[i]][parts[i].second]);
+    }
+    bool agreed = true;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      const Cursor& c = (*cursors)[parts[i].first];
+      pos[i] = seek(c, parts[i].second, pos[i], key);
+      if (pos[i] >= c._end) {
+        return;
+      }
+      if ((*c._list)[pos[i]][parts[i].second] != key) {
+        agreed = false;
+      }
+    }
+    if (!agreed) {
+      continue;
+    }
+    // All inputs contain the key. Restrict them to the matching rows,
+    // descend and restore them afterwards.
+    vector<Cursor> saved;
+    saved.reserve(parts.size());
+    vector<size_t> next(parts.size());
+    for (size_t i = 0; i < parts.size(); ++i) {
+      Cursor& c = (*cursors)[parts[i].first];
+      saved.push_back(c);
+      next[i] = key == std::numeric_limits<Id>::max()
+                    ? c._end
+                    : seek(c, parts[i].second, pos[i], key + 1);
+      c._begin = pos[i];
+      c._end = next[i];
+    }
+    (*tuple)[depth] = key;
+    leapfrog(depth + 1, participants, cursors, tuple, result);
+    bool done = false;
+    for (size_t i = 0; i < parts.size(); ++i) {
+      (*cursors)[parts[i].first] = saved[i];
+      pos[i] = next[i];
+      done = done || pos[i] >= saved[i]._end;
+    }
+    if (done) {
+      return;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+template <typename Row>
+void LeapfrogTriejoin::joinLists(
+    const vector<const vector<array<Id, 2>>*>& lists,
+    const vector<array<size_t, 2>>& columns, size_t nofVars,
+    vector<Row>* result) {
+  AD_CHECK_EQ(lists.size(), columns.size());
+  vector<Cursor> cursors;
+  Participants participants(nofVars);
+  for (size_t i = 0; i < lists.size(); ++i) {
+    cursors.push_back(Cursor{lists[i], 0, lists[i]->size()});
+    participants[columns[i][0]].emplace_back(i, 0);
+    participants[columns[i][1]].emplace_back(i, 1);
+  }
+  for (size_t i = 0; i < nofVars; ++i) {
+    AD_CHECK(participants[i].size() > 0);
+  }
+  vector<Id> tuple(nofVars);
+  leapfrog(0, participants, &cursors, &tuple, result);
+}
+
+// _____________________________________________________________________________
+void LeapfrogTriejoin::join(const vector<const vector<array<Id, 2>>*>& lists,
+                            const vector<array<size_t, 2>>& columns,
+                            size_t nofVars, vector<vector<Id>>* result) {
+  joinLists(lists, columns, nofVars, result);
+}
+
+// _____________________________________________________________________________
+void LeapfrogTriejoin::computeResult(ResultTable* result) const {
+  LOG(DEBUG) << "Leapfrog triejoin result computation..." << endl;
+  // The inputs are independent, compute them concurrently.
+  vector<shared_ptr<const ResultTable>> childResults(_children.size());
+  vector<std::function<void()>> computeChildren;
+  for (size_t i = 0; i < _children.size(); ++i) {
+    computeChildren.push_back([this, i, &childResults] {
+      childResults[i] = _children[i]->getResult();
+    });
+  }
+  computeChildrenConcurrently(computeChildren);
+  vector<const vector<array<Id, 2>>*> lists;
+  for (const auto& childResult : childResults) {
+    lists.push_back(
+        static_cast<const vector<array<Id, 2>>*>(childResult->_fixedSizeData));
+  }
+  size_t width = getResultWidth();
+  result->_nofColumns = width;
+  result->_sortedBy = 0;
+  result->_resultTypes.resize(width, ResultTable::ResultType::KB);
+  switch (width) {
+    case 1:
+      result->_fixedSizeData = new vector<array<Id, 1>>();
+      joinLists(lists, _childColumns, width,
+                static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+      break;
+    case 2:
+      result->_fixedSizeData = new vector<array<Id, 2>>();
+      joinLists(lists, _childColumns, width,
+                static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      break;
+    case 3:
+      result->_fixedSizeData = new vector<array<Id, 3>>();
+      joinLists(lists, _childColumns, width,
+                static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData));
+      break;
+    case 4:
+      result->_fixedSizeData = new vector<array<Id, 4>>();
+      joinLists(lists, _childColumns, width,
+                static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+      break;
+    case 5:
+      result->_fixedSizeData = new vector<array<Id, 5>>();
+      joinLists(lists, _childColumns, width,
+                static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+      break;
+    default:
+      joinLists(lists, _childColumns, width, &result->_varSizeData);
+      break;
+  }
+  result->finish();
+  LOG(DEBUG) << "Leapfrog triejoin result computation done." << endl;
+}
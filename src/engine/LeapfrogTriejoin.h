@@ -0,0 +1,119 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "./Operation.h"
+#include "./QueryExecutionTree.h"
+
+using std::array;
+using std::string;
+using std::vector;
+
+// Worst-case optimal join of several two-column inputs (usually full
+// relation scans) that share variables in a cyclic way, e.g. the triangle
+// ?a <p> ?b . ?b <p> ?c . ?a <p> ?c.
+// The join binds one variable after the other (in the given variable order)
+// and finds the values of each variable by leapfrogging over all inputs that
+// contain it. Every input has to be sorted lexicographically on (0, 1) and
+// its first column has to precede its second column in the variable order,
+// which for index scans can always be achieved by picking the right
+// permutation.
+class LeapfrogTriejoin : public Operation {
+ public:
+  LeapfrogTriejoin(QueryExecutionContext* qec,
+                   const vector<std::shared_ptr<QueryExecutionTree>>& children,
+                   const vector<string>& variableOrder);
+
+  virtual string asString(size_t indent = 0) const;
+
+  virtual size_t getResultWidth() const { return _variableOrder.size(); }
+
+  // The result is sorted lexicographically in the variable order.
+  virtual size_t resultSortedOn() const { return 0; }
+
+  std::unordered_map<string, size_t> getVariableColumns() const;
+
+  virtual void setTextLimit(size_t limit) {
+    for (auto& child : _children) {
+      child->setTextLimit(limit);
+    }
+  }
+
+  virtual size_t getSizeEstimate();
+
+  virtual size_t getCostEstimate();
+
+  virtual float getMultiplicity(size_t col);
+
+  virtual bool knownEmptyResult() {
+    for (auto& child : _children) {
+      if (child->knownEmptyResult()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    vector<QueryExecutionTree*> children;
+    for (const auto& child : _children) {
+      children.push_back(child.get());
+    }
+    return children;
+  }
+
+  // Computes the join of the given sorted two-column lists. The columns of
+  // list i are bound to the variables with the indices in columns[i].
+  // Exposed for testing.
+  static void join(const vector<const vector<array<Id, 2>>*>& lists,
+                   const vector<array<size_t, 2>>& columns, size_t nofVars,
+                   vector<vector<Id>>* result);
+
+ private:
+  vector<std::shared_ptr<QueryExecutionTree>> _children;
+  vector<string> _variableOrder;
+  // For each child the indices (in _variableOrder) of its two columns.
+  vector<array<size_t, 2>> _childColumns;
+  vector<float> _multiplicities;
+
+  // The part of a sorted list that is currently considered by the join.
+  struct Cursor {
+    const vector<array<Id, 2>>* _list;
+    size_t _begin;
+    size_t _end;
+  };
+
+  // For each level, the cursors that are restricted by that variable together
+  // with the column they contain it in.
+  typedef vector<vector<pair<size_t, size_t>>> Participants;
+
+  template <typename Row>
+  static void leapfrog(size_t depth, const Participants& participants,
+                       vector<Cursor>* cursors, vector<Id>* tuple,
+                       vector<Row>* result);
+
+  static size_t seek(const Cursor& cursor, size_t col, size_t pos, Id key);
+
+  template <size_t N>
+  static void appendRow(const vector<Id>& tuple, vector<array<Id, N>>* res) {
+    array<Id, N> row;
+    std::copy(tuple.begin(), tuple.end(), row.begin());
+    res->push_back(row);
+  }
+
+  static void appendRow(const vector<Id>& tuple, vector<vector<Id>>* res) {
+    res->push_back(tuple);
+  }
+
+  template <typename Row>
+  static void joinLists(const vector<const vector<array<Id, 2>>*>& lists,
+                        const vector<array<size_t, 2>>& columns,
+                        size_t nofVars, vector<Row>* result);
+
+  virtual void computeResult(ResultTable* result) const;
+};
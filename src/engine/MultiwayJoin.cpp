@@ -0,0 +1,381 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include "./MultiwayJoin.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using std::string;
+
+// _____________________________________________________________________________
+MultiwayJoin::MultiwayJoin(
+    QueryExecutionContext* qec,
+    const vector<std::shared_ptr<QueryExecutionTree>>& children,
+    const vector<size_t>& joinColumns)
+    : Operation(qec), _sizeEstimateComputed(false), _sizeEstimate(0) {
+  AD_CHECK_EQ(children.size(), joinColumns.size());
+  AD_CHECK(children.size() >= 2);
+  // Make sure children are ordered so that identical queries can be
+  // identified.
+  vector<size_t> order(children.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  vector<string> keys;
+  for (const auto& child : children) {
+    keys.push_back(child->asString());
+  }
+  std::sort(order.begin(), order.end(), [&keys](size_t a, size_t b) {
+    return keys[a] < keys[b];
+  });
+  for (size_t i : order) {
+    _children.push_back(children[i]);
+    _joinColumns.push_back(joinColumns[i]);
+  }
+}
+
+// _____________________________________________________________________________
+string MultiwayJoin::asString(size_t indent) const {
+  std::ostringstream os;
+  for (size_t i = 0; i < indent; ++i) {
+    os << " ";
+  }
+  os << "MULTIWAY_JOIN";
+  for (size_t i = 0; i < _children.size(); ++i) {
+    os << "\n"
+       << _children[i]->asString(indent) << " join-column: ["
+       << _joinColumns[i] << "]";
+  }
+  return os.str();
+}
+
+// _____________________________________________________________________________
+size_t MultiwayJoin::getResultWidth() const {
+  size_t width = 1;
+  for (const auto& child : _children) {
+    width += child->getResultWidth() - 1;
+  }
+  return width;
+}
+
+// _____________________________________________________________________________
+std::unordered_map<string, size_t> MultiwayJoin::getVariableColumns() const {
+  std::unordered_map<string, size_t> retVal =
+      _children[0]->getVariableColumnMap();
+  size_t offset = _children[0]->getResultWidth();
+  for (size_t i = 1; i < _children.size(); ++i) {
+    for (const auto& vc : _children[i]->getVariableColumnMap()) {
+      if (vc.second < _joinColumns[i]) {
+        retVal[vc.first] = offset + vc.second;
+      } else if (vc.second > _joinColumns[i]) {
+        retVal[vc.first] = offset + vc.second - 1;
+      }
+    }
+    offset += _children[i]->getResultWidth() - 1;
+  }
+  return retVal;
+}
+
+// _____________________________________________________________________________
+std::unordered_set<string> MultiwayJoin::getContextVars() const {
+  std::unordered_set<string> cvars;
+  for (const auto& child : _children) {
+    cvars.insert(child->getContextVars().begin(),
+                 child->getContextVars().end());
+  }
+  return cvars;
+}
+
+// _____________________________________________________________________________
+float MultiwayJoin::getMultiplicity(size_t col) {
+  if (_multiplicities.size() == 0) {
+    computeSizeEstimateAndMultiplicities();
+    _sizeEstimateComputed = true;
+  }
+  return _multiplicities[col];
+}
+
+// _____________________________________________________________________________
+size_t MultiwayJoin::getCostEstimate() {
+  // Like a chain of binary joins, but without the intermediate results.
+  size_t cost = getSizeEstimate();
+  for (auto& child : _children) {
+    cost += child->getSizeEstimate() + child->getCostEstimate();
+  }
+  return cost;
+}
+
+// _____________________________________________________________________________
+void MultiwayJoin::computeSizeEstimateAndMultiplicities() {
+  // Uses the same model as Join, applied to all inputs at once, so that the
+  // estimates are comparable to those of the equivalent chain of joins.
+  _multiplicities.clear();
+  size_t k = _children.size();
+  bool anyEmpty = false;
+  for (auto& child : _children) {
+    anyEmpty = anyEmpty || child->getSizeEstimate() == 0;
+  }
+  if (anyEmpty) {
+    _sizeEstimate = 0;
+    _multiplicities.resize(getResultWidth(), 1);
+    return;
+  }
+
+  vector<size_t> nofDistinct(k);
+  size_t nofDistinctInResult = std::numeric_limits<size_t>::max();
+  double jcMultiplicityInResult = 1;
+  for (size_t i = 0; i < k; ++i) {
+    float jcMult = _children[i]->getMultiplicity(_joinColumns[i]);
+    nofDistinct[i] = std::max(
+        size_t(1),
+        static_cast<size_t>(_children[i]->getSizeEstimate() / jcMult));
+    nofDistinctInResult = std::min(nofDistinctInResult, nofDistinct[i]);
+    jcMultiplicityInResult *= jcMult;
+  }
+
+  double corrFactor =
+      _executionContext ? std::pow(_executionContext->getCostFactor(
+                                       "JOIN_SIZE_ESTIMATE_CORRECTION_FACTOR"),
+                                   static_cast<double>(k - 1))
+                        : 1;
+  _sizeEstimate = std::max(
+      size_t(1), static_cast<size_t>(corrFactor * jcMultiplicityInResult *
+                                     nofDistinctInResult));
+
+  LOG(TRACE) << "Estimated size as: " << _sizeEstimate << " := " << corrFactor
+             << " * " << jcMultiplicityInResult << " * " << nofDistinctInResult
+             << std::endl;
+
+  for (size_t i = 0; i < k; ++i) {
+    const auto& child = _children[i];
+    double otherJcMult =
+        jcMultiplicityInResult / child->getMultiplicity(_joinColumns[i]);
+    double adaptSize = child->getSizeEstimate() *
+                       (static_cast<double>(nofDistinctInResult) /
+                        nofDistinct[i]);
+    for (size_t c = 0; c < child->getResultWidth(); ++c) {
+      if (i > 0 && c == _joinColumns[i]) {
+        continue;
+      }
+      double oldMult = child->getMultiplicity(c);
+      double m = std::max(1.0, oldMult * otherJcMult * corrFactor);
+      if (c != _joinColumns[i] && nofDistinct[i] != nofDistinctInResult) {
+        double oldDist = child->getSizeEstimate() / oldMult;
+        double newDist = std::min(oldDist, adaptSize);
+        m = (_sizeEstimate / corrFactor) / newDist;
+      }
+      _multiplicities.emplace_back(m);
+    }
+  }
+  assert(_multiplicities.size() == getResultWidth());
+}
+
+// _____________________________________________________________________________
+size_t MultiwayJoin::seek(const RowAccess& input, size_t col, size_t pos,
+                          Id key) {
+  // Galloping search, most of the time the next key is close by.
+  size_t step = 1;
+  size_t low = pos;
+  size_t high = pos;
+  while (high < input.size() && input[high][col] < key) {
+    low = high + 1;
+    high += step;
+    step *= 2;
+  }
+  high = std::min(high, input.size());
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (input[mid][col] < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low;
+}
+
+// _____________________________________________________________________________
+template <typename Row>
+void MultiwayJoin::doJoin(const vector<RowAccess>& inputs,
+                          const vector<size_t>& joinColumns, size_t width,
+                          vector<Row>* result) {
+  size_t k = inputs.size();
+  vector<size_t> pos(k, 0);
+  vector<size_t> end(k, 0);
+  for (size_t i = 0; i < k; ++i) {
+    if (inputs[i].size() == 0) {
+      return;
+    }
+  }
+  vector<size_t> cur(k);
+  vector<Id> row(width);
+  while (true) {
+    // Leapfrog: advance all inputs to the largest current key until they
+    // agree.
+    Id key = 0;
+    for (size_t i = 0; i < k; ++i) {
+      key = std::max(key, inputs[i][pos[i]][joinColumns[i]]);
+    }
+    bool agreed = true;
+    for (size_t i = 0; i < k; ++i) {
+      pos[i] = seek(inputs[i], joinColumns[i], pos[i], key);
+      if (pos[i] >= inputs[i].size()) {
+        return;
+      }
+      if (inputs[i][pos[i]][joinColumns[i]] != key) {
+        agreed = false;
+      }
+    }
+    if (!agreed) {
+      continue;
+    }
+    for (size_t i = 0; i < k; ++i) {
+      end[i] = pos[i] + 1;
+      while (end[i] < inputs[i].size() &&
+             inputs[i][end[i]][joinColumns[i]] == key) {
+        ++end[i];
+      }
+    }
+    // Append the cross product of the matching blocks, the last input
+    // varies fastest.
+    cur = pos;
+    while (true) {
+      size_t out = 0;
+      for (size_t i = 0; i < k; ++i) {
+        const Id* in = inputs[i][cur[i]];
+        for (size_t c = 0; c < inputs[i].width(); ++c) {
+          if (i == 0 || c != joinColumns[i]) {
+            row[out++] = in[c];
+          }
+        }
+      }
+      appendRow(row, result);
+      size_t i = k;
+      while (i > 0 && ++cur[i - 1] == end[i - 1]) {
+        cur[i - 1] = pos[i - 1];
+        --i;
+      }
+      if (i == 0) {
+        break;
+      }
+    }
+    bool done = false;
+    for (size_t i = 0; i < k; ++i) {
+      pos[i] = end[i];
+      done = done || pos[i] >= inputs[i].size();
+    }
+    if (done) {
+      return;
+    }
+  }
+}
+
+// _____________________________________________________________________________
+void MultiwayJoin::join(const vector<const ResultTable*>& inputs,
+                        const vector<size_t>& joinColumns,
+                        ResultTable* result) {
+  AD_CHECK_EQ(inputs.size(), joinColumns.size());
+  AD_CHECK(result);
+  AD_CHECK(!result->_fixedSizeData);
+  vector<RowAccess> rows;
+  size_t width = 1;
+  result->_resultTypes.clear();
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    rows.emplace_back(*inputs[i]);
+    width += inputs[i]->_nofColumns - 1;
+    for (size_t c = 0; c < inputs[i]->_nofColumns; ++c) {
+      if (i == 0 || c != joinColumns[i]) {
+        result->_resultTypes.push_back(inputs[i]->getResultType(c));
+      }
+    }
+  }
+  result->_nofColumns = width;
+  result->_sortedBy = joinColumns[0];
+  switch (width) {
+    case 1:
+      result->_fixedSizeData = new vector<array<Id, 1>>();
+      doJoin(rows, joinColumns, width,
+             static_cast<vector<array<Id, 1>>*>(result->_fixedSizeData));
+      break;
+    case 2:
+      result->_fixedSizeData = new vector<array<Id, 2>>();
+      doJoin(rows, joinColumns, width,
+             static_cast<vector<array<Id, 2>>*>(result->_fixedSizeData));
+      break;
+    case 3:
+      result->_fixedSizeData = new vector<array<Id, 3>>();
+      doJoin(rows, joinColumns, width,
+             static_cast<vector<array<Id, 3>>*>(result->_fixedSizeData));
+      break;
+    case 4:
+      result->_fixedSizeData = new vector<array<Id, 4>>();
+      doJoin(rows, joinColumns, width,
+             static_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+      break;
+    case 5:
+      result->_fixedSizeData = new vector<array<Id, 5>>();
+      doJoin(rows, joinColumns, width,
+             static_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+      break;
+    default:
+      doJoin(rows, joinColumns, width, &result->_varSizeData);
+      break;
+  }
+}
+
+// _____________________________________________________________________________
+void MultiwayJoin::computeResult(ResultTable* result) const {
+  LOG(DEBUG) << "Getting sub-results for multiway join result computation..."
+             << endl;
+  vector<shared_ptr<const ResultTable>> childResults(_children.size());
+  vector<const ResultTable*> inputs;
+  bool empty = false;
+  for (const auto& child : _children) {
+    empty = empty || child->knownEmptyResult();
+  }
+  if (!empty) {
+    // The inputs are independent, compute them concurrently.
+    vector<std::function<void()>> computeChildren;
+    for (size_t i = 0; i < _children.size(); ++i) {
+      computeChildren.push_back([this, i, &childResults] {
+        childResults[i] = _children[i]->getResult();
+      });
+    }
+    computeChildrenConcurrently(computeChildren);
+    for (const auto& res : childResults) {
+      empty = empty || res->size() == 0;
+    }
+  }
+  if (empty) {
+    result->_nofColumns = getResultWidth();
+    result->_resultTypes.resize(result->_nofColumns);
+    result->_sortedBy = _joinColumns[0];
+    switch (result->_nofColumns) {
+      case 1:
+        result->_fixedSizeData = new vector<array<Id, 1>>();
+        break;
+      case 2:
+        result->_fixedSizeData = new vector<array<Id, 2>>();
+        break;
+      case 3:
+        result->_fixedSizeData = new vector<array<Id, 3>>();
+        break;
+      case 4:
+        result->_fixedSizeData = new vector<array<Id, 4>>();
+        break;
+      case 5:
+        result->_fixedSizeData = new vector<array<Id, 5>>();
+        break;
+    }
+    result->finish();
+    return;
+  }
+  for (const auto& res : childResults) {
+    inputs.push_back(res.get());
+  }
+  LOG(DEBUG) << "Multiway join result computation..." << endl;
+  join(inputs, _joinColumns, result);
+  result->finish();
+  LOG(DEBUG) << "Multiway join result computation done." << endl;
+}
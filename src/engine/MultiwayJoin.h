@@ -0,0 +1,116 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "./Operation.h"
+#include "./QueryExecutionTree.h"
+
+using std::string;
+using std::vector;
+
+// Joins an arbitrary number of inputs on a single variable in one pass, e.g.
+// the arms of a star ?x <p1> ?a . ?x <p2> ?b . ?x <p3> ?c.
+// Every input has to be sorted on its join column. The result consists of all
+// columns of the first input followed by the columns of the other inputs
+// without their join column, and is sorted on the join column of the first
+// input. In contrast to a chain of binary joins no intermediate results are
+// materialized.
+class MultiwayJoin : public Operation {
+ public:
+  MultiwayJoin(QueryExecutionContext* qec,
+               const vector<std::shared_ptr<QueryExecutionTree>>& children,
+               const vector<size_t>& joinColumns);
+
+  virtual string asString(size_t indent = 0) const;
+
+  virtual size_t getResultWidth() const;
+
+  virtual size_t resultSortedOn() const { return _joinColumns[0]; }
+
+  std::unordered_map<string, size_t> getVariableColumns() const;
+
+  std::unordered_set<string> getContextVars() const;
+
+  virtual void setTextLimit(size_t limit) {
+    for (auto& child : _children) {
+      child->setTextLimit(limit);
+    }
+    _sizeEstimateComputed = false;
+  }
+
+  virtual size_t getSizeEstimate() {
+    if (!_sizeEstimateComputed) {
+      computeSizeEstimateAndMultiplicities();
+      _sizeEstimateComputed = true;
+    }
+    return _sizeEstimate;
+  }
+
+  virtual size_t getCostEstimate();
+
+  virtual float getMultiplicity(size_t col);
+
+  virtual bool knownEmptyResult() {
+    for (auto& child : _children) {
+      if (child->knownEmptyResult()) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    vector<QueryExecutionTree*> children;
+    for (const auto& child : _children) {
+      children.push_back(child.get());
+    }
+    return children;
+  }
+
+  const vector<std::shared_ptr<QueryExecutionTree>>& getInputs() const {
+    return _children;
+  }
+
+  const vector<size_t>& getJoinColumns() const { return _joinColumns; }
+
+  // Joins the given inputs, each of which has to be sorted on its join
+  // column, and writes the (unfinished) result to result.
+  // Exposed for testing.
+  static void join(const vector<const ResultTable*>& inputs,
+                   const vector<size_t>& joinColumns, ResultTable* result);
+
+ private:
+  vector<std::shared_ptr<QueryExecutionTree>> _children;
+  vector<size_t> _joinColumns;
+
+  bool _sizeEstimateComputed;
+  size_t _sizeEstimate;
+  vector<float> _multiplicities;
+
+  void computeSizeEstimateAndMultiplicities();
+
+  virtual void computeResult(ResultTable* result) const;
+
+  template <typename Row>
+  static void doJoin(const vector<RowAccess>& inputs,
+                     const vector<size_t>& joinColumns, size_t width,
+                     vector<Row>* result);
+
+  static size_t seek(const RowAccess& input, size_t col, size_t pos, Id key);
+
+  template <size_t N>
+  static void appendRow(const vector<Id>& row, vector<array<Id, N>>* res) {
+    array<Id, N> entry;
+    std::copy(row.begin(), row.end(), entry.begin());
+    res->push_back(entry);
+  }
+
+  static void appendRow(const vector<Id>& row, vector<vector<Id>>* res) {
+    res->push_back(row);
+  }
+};
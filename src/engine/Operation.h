@@ -3,17 +3,27 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "../util/Exception.h"
+#include "../util/ExternalSorter.h"
 #include "../util/Log.h"
+#include "../util/TaskScheduler.h"
+#include "../util/Timer.h"
 #include "./QueryExecutionContext.h"
+#include "./ResultIterator.h"
 #include "./ResultTable.h"
+#include "./RuntimeInformation.h"
 
 using std::endl;
 using std::pair;
 using std::shared_ptr;
+using std::vector;
+
+class QueryExecutionTree;
 
 class Operation {
  public:
@@ -34,6 +44,7 @@ class Operation {
   // Use existing results if they are already available, otherwise
   // trigger computation.
   shared_ptr<const ResultTable> getResult() const {
+    _executionContext->getCancellationHandle()->check();
     LOG(TRACE) << "Try to atomically emplace a new empty ResultTable" << endl;
     LOG(TRACE) << "Using key: \n" << asString() << endl;
     // TODO(schnelle) with C++17 we can use nice decomposition here
@@ -42,16 +53,56 @@ class Operation {
     if (emplacePair.first) {
       LOG(DEBUG) << "We were the first to emplace, need to compute result"
                  << endl;
-      // Passing the raw pointer here is ok as the result shared_ptr remains
-      // in scope
-      computeResult(emplacePair.first.get());
-      return emplacePair.first;
+      try {
+        double msecs;
+        shared_ptr<const ResultTable> result =
+            computeTrackedResult(emplacePair.first, &msecs);
+        // The time is the cost of computing the result again.
+        _executionContext->getQueryTreeCache().updateSize(
+            asString(), emplacePair.first->getTrackedMemoryUsage(), msecs);
+        return result;
+      } catch (...) {
+        // Never leave an unfinished result in the cache, other threads would
+        // wait for it forever. The entry may have been evicted and replaced
+        // by another query in the meantime, which must not be removed.
+        _executionContext->getQueryTreeCache().erase(asString(),
+                                                     emplacePair.first);
+        emplacePair.first->abort();
+        throw;
+      }
     }
     LOG(INFO) << "Result already (being) computed" << endl;
     emplacePair.second->awaitFinished();
+    if (emplacePair.second->isAborted()) {
+      // The computing query failed or was cancelled and has removed the
+      // entry from the cache, compute the result for this query instead.
+      LOG(DEBUG) << "Computation by another query was aborted" << endl;
+      return getResult();
+    }
+    recordCachedResult(*emplacePair.second);
     return emplacePair.second;
   }
 
+  // Get the result for the subtree rooted at this element block by block.
+  // Operations that can compute their result incrementally override this,
+  // by default the (possibly cached) result is materialized first. Callers
+  // that read the result only once pass cacheResult = false, then a result
+  // that has to be materialized is not cached but released after reading.
+  virtual shared_ptr<ResultIterator> getResultIterator(
+      bool cacheResult = true) const {
+    if (cacheResult) {
+      return std::make_shared<MaterializedResultIterator>(getResult());
+    }
+    shared_ptr<const ResultTable> cached = getCachedResult();
+    if (cached) {
+      return iterateCachedResult(cached);
+    }
+    _executionContext->getCancellationHandle()->check();
+    double msecs;
+    return std::make_shared<MaterializedResultIterator>(
+        computeTrackedResult(std::make_shared<ResultTable>(), &msecs));
+  }
+
   //! Set the QueryExecutionContext for this particular element.
   void setQueryExecutionContext(QueryExecutionContext* executionContext) {
     _executionContext = executionContext;
@@ -59,6 +110,22 @@ class Operation {
 
   const Index& getIndex() const { return _executionContext->getIndex(); }
 
+  // Information recorded while computing the result of this operation. Only
+  // the size of the result is known if it was taken from the cache.
+  const RuntimeInformation& getRuntimeInfo() const { return _runtimeInfo; }
+
+  // Keeps the size estimate of the planner in the runtime information. It
+  // has to be taken before the execution, afterwards the estimates of
+  // subtrees that were computed are their observed sizes.
+  void recordSizeEstimate(size_t sizeEstimate) const {
+    _runtimeInfo.setSizeEstimate(sizeEstimate);
+  }
+
+  // The trees whose results are the inputs of this operation.
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return vector<QueryExecutionTree*>();
+  }
+
   const Engine& getEngine() const { return _executionContext->getEngine(); }
 
   // Get a unique, not ambiguous string representation for a subtree.
@@ -66,6 +133,18 @@ class Operation {
   virtual string asString(size_t indent = 0) const = 0;
   virtual size_t getResultWidth() const = 0;
   virtual size_t resultSortedOn() const = 0;
+
+  // The columns by which the result is sorted lexicographically, most
+  // significant first, or nothing if it is not sorted. Unless an operation
+  // knows better this is only the column from resultSortedOn().
+  virtual vector<size_t> resultSortedOnColumns() const {
+    size_t col = resultSortedOn();
+    if (col >= getResultWidth()) {
+      return vector<size_t>();
+    }
+    return vector<size_t>(1, col);
+  }
+
   virtual void setTextLimit(size_t limit) = 0;
   virtual size_t getCostEstimate() = 0;
   virtual size_t getSizeEstimate() = 0;
@@ -77,12 +156,192 @@ class Operation {
     return _executionContext;
   }
 
+  // Returns the result of this operation if it has already been computed
+  // completely and is still cached, a null pointer otherwise. Used to avoid
+  // incremental recomputation of results that are available anyway.
+  shared_ptr<const ResultTable> getCachedResult() const {
+    shared_ptr<const ResultTable> cached =
+        _executionContext->getQueryTreeCache()[asString()];
+    if (cached && cached->isFinished()) {
+      return cached;
+    }
+    return shared_ptr<const ResultTable>();
+  }
+
+  // Iterates over the cached result of this operation.
+  shared_ptr<ResultIterator> iterateCachedResult(
+      shared_ptr<const ResultTable> cached) const {
+    recordCachedResult(*cached);
+    return std::make_shared<MaterializedResultIterator>(cached);
+  }
+
+  // Records a result taken from the cache in the runtime information. Its
+  // memory was measured by the query that computed it. If that query has not
+  // accounted for it yet, only the lower bound that is cheap to get is used.
+  void recordCachedResult(const ResultTable& cached) const {
+    size_t bytes = cached.getTrackedMemoryUsage();
+    if (bytes == 0) {
+      bytes = cached.getMinMemoryUsage();
+    }
+    _runtimeInfo.setCached(cached.size(), cached._nofColumns, bytes);
+  }
+
+  // Wraps an iterator that computes the result of this operation block by
+  // block, so that the runtime information is recorded although the result
+  // is never materialized.
+  shared_ptr<ResultIterator> recordRuntimeInfo(
+      shared_ptr<ResultIterator> rows) const {
+    return std::make_shared<RuntimeInfoResultIterator>(rows, &_runtimeInfo);
+  }
+
+  // Computes the results of independent children at the same time.
+  void computeChildrenConcurrently(
+      const vector<std::function<void()>>& computeChildren) const {
+    ad_utility::TaskScheduler& scheduler = getTaskScheduler();
+    if (scheduler.getNofWorkers() > 0) {
+      _runtimeInfo.setChildrenComputedConcurrently();
+    }
+    scheduler.runInParallel(computeChildren);
+  }
+
+  // The workers for the parts of an operation that can run in parallel.
+  ad_utility::TaskScheduler& getTaskScheduler() const {
+    return _executionContext->getTaskScheduler();
+  }
+
+  // Accounts for the memory of a result computed by this operation, both in
+  // the budget of the current query and in the memory held by all results.
+  // The budget of the query was already charged for the growth of the result
+  // while it was computed. Throws if the budget of the query is exceeded.
+  // The memory is measured only here, everything else uses
+  // getTrackedMemoryUsage() of the result, since measuring looks at all rows
+  // of variable size. The returned pointer releases the charge of the query
+  // when the query drops it, even if the result stays in the cache.
+  shared_ptr<const ResultTable> trackResultMemory(
+      shared_ptr<ResultTable> result,
+      ad_utility::GrowingMemory* growingResult) const {
+    size_t bytes = result->getMemoryUsage();
+    growingResult->finish(bytes);
+    LOG(DEBUG) << "Result uses " << bytes << " bytes, query total is "
+               << _executionContext->getQueryMemoryTracker()->getBytesUsed()
+               << " bytes." << endl;
+    result->trackMemory(_executionContext->getResultMemoryTracker(), bytes);
+    return ad_utility::freeWhenReleased<const ResultTable>(
+        result, _executionContext->getQueryMemoryTracker(),
+        growingResult->getAccountedBytes());
+  }
+
+  // True if the result of input needs more memory than a sort may use. The
+  // actual size of the result is used if it is cached or was computed
+  // before, the estimate otherwise. Sorts and groupings then stream the input
+  // through an external sorter instead of materializing and caching their
+  // result. The sorter only writes to disk if the rows pushed into it
+  // actually exceed the memory.
+  bool needsExternalSort(const shared_ptr<Operation>& input) const {
+    size_t nofRows;
+    shared_ptr<const ResultTable> cached = input->getCachedResult();
+    if (cached) {
+      nofRows = cached->size();
+    } else if (!_executionContext->getObservedResultSize(input->asString(),
+                                                         &nofRows)) {
+      nofRows = input->getSizeEstimate();
+    }
+    double bytes =
+        static_cast<double>(nofRows) * input->getResultWidth() * sizeof(Id);
+    return bytes > _executionContext->getSortMemory();
+  }
+
+  // Sorts the result of input externally with the memory and temporary
+  // directory configured in the execution context. The input is read only
+  // once, so it is not cached.
+  shared_ptr<ExternalSortResultIterator> sortExternally(
+      const shared_ptr<Operation>& input,
+      ad_utility::ExternalSorter<Id>::Comparator lessThan) const {
+    return std::make_shared<ExternalSortResultIterator>(
+        input->getResultIterator(false), lessThan,
+        _executionContext->getSortMemory(),
+        _executionContext->getSortDirectory(), getCancellationHandle());
+  }
+
+  // Computes the result of a sort whose input is too large to be sorted in
+  // memory, see needsExternalSort: the input is streamed into an external
+  // sorter without being cached and the sorted rows are written to result.
+  // Returns false without touching result if the input has a local
+  // vocabulary, which is lost when streaming. The caller has to sort the
+  // materialized input then.
+  bool computeSortedExternally(
+      const shared_ptr<Operation>& input,
+      ad_utility::ExternalSorter<Id>::Comparator lessThan,
+      ResultTable* result) const {
+    shared_ptr<ResultIterator> rows = input->getResultIterator(false);
+    const vector<ResultTable::ResultType>& types = rows->getResultTypes();
+    if (std::find(types.begin(), types.end(),
+                  ResultTable::ResultType::LOCAL_VOCAB) != types.end()) {
+      return false;
+    }
+    ad_utility::ExternalSorter<Id> sorter(
+        rows->width(), lessThan, _executionContext->getSortMemory(),
+        _executionContext->getSortDirectory(), getCancellationHandle());
+    ResultBlock block(rows->width());
+    while (rows->nextBlock(&block)) {
+      for (size_t i = 0; i < block.size(); ++i) {
+        sorter.push(block[i]);
+      }
+    }
+    // Release the input, it might hold a materialized result.
+    rows.reset();
+    result->_nofColumns = types.size();
+    result->_resultTypes = types;
+    createRowStorage(result);
+    reserveRows(result, sorter.size());
+    const Id* row;
+    while ((row = sorter.next())) {
+      appendRow(result, row);
+    }
+    _runtimeInfo.addDetail("sort", "external");
+    LOG(DEBUG) << "Sorted " << sorter.size() << " rows externally in "
+               << sorter.getNofRuns() << " runs" << endl;
+    return true;
+  }
+
+  // To be passed to long running functions, see Engine.
+  const ad_utility::CancellationHandle* getCancellationHandle() const {
+    return _executionContext->getCancellationHandle();
+  }
+
   // The QueryExecutionContext for this particular element.
   // No ownership.
   QueryExecutionContext* _executionContext;
 
+  // Filled by computeResult, which is const.
+  mutable RuntimeInformation _runtimeInfo;
+
  private:
   //! Compute the result of the query-subtree rooted at this element..
   //! Computes both, an EntityList and a HitList.
   virtual void computeResult(ResultTable* result) const = 0;
+
+  // Computes the result, accounts for its memory and records the runtime
+  // information, see trackResultMemory for the returned pointer. Sets msecs
+  // to the time it took.
+  shared_ptr<const ResultTable> computeTrackedResult(
+      shared_ptr<ResultTable> result, double* msecs) const {
+    ad_utility::Timer timer;
+    timer.start();
+    ResultTable* table = result.get();
+    ad_utility::GrowingMemory growingResult(
+        _executionContext->getQueryMemoryTracker().get(),
+        [table]() { return table->getMinMemoryUsage(); });
+    computeResult(table);
+    timer.stop();
+    shared_ptr<const ResultTable> tracked =
+        trackResultMemory(result, &growingResult);
+    *msecs = timer.usecs() / 1000.0;
+    _runtimeInfo.setComputed(*msecs, result->size(), result->_nofColumns,
+                             result->getTrackedMemoryUsage());
+    if (result->isFinished()) {
+      _executionContext->recordResultSize(asString(), result->size());
+    }
+    return tracked;
+  }
 };
@@ -181,8 +181,12 @@ void OptionalJoin::computeResult(ResultTable* result) const {
 
   AD_CHECK_GE(result->_nofColumns, _joinColumns.size());
 
-  const auto leftResult = _left->getResult();
-  const auto rightResult = _right->getResult();
+  // The subtrees are independent, compute them concurrently.
+  shared_ptr<const ResultTable> leftResult;
+  shared_ptr<const ResultTable> rightResult;
+  computeChildrenConcurrently(
+      {[this, &leftResult] { leftResult = _left->getResult(); },
+       [this, &rightResult] { rightResult = _right->getResult(); }});
 
   // compute the result types
   result->_resultTypes.reserve(result->_nofColumns);
@@ -37,6 +37,10 @@ class OptionalJoin : public Operation {
            (_left->knownEmptyResult() && _right->knownEmptyResult());
   }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_left.get(), _right.get()};
+  }
+
   virtual float getMultiplicity(size_t col);
 
   virtual size_t getSizeEstimate();
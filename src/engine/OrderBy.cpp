@@ -36,10 +36,33 @@ string OrderBy::asString(size_t indent) const {
   return os.str();
 }
 
+// _____________________________________________________________________________
+shared_ptr<ResultIterator> OrderBy::getResultIterator(bool cacheResult) const {
+  shared_ptr<const ResultTable> cached = getCachedResult();
+  if (cached) {
+    return iterateCachedResult(cached);
+  }
+  if (!needsExternalSort(_subtree->getRootOperation())) {
+    return Operation::getResultIterator(cacheResult);
+  }
+  // The sorted rows are streamed, they are neither materialized nor cached.
+  return recordRuntimeInfo(sortExternally(_subtree->getRootOperation(),
+                                          OBComp<const Id*>(_sortIndices)));
+}
+
 // _____________________________________________________________________________
 void OrderBy::computeResult(ResultTable* result) const {
-  LOG(DEBUG) << "Gettign sub-result for OrderBy result computation..." << endl;
   AD_CHECK(_sortIndices.size() > 0);
+  size_t sortedBy =
+      _sortIndices[0].second ? getResultWidth() + 1 : _sortIndices[0].first;
+  if (needsExternalSort(_subtree->getRootOperation()) &&
+      computeSortedExternally(_subtree->getRootOperation(),
+                              OBComp<const Id*>(_sortIndices), result)) {
+    result->_sortedBy = sortedBy;
+    result->finish();
+    return;
+  }
+  LOG(DEBUG) << "Gettign sub-result for OrderBy result computation..." << endl;
   shared_ptr<const ResultTable> subRes = _subtree->getResult();
   LOG(DEBUG) << "OrderBy result computation..." << endl;
   result->_nofColumns = subRes->_nofColumns;
@@ -52,44 +75,49 @@ void OrderBy::computeResult(ResultTable* result) const {
       auto res = new vector<array<Id, 1>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 1>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, OBComp<array<Id, 1>>(_sortIndices));
+      getEngine().sort(*res, OBComp<array<Id, 1>>(_sortIndices),
+                       getCancellationHandle());
     } break;
     case 2: {
       auto res = new vector<array<Id, 2>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 2>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, OBComp<array<Id, 2>>(_sortIndices));
+      getEngine().sort(*res, OBComp<array<Id, 2>>(_sortIndices),
+                       getCancellationHandle());
       break;
     }
     case 3: {
       auto res = new vector<array<Id, 3>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 3>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, OBComp<array<Id, 3>>(_sortIndices));
+      getEngine().sort(*res, OBComp<array<Id, 3>>(_sortIndices),
+                       getCancellationHandle());
       break;
     }
     case 4: {
       auto res = new vector<array<Id, 4>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 4>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, OBComp<array<Id, 4>>(_sortIndices));
+      getEngine().sort(*res, OBComp<array<Id, 4>>(_sortIndices),
+                       getCancellationHandle());
       break;
     }
     case 5: {
       auto res = new vector<array<Id, 5>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 5>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, OBComp<array<Id, 5>>(_sortIndices));
+      getEngine().sort(*res, OBComp<array<Id, 5>>(_sortIndices),
+                       getCancellationHandle());
       break;
     }
     default: {
       result->_varSizeData = subRes->_varSizeData;
-      getEngine().sort(result->_varSizeData, OBComp<vector<Id>>(_sortIndices));
+      getEngine().sort(result->_varSizeData, OBComp<vector<Id>>(_sortIndices),
+                       getCancellationHandle());
       break;
     }
   }
-  result->_sortedBy = (_sortIndices[0].second ? result->_nofColumns + 1
-                                              : _sortIndices[0].first);
+  result->_sortedBy = sortedBy;
   result->finish();
   LOG(DEBUG) << "OrderBy result computation done." << endl;
 }
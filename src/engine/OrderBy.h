@@ -28,7 +28,22 @@ class OrderBy : public Operation {
   virtual string asString(size_t indent = 0) const;
 
   virtual size_t resultSortedOn() const {
-    return std::numeric_limits<size_t>::max();
+    if (_sortIndices.empty() || _sortIndices[0].second) {
+      return std::numeric_limits<size_t>::max();
+    }
+    return _sortIndices[0].first;
+  }
+
+  // The columns up to the first one ordered descendingly.
+  virtual vector<size_t> resultSortedOnColumns() const {
+    vector<size_t> cols;
+    for (const auto& sortIndex : _sortIndices) {
+      if (sortIndex.second) {
+        break;
+      }
+      cols.push_back(sortIndex.first);
+    }
+    return cols;
   }
 
   virtual void setTextLimit(size_t limit) { _subtree->setTextLimit(limit); }
@@ -46,11 +61,24 @@ class OrderBy : public Operation {
         static_cast<size_t>(logb(static_cast<double>(getSizeEstimate()))));
     size_t nlogn = size * logSize;
     size_t subcost = _subtree->getCostEstimate();
-    return nlogn + subcost;
+    double costPerRowAndLevel =
+        _executionContext
+            ? _executionContext->getCostFactor("SORT_COST_PER_ROW_AND_LEVEL")
+            : 1;
+    return static_cast<size_t>(costPerRowAndLevel * nlogn) + subcost;
   }
 
   virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
+  // Streams the sorted input from disk if it is too large to be sorted in
+  // memory.
+  virtual shared_ptr<ResultIterator> getResultIterator(
+      bool cacheResult = true) const;
+
  private:
   std::shared_ptr<QueryExecutionTree> _subtree;
   vector<pair<size_t, bool>> _sortIndices;
@@ -4,13 +4,18 @@
 
 #pragma once
 
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 #include "../global/Constants.h"
 #include "../index/Index.h"
+#include "../util/CancellationHandle.h"
 #include "../util/LRUCache.h"
 #include "../util/Log.h"
+#include "../util/MemoryTracker.h"
+#include "../util/TaskScheduler.h"
 #include "./Engine.h"
 #include "./ResultTable.h"
 #include "QueryPlanningCostFactors.h"
@@ -21,35 +26,179 @@ using std::vector;
 
 typedef ad_utility::LRUCache<string, ResultTable> SubtreeCache;
 
+// A join order chosen by the query planner, together with the estimated
+// sizes of the subtrees of the plan it was chosen for, by their cache keys.
+struct CachedPlan {
+  vector<uint64_t> _joinOrder;
+  vector<std::pair<string, size_t>> _sizeEstimates;
+};
+
+// Join orders chosen by the query planner, by the shape of the query.
+typedef ad_utility::LRUCache<string, CachedPlan> PlanCache;
+typedef ad_utility::LRUCache<string, size_t> CardinalityCache;
+
 // Execution context for queries.
-// Holds references to index and engine, implements caching.
+// Holds references to index and engine, implements caching, keeps track of
+// the memory held by results and allows to cancel the query.
 class QueryExecutionContext {
  public:
   QueryExecutionContext(const Index& index, const Engine& engine)
-      : _subtreeCache(NOF_SUBTREES_TO_CACHE),
+      : _subtreeCache(std::make_shared<SubtreeCache>(
+            NOF_SUBTREES_TO_CACHE, DEFAULT_CACHE_MEMORY_IN_GB << 30)),
+        _planCache(std::make_shared<PlanCache>(NOF_PLANS_TO_CACHE)),
+        _cardinalityCache(
+            std::make_shared<CardinalityCache>(NOF_CARDINALITIES_TO_CACHE)),
         _index(index),
         _engine(engine),
-        _costFactors() {}
+        _costFactors(),
+        _resultMemoryTracker(
+            std::make_shared<ad_utility::MemoryTracker>()),
+        _queryMemoryTracker(std::make_shared<ad_utility::MemoryTracker>()),
+        _cancellationHandle(
+            std::make_shared<ad_utility::CancellationHandle>()),
+        _sortMemory(DEFAULT_SORT_MEMORY_IN_GB << 30),
+        _sortDirectory(DEFAULT_SORT_DIRECTORY),
+        _taskScheduler() {}
+
+  // Context for a single query. Shares index, engine, cost factors, the caches
+  // and the memory held by results with the given context, but limits the
+  // memory of the results computed for this query to memoryLimit bytes and
+  // cancels the query timeoutInSeconds after its creation.
+  QueryExecutionContext(const QueryExecutionContext& shared,
+                        size_t memoryLimit, double timeoutInSeconds)
+      : _subtreeCache(shared._subtreeCache),
+        _planCache(shared._planCache),
+        _cardinalityCache(shared._cardinalityCache),
+        _index(shared._index),
+        _engine(shared._engine),
+        _costFactors(shared._costFactors),
+        _resultMemoryTracker(shared._resultMemoryTracker),
+        _queryMemoryTracker(std::make_shared<ad_utility::MemoryTracker>(
+            memoryLimit, "this query")),
+        _cancellationHandle(std::make_shared<ad_utility::CancellationHandle>(
+            timeoutInSeconds)),
+        _sortMemory(shared._sortMemory),
+        _sortDirectory(shared._sortDirectory),
+        _taskScheduler(shared._taskScheduler) {}
 
-  SubtreeCache& getQueryTreeCache() { return _subtreeCache; }
+  SubtreeCache& getQueryTreeCache() { return *_subtreeCache; }
 
   const Engine& getEngine() const { return _engine; }
 
   const Index& getIndex() const { return _index; }
 
-  void clearCache() { _subtreeCache.clear(); }
+  void clearCache() { _subtreeCache->clear(); }
+
+  // The cached results may use at most that many bytes together. Shared by
+  // all queries.
+  void setCacheMemory(size_t bytes) { _subtreeCache->setMaxSize(bytes); }
+
+  // How the results to evict from the cache are chosen. Under GDSF results
+  // that took long to compute relative to their size are kept longer.
+  void setCacheEvictionPolicy(ad_utility::EvictionPolicy policy) {
+    _subtreeCache->setEvictionPolicy(policy);
+  }
+
+  PlanCache& getPlanCache() { return *_planCache; }
 
+  // Remembers the actual size of the result with the given cache key, so
+  // that plans built later use it instead of an estimate. Results never
+  // change for a loaded index, so the first observation is kept.
+  void recordResultSize(const string& key, size_t size) {
+    _cardinalityCache->tryEmplace(key, size);
+  }
+
+  // Returns false if no result with the given cache key was computed yet.
+  bool getObservedResultSize(const string& key, size_t* size) const {
+    shared_ptr<const size_t> observed = (*_cardinalityCache)[key];
+    if (!observed) {
+      return false;
+    }
+    *size = *observed;
+    return true;
+  }
+
+  // True if a subtree of the plan has been computed since the plan was chosen
+  // and its actual size differs from the estimate by more than a factor of
+  // MAX_PLAN_ESTIMATE_ERROR.
+  bool isMisestimated(const CachedPlan& plan) const {
+    for (const auto& estimate : plan._sizeEstimates) {
+      size_t observed;
+      if (getObservedResultSize(estimate.first, &observed)) {
+        double larger = std::max(observed, estimate.second);
+        double smaller = std::max<size_t>(
+            std::min(observed, estimate.second), 1);
+        if (larger > MAX_PLAN_ESTIMATE_ERROR * smaller) {
+          return true;
+        }
+      }
+    }
+    return false;
+  }
+
+  // The cached join orders were chosen with the old cost factors.
   void readCostFactorsFromTSVFile(const string& fileName) {
     _costFactors.readFromFile(fileName);
+    _planCache->clear();
   }
 
   float getCostFactor(const string& key) const {
     return _costFactors.getCostFactor(key);
   };
 
+  // Bytes held by all results that are still referenced, either by the cache
+  // or by a running query. Shared by all queries.
+  const std::shared_ptr<ad_utility::MemoryTracker>& getResultMemoryTracker()
+      const {
+    return _resultMemoryTracker;
+  }
+
+  // Bytes of the results computed for the current query and its limit.
+  const std::shared_ptr<ad_utility::MemoryTracker>& getQueryMemoryTracker()
+      const {
+    return _queryMemoryTracker;
+  }
+
+  const ad_utility::CancellationHandle* getCancellationHandle() const {
+    return _cancellationHandle.get();
+  }
+
+  void cancel() { _cancellationHandle->cancel(); }
+
+  // Inputs of sorts that need more than memory bytes are sorted externally
+  // with temporary files in directory.
+  void setSortOptions(size_t memory, const string& directory) {
+    _sortMemory = memory;
+    _sortDirectory = directory;
+  }
+
+  size_t getSortMemory() const { return _sortMemory; }
+
+  const string& getSortDirectory() const { return _sortDirectory; }
+
+  // Independent parts of the queries are computed by a pool of nofWorkers
+  // threads shared by all queries, in addition to the thread of the query
+  // itself. By default the pool of the process is used, which has one
+  // worker per hardware thread.
+  void setNofWorkers(size_t nofWorkers) {
+    _taskScheduler = std::make_shared<ad_utility::TaskScheduler>(nofWorkers);
+  }
+
+  ad_utility::TaskScheduler& getTaskScheduler() const {
+    return _taskScheduler ? *_taskScheduler : ad_utility::TaskScheduler::get();
+  }
+
  private:
-  SubtreeCache _subtreeCache;
+  std::shared_ptr<SubtreeCache> _subtreeCache;
+  std::shared_ptr<PlanCache> _planCache;
+  std::shared_ptr<CardinalityCache> _cardinalityCache;
   const Index& _index;
   const Engine& _engine;
   QueryPlanningCostFactors _costFactors;
+  std::shared_ptr<ad_utility::MemoryTracker> _resultMemoryTracker;
+  std::shared_ptr<ad_utility::MemoryTracker> _queryMemoryTracker;
+  std::shared_ptr<ad_utility::CancellationHandle> _cancellationHandle;
+  size_t _sortMemory;
+  string _sortDirectory;
+  std::shared_ptr<ad_utility::TaskScheduler> _taskScheduler;
 };
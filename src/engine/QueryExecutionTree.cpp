@@ -89,12 +89,14 @@ void QueryExecutionTree::setVariableColumns(
 }
 
 // _____________________________________________________________________________
-void QueryExecutionTree::writeResultToStream(std::ostream& out,
-                                             const vector<string>& selectVars,
-                                             size_t limit, size_t offset,
-                                             char sep) const {
+size_t QueryExecutionTree::writeResultToStream(
+    std::ostream& out, const vector<string>& selectVars, size_t limit,
+    size_t offset, char sep) const {
   // They may trigger computation (but does not have to).
-  shared_ptr<const ResultTable> res = getResult();
+  shared_ptr<const ResultTable> res = getResultForOutput(
+      limit >= std::numeric_limits<size_t>::max() - offset
+          ? std::numeric_limits<size_t>::max()
+          : offset + limit);
   LOG(DEBUG) << "Resolving strings for finished binary result...\n";
   vector<pair<size_t, ResultTable::ResultType>> validIndices;
   for (auto var : selectVars) {
@@ -108,43 +110,48 @@ void QueryExecutionTree::writeResultToStream(std::ostream& out,
     }
   }
   if (validIndices.size() == 0) {
-    return;
+    return res->size();
   }
   if (res->_nofColumns == 1) {
     auto data = static_cast<vector<array<Id, 1>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeTable(*data, sep, offset, upperBound, validIndices, out);
+    writeTable(*res, *data, sep, offset, upperBound, validIndices, out);
   } else if (res->_nofColumns == 2) {
     auto data = static_cast<vector<array<Id, 2>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeTable(*data, sep, offset, upperBound, validIndices, out);
+    writeTable(*res, *data, sep, offset, upperBound, validIndices, out);
   } else if (res->_nofColumns == 3) {
     auto data = static_cast<vector<array<Id, 3>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeTable(*data, sep, offset, upperBound, validIndices, out);
+    writeTable(*res, *data, sep, offset, upperBound, validIndices, out);
   } else if (res->_nofColumns == 4) {
     auto data = static_cast<vector<array<Id, 4>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeTable(*data, sep, offset, upperBound, validIndices, out);
+    writeTable(*res, *data, sep, offset, upperBound, validIndices, out);
   } else if (res->_nofColumns == 5) {
     auto data = static_cast<vector<array<Id, 5>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeTable(*data, sep, offset, upperBound, validIndices, out);
+    writeTable(*res, *data, sep, offset, upperBound, validIndices, out);
   } else {
     size_t upperBound =
         std::min<size_t>(offset + limit, res->_varSizeData.size());
-    writeTable(res->_varSizeData, sep, offset, upperBound, validIndices, out);
+    writeTable(*res, res->_varSizeData, sep, offset, upperBound, validIndices,
+               out);
   }
   LOG(DEBUG) << "Done creating readable result.\n";
+  return res->size();
 }
 
 // _____________________________________________________________________________
-void QueryExecutionTree::writeResultToStreamAsJson(
+size_t QueryExecutionTree::writeResultToStreamAsJson(
     std::ostream& out, const vector<string>& selectVars, size_t limit,
     size_t offset, size_t maxSend) const {
   out << "[\r\n";
   // They may trigger computation (but does not have to).
-  shared_ptr<const ResultTable> res = getResult();
+  shared_ptr<const ResultTable> res = getResultForOutput(
+      limit >= std::numeric_limits<size_t>::max() - offset
+          ? std::numeric_limits<size_t>::max()
+          : offset + limit);
   LOG(DEBUG) << "Resolving strings for finished binary result...\n";
   vector<pair<size_t, ResultTable::ResultType>> validIndices;
   for (auto var : selectVars) {
@@ -159,36 +166,48 @@ void QueryExecutionTree::writeResultToStreamAsJson(
   }
   if (validIndices.size() == 0) {
     out << "]";
-    return;
+    return res->size();
   }
   if (res->_nofColumns == 1) {
     auto data = static_cast<vector<array<Id, 1>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeJsonTable(*data, offset, upperBound, validIndices, maxSend, out);
+    writeJsonTable(*res, *data, offset, upperBound, validIndices, maxSend, out);
   } else if (res->_nofColumns == 2) {
     auto data = static_cast<vector<array<Id, 2>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeJsonTable(*data, offset, upperBound, validIndices, maxSend, out);
+    writeJsonTable(*res, *data, offset, upperBound, validIndices, maxSend, out);
   } else if (res->_nofColumns == 3) {
     auto data = static_cast<vector<array<Id, 3>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeJsonTable(*data, offset, upperBound, validIndices, maxSend, out);
+    writeJsonTable(*res, *data, offset, upperBound, validIndices, maxSend, out);
   } else if (res->_nofColumns == 4) {
     auto data = static_cast<vector<array<Id, 4>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeJsonTable(*data, offset, upperBound, validIndices, maxSend, out);
+    writeJsonTable(*res, *data, offset, upperBound, validIndices, maxSend, out);
   } else if (res->_nofColumns == 5) {
     auto data = static_cast<vector<array<Id, 5>>*>(res->_fixedSizeData);
     size_t upperBound = std::min<size_t>(offset + limit, data->size());
-    writeJsonTable(*data, offset, upperBound, validIndices, maxSend, out);
+    writeJsonTable(*res, *data, offset, upperBound, validIndices, maxSend, out);
   } else {
     size_t upperBound =
         std::min<size_t>(offset + limit, res->_varSizeData.size());
-    writeJsonTable(res->_varSizeData, offset, upperBound, validIndices, maxSend,
-                   out);
+    writeJsonTable(*res, res->_varSizeData, offset, upperBound, validIndices,
+                   maxSend, out);
   }
   out << "]";
   LOG(DEBUG) << "Done creating readable result.\n";
+  return res->size();
+}
+
+// _____________________________________________________________________________
+shared_ptr<const ResultTable> QueryExecutionTree::getResultForOutput(
+    size_t nofRows) const {
+  if (nofRows >= MAX_NOF_ROWS_IN_RESULT) {
+    return getResult();
+  }
+  LOG(DEBUG) << "Computing the first " << nofRows << " rows of the result.\n";
+  return _rootOperation->getResultIterator()->materialize(
+      nofRows, _rootOperation->resultSortedOn());
 }
 
 // _____________________________________________________________________________
@@ -206,7 +225,9 @@ size_t QueryExecutionTree::getSizeEstimate() {
     if (_qec) {
       if (_type == QueryExecutionTree::SCAN && getResultWidth() == 1) {
         _sizeEstimate = getResult()->size();
-      } else {
+      } else if (!_qec->getObservedResultSize(_rootOperation->asString(),
+                                              &_sizeEstimate)) {
+        // The same subtree has not been computed before.
         _sizeEstimate = _rootOperation->getSizeEstimate();
       }
     } else {
@@ -222,6 +243,102 @@ size_t QueryExecutionTree::getSizeEstimate() {
 // _____________________________________________________________________________
 bool QueryExecutionTree::knownEmptyResult() { return getSizeEstimate() == 0; }
 
+// _____________________________________________________________________________
+void QueryExecutionTree::recordSizeEstimates() {
+  // The estimates of the children memoize their strings, which have to be
+  // indented as within this tree.
+  asString();
+  _rootOperation->recordSizeEstimate(getSizeEstimate());
+  for (QueryExecutionTree* child : _rootOperation->getChildren()) {
+    if (child) {
+      child->recordSizeEstimates();
+    }
+  }
+}
+
+// _____________________________________________________________________________
+RuntimeInformation QueryExecutionTree::getRuntimeInfo() {
+  RuntimeInformation info = _rootOperation->getRuntimeInfo();
+  vector<QueryExecutionTree*> children = _rootOperation->getChildren();
+  // The string of an inner operation contains its whole subtree, only the
+  // leaves are described by it.
+  info.setDescriptor(getTypeName(_type),
+                     children.empty() ? _rootOperation->asString() : "");
+  vector<string> columnNames(getResultWidth());
+  for (const auto& var : _variableColumnMap) {
+    if (var.second < columnNames.size()) {
+      columnNames[var.second] = var.first;
+    }
+  }
+  info.setColumnNames(columnNames);
+  info.setCostEstimate(getCostEstimate());
+  for (QueryExecutionTree* child : children) {
+    if (child) {
+      info.addChild(child->getRuntimeInfo());
+    }
+  }
+  return info;
+}
+
+// _____________________________________________________________________________
+string QueryExecutionTree::getTypeName(OperationType type) {
+  switch (type) {
+    case SCAN:
+      return "SCAN";
+    case JOIN:
+      return "JOIN";
+    case SORT:
+      return "SORT";
+    case ORDER_BY:
+      return "ORDER_BY";
+    case FILTER:
+      return "FILTER";
+    case DISTINCT:
+      return "DISTINCT";
+    case TEXT_FOR_CONTEXTS:
+      return "TEXT_FOR_CONTEXTS";
+    case TEXT_WITHOUT_FILTER:
+      return "TEXT_WITHOUT_FILTER";
+    case TEXT_WITH_FILTER:
+      return "TEXT_WITH_FILTER";
+    case TWO_COL_JOIN:
+      return "TWO_COL_JOIN";
+    case OPTIONAL_JOIN:
+      return "OPTIONAL_JOIN";
+    case COUNT_AVAILABLE_PREDICATES:
+      return "COUNT_AVAILABLE_PREDICATES";
+    case GROUP_BY:
+      return "GROUP_BY";
+    case HAS_RELATION_SCAN:
+      return "HAS_RELATION_SCAN";
+    case LEAPFROG_TRIEJOIN:
+      return "LEAPFROG_TRIEJOIN";
+    case MULTIWAY_JOIN:
+      return "MULTIWAY_JOIN";
+    case TOP_K:
+      return "TOP_K";
+    case HASH_DISTINCT:
+      return "HASH_DISTINCT";
+    default:
+      return "UNDEFINED";
+  }
+}
+
+// _____________________________________________________________________________
+bool QueryExecutionTree::isGroupedBy(const vector<size_t>& cols) const {
+  std::unordered_set<size_t> wanted(cols.begin(), cols.end());
+  vector<size_t> sortedOn = resultSortedOnColumns();
+  if (sortedOn.size() < wanted.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < wanted.size(); ++i) {
+    if (wanted.count(sortedOn[i]) == 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // _____________________________________________________________________________
 bool QueryExecutionTree::varCovered(string var) const {
   return _variableColumnMap.count(var) > 0;
@@ -37,7 +37,11 @@ class QueryExecutionTree {
     OPTIONAL_JOIN = 11,
     COUNT_AVAILABLE_PREDICATES = 12,
     GROUP_BY = 13,
-    HAS_RELATION_SCAN = 14
+    HAS_RELATION_SCAN = 14,
+    LEAPFROG_TRIEJOIN = 15,
+    MULTIWAY_JOIN = 16,
+    TOP_K = 17,
+    HASH_DISTINCT = 18
   };
 
   void setOperation(OperationType type, std::shared_ptr<Operation> op);
@@ -78,18 +82,30 @@ class QueryExecutionTree {
     return _rootOperation->getResult();
   }
 
-  void writeResultToStream(std::ostream& out, const vector<string>& selectVars,
-                           size_t limit = MAX_NOF_ROWS_IN_RESULT,
-                           size_t offset = 0, char sep = '\t') const;
+  // The writers return the number of rows of the result they computed. That
+  // is the size of the whole result if it was materialized, but only the
+  // first offset + limit rows if they could be computed incrementally.
+  size_t writeResultToStream(std::ostream& out,
+                             const vector<string>& selectVars,
+                             size_t limit = MAX_NOF_ROWS_IN_RESULT,
+                             size_t offset = 0, char sep = '\t') const;
 
-  void writeResultToStreamAsJson(std::ostream& out,
-                                 const vector<string>& selectVars,
-                                 size_t limit = MAX_NOF_ROWS_IN_RESULT,
-                                 size_t offset = 0,
-                                 size_t maxSend = MAX_NOF_ROWS_IN_RESULT) const;
+  size_t writeResultToStreamAsJson(
+      std::ostream& out, const vector<string>& selectVars,
+      size_t limit = MAX_NOF_ROWS_IN_RESULT, size_t offset = 0,
+      size_t maxSend = MAX_NOF_ROWS_IN_RESULT) const;
 
   size_t resultSortedOn() const { return _rootOperation->resultSortedOn(); }
 
+  vector<size_t> resultSortedOnColumns() const {
+    return _rootOperation->resultSortedOnColumns();
+  }
+
+  // True if the result is sorted such that rows with equal values in the
+  // given columns are adjacent, i.e. its first sort columns are exactly the
+  // given ones in any order.
+  bool isGroupedBy(const vector<size_t>& cols) const;
+
   bool isContextvar(const string& var) const {
     return _contextVars.count(var) > 0;
   }
@@ -120,6 +136,18 @@ class QueryExecutionTree {
 
   bool knownEmptyResult();
 
+  // Records the size estimates of all operations of this tree in their
+  // runtime information. Called by the planner for the final tree, before
+  // anything is computed.
+  void recordSizeEstimates();
+
+  // The runtime information of all operations of this tree, after its result
+  // has been computed. The size estimates are the ones recorded by
+  // recordSizeEstimates.
+  RuntimeInformation getRuntimeInfo();
+
+  static string getTypeName(OperationType type);
+
  private:
   QueryExecutionContext* _qec;  // No ownership
   std::unordered_map<string, size_t> _variableColumnMap;
@@ -130,13 +158,18 @@ class QueryExecutionTree {
   string _asString;
   size_t _sizeEstimate;
 
+  // Returns a table that contains at least the first nofRows rows of the
+  // result. For small numbers of rows only as much of the result is computed
+  // as needed (if the operations allow it).
+  shared_ptr<const ResultTable> getResultForOutput(size_t nofRows) const;
+
   template <typename Row>
   void writeJsonTable(
-      const vector<Row>& data, size_t from, size_t upperBound,
+      const ResultTable& res, const vector<Row>& data, size_t from,
+      size_t upperBound,
       const vector<pair<size_t, ResultTable::ResultType>>& validIndices,
       size_t maxSend, std::ostream& out) const {
     std::ostringstream throwaway;
-    shared_ptr<const ResultTable> res = getResult();
     for (size_t i = from; i < upperBound; ++i) {
       const auto& row = data[i];
       auto& os = (i < (maxSend + from) ? out : throwaway);
@@ -168,7 +201,7 @@ class QueryExecutionTree {
           }
           case ResultTable::ResultType::LOCAL_VOCAB: {
             os << ad_utility::escapeForJson(
-                      res->idToString(row[validIndices[j].first]))
+                      res.idToString(row[validIndices[j].first]))
                << "\",\"";
             break;
           }
@@ -203,7 +236,7 @@ class QueryExecutionTree {
           break;
         }
         case ResultTable::ResultType::LOCAL_VOCAB: {
-          os << ad_utility::escapeForJson(res->idToString(
+          os << ad_utility::escapeForJson(res.idToString(
                     row[validIndices[validIndices.size() - 1].first]))
              << "\"]";
           break;
@@ -221,10 +254,10 @@ class QueryExecutionTree {
 
   template <typename Row>
   void writeTable(
-      const vector<Row>& data, char sep, size_t from, size_t upperBound,
+      const ResultTable& res, const vector<Row>& data, char sep, size_t from,
+      size_t upperBound,
       const vector<pair<size_t, ResultTable::ResultType>>& validIndices,
       std::ostream& out) const {
-    shared_ptr<const ResultTable> res = getResult();
     for (size_t i = from; i < upperBound; ++i) {
       const auto& row = data[i];
       for (size_t j = 0; j < validIndices.size(); ++j) {
@@ -252,7 +285,7 @@ class QueryExecutionTree {
             break;
           }
           case ResultTable::ResultType::LOCAL_VOCAB: {
-            out << res->idToString(row[validIndices[j].first]);
+            out << res.idToString(row[validIndices[j].first]);
             break;
           }
           default:
@@ -4,29 +4,41 @@
 
 #include "./QueryPlanner.h"
 #include <algorithm>
+#include <chrono>
 #include "../parser/ParseException.h"
+#include "../util/TaskScheduler.h"
 #include "CountAvailablePredicates.h"
 #include "Distinct.h"
 #include "Filter.h"
 #include "GroupBy.h"
 #include "HasRelationScan.h"
+#include "HashDistinct.h"
 #include "IndexScan.h"
 #include "Join.h"
+#include "LeapfrogTriejoin.h"
+#include "MultiwayJoin.h"
 #include "OptionalJoin.h"
 #include "OrderBy.h"
 #include "Sort.h"
 #include "TextOperationWithFilter.h"
 #include "TextOperationWithoutFilter.h"
+#include "TopK.h"
 #include "TwoColumnJoin.h"
 
 // _____________________________________________________________________________
 QueryPlanner::QueryPlanner(QueryExecutionContext* qec, bool optimizeOptionals)
-    : _qec(qec), _optimizeOptionals(optimizeOptionals) {}
+    : _qec(qec),
+      _optimizeOptionals(optimizeOptionals),
+      _planCache(qec ? &qec->getPlanCache() : nullptr),
+      _maxExhaustivePlanningTimeInMs(MAX_EXHAUSTIVE_PLANNING_TIME_IN_MS),
+      _planningAlgorithm(PlanningAlgorithm::DYNAMIC_PROGRAMMING),
+      _exhaustivePlanningTimedOut(false) {}
 
 // _____________________________________________________________________________
 QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
   // Create a topological sorting of the tree where children are in the list
   // after their parents.
+  _planningAlgorithm = PlanningAlgorithm::DYNAMIC_PROGRAMMING;
   std::vector<const ParsedQuery::GraphPattern*> patternsToProcess;
   std::vector<const ParsedQuery::GraphPattern*> childrenToAdd;
   childrenToAdd.push_back(&pq._rootGraphPattern);
@@ -76,6 +88,24 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
     }
   }
 
+  // If the triple was the only one, the predicates of all entities are
+  // counted. Their counts are precomputed by the index and nothing else has
+  // to be planned.
+  bool countAllPredicates =
+      usePatternTrick && isVariable(patternTrickTriple._s) &&
+      pq._rootGraphPattern._whereClauseTriples.empty() &&
+      pq._rootGraphPattern._filters.empty() &&
+      pq._rootGraphPattern._children.empty();
+  if (countAllPredicates) {
+    patternsToProcess.clear();
+  }
+
+  // The join orders of the patterns are cached by the shape of the query.
+  string queryShape;
+  if (_planCache) {
+    queryShape = getQueryShape(pq);
+  }
+
   bool doGrouping = pq._groupByVariables.size() > 0 || usePatternTrick;
   if (!doGrouping) {
     // if there is no group by statement, but
@@ -153,7 +183,29 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
     // and will filter on one variable.
     // Cycles have to be avoided (by previously removing a triple and using it
     // as a filter later on).
-    finalTab = fillDpTab(tg, pattern->_filters, childPlans);
+    string planKey;
+    std::shared_ptr<const CachedPlan> cachedPlan;
+    if (_planCache) {
+      planKey = queryShape + " #" + std::to_string(pattern->_id);
+      cachedPlan = (*_planCache)[planKey];
+      if (cachedPlan && _qec && _qec->isMisestimated(*cachedPlan)) {
+        // The sizes the join order was chosen with were far off, the plan
+        // for the observed sizes replaces it.
+        LOG(DEBUG) << "The cached join order for pattern " << pattern->_id
+                   << " was chosen with misestimated sizes" << endl;
+        cachedPlan.reset();
+      }
+      if (cachedPlan) {
+        LOG(DEBUG) << "Using the cached join order for pattern "
+                   << pattern->_id << endl;
+        if (_planningAlgorithm == PlanningAlgorithm::DYNAMIC_PROGRAMMING) {
+          _planningAlgorithm = PlanningAlgorithm::CACHED_JOIN_ORDER;
+        }
+      }
+    }
+    _exhaustivePlanningTimedOut = false;
+    finalTab = fillDpTab(tg, pattern->_filters, childPlans,
+                         cachedPlan ? &cachedPlan->_joinOrder : nullptr);
 
     // If any form of grouping is used (e.g. the pattern trick) sorting
     // has to be done after the grouping.
@@ -179,6 +231,19 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
     }
     lastRow[minInd]._isOptional = pattern->_optional;
     patternPlans[pattern->_id] = lastRow[minInd];
+    if (_planCache && !_exhaustivePlanningTimedOut) {
+      vector<uint64_t> order = lastRow[minInd]._joinOrder;
+      std::sort(order.begin(), order.end());
+      // The cached join order is replaced if it was not used after all,
+      // e.g. because it did not fit the query.
+      if (!cachedPlan || cachedPlan->_joinOrder != order) {
+        CachedPlan newPlan;
+        newPlan._joinOrder = std::move(order);
+        collectSizeEstimates(lastRow[minInd]._qet.get(),
+                             &newPlan._sizeEstimates);
+        _planCache->insert(planKey, std::move(newPlan));
+      }
+    }
   }
 
   if (!_optimizeOptionals) {
@@ -237,7 +302,16 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
 
   SubtreePlan final = patternPlans[0];
 
-  if (usePatternTrick) {
+  if (countAllPredicates) {
+    SubtreePlan patternTrickPlan(_qec);
+    auto countPred = std::make_shared<CountAvailablePredicates>(_qec);
+    countPred->setVarNames(patternTrickTriple._o, pq._aliases[0]._outVarName);
+    QueryExecutionTree& tree = *patternTrickPlan._qet.get();
+    tree.setVariableColumns(countPred->getVariableColumns());
+    tree.setOperation(QueryExecutionTree::COUNT_AVAILABLE_PREDICATES,
+                      countPred);
+    final = patternTrickPlan;
+  } else if (usePatternTrick) {
     // Determine the column containing the subjects for which we are interested
     // in their predicates.
     auto it =
@@ -296,9 +370,11 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
     std::vector<std::pair<size_t, bool>> sortColumns =
         static_cast<GroupBy*>(groupBy.get())->computeSortColumns(final._qet);
 
-    if (!sortColumns.empty() &&
-        !(sortColumns.size() == 1 &&
-          final._qet->resultSortedOn() == sortColumns[0].first)) {
+    vector<size_t> groupColumns;
+    for (const auto& sortColumn : sortColumns) {
+      groupColumns.push_back(sortColumn.first);
+    }
+    if (!sortColumns.empty() && !final._qet->isGroupedBy(groupColumns)) {
       // Create an order by operation as required by the group by
       std::shared_ptr<Operation> orderBy =
           std::make_shared<OrderBy>(_qec, final._qet, sortColumns);
@@ -326,9 +402,17 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
         sortIndices.emplace_back(pair<size_t, bool>{
             final._qet.get()->getVariableColumn(ord._key), ord._desc});
       }
-      std::shared_ptr<Operation> ob(new OrderBy(_qec, final._qet, sortIndices));
+      size_t topK = getTopKLimit(pq);
       tree.setVariableColumns(final._qet.get()->getVariableColumnMap());
-      tree.setOperation(QueryExecutionTree::ORDER_BY, ob);
+      if (topK != std::numeric_limits<size_t>::max()) {
+        std::shared_ptr<Operation> op(
+            new TopK(_qec, final._qet, sortIndices, topK));
+        tree.setOperation(QueryExecutionTree::TOP_K, op);
+      } else {
+        std::shared_ptr<Operation> ob(
+            new OrderBy(_qec, final._qet, sortIndices));
+        tree.setOperation(QueryExecutionTree::ORDER_BY, ob);
+      }
       tree.setContextVars(final._qet.get()->getContextVars());
       final = plan;
     }
@@ -366,42 +450,23 @@ QueryExecutionTree QueryPlanner::createExecutionTree(ParsedQuery& pq) const {
     }
     if (final._qet.get()->getType() == QueryExecutionTree::SORT ||
         final._qet.get()->getType() == QueryExecutionTree::ORDER_BY ||
-        std::find(keepIndices.begin(), keepIndices.end(),
-                  final._qet.get()->resultSortedOn()) != keepIndices.end()) {
+        final._qet->isGroupedBy(keepIndices)) {
       std::shared_ptr<Operation> distinct(
           new Distinct(_qec, final._qet, keepIndices));
       distinctTree.setOperation(QueryExecutionTree::DISTINCT, distinct);
     } else {
-      if (keepIndices.size() == 1) {
-        std::shared_ptr<QueryExecutionTree> tree(new QueryExecutionTree(_qec));
-        std::shared_ptr<Operation> sort(
-            new Sort(_qec, final._qet, keepIndices[0]));
-        tree->setVariableColumns(final._qet.get()->getVariableColumnMap());
-        tree->setOperation(QueryExecutionTree::SORT, sort);
-        tree->setContextVars(final._qet.get()->getContextVars());
-        std::shared_ptr<Operation> distinct(
-            new Distinct(_qec, tree, keepIndices));
-        distinctTree.setOperation(QueryExecutionTree::DISTINCT, distinct);
-      } else {
-        std::shared_ptr<QueryExecutionTree> tree(new QueryExecutionTree(_qec));
-        vector<pair<size_t, bool>> obCols;
-        for (auto& i : keepIndices) {
-          obCols.emplace_back(std::make_pair(i, false));
-        }
-        std::shared_ptr<Operation> ob(new OrderBy(_qec, final._qet, obCols));
-        tree->setVariableColumns(final._qet.get()->getVariableColumnMap());
-        tree->setOperation(QueryExecutionTree::ORDER_BY, ob);
-        tree->setContextVars(final._qet.get()->getContextVars());
-        std::shared_ptr<Operation> distinct(
-            new Distinct(_qec, tree, keepIndices));
-        distinctTree.setOperation(QueryExecutionTree::DISTINCT, distinct);
-      }
+      // Deduplicating with a hash set is cheaper than sorting first.
+      std::shared_ptr<Operation> distinct(
+          new HashDistinct(_qec, final._qet, keepIndices));
+      distinctTree.setOperation(QueryExecutionTree::HASH_DISTINCT, distinct);
     }
     distinctTree.setTextLimit(getTextLimit(pq._textLimit));
+    distinctTree.recordSizeEstimates();
     return distinctTree;
   }
 
   final._qet.get()->setTextLimit(getTextLimit(pq._textLimit));
+  final._qet.get()->recordSizeEstimates();
   LOG(DEBUG) << "Done creating execution plan.\n";
   return *final._qet.get();
 }
@@ -412,24 +477,38 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::getOrderByRow(
   const vector<SubtreePlan>& previous = dpTab[dpTab.size() - 1];
   vector<SubtreePlan> added;
   added.reserve(previous.size());
+  size_t topK = getTopKLimit(pq);
   for (size_t i = 0; i < previous.size(); ++i) {
     SubtreePlan plan(_qec);
     auto& tree = *plan._qet.get();
     plan._idsOfIncludedNodes = previous[i]._idsOfIncludedNodes;
     plan._idsOfIncludedFilters = previous[i]._idsOfIncludedFilters;
-    if (pq._orderBy.size() == 1 && !pq._orderBy[0]._desc) {
+    plan._joinOrder = previous[i]._joinOrder;
+    bool singleAscending = pq._orderBy.size() == 1 && !pq._orderBy[0]._desc;
+    if (isSortedBy(*previous[i]._qet, pq._orderBy)) {
+      // Already sorted perfectly
+      added.push_back(previous[i]);
+    } else if (topK != std::numeric_limits<size_t>::max()) {
+      // Only the first rows are needed, there is no need to sort everything.
+      vector<pair<size_t, bool>> sortIndices;
+      for (auto& ord : pq._orderBy) {
+        sortIndices.emplace_back(pair<size_t, bool>{
+            previous[i]._qet.get()->getVariableColumn(ord._key), ord._desc});
+      }
+      std::shared_ptr<Operation> op(
+          new TopK(_qec, previous[i]._qet, sortIndices, topK));
+      tree.setVariableColumns(previous[i]._qet.get()->getVariableColumnMap());
+      tree.setOperation(QueryExecutionTree::TOP_K, op);
+      tree.setContextVars(previous[i]._qet.get()->getContextVars());
+      added.push_back(plan);
+    } else if (singleAscending) {
       size_t col =
           previous[i]._qet.get()->getVariableColumn(pq._orderBy[0]._key);
-      if (col == previous[i]._qet.get()->resultSortedOn()) {
-        // Already sorted perfectly
-        added.push_back(previous[i]);
-      } else {
-        std::shared_ptr<Operation> sort(new Sort(_qec, previous[i]._qet, col));
-        tree.setVariableColumns(previous[i]._qet.get()->getVariableColumnMap());
-        tree.setOperation(QueryExecutionTree::SORT, sort);
-        tree.setContextVars(previous[i]._qet.get()->getContextVars());
-        added.push_back(plan);
-      }
+      std::shared_ptr<Operation> sort(new Sort(_qec, previous[i]._qet, col));
+      tree.setVariableColumns(previous[i]._qet.get()->getVariableColumnMap());
+      tree.setOperation(QueryExecutionTree::SORT, sort);
+      tree.setContextVars(previous[i]._qet.get()->getContextVars());
+      added.push_back(plan);
     } else {
       vector<pair<size_t, bool>> sortIndices;
       for (auto& ord : pq._orderBy) {
@@ -448,6 +527,23 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::getOrderByRow(
   return added;
 }
 
+// _____________________________________________________________________________
+size_t QueryPlanner::getTopKLimit(const ParsedQuery& pq) const {
+  // LIMIT and OFFSET are applied when the result is written, so the ordering
+  // has to provide limit + offset rows. This is only valid if no later
+  // operation (a DISTINCT or optional joins that are done after the ordering)
+  // can change the rows of the result.
+  if (pq._limit.size() == 0 || pq._distinct ||
+      (!_optimizeOptionals && pq._rootGraphPattern._children.size() > 0)) {
+    return std::numeric_limits<size_t>::max();
+  }
+  size_t k = static_cast<size_t>(atol(pq._limit.c_str()));
+  if (pq._offset.size() > 0) {
+    k += static_cast<size_t>(atol(pq._offset.c_str()));
+  }
+  return k;
+}
+
 // _____________________________________________________________________________
 void QueryPlanner::getVarTripleMap(
     const ParsedQuery& pq,
@@ -473,6 +569,65 @@ void QueryPlanner::getVarTripleMap(
   }
 }
 
+// _____________________________________________________________________________
+string QueryPlanner::getPlanningAlgorithmName() const {
+  switch (_planningAlgorithm) {
+    case PlanningAlgorithm::DYNAMIC_PROGRAMMING:
+      return "dynamic programming";
+    case PlanningAlgorithm::CACHED_JOIN_ORDER:
+      return "cached join order";
+    case PlanningAlgorithm::ITERATIVE_DYNAMIC_PROGRAMMING:
+      return "iterative dynamic programming";
+  }
+  return "";
+}
+
+// _____________________________________________________________________________
+string QueryPlanner::getQueryShape(const ParsedQuery& pq) {
+  ad_utility::HashMap<string, size_t> varIds;
+  std::ostringstream os;
+  appendPatternShape(pq._rootGraphPattern, &varIds, &os);
+  return os.str();
+}
+
+// _____________________________________________________________________________
+void QueryPlanner::appendPatternShape(
+    const ParsedQuery::GraphPattern& pattern,
+    ad_utility::HashMap<string, size_t>* varIds, std::ostringstream* os) {
+  auto appendTerm = [varIds, os](const string& term, bool keepConstant) {
+    if (isVariable(term)) {
+      if (varIds->count(term) == 0) {
+        size_t id = varIds->size();
+        (*varIds)[term] = id;
+      }
+      *os << " ?" << (*varIds)[term];
+    } else if (keepConstant) {
+      *os << ' ' << term;
+    } else {
+      *os << " _";
+    }
+  };
+  *os << (pattern._optional ? "OPTIONAL {" : "{");
+  for (const SparqlTriple& t : pattern._whereClauseTriples) {
+    // The predicates determine the relations that are joined, they are part
+    // of the shape.
+    appendTerm(t._s, false);
+    appendTerm(t._p, true);
+    appendTerm(t._o, false);
+    *os << " .";
+  }
+  for (const SparqlFilter& f : pattern._filters) {
+    *os << " FILTER " << f._type;
+    appendTerm(f._lhs, false);
+    appendTerm(f._rhs, false);
+  }
+  for (const ParsedQuery::GraphPattern* child : pattern._children) {
+    *os << ' ';
+    appendPatternShape(*child, varIds, os);
+  }
+  *os << " }";
+}
+
 // _____________________________________________________________________________
 bool QueryPlanner::isVariable(const string& elem) {
   return ad_utility::startsWith(elem, "?");
@@ -528,8 +683,9 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
   for (SubtreePlan* plan : children) {
     SubtreePlan newIdPlan = *plan;
     // give the plan a unique id bit
-    newIdPlan._idsOfIncludedNodes = 1 << idShift;
+    newIdPlan._idsOfIncludedNodes = uint64_t(1) << idShift;
     newIdPlan._idsOfIncludedFilters = 0;
+    newIdPlan._joinOrder.clear();
     seeds.push_back(newIdPlan);
     idShift++;
   }
@@ -546,7 +702,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
       } else if (node._variables.size() == 1) {
         // Just pick one direction, they should be equivalent.
         SubtreePlan plan(_qec);
-        plan._idsOfIncludedNodes |= (1 << i);
+        plan._idsOfIncludedNodes |= (uint64_t(1) << i);
         auto& tree = *plan._qet.get();
         if (node._triple._p == HAS_RELATION_PREDIACTE) {
           // Add a has relation scan instead of a normal IndexScan
@@ -601,7 +757,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
         if (node._triple._p == HAS_RELATION_PREDIACTE) {
           // Add a has relation scan instead of a normal IndexScan
           SubtreePlan plan(_qec);
-          plan._idsOfIncludedNodes |= (1 << i);
+          plan._idsOfIncludedNodes |= (uint64_t(1) << i);
           auto& tree = *plan._qet.get();
           std::shared_ptr<Operation> scan(
               new HasRelationScan(_qec, HasRelationScan::ScanType::FULL_SCAN));
@@ -616,7 +772,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
         } else if (!isVariable(node._triple._p)) {
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::PSO_FREE_S));
@@ -629,7 +785,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           }
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::POS_FREE_O));
@@ -643,7 +799,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
         } else if (!isVariable(node._triple._s)) {
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::SPO_FREE_P));
@@ -656,7 +812,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           }
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::SOP_FREE_O));
@@ -670,7 +826,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
         } else if (!isVariable(node._triple._o)) {
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::OSP_FREE_S));
@@ -683,7 +839,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           }
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::OPS_FREE_P));
@@ -701,7 +857,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           // SPO
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::FULL_INDEX_SCAN_SPO));
@@ -715,7 +871,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           // SOP
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::FULL_INDEX_SCAN_SOP));
@@ -729,7 +885,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           // PSO
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::FULL_INDEX_SCAN_PSO));
@@ -743,7 +899,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           // POS
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::FULL_INDEX_SCAN_POS));
@@ -757,7 +913,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           // OSP
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::FULL_INDEX_SCAN_OSP));
@@ -771,7 +927,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
           // OPS
           {
             SubtreePlan plan(_qec);
-            plan._idsOfIncludedNodes |= (1 << i);
+            plan._idsOfIncludedNodes |= (uint64_t(1) << i);
             auto& tree = *plan._qet.get();
             std::shared_ptr<Operation> scan(
                 new IndexScan(_qec, IndexScan::ScanType::FULL_INDEX_SCAN_OPS));
@@ -799,7 +955,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::seedWithScansAndText(
 QueryPlanner::SubtreePlan QueryPlanner::getTextLeafPlan(
     const QueryPlanner::TripleGraph::Node& node) const {
   SubtreePlan plan(_qec);
-  plan._idsOfIncludedNodes |= (1 << node._id);
+  plan._idsOfIncludedNodes |= (uint64_t(1) << node._id);
   auto& tree = *plan._qet.get();
   AD_CHECK(node._wordPart.size() > 0);
   // Subtract 1 for variables.size() for the context var.
@@ -825,19 +981,91 @@ QueryPlanner::SubtreePlan QueryPlanner::getTextLeafPlan(
 vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
     const vector<QueryPlanner::SubtreePlan>& a,
     const vector<QueryPlanner::SubtreePlan>& b,
-    const QueryPlanner::TripleGraph& tg) const {
+    const QueryPlanner::TripleGraph& tg,
+    const vector<uint64_t>* joinOrder) const {
+  LOG(TRACE) << "Considering joins that merge " << a.size() << " and "
+             << b.size() << " plans...\n";
+  // For many pairs the rows of a are split into chunks whose candidates are
+  // built concurrently. The candidates are collected in the order of the
+  // chunks, so the chosen plans do not depend on the number of threads.
+  ad_utility::TaskScheduler& scheduler =
+      _qec ? _qec->getTaskScheduler() : ad_utility::TaskScheduler::get();
+  size_t nofChunks = 1;
+  if (a.size() * b.size() >= MIN_NOF_PAIRS_FOR_PARALLEL_PLANNING) {
+    nofChunks = std::max(size_t(1), std::min(a.size(),
+                                             scheduler.getNofWorkers()));
+  }
+  if (nofChunks > 1) {
+    // The estimates of the existing plans are computed lazily and shared by
+    // all new plans built on them, compute them before the threads read them.
+    precomputeEstimates(a);
+    precomputeEstimates(b);
+  }
+  vector<vector<pair<string, SubtreePlan>>> chunkCandidates(nofChunks);
+  vector<std::function<void()>> chunks;
+  for (size_t c = 0; c < nofChunks; ++c) {
+    size_t aBegin = a.size() * c / nofChunks;
+    size_t aEnd = a.size() * (c + 1) / nofChunks;
+    vector<pair<string, SubtreePlan>>* candidates = &chunkCandidates[c];
+    chunks.push_back(
+        [this, &a, &b, &tg, joinOrder, aBegin, aEnd, candidates] {
+          addJoinCandidates(a, aBegin, aEnd, b, tg, joinOrder, candidates);
+        });
+  }
+  scheduler.runInParallel(chunks);
+  ad_utility::HashMap<string, vector<SubtreePlan>> candidates;
+  for (const auto& chunk : chunkCandidates) {
+    for (const auto& candidate : chunk) {
+      candidates[candidate.first].push_back(candidate.second);
+    }
+  }
+
+  // Duplicates are removed if the same triples are touched,
+  // the ordering is the same. Only the best is kept then.
+
+  // Therefore we mapped plans and use contained triples + ordering var
+  // as key.
+  LOG(TRACE) << "Pruning...\n";
+  vector<SubtreePlan> prunedPlans;
+  size_t nofCandidates = 0;
+  for (auto it = candidates.begin(); it != candidates.end(); ++it) {
+    size_t minCost = std::numeric_limits<size_t>::max();
+    size_t minIndex = 0;
+    for (size_t i = 0; i < it->second.size(); ++i) {
+      ++nofCandidates;
+      if (it->second[i].getCostEstimate() < minCost) {
+        minCost = it->second[i].getCostEstimate();
+        minIndex = i;
+      }
+    }
+    prunedPlans.push_back(it->second[minIndex]);
+  }
+  LOG(TRACE) << "Got " << prunedPlans.size() << " pruned plans from "
+             << nofCandidates << " candidates.\n";
+  return prunedPlans;
+}
+
+// _____________________________________________________________________________
+void QueryPlanner::addJoinCandidates(
+    const vector<QueryPlanner::SubtreePlan>& a, size_t aBegin, size_t aEnd,
+    const vector<QueryPlanner::SubtreePlan>& b,
+    const QueryPlanner::TripleGraph& tg, const vector<uint64_t>* joinOrder,
+    vector<pair<string, SubtreePlan>>* candidates) const {
   // TODO: Add the following features:
   // If a join is supposed to happen, always check if it happens between
   // a scan with a relatively large result size
   // esp. with an entire relation but also with something like is-a Person
   // If that is the case look at the size estimate for the other side,
   // if that is rather small, replace the join and scan by a combination.
-  ad_utility::HashMap<string, vector<SubtreePlan>> candidates;
   // Find all pairs between a and b that are connected by an edge.
-  LOG(TRACE) << "Considering joins that merge " << a.size() << " and "
-             << b.size() << " plans...\n";
-  for (size_t i = 0; i < a.size(); ++i) {
+  for (size_t i = aBegin; i < aEnd; ++i) {
     for (size_t j = 0; j < b.size(); ++j) {
+      if (joinOrder &&
+          !std::binary_search(
+              joinOrder->begin(), joinOrder->end(),
+              a[i]._idsOfIncludedNodes | b[j]._idsOfIncludedNodes)) {
+        continue;
+      }
       if (connected(a[i], b[j], tg)) {
         // Find join variable(s) / columns.
         auto jcs = getJoinColumns(a[i], b[j]);
@@ -859,12 +1087,11 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
         if (a[i]._isOptional || b[j]._isOptional) {
           // Join the two optional columns using an optional join
           SubtreePlan plan = optionalJoin(a[i], b[j]);
-          plan._idsOfIncludedNodes = a[i]._idsOfIncludedNodes;
-          plan.addAllNodes(b[j]._idsOfIncludedNodes);
+          plan.setJoinOf(a[i], b[j]);
           plan._idsOfIncludedFilters = a[i]._idsOfIncludedFilters;
           plan._idsOfIncludedFilters |= b[j]._idsOfIncludedFilters;
-          candidates[getPruningKey(plan, plan._qet->resultSortedOn())]
-              .emplace_back(plan);
+          candidates->emplace_back(
+              getPruningKey(plan, plan._qet->resultSortedOn()), plan);
           continue;
         }
 
@@ -893,9 +1120,12 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
                 new QueryExecutionTree(_qec));
             std::shared_ptr<QueryExecutionTree> right(
                 new QueryExecutionTree(_qec));
-            if (a[i]._qet.get()->resultSortedOn() == jcs[c][(0 + swap) % 2] &&
-                (a[i]._qet.get()->getResultWidth() == 2 ||
-                 a[i]._qet.get()->getType() == QueryExecutionTree::SCAN)) {
+            if ((a[i]._qet.get()->resultSortedOn() == jcs[c][(0 + swap) % 2] &&
+                 (a[i]._qet.get()->getResultWidth() == 2 ||
+                  a[i]._qet.get()->getType() == QueryExecutionTree::SCAN)) ||
+                startsWithColumns(a[i]._qet->resultSortedOnColumns(),
+                                  {jcs[c][(0 + swap) % 2],
+                                   jcs[(c + 1) % 2][(0 + swap) % 2]})) {
               left = a[i]._qet;
             } else {
               // Create an order by operation.
@@ -909,8 +1139,14 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
               left->setVariableColumns(a[i]._qet->getVariableColumnMap());
               left->setOperation(QueryExecutionTree::ORDER_BY, orderBy);
             }
-            if (b[j]._qet.get()->resultSortedOn() == jcs[c][(1 + swap) % 2] &&
-                b[j]._qet.get()->getResultWidth() == 2) {
+            // Scans are only used directly if they are narrow enough to be
+            // used as a filter.
+            if ((b[j]._qet.get()->resultSortedOn() == jcs[c][(1 + swap) % 2] &&
+                 b[j]._qet.get()->getResultWidth() == 2) ||
+                (b[j]._qet->getType() != QueryExecutionTree::SCAN &&
+                  startsWithColumns(b[j]._qet->resultSortedOnColumns(),
+                                   {jcs[c][(1 + swap) % 2],
+                                    jcs[(c + 1) % 2][(1 + swap) % 2]}))) {
               right = b[j]._qet;
             } else {
               // Create a sort operation.
@@ -934,10 +1170,9 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
                 static_cast<TwoColumnJoin*>(join.get())->getVariableColumns());
             tree.setOperation(QueryExecutionTree::TWO_COL_JOIN, join);
             plan._idsOfIncludedFilters = a[i]._idsOfIncludedFilters;
-            plan._idsOfIncludedNodes = a[i]._idsOfIncludedNodes;
-            plan.addAllNodes(b[j]._idsOfIncludedNodes);
-            candidates[getPruningKey(plan, jcs[c][(0 + swap) % 2])]
-                .emplace_back(plan);
+            plan.setJoinOf(a[i], b[j]);
+            candidates->emplace_back(
+                getPruningKey(plan, jcs[c][(0 + swap) % 2]), plan);
           }
           continue;
         }
@@ -964,8 +1199,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
           const SubtreePlan& filterPlan = aTextOp ? b[j] : a[i];
           size_t otherPlanJc = aTextOp ? jcs[0][1] : jcs[0][0];
           SubtreePlan plan(_qec);
-          plan._idsOfIncludedNodes = filterPlan._idsOfIncludedNodes;
-          plan._idsOfIncludedNodes |= textPlan._idsOfIncludedNodes;
+          plan.setJoinOf(filterPlan, textPlan);
           plan._idsOfIncludedFilters = filterPlan._idsOfIncludedFilters;
           auto& tree = *plan._qet.get();
           // Subtract 1 for variables.size() for the context var.
@@ -1000,7 +1234,7 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
           tree.setVariableColumns(vcmap);
           tree.setContextVars(filterPlan._qet.get()->getContextVars());
           tree.addContextVar(cvar);
-          candidates[getPruningKey(plan, jcs[0][0])].emplace_back(plan);
+          candidates->emplace_back(getPruningKey(plan, jcs[0][0]), plan);
         }
         // Skip if we have two dummies
         if (a[i]._qet.get()->getType() ==
@@ -1062,14 +1296,13 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
             tree.setVariableColumns(static_cast<HasRelationScan*>(scan.get())
                                         ->getVariableColumns());
             tree.setOperation(QueryExecutionTree::HAS_RELATION_SCAN, scan);
-            plan._idsOfIncludedNodes = a[i]._idsOfIncludedNodes;
-            plan.addAllNodes(b[j]._idsOfIncludedNodes);
+            plan.setJoinOf(a[i], b[j]);
             plan._idsOfIncludedFilters = a[i]._idsOfIncludedFilters;
             plan._idsOfIncludedFilters |= b[j]._idsOfIncludedFilters;
-            candidates[getPruningKey(plan,
-                                     static_cast<HasRelationScan*>(scan.get())
-                                         ->resultSortedOn())]
-                .emplace_back(plan);
+            candidates->emplace_back(
+                getPruningKey(plan, static_cast<HasRelationScan*>(scan.get())
+                                        ->resultSortedOn()),
+                plan);
             continue;
           }
         }
@@ -1117,38 +1350,104 @@ vector<QueryPlanner::SubtreePlan> QueryPlanner::merge(
             static_cast<Join*>(join.get())->getVariableColumns());
         tree.setContextVars(static_cast<Join*>(join.get())->getContextVars());
         tree.setOperation(QueryExecutionTree::JOIN, join);
-        plan._idsOfIncludedNodes = a[i]._idsOfIncludedNodes;
-        plan.addAllNodes(b[j]._idsOfIncludedNodes);
+        plan.setJoinOf(a[i], b[j]);
         plan._idsOfIncludedFilters = a[i]._idsOfIncludedFilters;
         plan._idsOfIncludedFilters |= b[j]._idsOfIncludedFilters;
-        candidates[getPruningKey(plan, jcs[0][0])].emplace_back(plan);
+        candidates->emplace_back(getPruningKey(plan, jcs[0][0]), plan);
+
+        // If one of the inputs already is a join on the same variable (e.g.
+        // for the arms of a star) also consider joining all inputs at once.
+        vector<std::shared_ptr<QueryExecutionTree>> starChildren;
+        vector<size_t> starJoinCols;
+        collectMultiwayJoinInputs(left, jcs[0][0], &starChildren,
+                                  &starJoinCols);
+        collectMultiwayJoinInputs(right, jcs[0][1], &starChildren,
+                                  &starJoinCols);
+        bool starWithDummy = false;
+        for (const auto& child : starChildren) {
+          starWithDummy = starWithDummy ||
+                          (child->getType() == QueryExecutionTree::SCAN &&
+                           child->getResultWidth() == 3);
+        }
+        if (starChildren.size() > 2 && !starWithDummy) {
+          SubtreePlan starPlan(_qec);
+          auto& starTree = *starPlan._qet.get();
+          std::shared_ptr<Operation> multiwayJoin(
+              new MultiwayJoin(_qec, starChildren, starJoinCols));
+          const MultiwayJoin& mj =
+              *static_cast<MultiwayJoin*>(multiwayJoin.get());
+          starTree.setVariableColumns(mj.getVariableColumns());
+          starTree.setContextVars(mj.getContextVars());
+          starTree.setOperation(QueryExecutionTree::MULTIWAY_JOIN,
+                                multiwayJoin);
+          starPlan._idsOfIncludedNodes = plan._idsOfIncludedNodes;
+          starPlan._idsOfIncludedFilters = plan._idsOfIncludedFilters;
+          starPlan._joinOrder = plan._joinOrder;
+          candidates->emplace_back(
+              getPruningKey(starPlan, mj.resultSortedOn()), starPlan);
+        }
       }
     }
   }
+  // The estimates of the new plans are memoized by the thread that built them.
+  for (auto& candidate : *candidates) {
+    candidate.second.getCostEstimate();
+  }
+}
 
-  // Duplicates are removed if the same triples are touched,
-  // the ordering is the same. Only the best is kept then.
+// _____________________________________________________________________________
+void QueryPlanner::precomputeEstimates(const vector<SubtreePlan>& plans) {
+  for (const SubtreePlan& plan : plans) {
+    QueryExecutionTree& tree = *plan._qet;
+    tree.asString();
+    tree.getSizeEstimate();
+    tree.getCostEstimate();
+    for (size_t col = 0; col < tree.getResultWidth(); ++col) {
+      tree.getMultiplicity(col);
+    }
+  }
+}
 
-  // Therefore we mapped plans and use contained triples + ordering var
-  // as key.
-  LOG(TRACE) << "Pruning...\n";
-  vector<SubtreePlan> prunedPlans;
-  size_t nofCandidates = 0;
-  for (auto it = candidates.begin(); it != candidates.end(); ++it) {
-    size_t minCost = std::numeric_limits<size_t>::max();
-    size_t minIndex = 0;
-    for (size_t i = 0; i < it->second.size(); ++i) {
-      ++nofCandidates;
-      if (it->second[i].getCostEstimate() < minCost) {
-        minCost = it->second[i].getCostEstimate();
-        minIndex = i;
+// _____________________________________________________________________________
+void QueryPlanner::collectSizeEstimates(
+    QueryExecutionTree* tree, vector<pair<string, size_t>>* estimates) {
+  estimates->emplace_back(tree->getRootOperation()->asString(),
+                          tree->getSizeEstimate());
+  for (QueryExecutionTree* child : tree->getRootOperation()->getChildren()) {
+    collectSizeEstimates(child, estimates);
+  }
+}
+
+// _____________________________________________________________________________
+void QueryPlanner::collectMultiwayJoinInputs(
+    const std::shared_ptr<QueryExecutionTree>& tree, size_t joinCol,
+    vector<std::shared_ptr<QueryExecutionTree>>* children,
+    vector<size_t>* joinCols) const {
+  if (tree->getType() == QueryExecutionTree::JOIN) {
+    const Join& join =
+        *static_cast<const Join*>(tree->getRootOperation().get());
+    if (join.keepsJoinColumn() && !join.involvesFullScanDummy() &&
+        join.resultSortedOn() == joinCol) {
+      collectMultiwayJoinInputs(join.getLeft(), join.getLeftJoinCol(),
+                                children, joinCols);
+      collectMultiwayJoinInputs(join.getRight(), join.getRightJoinCol(),
+                                children, joinCols);
+      return;
+    }
+  } else if (tree->getType() == QueryExecutionTree::MULTIWAY_JOIN) {
+    const MultiwayJoin& join =
+        *static_cast<const MultiwayJoin*>(tree->getRootOperation().get());
+    if (join.resultSortedOn() == joinCol) {
+      for (size_t i = 0; i < join.getInputs().size(); ++i) {
+        collectMultiwayJoinInputs(join.getInputs()[i],
+                                  join.getJoinColumns()[i], children,
+                                  joinCols);
       }
+      return;
     }
-    prunedPlans.push_back(it->second[minIndex]);
   }
-  LOG(TRACE) << "Got " << prunedPlans.size() << " pruned plans from "
-             << nofCandidates << " candidates.\n";
-  return prunedPlans;
+  children->push_back(tree);
+  joinCols->push_back(joinCol);
 }
 
 // _____________________________________________________________________________
@@ -1195,6 +1494,131 @@ QueryPlanner::SubtreePlan QueryPlanner::optionalJoin(
   return plan;
 }
 
+// _____________________________________________________________________________
+vector<vector<size_t>> QueryPlanner::getCyclicTripleGroups(
+    const QueryPlanner::TripleGraph& tg) const {
+  // Only triples with a fixed predicate and two different variables can be
+  // read as a sorted relation in both directions.
+  vector<size_t> edges;
+  for (size_t i = 0; i < tg._nodeMap.size(); ++i) {
+    const SparqlTriple& t = tg._nodeMap.find(i)->second->_triple;
+    if (tg._nodeMap.find(i)->second->_cvar.empty() && !isVariable(t._p) &&
+        t._p != HAS_RELATION_PREDIACTE && isVariable(t._s) &&
+        isVariable(t._o) && t._s != t._o) {
+      edges.push_back(i);
+    }
+  }
+  // Repeatedly remove triples with a variable that no other triple shares.
+  std::unordered_map<string, size_t> degree;
+  for (size_t e : edges) {
+    const SparqlTriple& t = tg._nodeMap.find(e)->second->_triple;
+    ++degree[t._s];
+    ++degree[t._o];
+  }
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    vector<size_t> remaining;
+    for (size_t e : edges) {
+      const SparqlTriple& t = tg._nodeMap.find(e)->second->_triple;
+      if (degree[t._s] < 2 || degree[t._o] < 2) {
+        --degree[t._s];
+        --degree[t._o];
+        changed = true;
+      } else {
+        remaining.push_back(e);
+      }
+    }
+    edges = remaining;
+  }
+  // Group the remaining triples into connected components.
+  vector<vector<size_t>> groups;
+  vector<bool> assigned(edges.size(), false);
+  for (size_t i = 0; i < edges.size(); ++i) {
+    if (assigned[i]) {
+      continue;
+    }
+    vector<size_t> group;
+    std::set<string> vars;
+    assigned[i] = true;
+    group.push_back(edges[i]);
+    vars.insert(tg._nodeMap.find(edges[i])->second->_triple._s);
+    vars.insert(tg._nodeMap.find(edges[i])->second->_triple._o);
+    bool grown = true;
+    while (grown) {
+      grown = false;
+      for (size_t j = 0; j < edges.size(); ++j) {
+        const SparqlTriple& t = tg._nodeMap.find(edges[j])->second->_triple;
+        if (!assigned[j] && (vars.count(t._s) > 0 || vars.count(t._o) > 0)) {
+          assigned[j] = true;
+          group.push_back(edges[j]);
+          vars.insert(t._s);
+          vars.insert(t._o);
+          grown = true;
+        }
+      }
+    }
+    if (group.size() >= 3) {
+      std::sort(group.begin(), group.end());
+      groups.push_back(group);
+    }
+  }
+  return groups;
+}
+
+// _____________________________________________________________________________
+QueryPlanner::SubtreePlan QueryPlanner::getLeapfrogTriejoinPlan(
+    const QueryPlanner::TripleGraph& tg, const vector<size_t>& nodes) const {
+  // Bind the most connected variables first, they restrict the most inputs.
+  std::unordered_map<string, size_t> degree;
+  for (size_t n : nodes) {
+    const SparqlTriple& t = tg._nodeMap.find(n)->second->_triple;
+    ++degree[t._s];
+    ++degree[t._o];
+  }
+  vector<string> order;
+  for (const auto& d : degree) {
+    order.push_back(d.first);
+  }
+  std::sort(order.begin(), order.end(),
+            [&degree](const string& a, const string& b) {
+              size_t da = degree.find(a)->second;
+              size_t db = degree.find(b)->second;
+              return da > db || (da == db && a < b);
+            });
+  std::unordered_map<string, size_t> position;
+  for (size_t i = 0; i < order.size(); ++i) {
+    position[order[i]] = i;
+  }
+
+  SubtreePlan plan(_qec);
+  vector<std::shared_ptr<QueryExecutionTree>> scans;
+  for (size_t n : nodes) {
+    const SparqlTriple& t = tg._nodeMap.find(n)->second->_triple;
+    // Scan the permutation whose first column is bound first.
+    bool subjectFirst = position[t._s] < position[t._o];
+    std::shared_ptr<QueryExecutionTree> tree =
+        std::make_shared<QueryExecutionTree>(_qec);
+    std::shared_ptr<Operation> scan(new IndexScan(
+        _qec, subjectFirst ? IndexScan::ScanType::PSO_FREE_S
+                           : IndexScan::ScanType::POS_FREE_O));
+    static_cast<IndexScan*>(scan.get())->setPredicate(t._p);
+    static_cast<IndexScan*>(scan.get())->precomputeSizeEstimate();
+    tree->setOperation(QueryExecutionTree::OperationType::SCAN, scan);
+    tree->setVariableColumn(t._s, subjectFirst ? 0 : 1);
+    tree->setVariableColumn(t._o, subjectFirst ? 1 : 0);
+    scans.push_back(tree);
+    plan._idsOfIncludedNodes |= (uint64_t(1) << n);
+  }
+  plan._joinOrder.push_back(plan._idsOfIncludedNodes);
+  std::shared_ptr<Operation> join(new LeapfrogTriejoin(_qec, scans, order));
+  auto& tree = *plan._qet.get();
+  tree.setVariableColumns(
+      static_cast<LeapfrogTriejoin*>(join.get())->getVariableColumns());
+  tree.setOperation(QueryExecutionTree::LEAPFROG_TRIEJOIN, join);
+  return plan;
+}
+
 // _____________________________________________________________________________
 string QueryPlanner::TripleGraph::asString() const {
   std::ostringstream os;
@@ -1236,6 +1660,16 @@ void QueryPlanner::SubtreePlan::addAllNodes(uint64_t otherNodes) {
   _idsOfIncludedNodes |= otherNodes;
 }
 
+// _____________________________________________________________________________
+void QueryPlanner::SubtreePlan::setJoinOf(const SubtreePlan& a,
+                                          const SubtreePlan& b) {
+  _idsOfIncludedNodes = a._idsOfIncludedNodes | b._idsOfIncludedNodes;
+  _joinOrder = a._joinOrder;
+  _joinOrder.insert(_joinOrder.end(), b._joinOrder.begin(),
+                    b._joinOrder.end());
+  _joinOrder.push_back(_idsOfIncludedNodes);
+}
+
 // _____________________________________________________________________________
 bool QueryPlanner::connected(const QueryPlanner::SubtreePlan& a,
                              const QueryPlanner::SubtreePlan& b,
@@ -1280,16 +1714,44 @@ vector<array<size_t, 2>> QueryPlanner::getJoinColumns(
   return jcs;
 }
 
+// _____________________________________________________________________________
+bool QueryPlanner::startsWithColumns(const vector<size_t>& cols,
+                                     const vector<size_t>& prefix) {
+  return cols.size() >= prefix.size() &&
+         std::equal(prefix.begin(), prefix.end(), cols.begin());
+}
+
+// _____________________________________________________________________________
+bool QueryPlanner::isSortedBy(const QueryExecutionTree& tree,
+                              const vector<OrderKey>& orderBy) {
+  vector<size_t> cols;
+  for (const OrderKey& key : orderBy) {
+    auto it = tree.getVariableColumnMap().find(key._key);
+    if (key._desc || it == tree.getVariableColumnMap().end()) {
+      return false;
+    }
+    cols.push_back(it->second);
+  }
+  return startsWithColumns(tree.resultSortedOnColumns(), cols);
+}
+
 // _____________________________________________________________________________
 string QueryPlanner::getPruningKey(const QueryPlanner::SubtreePlan& plan,
                                    size_t orderedOnCol) const {
-  // Get the ordered var
+  // Get the ordered vars. Plans that are sorted by more columns are kept
+  // separately, their order may save a sort later on.
   std::ostringstream os;
-  for (auto it = plan._qet.get()->getVariableColumnMap().begin();
-       it != plan._qet.get()->getVariableColumnMap().end(); ++it) {
-    if (it->second == orderedOnCol) {
-      os << it->first;
-      break;
+  vector<size_t> sortedOn = plan._qet->resultSortedOnColumns();
+  if (sortedOn.empty() || sortedOn[0] != orderedOnCol) {
+    sortedOn.assign(1, orderedOnCol);
+  }
+  for (size_t col : sortedOn) {
+    for (auto it = plan._qet.get()->getVariableColumnMap().begin();
+         it != plan._qet.get()->getVariableColumnMap().end(); ++it) {
+      if (it->second == col) {
+        os << it->first << ' ';
+        break;
+      }
     }
   }
 
@@ -1323,6 +1785,10 @@ void QueryPlanner::applyFiltersIfPossible(
   // where applying the filter later is better. Finally, the replace flag can be
   // set to enforce that all filters are applied. This should be done for the
   // last row in the DPTab so that no filters are missed.
+  // Filters that compare two variables are always applied to the first join
+  // that covers both, without keeping the unfiltered plan. They cannot be
+  // evaluated by scans or text operations and only get more expensive
+  // (and let the joins above them grow) the later they are applied.
   for (size_t n = 0; n < row.size(); ++n) {
     if (row[n]._qet->getType() == QueryExecutionTree::SCAN &&
         row[n]._qet->getResultWidth() == 3) {
@@ -1340,8 +1806,9 @@ void QueryPlanner::applyFiltersIfPossible(
         // Apply this filter.
         SubtreePlan newPlan(_qec);
         newPlan._idsOfIncludedFilters = row[n]._idsOfIncludedFilters;
-        newPlan._idsOfIncludedFilters |= (1 << i);
+        newPlan._idsOfIncludedFilters |= (uint64_t(1) << i);
         newPlan._idsOfIncludedNodes = row[n]._idsOfIncludedNodes;
+        newPlan._joinOrder = row[n]._joinOrder;
         auto& tree = *newPlan._qet.get();
         if (isVariable(filters[i]._rhs)) {
           std::shared_ptr<Operation> filter = std::make_shared<Filter>(
@@ -1373,20 +1840,36 @@ void QueryPlanner::applyFiltersIfPossible(
               entityId = std::numeric_limits<size_t>::max() - 1;
             }
           }
-          std::shared_ptr<Operation> filter(
-              new Filter(_qec, row[n]._qet, filters[i]._type,
-                         row[n]._qet.get()->getVariableColumn(filters[i]._lhs),
-                         std::numeric_limits<size_t>::max(), entityId));
-          if (_qec && filters[i]._type == SparqlFilter::LANG_MATCHES) {
-            static_cast<Filter*>(filter.get())
-                ->setRightHandSideString(filters[i]._rhs);
+          size_t lhsCol = row[n]._qet.get()->getVariableColumn(filters[i]._lhs);
+          std::shared_ptr<IndexScan> scan;
+          if (row[n]._qet->getType() == QueryExecutionTree::SCAN) {
+            // Evaluate the filter while reading the relation instead of
+            // materializing the full scan first.
+            scan = std::make_shared<IndexScan>(*static_cast<IndexScan*>(
+                row[n]._qet->getRootOperation().get()));
+            if (!scan->addFilter(lhsCol, filters[i]._type, entityId)) {
+              scan.reset();
+            }
+          }
+          if (scan) {
+            tree.setOperation(QueryExecutionTree::SCAN, scan);
+          } else {
+            std::shared_ptr<Operation> filter(
+                new Filter(_qec, row[n]._qet, filters[i]._type, lhsCol,
+                           std::numeric_limits<size_t>::max(), entityId));
+            if (_qec && filters[i]._type == SparqlFilter::LANG_MATCHES) {
+              static_cast<Filter*>(filter.get())
+                  ->setRightHandSideString(filters[i]._rhs);
+            }
+            tree.setOperation(QueryExecutionTree::FILTER, filter);
           }
-          tree.setOperation(QueryExecutionTree::FILTER, filter);
         }
 
         tree.setVariableColumns(row[n]._qet.get()->getVariableColumnMap());
         tree.setContextVars(row[n]._qet.get()->getContextVars());
-        if (replace) {
+        uint64_t nodes = row[n]._idsOfIncludedNodes;
+        bool isJoin = (nodes & (nodes - 1)) != 0;
+        if (replace || (isJoin && isVariable(filters[i]._rhs))) {
           row[n] = newPlan;
         } else {
           row.push_back(newPlan);
@@ -1399,26 +1882,76 @@ void QueryPlanner::applyFiltersIfPossible(
 // _____________________________________________________________________________
 vector<vector<QueryPlanner::SubtreePlan>> QueryPlanner::fillDpTab(
     const QueryPlanner::TripleGraph& tg, const vector<SparqlFilter>& filters,
-    const vector<QueryPlanner::SubtreePlan*>& children) const {
+    const vector<QueryPlanner::SubtreePlan*>& children,
+    const vector<uint64_t>* joinOrder) const {
   LOG(TRACE) << "Fill DP table... (there are " << tg._nodeMap.size()
              << " triples to join)" << std::endl;
   ;
   vector<vector<SubtreePlan>> dpTab;
   dpTab.emplace_back(seedWithScansAndText(tg, children));
   applyFiltersIfPossible(dpTab.back(), filters, tg._nodeMap.size() == 1);
+  vector<vector<size_t>> cyclicGroups = getCyclicTripleGroups(tg);
+
+  // The plans in dpTab[0] are the units that are joined, initially the
+  // triples and children. For large patterns only blockSize units are joined
+  // exhaustively, then the cheapest of these joins becomes a single unit
+  // and the planning continues from there (iterative dynamic programming).
+  // The same happens if the exhaustive planning takes too long, which makes
+  // it continue greedily.
+  size_t nofUnits = tg._nodeMap.size() + children.size();
+  size_t nofCollapsed = 0;
+  size_t blockSize = nofUnits;
+  if (!joinOrder && nofUnits > MAX_NOF_NODES_FOR_EXHAUSTIVE_PLANNING) {
+    blockSize = IDP_BLOCK_SIZE;
+  }
+  auto deadline =
+      std::chrono::steady_clock::now() +
+      std::chrono::milliseconds(_maxExhaustivePlanningTimeInMs);
 
-  for (size_t k = 2; k <= tg._nodeMap.size() + children.size(); ++k) {
+  for (size_t k = 2; k <= nofUnits; ++k) {
     LOG(TRACE) << "Producing plans that unite " << k << " triples."
                << std::endl;
     ;
+    bool lastRow = k + nofCollapsed == tg._nodeMap.size();
     dpTab.emplace_back(vector<SubtreePlan>());
     for (size_t i = 1; i * 2 <= k; ++i) {
-      auto newPlans = merge(dpTab[i - 1], dpTab[k - i - 1], tg);
+      // With a join order only the joins that are part of it are built.
+      auto newPlans = merge(dpTab[i - 1], dpTab[k - i - 1], tg, joinOrder);
       if (newPlans.size() == 0) {
         continue;
       }
+      // Only the new plans, the others already got their filters.
+      applyFiltersIfPossible(newPlans, filters, lastRow);
       dpTab[k - 1].insert(dpTab[k - 1].end(), newPlans.begin(), newPlans.end());
-      applyFiltersIfPossible(dpTab.back(), filters, k == tg._nodeMap.size());
+    }
+    // Cyclic groups of triples can also be joined all at once, which avoids
+    // the (potentially huge) intermediate results of pairwise joins.
+    for (const auto& group : cyclicGroups) {
+      if (group.size() == k && nofCollapsed == 0) {
+        if (joinOrder) {
+          uint64_t nodes = 0;
+          for (size_t n : group) {
+            nodes |= (uint64_t(1) << n);
+          }
+          if (!std::binary_search(joinOrder->begin(), joinOrder->end(),
+                                  nodes)) {
+            continue;
+          }
+        }
+        vector<SubtreePlan> plans;
+        plans.push_back(getLeapfrogTriejoinPlan(tg, group));
+        applyFiltersIfPossible(plans, filters, lastRow);
+        dpTab[k - 1].insert(dpTab[k - 1].end(), plans.begin(), plans.end());
+      }
+    }
+    if (dpTab[k - 1].size() == 0 && joinOrder) {
+      // A join order does not need to join k nodes for every k.
+      if (k < nofUnits) {
+        continue;
+      }
+      LOG(WARN) << "The cached join order does not fit the query, "
+                << "planning it from scratch." << std::endl;
+      return fillDpTab(tg, filters, children);
     }
     if (dpTab[k - 1].size() == 0) {
       AD_THROW(ad_semsearch::Exception::BAD_QUERY,
@@ -1426,6 +1959,17 @@ vector<vector<QueryPlanner::SubtreePlan>> QueryPlanner::fillDpTab(
                "Likely cause: Queries that require joins of the full "
                "index with itself are not supported at the moment.");
     }
+    if (k < nofUnits && k != blockSize && !joinOrder &&
+        std::chrono::steady_clock::now() > deadline) {
+      _exhaustivePlanningTimedOut = true;
+    }
+    if (k < nofUnits && (k == blockSize || _exhaustivePlanningTimedOut)) {
+      dpTab = collapseDpTab(dpTab);
+      nofUnits -= k - 1;
+      nofCollapsed += k - 1;
+      _planningAlgorithm = PlanningAlgorithm::ITERATIVE_DYNAMIC_PROGRAMMING;
+      k = 1;
+    }
   }
 
   LOG(TRACE) << "Fill DP table done." << std::endl;
@@ -1433,6 +1977,35 @@ vector<vector<QueryPlanner::SubtreePlan>> QueryPlanner::fillDpTab(
   return dpTab;
 }
 
+// _____________________________________________________________________________
+vector<vector<QueryPlanner::SubtreePlan>> QueryPlanner::collapseDpTab(
+    const vector<vector<SubtreePlan>>& dpTab) const {
+  const vector<SubtreePlan>& row = dpTab.back();
+  size_t best = 0;
+  for (size_t i = 1; i < row.size(); ++i) {
+    if (row[i].getCostEstimate() < row[best].getCostEstimate()) {
+      best = i;
+    }
+  }
+  uint64_t nodes = row[best]._idsOfIncludedNodes;
+  LOG(DEBUG) << "Continuing the planning with the join of the nodes "
+             << nodes << " as a single unit." << std::endl;
+  // Plans for the same nodes that are sorted differently or have other
+  // filters applied may still lead to a cheaper plan later on.
+  vector<vector<SubtreePlan>> collapsed(1);
+  for (const SubtreePlan& plan : row) {
+    if (plan._idsOfIncludedNodes == nodes) {
+      collapsed[0].push_back(plan);
+    }
+  }
+  for (const SubtreePlan& plan : dpTab[0]) {
+    if ((plan._idsOfIncludedNodes & nodes) == 0) {
+      collapsed[0].push_back(plan);
+    }
+  }
+  return collapsed;
+}
+
 // _____________________________________________________________________________
 size_t QueryPlanner::getTextLimit(const string& textLimitString) const {
   if (textLimitString.size() == 0) {
@@ -3,6 +3,7 @@
 // Author: Björn Buchhold (buchhold@informatik.uni-freiburg.de)
 #pragma once
 
+#include <sstream>
 #include <vector>
 #include "../parser/ParsedQuery.h"
 #include "QueryExecutionTree.h"
@@ -11,11 +12,42 @@ using std::vector;
 
 class QueryPlanner {
  public:
+  // How the join order of the last query was found. If the patterns of the
+  // query were planned differently, the last one in this list applies.
+  enum class PlanningAlgorithm {
+    // All possible join orders were considered.
+    DYNAMIC_PROGRAMMING,
+    // The join order was taken from the plan cache.
+    CACHED_JOIN_ORDER,
+    // Only some joins were chosen exhaustively at a time, because the
+    // pattern was too large or the exhaustive planning took too long.
+    ITERATIVE_DYNAMIC_PROGRAMMING
+  };
+
   explicit QueryPlanner(QueryExecutionContext* qec,
                         bool optimizeOptionals = true);
 
   QueryExecutionTree createExecutionTree(ParsedQuery& pq) const;
 
+  // Join orders are looked up in and added to the given cache. By default
+  // the plan cache of the execution context is used, null disables caching.
+  void setPlanCache(PlanCache* planCache) { _planCache = planCache; }
+
+  // Exhaustive planning of a graph pattern continues greedily after this
+  // time. Default: MAX_EXHAUSTIVE_PLANNING_TIME_IN_MS.
+  void setMaxExhaustivePlanningTime(size_t milliseconds) {
+    _maxExhaustivePlanningTimeInMs = milliseconds;
+  }
+
+  PlanningAlgorithm getPlanningAlgorithm() const { return _planningAlgorithm; }
+
+  string getPlanningAlgorithmName() const;
+
+  // Describes the query with all variables renamed and all subjects and
+  // objects that are not variables replaced by a placeholder. Queries that
+  // only differ in these have the same shape and thus the same join order.
+  static string getQueryShape(const ParsedQuery& pq);
+
   class TripleGraph {
    public:
     TripleGraph();
@@ -112,12 +144,19 @@ class QueryPlanner {
     uint64_t _idsOfIncludedNodes;
     uint64_t _idsOfIncludedFilters;
     bool _isOptional;
+    // The included nodes of every join that built this plan. This determines
+    // the join order and is what the plan cache stores.
+    vector<uint64_t> _joinOrder;
 
     size_t getCostEstimate() const;
 
     size_t getSizeEstimate() const;
 
     void addAllNodes(uint64_t otherNodes);
+
+    // Makes this plan the join of a and b: it includes the nodes of both and
+    // their join orders followed by this join.
+    void setJoinOf(const SubtreePlan& a, const SubtreePlan& b);
   };
 
   TripleGraph createTripleGraph(const ParsedQuery::GraphPattern* pattern) const;
@@ -159,6 +198,12 @@ class QueryPlanner {
    *        done last.
    */
   bool _optimizeOptionals;
+  PlanCache* _planCache;
+  size_t _maxExhaustivePlanningTimeInMs;
+  mutable PlanningAlgorithm _planningAlgorithm;
+  // Set by fillDpTab if it continued greedily because it ran out of time.
+  // Such a join order depends on how busy the machine was and is not cached.
+  mutable bool _exhaustivePlanningTimedOut;
 
   static bool isVariable(const string& elem);
 
@@ -173,13 +218,38 @@ class QueryPlanner {
       const TripleGraph& tg,
       const vector<QueryPlanner::SubtreePlan*>& children) const;
 
+  // Joins the plans of a with those of b. If a join order is given, only
+  // the joins that are part of it are considered.
   vector<SubtreePlan> merge(const vector<SubtreePlan>& a,
                             const vector<SubtreePlan>& b,
-                            const TripleGraph& tg) const;
+                            const TripleGraph& tg,
+                            const vector<uint64_t>* joinOrder = nullptr) const;
+
+  // Adds the joins of a[aBegin, aEnd) with b to candidates, each with the key
+  // under which it is pruned. Only reads shared state, so disjoint ranges of
+  // a can be handled concurrently.
+  void addJoinCandidates(const vector<SubtreePlan>& a, size_t aBegin,
+                         size_t aEnd, const vector<SubtreePlan>& b,
+                         const TripleGraph& tg,
+                         const vector<uint64_t>* joinOrder,
+                         vector<pair<string, SubtreePlan>>* candidates) const;
+
+  // Computes the lazily memoized estimates of the plans, so that they can be
+  // read from several threads afterwards.
+  static void precomputeEstimates(const vector<SubtreePlan>& plans);
+
+  // Appends the cache keys and size estimates of the tree and all its
+  // subtrees, with which a cached plan is checked for misestimates later.
+  static void collectSizeEstimates(QueryExecutionTree* tree,
+                                   vector<pair<string, size_t>>* estimates);
 
   vector<SubtreePlan> getOrderByRow(
       const ParsedQuery& pq, const vector<vector<SubtreePlan>>& dpTab) const;
 
+  // Returns the number of rows the ordering of the query's result has to
+  // produce, or the maximum size_t if the full result has to be ordered.
+  size_t getTopKLimit(const ParsedQuery& pq) const;
+
   bool connected(const SubtreePlan& a, const SubtreePlan& b,
                  const TripleGraph& graph) const;
 
@@ -188,17 +258,57 @@ class QueryPlanner {
 
   string getPruningKey(const SubtreePlan& plan, size_t orderedOnCol) const;
 
+  static bool startsWithColumns(const vector<size_t>& cols,
+                                const vector<size_t>& prefix);
+
+  // True if the result of tree already has the order asked for by orderBy.
+  static bool isSortedBy(const QueryExecutionTree& tree,
+                         const vector<OrderKey>& orderBy);
+
   void applyFiltersIfPossible(vector<SubtreePlan>& row,
                               const vector<SparqlFilter>& filters,
                               bool replaceInsteadOfAddPlans) const;
 
+  // If a join order is given only plans that follow it are created.
   vector<vector<SubtreePlan>> fillDpTab(
       const TripleGraph& graph, const vector<SparqlFilter>& fs,
-      const vector<SubtreePlan*>& children) const;
+      const vector<SubtreePlan*>& children,
+      const vector<uint64_t>* joinOrder = nullptr) const;
+
+  // Continues the planning with the cheapest plan in the last row of dpTab
+  // as a single unit. Returns the first row of the new table, which holds
+  // all plans for these nodes and the units of dpTab that are not part of
+  // them.
+  vector<vector<SubtreePlan>> collapseDpTab(
+      const vector<vector<SubtreePlan>>& dpTab) const;
+
+  // Appends the shape of the pattern and its children to os, renaming
+  // variables in the order of their first occurrence.
+  static void appendPatternShape(const ParsedQuery::GraphPattern& pattern,
+                                 ad_utility::HashMap<string, size_t>* varIds,
+                                 std::ostringstream* os);
 
   size_t getTextLimit(const string& textLimitString) const;
 
   SubtreePlan getTextLeafPlan(const TripleGraph::Node& node) const;
 
   SubtreePlan optionalJoin(const SubtreePlan& a, const SubtreePlan& b) const;
+
+  // Collects the inputs of a join on the given column of tree. Joins (and
+  // multiway joins) on that same column are unfolded into their inputs.
+  void collectMultiwayJoinInputs(
+      const std::shared_ptr<QueryExecutionTree>& tree, size_t joinCol,
+      vector<std::shared_ptr<QueryExecutionTree>>* children,
+      vector<size_t>* joinCols) const;
+
+  // Finds groups of triples of the form ?x <p> ?y that form cycles over
+  // their variables (the 2-core of the graph with the variables as vertices
+  // and the triples as edges). Each group with at least three triples is
+  // returned as the sorted ids of its nodes.
+  vector<vector<size_t>> getCyclicTripleGroups(const TripleGraph& tg) const;
+
+  // Creates a plan that evaluates the given group of triples with a single
+  // LeapfrogTriejoin over full relation scans.
+  SubtreePlan getLeapfrogTriejoinPlan(const TripleGraph& tg,
+                                      const vector<size_t>& nodes) const;
 };
@@ -18,6 +18,10 @@ QueryPlanningCostFactors::QueryPlanningCostFactors() : _factors() {
   _factors["JOIN_SIZE_ESTIMATE_CORRECTION_FACTOR"] = 0.7;
   _factors["DUMMY_JOIN_SIZE_ESTIMATE_CORRECTION_FACTOR"] = 1000.0;
   _factors["DISK_RANDOM_ACCESS_COST"] = 1000;
+  // Costs of the basic operations relative to the cost of scanning one row.
+  _factors["JOIN_COST_PER_ROW"] = 1.0;
+  _factors["SORT_COST_PER_ROW_AND_LEVEL"] = 1.0;
+  _factors["FILTER_COST_PER_ROW"] = 1.0;
 }
 
 // _____________________________________________________________________________
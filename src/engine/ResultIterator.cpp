@@ -0,0 +1,332 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include "./ResultIterator.h"
+#include <algorithm>
+
+// _____________________________________________________________________________
+void createRowStorage(ResultTable* table) {
+  switch (table->_nofColumns) {
+    case 1:
+      table->_fixedSizeData = new vector<array<Id, 1>>();
+      break;
+    case 2:
+      table->_fixedSizeData = new vector<array<Id, 2>>();
+      break;
+    case 3:
+      table->_fixedSizeData = new vector<array<Id, 3>>();
+      break;
+    case 4:
+      table->_fixedSizeData = new vector<array<Id, 4>>();
+      break;
+    case 5:
+      table->_fixedSizeData = new vector<array<Id, 5>>();
+      break;
+  }
+}
+
+// _____________________________________________________________________________
+void reserveRows(ResultTable* table, size_t nofRows) {
+  switch (table->_nofColumns) {
+    case 1:
+      static_cast<vector<array<Id, 1>>*>(table->_fixedSizeData)
+          ->reserve(nofRows);
+      break;
+    case 2:
+      static_cast<vector<array<Id, 2>>*>(table->_fixedSizeData)
+          ->reserve(nofRows);
+      break;
+    case 3:
+      static_cast<vector<array<Id, 3>>*>(table->_fixedSizeData)
+          ->reserve(nofRows);
+      break;
+    case 4:
+      static_cast<vector<array<Id, 4>>*>(table->_fixedSizeData)
+          ->reserve(nofRows);
+      break;
+    case 5:
+      static_cast<vector<array<Id, 5>>*>(table->_fixedSizeData)
+          ->reserve(nofRows);
+      break;
+    default:
+      table->_varSizeData.reserve(nofRows);
+  }
+}
+
+// _____________________________________________________________________________
+void appendRow(ResultTable* table, const Id* row) {
+  switch (table->_nofColumns) {
+    case 1:
+      static_cast<vector<array<Id, 1>>*>(table->_fixedSizeData)
+          ->push_back(array<Id, 1>{{row[0]}});
+      break;
+    case 2:
+      static_cast<vector<array<Id, 2>>*>(table->_fixedSizeData)
+          ->push_back(array<Id, 2>{{row[0], row[1]}});
+      break;
+    case 3:
+      static_cast<vector<array<Id, 3>>*>(table->_fixedSizeData)
+          ->push_back(array<Id, 3>{{row[0], row[1], row[2]}});
+      break;
+    case 4:
+      static_cast<vector<array<Id, 4>>*>(table->_fixedSizeData)
+          ->push_back(array<Id, 4>{{row[0], row[1], row[2], row[3]}});
+      break;
+    case 5:
+      static_cast<vector<array<Id, 5>>*>(table->_fixedSizeData)
+          ->push_back(
+              array<Id, 5>{{row[0], row[1], row[2], row[3], row[4]}});
+      break;
+    default:
+      table->_varSizeData.emplace_back(row, row + table->_nofColumns);
+  }
+}
+
+// _____________________________________________________________________________
+template <size_t N>
+static void appendFixedRows(vector<array<Id, N>>* rows,
+                            const ResultBlock& block, size_t nofRows) {
+  if (nofRows == 0) {
+    return;
+  }
+  size_t first = rows->size();
+  rows->resize(first + nofRows);
+  // Both store the rows one after another.
+  std::copy(block[0], block[0] + nofRows * N, (*rows)[first].data());
+}
+
+// _____________________________________________________________________________
+void appendRows(ResultTable* table, const ResultBlock& block,
+                size_t nofRows) {
+  switch (table->_nofColumns) {
+    case 1:
+      appendFixedRows(
+          static_cast<vector<array<Id, 1>>*>(table->_fixedSizeData), block,
+          nofRows);
+      break;
+    case 2:
+      appendFixedRows(
+          static_cast<vector<array<Id, 2>>*>(table->_fixedSizeData), block,
+          nofRows);
+      break;
+    case 3:
+      appendFixedRows(
+          static_cast<vector<array<Id, 3>>*>(table->_fixedSizeData), block,
+          nofRows);
+      break;
+    case 4:
+      appendFixedRows(
+          static_cast<vector<array<Id, 4>>*>(table->_fixedSizeData), block,
+          nofRows);
+      break;
+    case 5:
+      appendFixedRows(
+          static_cast<vector<array<Id, 5>>*>(table->_fixedSizeData), block,
+          nofRows);
+      break;
+    default:
+      for (size_t i = 0; i < nofRows; ++i) {
+        table->_varSizeData.emplace_back(block[i],
+                                         block[i] + table->_nofColumns);
+      }
+  }
+}
+
+// _____________________________________________________________________________
+shared_ptr<const ResultTable> ResultIterator::materialize(size_t maxRows,
+                                                          size_t sortedBy) {
+  std::shared_ptr<ResultTable> result = std::make_shared<ResultTable>();
+  size_t width = this->width();
+  result->_nofColumns = width;
+  result->_sortedBy = sortedBy;
+  result->_resultTypes = _resultTypes;
+  createRowStorage(result.get());
+  size_t nofRows = 0;
+  ResultBlock block(width);
+  // Each block is appended as a whole, without looking at its rows.
+  while (nofRows < maxRows && nextBlock(&block)) {
+    size_t n = std::min(block.size(), maxRows - nofRows);
+    appendRows(result.get(), block, n);
+    nofRows += n;
+  }
+  result->finish();
+  return result;
+}
+
+// _____________________________________________________________________________
+MaterializedResultIterator::MaterializedResultIterator(
+    shared_ptr<const ResultTable> result)
+    : _result(result), _rows(*result), _pos(0) {
+  _resultTypes = result->_resultTypes;
+  _resultTypes.resize(result->_nofColumns, ResultTable::ResultType::KB);
+}
+
+// _____________________________________________________________________________
+bool MaterializedResultIterator::nextBlock(ResultBlock* block) {
+  block->reset(width());
+  size_t end = std::min(_rows.size(), _pos + RESULT_BLOCK_SIZE);
+  for (; _pos < end; ++_pos) {
+    block->pushBack(_rows[_pos]);
+  }
+  return block->size() > 0;
+}
+
+// _____________________________________________________________________________
+FilterResultIterator::FilterResultIterator(
+    shared_ptr<ResultIterator> input, std::function<bool(const Id*)> predicate)
+    : _input(input), _predicate(predicate), _inputBlock(input->width()) {
+  _resultTypes = input->getResultTypes();
+}
+
+// _____________________________________________________________________________
+bool FilterResultIterator::nextBlock(ResultBlock* block) {
+  block->reset(width());
+  // Skip input blocks without any matching row, an empty block would signal
+  // the end of the result.
+  while (block->size() == 0 && _input->nextBlock(&_inputBlock)) {
+    for (size_t i = 0; i < _inputBlock.size(); ++i) {
+      if (_predicate(_inputBlock[i])) {
+        block->pushBack(_inputBlock[i]);
+      }
+    }
+  }
+  return block->size() > 0;
+}
+
+// _____________________________________________________________________________
+MergeJoinResultIterator::MergeJoinResultIterator(
+    shared_ptr<ResultIterator> left, shared_ptr<ResultIterator> right,
+    size_t leftJoinCol, size_t rightJoinCol)
+    : _left(left),
+      _right(right),
+      _leftJoinCol(leftJoinCol),
+      _rightJoinCol(rightJoinCol),
+      _leftGroup(left->width()),
+      _rightGroup(right->width()) {
+  _resultTypes = left->getResultTypes();
+  for (size_t i = 0; i < right->width(); ++i) {
+    if (i != rightJoinCol) {
+      _resultTypes.push_back(right->getResultTypes()[i]);
+    }
+  }
+  _row.resize(_resultTypes.size());
+}
+
+// _____________________________________________________________________________
+bool MergeJoinResultIterator::Cursor::valid() {
+  while (!_done && _pos >= _block.size()) {
+    _pos = 0;
+    _done = !_input->nextBlock(&_block);
+  }
+  return !_done;
+}
+
+// _____________________________________________________________________________
+void MergeJoinResultIterator::Cursor::collectGroup(size_t col, Id key,
+                                                   ResultBlock* group) {
+  group->clear();
+  // A group may continue in the next block.
+  while (valid() && row()[col] == key) {
+    group->pushBack(row());
+    advance();
+  }
+}
+
+// _____________________________________________________________________________
+bool MergeJoinResultIterator::nextBlock(ResultBlock* block) {
+  block->reset(width());
+  size_t leftWidth = _leftGroup.width();
+  size_t rightWidth = _rightGroup.width();
+  while (block->size() < RESULT_BLOCK_SIZE && _left.valid() &&
+         _right.valid()) {
+    Id l = _left.row()[_leftJoinCol];
+    Id r = _right.row()[_rightJoinCol];
+    if (l < r) {
+      _left.advance();
+    } else if (r < l) {
+      _right.advance();
+    } else {
+      _left.collectGroup(_leftJoinCol, l, &_leftGroup);
+      _right.collectGroup(_rightJoinCol, r, &_rightGroup);
+      for (size_t i = 0; i < _leftGroup.size(); ++i) {
+        std::copy(_leftGroup[i], _leftGroup[i] + leftWidth, _row.begin());
+        for (size_t j = 0; j < _rightGroup.size(); ++j) {
+          size_t out = leftWidth;
+          for (size_t c = 0; c < rightWidth; ++c) {
+            if (c != _rightJoinCol) {
+              _row[out++] = _rightGroup[j][c];
+            }
+          }
+          block->pushBack(_row.data());
+        }
+      }
+    }
+  }
+  return block->size() > 0;
+}
+
+// _____________________________________________________________________________
+ExternalSortResultIterator::ExternalSortResultIterator(
+    shared_ptr<ResultIterator> input,
+    ad_utility::ExternalSorter<Id>::Comparator lessThan, size_t memoryBudget,
+    const std::string& directory,
+    const ad_utility::CancellationHandle* cancellation)
+    : _input(input),
+      _sorter(input->width(), lessThan, memoryBudget, directory,
+              cancellation) {
+  _resultTypes = input->getResultTypes();
+}
+
+// _____________________________________________________________________________
+bool ExternalSortResultIterator::nextBlock(ResultBlock* block) {
+  if (_input) {
+    ResultBlock inputBlock(width());
+    while (_input->nextBlock(&inputBlock)) {
+      for (size_t i = 0; i < inputBlock.size(); ++i) {
+        _sorter.push(inputBlock[i]);
+      }
+    }
+    // Release the input, it might hold a materialized result.
+    _input.reset();
+    LOG(DEBUG) << "External sort of " << _sorter.size() << " rows" << std::endl;
+  }
+  block->reset(width());
+  const Id* row;
+  while (block->size() < RESULT_BLOCK_SIZE && (row = _sorter.next())) {
+    block->pushBack(row);
+  }
+  return block->size() > 0;
+}
+
+// _____________________________________________________________________________
+RuntimeInfoResultIterator::RuntimeInfoResultIterator(
+    shared_ptr<ResultIterator> input, RuntimeInformation* info)
+    : _input(input), _info(info), _nofRows(0), _recorded(false) {
+  _resultTypes = input->getResultTypes();
+}
+
+// _____________________________________________________________________________
+RuntimeInfoResultIterator::~RuntimeInfoResultIterator() { record(); }
+
+// _____________________________________________________________________________
+bool RuntimeInfoResultIterator::nextBlock(ResultBlock* block) {
+  _timer.cont();
+  bool hasRows = _input->nextBlock(block);
+  _timer.stop();
+  _nofRows += block->size();
+  if (!hasRows) {
+    record();
+  }
+  return hasRows;
+}
+
+// _____________________________________________________________________________
+void RuntimeInfoResultIterator::record() {
+  if (_recorded) {
+    return;
+  }
+  _recorded = true;
+  // The rows were passed on block by block, they never used memory at once.
+  _info->setComputed(_timer.usecs() / 1000.0, _nofRows, width(), 0);
+  _info->addDetail("result", "streamed");
+}
@@ -0,0 +1,270 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../global/Constants.h"
+#include "../global/Id.h"
+#include "../util/ExternalSorter.h"
+#include "../util/Timer.h"
+#include "./ResultTable.h"
+#include "./RuntimeInformation.h"
+
+using std::shared_ptr;
+using std::vector;
+
+// Read access to the rows of a result table regardless of its width. The
+// storage of the rows is resolved once when the access is created, not for
+// every row: the rows of a fixed width are stored one after another, so a row
+// is found by its offset.
+class RowAccess {
+ public:
+  explicit RowAccess(const ResultTable& table)
+      : _fixedRows(nullptr),
+        _varRows(&table._varSizeData),
+        _width(table._nofColumns),
+        _size(table.size()) {
+    static_assert(sizeof(array<Id, 5>) == 5 * sizeof(Id),
+                  "Rows of a fixed width have to be stored without padding");
+    if (table._fixedSizeData) {
+      _fixedRows = fixedRows(table);
+      _varRows = nullptr;
+    }
+  }
+
+  const Id* operator[](size_t row) const {
+    return _varRows ? (*_varRows)[row].data() : _fixedRows + row * _width;
+  }
+
+  size_t size() const { return _size; }
+
+  size_t width() const { return _width; }
+
+ private:
+  static const Id* fixedRows(const ResultTable& table) {
+    switch (table._nofColumns) {
+      case 1:
+        return rowData<1>(table);
+      case 2:
+        return rowData<2>(table);
+      case 3:
+        return rowData<3>(table);
+      case 4:
+        return rowData<4>(table);
+      case 5:
+        return rowData<5>(table);
+      default:
+        AD_THROW(ad_semsearch::Exception::CHECK_FAILED,
+                 "Fixed size rows of an unsupported width.");
+    }
+  }
+
+  template <size_t N>
+  static const Id* rowData(const ResultTable& table) {
+    const auto& rows =
+        *static_cast<const vector<array<Id, N>>*>(table._fixedSizeData);
+    return rows.empty() ? nullptr : rows[0].data();
+  }
+
+  const Id* _fixedRows;
+  const vector<vector<Id>>* _varRows;
+  size_t _width;
+  size_t _size;
+};
+
+// Creates the empty storage for the rows of a table with _nofColumns columns.
+void createRowStorage(ResultTable* table);
+
+// Reserves the storage of a table for nofRows rows.
+void reserveRows(ResultTable* table, size_t nofRows);
+
+// Appends a row to a table whose storage has been created.
+void appendRow(ResultTable* table, const Id* row);
+
+class ResultBlock;
+
+// Appends the first nofRows rows of block to a table whose storage has been
+// created.
+void appendRows(ResultTable* table, const ResultBlock& block, size_t nofRows);
+
+// A block of consecutive result rows, stored row by row in one vector.
+class ResultBlock {
+ public:
+  explicit ResultBlock(size_t width = 0) : _width(width), _data() {}
+
+  size_t size() const { return _width == 0 ? 0 : _data.size() / _width; }
+
+  size_t width() const { return _width; }
+
+  const Id* operator[](size_t row) const { return &_data[row * _width]; }
+
+  void pushBack(const Id* row) {
+    _data.insert(_data.end(), row, row + _width);
+  }
+
+  void clear() { _data.clear(); }
+
+  void reset(size_t width) {
+    _width = width;
+    _data.clear();
+  }
+
+ private:
+  size_t _width;
+  vector<Id> _data;
+};
+
+// Pull-based access to the result of an operation, one block of rows at a
+// time. Operations that can compute their result incrementally (e.g. filters
+// and merge joins) provide iterators that only compute as many rows as are
+// actually requested, all others materialize their result first.
+class ResultIterator {
+ public:
+  virtual ~ResultIterator() {}
+
+  // Replaces the content of block by the next rows of the result. Returns
+  // false iff the result is exhausted, in which case the block is empty.
+  virtual bool nextBlock(ResultBlock* block) = 0;
+
+  size_t width() const { return _resultTypes.size(); }
+
+  const vector<ResultTable::ResultType>& getResultTypes() const {
+    return _resultTypes;
+  }
+
+  // Collects (at least) the first maxRows rows of the result into a table.
+  // The table is not cached, it is only meant for writing a limited
+  // result. Its rows are sorted on column sortedBy, as the operation that
+  // computes them states with resultSortedOn.
+  virtual shared_ptr<const ResultTable> materialize(size_t maxRows,
+                                                    size_t sortedBy);
+
+ protected:
+  vector<ResultTable::ResultType> _resultTypes;
+};
+
+// Iterates over a result that has already been computed.
+class MaterializedResultIterator : public ResultIterator {
+ public:
+  explicit MaterializedResultIterator(shared_ptr<const ResultTable> result);
+
+  virtual bool nextBlock(ResultBlock* block);
+
+  // The result is already there, no need to copy it.
+  virtual shared_ptr<const ResultTable> materialize(size_t, size_t) {
+    return _result;
+  }
+
+ private:
+  shared_ptr<const ResultTable> _result;
+  RowAccess _rows;
+  size_t _pos;
+};
+
+// Keeps the rows of the input for which the predicate holds.
+class FilterResultIterator : public ResultIterator {
+ public:
+  FilterResultIterator(shared_ptr<ResultIterator> input,
+                       std::function<bool(const Id*)> predicate);
+
+  virtual bool nextBlock(ResultBlock* block);
+
+ private:
+  shared_ptr<ResultIterator> _input;
+  std::function<bool(const Id*)> _predicate;
+  ResultBlock _inputBlock;
+};
+
+// Merge join of two inputs that are sorted on their join columns. The
+// result rows consist of the left row followed by the right row without its
+// join column, exactly as for Join.
+class MergeJoinResultIterator : public ResultIterator {
+ public:
+  MergeJoinResultIterator(shared_ptr<ResultIterator> left,
+                          shared_ptr<ResultIterator> right, size_t leftJoinCol,
+                          size_t rightJoinCol);
+
+  virtual bool nextBlock(ResultBlock* block);
+
+ private:
+  // The current position in one of the inputs.
+  class Cursor {
+   public:
+    explicit Cursor(shared_ptr<ResultIterator> input)
+        : _input(input), _block(input->width()), _pos(0), _done(false) {}
+
+    // Makes sure the cursor points to a row unless the input is exhausted.
+    bool valid();
+
+    const Id* row() const { return _block[_pos]; }
+
+    void advance() { ++_pos; }
+
+    // Appends all rows starting at the current one that have the given key
+    // in column col to group and moves behind them.
+    void collectGroup(size_t col, Id key, ResultBlock* group);
+
+   private:
+    shared_ptr<ResultIterator> _input;
+    ResultBlock _block;
+    size_t _pos;
+    bool _done;
+  };
+
+  Cursor _left;
+  Cursor _right;
+  size_t _leftJoinCol;
+  size_t _rightJoinCol;
+  ResultBlock _leftGroup;
+  ResultBlock _rightGroup;
+  vector<Id> _row;
+};
+
+// Sorts its input with an external merge sort, see ad_utility::ExternalSorter,
+// so that neither the input nor the sorted result has to fit into memory.
+// The input is consumed completely on the first call of nextBlock.
+class ExternalSortResultIterator : public ResultIterator {
+ public:
+  ExternalSortResultIterator(
+      shared_ptr<ResultIterator> input,
+      ad_utility::ExternalSorter<Id>::Comparator lessThan, size_t memoryBudget,
+      const std::string& directory,
+      const ad_utility::CancellationHandle* cancellation);
+
+  virtual bool nextBlock(ResultBlock* block);
+
+  // The number of sorted runs written to disk, valid after the first block.
+  size_t getNofRuns() const { return _sorter.getNofRuns(); }
+
+ private:
+  shared_ptr<ResultIterator> _input;
+  ad_utility::ExternalSorter<Id> _sorter;
+};
+
+// Records the time spent in its input and the number of rows it returned in
+// the runtime information of the operation that computes the input block by
+// block. This happens when the input is exhausted or, if it is not consumed
+// completely, when this iterator is destroyed. The information must outlive
+// the iterator.
+class RuntimeInfoResultIterator : public ResultIterator {
+ public:
+  RuntimeInfoResultIterator(shared_ptr<ResultIterator> input,
+                            RuntimeInformation* info);
+
+  virtual ~RuntimeInfoResultIterator();
+
+  virtual bool nextBlock(ResultBlock* block);
+
+ private:
+  void record();
+
+  shared_ptr<ResultIterator> _input;
+  RuntimeInformation* _info;
+  ad_utility::Timer _timer;
+  size_t _nofRows;
+  bool _recorded;
+};
@@ -11,7 +11,9 @@ ResultTable::ResultTable()
       _sortedBy(0),
       _varSizeData(),
       _fixedSizeData(nullptr),
-      _status(ResultTable::OTHER) {}
+      _status(ResultTable::OTHER),
+      _memoryTracker(),
+      _trackedBytes(0) {}
 
 // _____________________________________________________________________________
 void ResultTable::clear() {
@@ -45,6 +47,11 @@ void ResultTable::clear() {
   _fixedSizeData = nullptr;
   _varSizeData.clear();
   _status = OTHER;
+  if (_memoryTracker) {
+    _memoryTracker->free(_trackedBytes);
+    _memoryTracker.reset();
+    _trackedBytes = 0;
+  }
 }
 
 // _____________________________________________________________________________
@@ -128,3 +135,51 @@ size_t ResultTable::size() const {
   }
   return rv;
 }
+
+// _____________________________________________________________________________
+size_t ResultTable::getMemoryUsage() const {
+  size_t bytes = getMinMemoryUsage();
+  for (const auto& row : _varSizeData) {
+    bytes += row.capacity() * sizeof(Id);
+  }
+  for (const auto& word : _localVocab) {
+    bytes += word.capacity();
+  }
+  return bytes;
+}
+
+// _____________________________________________________________________________
+size_t ResultTable::getMinMemoryUsage() const {
+  size_t bytes = sizeof(ResultTable);
+  if (_fixedSizeData) {
+    size_t capacity = 0;
+    if (_nofColumns == 1) {
+      capacity = static_cast<vector<array<Id, 1>>*>(_fixedSizeData)->capacity();
+    }
+    if (_nofColumns == 2) {
+      capacity = static_cast<vector<array<Id, 2>>*>(_fixedSizeData)->capacity();
+    }
+    if (_nofColumns == 3) {
+      capacity = static_cast<vector<array<Id, 3>>*>(_fixedSizeData)->capacity();
+    }
+    if (_nofColumns == 4) {
+      capacity = static_cast<vector<array<Id, 4>>*>(_fixedSizeData)->capacity();
+    }
+    if (_nofColumns == 5) {
+      capacity = static_cast<vector<array<Id, 5>>*>(_fixedSizeData)->capacity();
+    }
+    bytes += sizeof(vector<Id>) + capacity * _nofColumns * sizeof(Id);
+  }
+  bytes += _varSizeData.capacity() * sizeof(vector<Id>);
+  bytes += _localVocab.capacity() * sizeof(string);
+  return bytes;
+}
+
+// _____________________________________________________________________________
+void ResultTable::trackMemory(
+    std::shared_ptr<ad_utility::MemoryTracker> tracker, size_t bytes) {
+  AD_CHECK(!_memoryTracker);
+  tracker->allocate(bytes);
+  _memoryTracker = tracker;
+  _trackedBytes = bytes;
+}
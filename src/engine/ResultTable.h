@@ -4,11 +4,14 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <vector>
 #include "../global/Id.h"
 #include "../util/Exception.h"
+#include "../util/MemoryTracker.h"
 
 using std::array;
 using std::condition_variable;
@@ -19,7 +22,7 @@ using std::vector;
 
 class ResultTable {
  public:
-  enum Status { FINISHED = 0, OTHER = 1 };
+  enum Status { FINISHED = 0, OTHER = 1, ABORTED = 2 };
 
   /**
    * @brief Describes the type of a columns data
@@ -76,11 +79,48 @@ class ResultTable {
     return tmp;
   }
 
+  // Marks the result as never going to be finished, e.g. because its
+  // computation failed. Wakes up all threads waiting for the result. Has no
+  // effect on results that are already finished.
+  void abort() {
+    lock_guard<mutex> lk(_cond_var_m);
+    if (_status == ResultTable::FINISHED) {
+      return;
+    }
+    _status = ResultTable::ABORTED;
+    _cond_var.notify_all();
+  }
+
+  bool isAborted() const {
+    lock_guard<mutex> lk(_cond_var_m);
+    return _status == ResultTable::ABORTED;
+  }
+
+  // Waits until the result is either finished or aborted.
   void awaitFinished() const {
     unique_lock<mutex> lk(_cond_var_m);
-    _cond_var.wait(lk, [&] { return _status == ResultTable::FINISHED; });
+    _cond_var.wait(lk, [&] {
+      return _status == ResultTable::FINISHED ||
+             _status == ResultTable::ABORTED;
+    });
   }
 
+  // Estimate of the number of bytes held by this result.
+  size_t getMemoryUsage() const;
+
+  // Lower bound of getMemoryUsage that does not look at the single rows of
+  // variable size, cheap enough to be measured while the result is computed.
+  size_t getMinMemoryUsage() const;
+
+  // Accounts for bytes, the memory usage of this result measured by the
+  // caller, in the tracker until the result is cleared or destroyed.
+  void trackMemory(std::shared_ptr<ad_utility::MemoryTracker> tracker,
+                   size_t bytes);
+
+  // The bytes accounted for by trackMemory, 0 if the result is not tracked
+  // (yet). Unlike getMemoryUsage this does not look at the rows.
+  size_t getTrackedMemoryUsage() const { return _trackedBytes; }
+
   std::string idToString(Id id) const {
     if (id < _localVocab.size()) {
       return _localVocab[id];
@@ -146,4 +186,8 @@ class ResultTable {
   mutable condition_variable _cond_var;
   mutable mutex _cond_var_m;
   Status _status;
+  std::shared_ptr<ad_utility::MemoryTracker> _memoryTracker;
+  // Read by queries that take the result from the cache, possibly while the
+  // query that computed it is still accounting for it.
+  std::atomic<size_t> _trackedBytes;
 };
@@ -0,0 +1,180 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../util/StringUtils.h"
+
+using std::string;
+using std::vector;
+
+// Information about how an operation was actually executed, e.g. which
+// algorithm it chose based on the sizes of its inputs, how long it took and
+// how large its result was. QueryExecutionTree::getRuntimeInfo combines the
+// information of all operations of a tree with their estimates.
+class RuntimeInformation {
+ public:
+  enum class Status { NOT_COMPUTED, COMPUTED, CACHED };
+
+  RuntimeInformation()
+      : _status(Status::NOT_COMPUTED),
+        _totalTime(0),
+        _nofRows(0),
+        _nofColumns(0),
+        _memoryUsage(0),
+        _concurrentChildren(false),
+        _sizeEstimate(0),
+        _costEstimate(0) {}
+
+  void addDetail(const string& key, const string& value) {
+    _details[key] = value;
+  }
+
+  const std::map<string, string>& getDetails() const { return _details; }
+
+  // The result was computed in totalTime milliseconds, including the time
+  // for the results of the children that were not cached.
+  void setComputed(double totalTime, size_t nofRows, size_t nofColumns,
+                   size_t memoryUsage) {
+    _status = Status::COMPUTED;
+    _totalTime = totalTime;
+    setResult(nofRows, nofColumns, memoryUsage);
+  }
+
+  // The result was taken from the cache. Does not override a computation of
+  // the same operation before.
+  void setCached(size_t nofRows, size_t nofColumns, size_t memoryUsage) {
+    if (_status == Status::NOT_COMPUTED) {
+      _status = Status::CACHED;
+      setResult(nofRows, nofColumns, memoryUsage);
+    }
+  }
+
+  // The children were computed at the same time, so their times overlap.
+  void setChildrenComputedConcurrently() { _concurrentChildren = true; }
+
+  void setDescriptor(const string& name, const string& description) {
+    _name = name;
+    _description = description;
+  }
+
+  void setColumnNames(const vector<string>& columnNames) {
+    _columnNames = columnNames;
+  }
+
+  void setSizeEstimate(size_t sizeEstimate) { _sizeEstimate = sizeEstimate; }
+
+  void setCostEstimate(size_t costEstimate) { _costEstimate = costEstimate; }
+
+  void addChild(const RuntimeInformation& child) {
+    _children.push_back(child);
+  }
+
+  Status getStatus() const { return _status; }
+  double getTotalTime() const { return _totalTime; }
+  size_t getNofRows() const { return _nofRows; }
+  size_t getNofColumns() const { return _nofColumns; }
+  size_t getMemoryUsage() const { return _memoryUsage; }
+  size_t getSizeEstimate() const { return _sizeEstimate; }
+  size_t getCostEstimate() const { return _costEstimate; }
+  const vector<RuntimeInformation>& getChildren() const { return _children; }
+
+  // The time spent in this operation itself, without the time for computing
+  // the results of its children. For children that were computed
+  // concurrently only the time of the slowest one is subtracted. This
+  // overestimates the own time if they did not actually run at the same
+  // time, e.g. because all workers were busy.
+  double getOwnTime() const {
+    double childrenTime = 0;
+    for (const RuntimeInformation& child : _children) {
+      if (child._status == Status::COMPUTED) {
+        childrenTime = _concurrentChildren
+                           ? std::max(childrenTime, child._totalTime)
+                           : childrenTime + child._totalTime;
+      }
+    }
+    double ownTime = _totalTime - childrenTime;
+    return ownTime > 0 ? ownTime : 0;
+  }
+
+  string asString() const {
+    std::ostringstream os;
+    for (auto it = _details.begin(); it != _details.end(); ++it) {
+      os << (it == _details.begin() ? "" : ", ") << it->first << ": "
+         << it->second;
+    }
+    return os.str();
+  }
+
+  // Writes this information and that of all children as a JSON object.
+  void writeJson(std::ostream& out) const {
+    out << "{\"operation\": \"" << ad_utility::escapeForJson(_name) << "\", ";
+    if (!_description.empty()) {
+      out << "\"description\": \"" << ad_utility::escapeForJson(_description)
+          << "\", ";
+    }
+    out << "\"columns\": [";
+    for (size_t i = 0; i < _columnNames.size(); ++i) {
+      out << (i == 0 ? "\"" : ", \"")
+          << ad_utility::escapeForJson(_columnNames[i]) << "\"";
+    }
+    out << "], \"status\": \"" << getStatusName() << "\", "
+        << "\"total_time_ms\": " << _totalTime << ", "
+        << "\"own_time_ms\": " << getOwnTime() << ", "
+        << "\"rows\": " << _nofRows << ", "
+        << "\"estimated_rows\": " << _sizeEstimate << ", "
+        << "\"estimated_cost\": " << _costEstimate << ", "
+        << "\"memory_bytes\": " << _memoryUsage << ", "
+        << "\"details\": {";
+    for (auto it = _details.begin(); it != _details.end(); ++it) {
+      out << (it == _details.begin() ? "\"" : ", \"")
+          << ad_utility::escapeForJson(it->first) << "\": \""
+          << ad_utility::escapeForJson(it->second) << "\"";
+    }
+    out << "}, \"children\": [";
+    for (size_t i = 0; i < _children.size(); ++i) {
+      out << (i == 0 ? "" : ", ");
+      _children[i].writeJson(out);
+    }
+    out << "]}";
+  }
+
+ private:
+  void setResult(size_t nofRows, size_t nofColumns, size_t memoryUsage) {
+    _nofRows = nofRows;
+    _nofColumns = nofColumns;
+    _memoryUsage = memoryUsage;
+  }
+
+  string getStatusName() const {
+    switch (_status) {
+      case Status::COMPUTED:
+        return "computed";
+      case Status::CACHED:
+        return "cached";
+      default:
+        return "not computed";
+    }
+  }
+
+  std::map<string, string> _details;
+  Status _status;
+  double _totalTime;
+  size_t _nofRows;
+  size_t _nofColumns;
+  size_t _memoryUsage;
+  bool _concurrentChildren;
+
+  // Set by QueryExecutionTree::getRuntimeInfo.
+  string _name;
+  string _description;
+  vector<string> _columnNames;
+  size_t _sizeEstimate;
+  size_t _costEstimate;
+  vector<RuntimeInformation> _children;
+};
@@ -46,6 +46,10 @@ class ScanningJoin : public IndexScan {
     return _subtree->knownEmptyResult() || IndexScan::knownEmptyResult();
   }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree};
+  }
+
  private:
   QueryExecutionTree* _subtree;
   size_t _subtreeJoinCol;
@@ -3,6 +3,8 @@
 // Author: Björn Buchhold <buchholb>
 
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
 #include <sstream>
 #include <string>
@@ -53,6 +55,20 @@ void Server::run() {
     exit(1);
   }
   QueryExecutionContext qec(_index, _engine);
+  qec.setSortOptions(_sortMemory, _sortDirectory);
+  qec.setCacheMemory(_cacheMemory);
+  qec.setCacheEvictionPolicy(_cacheEvictionPolicy);
+  // Each thread that accepts requests computes its query itself, the workers
+  // only help with the independent parts of the queries. Sharing them bounds
+  // the number of busy threads, no matter how many queries run at once.
+  int nofWorkers = _nofQueryWorkers;
+  if (nofWorkers < 0) {
+    nofWorkers = std::max(
+        0, static_cast<int>(std::thread::hardware_concurrency()) - _numThreads);
+  }
+  LOG(INFO) << "Using " << nofWorkers << " threads to compute independent "
+            << "parts of queries." << std::endl;
+  qec.setNofWorkers(static_cast<size_t>(nofWorkers));
   std::vector<std::thread> threads;
   for (int i = 0; i < _numThreads; ++i) {
     threads.emplace_back(&Server::runAcceptLoop, this, &qec);
@@ -165,9 +181,24 @@ void Server::process(Socket* client, QueryExecutionContext* qec) const {
       // QueryGraph qg(qec);
       // qg.createFromParsedQuery(pq);
       // const QueryExecutionTree& qet = qg.getExecutionTree();
-      QueryPlanner qp(qec, _optimizeOptionals);
+      double timeout = _queryTimeout;
+      it = params.find("timeout");
+      if (it != params.end()) {
+        double requestedTimeout;
+        if (!parseTimeout(it->second, &requestedTimeout)) {
+          LOG(INFO) << "Invalid timeout \"" << it->second << "\", "
+                    << "responding with 400 Bad Request.\n";
+          auto bytesSent = client->send(create400HttpResponse());
+          LOG(DEBUG) << "Sent " << bytesSent << " bytes." << std::endl;
+          return;
+        }
+        timeout = std::min(timeout, requestedTimeout);
+      }
+      QueryExecutionContext queryQec(*qec, _memoryLimitPerQuery, timeout);
+      QueryPlanner qp(&queryQec, _optimizeOptionals);
       QueryExecutionTree qet = qp.createExecutionTree(pq);
-      LOG(INFO) << qet.asString() << std::endl;
+      LOG(INFO) << "Planned with " << qp.getPlanningAlgorithmName() << ":\n"
+                << qet.asString() << std::endl;
 
       if (ad_utility::getLowercase(params["action"]) == "csv_export") {
         // CSV export
@@ -183,9 +214,15 @@ void Server::process(Socket* client, QueryExecutionContext* qec) const {
             "Content-Disposition: attachment;filename=export.tsv";
       } else {
         // Normal case: JSON response
-        response = composeResponseJson(pq, qet, maxSend);
+        bool analyze = ad_utility::getLowercase(params["analyze"]) == "true";
+        response = composeResponseJson(pq, qet, maxSend, analyze);
         contentType = "application/json";
       }
+      LOG(INFO) << "Memory of the results computed for the query: "
+                << queryQec.getQueryMemoryTracker()->getBytesUsed()
+                << " bytes, of all results held: "
+                << qec->getResultMemoryTracker()->getBytesUsed() << " bytes."
+                << std::endl;
     } catch (const ad_semsearch::Exception& e) {
       response = composeResponseJson(query, e);
     } catch (const ParseException& e) {
@@ -278,6 +315,19 @@ string Server::createQueryFromHttpParams(const ParamValueMap& params) const {
   return it->second;
 }
 
+// _____________________________________________________________________________
+bool Server::parseTimeout(const string& value, double* timeout) {
+  const char* begin = value.c_str();
+  char* end;
+  double seconds = strtod(begin, &end);
+  if (end == begin || *end != '\0' || !std::isfinite(seconds) ||
+      seconds <= 0) {
+    return false;
+  }
+  *timeout = seconds;
+  return true;
+}
+
 // _____________________________________________________________________________
 string Server::createHttpResponse(const string& content,
                                   const string& contentType) const {
@@ -317,14 +367,28 @@ string Server::create400HttpResponse() const {
 
 // _____________________________________________________________________________
 string Server::composeResponseJson(const ParsedQuery& query,
-                                   const QueryExecutionTree& qet,
-                                   size_t maxSend) const {
+                                   QueryExecutionTree& qet, size_t maxSend,
+                                   bool analyze) const {
   // TODO(schnelle) we really should use a json library
   // such as https://github.com/nlohmann/json
-  shared_ptr<const ResultTable> rt = qet.getResult();
+  size_t limit = MAX_NOF_ROWS_IN_RESULT;
+  size_t offset = 0;
+  if (query._limit.size() > 0) {
+    limit = static_cast<size_t>(atol(query._limit.c_str()));
+  }
+  if (query._offset.size() > 0) {
+    offset = static_cast<size_t>(atol(query._offset.c_str()));
+  }
+  // The result is computed while it is written, only as far as needed for
+  // the limit if the operations allow it. So the result size is what the
+  // writer computed, not necessarily the size of the whole result.
+  std::ostringstream resultJson;
+  ad_utility::Timer computeTimer;
+  computeTimer.start();
+  size_t resultSize = qet.writeResultToStreamAsJson(
+      resultJson, query._selectedVariables, limit, offset, maxSend);
+  computeTimer.stop();
   _requestProcessingTimer.stop();
-  off_t compResultUsecs = _requestProcessingTimer.usecs();
-  size_t resultSize = rt->size();
 
   std::ostringstream os;
   os << "{\n"
@@ -341,26 +405,17 @@ string Server::composeResponseJson(const ParsedQuery& query,
     os << "[],\n";
   }
 
-  os << "\"res\": ";
-  size_t limit = MAX_NOF_ROWS_IN_RESULT;
-  size_t offset = 0;
-  if (query._limit.size() > 0) {
-    limit = static_cast<size_t>(atol(query._limit.c_str()));
-  }
-  if (query._offset.size() > 0) {
-    offset = static_cast<size_t>(atol(query._offset.c_str()));
-  }
-  _requestProcessingTimer.cont();
-  qet.writeResultToStreamAsJson(os, query._selectedVariables, limit, offset,
-                                maxSend);
-  _requestProcessingTimer.stop();
-  os << ",\n";
+  os << "\"res\": " << resultJson.str() << ",\n";
 
   os << "\"time\": {\n"
      << "\"total\": \"" << _requestProcessingTimer.usecs() / 1000.0 << "ms\",\n"
-     << "\"computeResult\": \"" << compResultUsecs / 1000.0 << "ms\"\n"
-     << "}\n"
-     << "}\n";
+     << "\"computeResult\": \"" << computeTimer.usecs() / 1000.0 << "ms\"\n"
+     << "}";
+  if (analyze) {
+    os << ",\n\"runtimeInformation\": ";
+    qet.getRuntimeInfo().writeJson(os);
+  }
+  os << "\n}\n";
 
   return os.str();
 }
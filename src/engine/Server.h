@@ -24,8 +24,18 @@ using ad_utility::Socket;
 //! The HTTP Sever used.
 class Server {
  public:
-  explicit Server(const int port, const int numThreads)
+  explicit Server(const int port, const int numThreads,
+                  size_t memoryLimitPerQuery =
+                      DEFAULT_MEMORY_LIMIT_PER_QUERY_IN_GB << 30,
+                  double queryTimeout = DEFAULT_QUERY_TIMEOUT_IN_SECONDS)
       : _numThreads(numThreads),
+        _memoryLimitPerQuery(memoryLimitPerQuery),
+        _queryTimeout(queryTimeout),
+        _sortMemory(DEFAULT_SORT_MEMORY_IN_GB << 30),
+        _sortDirectory(DEFAULT_SORT_DIRECTORY),
+        _cacheMemory(DEFAULT_CACHE_MEMORY_IN_GB << 30),
+        _cacheEvictionPolicy(ad_utility::EvictionPolicy::LRU),
+        _nofQueryWorkers(-1),
         _serverSocket(),
         _port(port),
         _index(),
@@ -42,8 +52,38 @@ class Server {
   //! Loop, wait for requests and trigger processing.
   void run();
 
+  // Inputs of sorts that need more than memory bytes are sorted externally
+  // with temporary files in directory.
+  void setSortOptions(size_t memory, const string& directory) {
+    _sortMemory = memory;
+    _sortDirectory = directory;
+  }
+
+  // The results cached between queries may use at most that many bytes.
+  void setCacheMemory(size_t bytes) { _cacheMemory = bytes; }
+
+  void setCacheEvictionPolicy(ad_utility::EvictionPolicy policy) {
+    _cacheEvictionPolicy = policy;
+  }
+
+  // Number of threads shared by all queries that compute independent parts
+  // of a query, in addition to the threads that accept requests. By default
+  // these are the hardware threads not used by the latter.
+  void setNofQueryWorkers(int nofWorkers) { _nofQueryWorkers = nofWorkers; }
+
  private:
   const int _numThreads;
+  // Maximum number of bytes of the results computed for a single query.
+  const size_t _memoryLimitPerQuery;
+  // Maximum time in seconds a query may take, can be lowered per request
+  // with the "timeout" parameter.
+  const double _queryTimeout;
+  size_t _sortMemory;
+  string _sortDirectory;
+  size_t _cacheMemory;
+  ad_utility::EvictionPolicy _cacheEvictionPolicy;
+  // Negative if not configured.
+  int _nofQueryWorkers;
   Socket _serverSocket;
   int _port;
   Index _index;
@@ -62,15 +102,21 @@ class Server {
 
   string createQueryFromHttpParams(const ParamValueMap& params) const;
 
+  // Parses the value of the timeout parameter in seconds. Returns false if it
+  // is not a positive number.
+  static bool parseTimeout(const string& value, double* timeout);
+
   string createHttpResponse(const string& content,
                             const string& contentType) const;
 
   string create404HttpResponse() const;
   string create400HttpResponse() const;
 
-  string composeResponseJson(const ParsedQuery& query,
-                             const QueryExecutionTree& qet,
-                             size_t sendMax = MAX_NOF_ROWS_IN_RESULT) const;
+  // With analyze, the runtime information of all operations of qet is added
+  // to the response.
+  string composeResponseJson(const ParsedQuery& query, QueryExecutionTree& qet,
+                             size_t sendMax = MAX_NOF_ROWS_IN_RESULT,
+                             bool analyze = false) const;
 
   string composeResponseSepValues(const ParsedQuery& query,
                                   const QueryExecutionTree& qet,
@@ -26,8 +26,37 @@ string Sort::asString(size_t indent) const {
   return os.str();
 }
 
+// _____________________________________________________________________________
+ad_utility::ExternalSorter<Id>::Comparator Sort::getComparator() const {
+  size_t sortCol = _sortCol;
+  return [sortCol](const Id* a, const Id* b) {
+    return a[sortCol] < b[sortCol];
+  };
+}
+
+// _____________________________________________________________________________
+shared_ptr<ResultIterator> Sort::getResultIterator(bool cacheResult) const {
+  shared_ptr<const ResultTable> cached = getCachedResult();
+  if (cached) {
+    return iterateCachedResult(cached);
+  }
+  if (!needsExternalSort(_subtree->getRootOperation())) {
+    return Operation::getResultIterator(cacheResult);
+  }
+  // The sorted rows are streamed, they are neither materialized nor cached.
+  return recordRuntimeInfo(
+      sortExternally(_subtree->getRootOperation(), getComparator()));
+}
+
 // _____________________________________________________________________________
 void Sort::computeResult(ResultTable* result) const {
+  if (needsExternalSort(_subtree->getRootOperation()) &&
+      computeSortedExternally(_subtree->getRootOperation(), getComparator(),
+                              result)) {
+    result->_sortedBy = _sortCol;
+    result->finish();
+    return;
+  }
   LOG(DEBUG) << "Getting sub-result for Sort result computation..." << endl;
   shared_ptr<const ResultTable> subRes = _subtree->getResult();
   LOG(DEBUG) << "Sort result computation..." << endl;
@@ -41,19 +70,19 @@ void Sort::computeResult(ResultTable* result) const {
       auto res = new vector<array<Id, 1>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 1>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, _sortCol);
+      getEngine().sort(*res, _sortCol, getCancellationHandle());
     } break;
     case 2: {
       auto res = new vector<array<Id, 2>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 2>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, _sortCol);
+      getEngine().sort(*res, _sortCol, getCancellationHandle());
       break;
     }
     case 3: {
       auto res = new vector<array<Id, 3>>();
       *res = *static_cast<vector<array<Id, 3>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, _sortCol);
+      getEngine().sort(*res, _sortCol, getCancellationHandle());
       result->_fixedSizeData = res;
       break;
     }
@@ -61,19 +90,19 @@ void Sort::computeResult(ResultTable* result) const {
       auto res = new vector<array<Id, 4>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 4>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, _sortCol);
+      getEngine().sort(*res, _sortCol, getCancellationHandle());
       break;
     }
     case 5: {
       auto res = new vector<array<Id, 5>>();
       result->_fixedSizeData = res;
       *res = *static_cast<vector<array<Id, 5>>*>(subRes->_fixedSizeData);
-      getEngine().sort(*res, _sortCol);
+      getEngine().sort(*res, _sortCol, getCancellationHandle());
       break;
     }
     default: {
       result->_varSizeData = subRes->_varSizeData;
-      getEngine().sort(result->_varSizeData, _sortCol);
+      getEngine().sort(result->_varSizeData, _sortCol, getCancellationHandle());
       break;
     }
   }
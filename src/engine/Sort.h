@@ -38,14 +38,29 @@ class Sort : public Operation {
         size_t(2), static_cast<size_t>(logb(static_cast<double>(size))));
     size_t nlogn = size * logSize;
     size_t subcost = _subtree->getCostEstimate();
-    return nlogn + subcost;
+    double costPerRowAndLevel =
+        _executionContext
+            ? _executionContext->getCostFactor("SORT_COST_PER_ROW_AND_LEVEL")
+            : 1;
+    return static_cast<size_t>(costPerRowAndLevel * nlogn) + subcost;
   }
 
   virtual bool knownEmptyResult() { return _subtree->knownEmptyResult(); }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
+  // Streams the sorted input from disk if it is too large to be sorted in
+  // memory.
+  virtual shared_ptr<ResultIterator> getResultIterator(
+      bool cacheResult = true) const;
+
  private:
   std::shared_ptr<QueryExecutionTree> _subtree;
   size_t _sortCol;
 
+  ad_utility::ExternalSorter<Id>::Comparator getComparator() const;
+
   virtual void computeResult(ResultTable* result) const;
 };
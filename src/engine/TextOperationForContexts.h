@@ -69,6 +69,14 @@ class TextOperationForContexts : public Operation {
     return false;
   }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    vector<QueryExecutionTree*> children;
+    for (const auto& subtree : _subtrees) {
+      children.push_back(subtree.first.get());
+    }
+    return children;
+  }
+
  private:
   string _words;
   vector<pair<std::shared_ptr<QueryExecutionTree>, size_t>> _subtrees;
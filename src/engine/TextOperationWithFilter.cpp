@@ -50,6 +50,8 @@ void TextOperationWithFilter::computeResult(ResultTable* result) const {
   AD_CHECK_GE(_nofVars, 1);
   result->_nofColumns = 1 + _filterResult->getResultWidth() + _nofVars;
   shared_ptr<const ResultTable> filterResult = _filterResult->getResult();
+  // Computing the filter may have taken most of the time of the query.
+  getCancellationHandle()->check();
   result->_resultTypes.reserve(result->_nofColumns);
   result->_resultTypes.push_back(ResultTable::ResultType::TEXT);
   result->_resultTypes.push_back(ResultTable::ResultType::VERBATIM);
@@ -51,6 +51,10 @@ class TextOperationWithFilter : public Operation {
             _executionContext->getIndex().getSizeEstimate(_words) == 0);
   }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_filterResult.get()};
+  }
+
   virtual float getMultiplicity(size_t col);
 
  private:
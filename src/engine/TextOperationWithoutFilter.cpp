@@ -87,7 +87,8 @@ void TextOperationWithoutFilter::computeResultMultVars(
     result->_resultTypes.push_back(ResultTable::ResultType::KB);
     getExecutionContext()->getIndex().getECListForWords(
         _words, _nofVars, _textLimit,
-        *reinterpret_cast<vector<array<Id, 4>>*>(result->_fixedSizeData));
+        *reinterpret_cast<vector<array<Id, 4>>*>(result->_fixedSizeData),
+        getCancellationHandle());
   } else if (_nofVars == 3) {
     result->_fixedSizeData = new vector<array<Id, 5>>;
     result->_nofColumns = 5;
@@ -98,7 +99,8 @@ void TextOperationWithoutFilter::computeResultMultVars(
     result->_resultTypes.push_back(ResultTable::ResultType::KB);
     getExecutionContext()->getIndex().getECListForWords(
         _words, _nofVars, _textLimit,
-        *reinterpret_cast<vector<array<Id, 5>>*>(result->_fixedSizeData));
+        *reinterpret_cast<vector<array<Id, 5>>*>(result->_fixedSizeData),
+        getCancellationHandle());
   } else {
     result->_nofColumns = _nofVars + 2;
     result->_resultTypes.reserve(result->_nofColumns);
@@ -108,7 +110,8 @@ void TextOperationWithoutFilter::computeResultMultVars(
       result->_resultTypes.push_back(ResultTable::ResultType::KB);
     }
     getExecutionContext()->getIndex().getECListForWords(
-        _words, _nofVars, _textLimit, result->_varSizeData);
+        _words, _nofVars, _textLimit, result->_varSizeData,
+        getCancellationHandle());
   }
 }
 
@@ -0,0 +1,104 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <sstream>
+
+#include "./Comparators.h"
+#include "./QueryExecutionTree.h"
+#include "./TopK.h"
+
+using std::string;
+
+// _____________________________________________________________________________
+size_t TopK::getResultWidth() const { return _subtree->getResultWidth(); }
+
+// _____________________________________________________________________________
+TopK::TopK(QueryExecutionContext* qec,
+           std::shared_ptr<QueryExecutionTree> subtree,
+           const vector<pair<size_t, bool>>& sortIndices, size_t k)
+    : Operation(qec), _subtree(subtree), _sortIndices(sortIndices), _k(k) {}
+
+// _____________________________________________________________________________
+string TopK::asString(size_t indent) const {
+  std::ostringstream os;
+  for (size_t i = 0; i < indent; ++i) {
+    os << " ";
+  }
+  os << "TopK " << _subtree->asString(indent) << "\n";
+  for (size_t i = 0; i < indent; ++i) {
+    os << " ";
+  }
+  os << "order on ";
+  for (auto ind : _sortIndices) {
+    os << (ind.second ? "desc(" : "asc(") << ind.first << ") ";
+  }
+  // The limit is part of the cache key, results for different limits
+  // must not be confused.
+  os << "limit " << _k;
+  return os.str();
+}
+
+// _____________________________________________________________________________
+void TopK::computeResult(ResultTable* result) const {
+  LOG(DEBUG) << "Getting sub-result for TopK result computation..." << endl;
+  AD_CHECK(_sortIndices.size() > 0);
+  shared_ptr<const ResultTable> subRes = _subtree->getResult();
+  LOG(DEBUG) << "TopK result computation..." << endl;
+  result->_nofColumns = subRes->_nofColumns;
+  result->_resultTypes.insert(result->_resultTypes.end(),
+                              subRes->_resultTypes.begin(),
+                              subRes->_resultTypes.end());
+  result->_localVocab = subRes->_localVocab;
+  switch (subRes->_nofColumns) {
+    case 1: {
+      auto res = new vector<array<Id, 1>>();
+      result->_fixedSizeData = res;
+      getEngine().topK(
+          *static_cast<vector<array<Id, 1>>*>(subRes->_fixedSizeData),
+          OBComp<array<Id, 1>>(_sortIndices), _k, res);
+      break;
+    }
+    case 2: {
+      auto res = new vector<array<Id, 2>>();
+      result->_fixedSizeData = res;
+      getEngine().topK(
+          *static_cast<vector<array<Id, 2>>*>(subRes->_fixedSizeData),
+          OBComp<array<Id, 2>>(_sortIndices), _k, res);
+      break;
+    }
+    case 3: {
+      auto res = new vector<array<Id, 3>>();
+      result->_fixedSizeData = res;
+      getEngine().topK(
+          *static_cast<vector<array<Id, 3>>*>(subRes->_fixedSizeData),
+          OBComp<array<Id, 3>>(_sortIndices), _k, res);
+      break;
+    }
+    case 4: {
+      auto res = new vector<array<Id, 4>>();
+      result->_fixedSizeData = res;
+      getEngine().topK(
+          *static_cast<vector<array<Id, 4>>*>(subRes->_fixedSizeData),
+          OBComp<array<Id, 4>>(_sortIndices), _k, res);
+      break;
+    }
+    case 5: {
+      auto res = new vector<array<Id, 5>>();
+      result->_fixedSizeData = res;
+      getEngine().topK(
+          *static_cast<vector<array<Id, 5>>*>(subRes->_fixedSizeData),
+          OBComp<array<Id, 5>>(_sortIndices), _k, res);
+      break;
+    }
+    default: {
+      getEngine().topK(subRes->_varSizeData,
+                       OBComp<vector<Id>>(_sortIndices), _k,
+                       &result->_varSizeData);
+      break;
+    }
+  }
+  result->_sortedBy = (_sortIndices[0].second ? result->_nofColumns + 1
+                                              : _sortIndices[0].first);
+  result->finish();
+  LOG(DEBUG) << "TopK result computation done." << endl;
+}
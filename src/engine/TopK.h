@@ -0,0 +1,83 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include "./Operation.h"
+#include "./QueryExecutionTree.h"
+
+using std::pair;
+using std::vector;
+
+// Combination of an OrderBy and a LIMIT: only the first k rows of the
+// ordered result are computed. Used for ORDER BY ... LIMIT queries, where k
+// is the limit plus the offset, so that the result can still be written
+// with the query's offset and limit.
+class TopK : public Operation {
+ public:
+  virtual size_t getResultWidth() const;
+
+ public:
+  TopK(QueryExecutionContext* qec, std::shared_ptr<QueryExecutionTree> subtree,
+       const vector<pair<size_t, bool>>& sortIndices, size_t k);
+
+  virtual string asString(size_t indent = 0) const;
+
+  virtual size_t resultSortedOn() const {
+    if (_sortIndices.empty() || _sortIndices[0].second) {
+      return std::numeric_limits<size_t>::max();
+    }
+    return _sortIndices[0].first;
+  }
+
+  // The columns up to the first one ordered descendingly.
+  virtual vector<size_t> resultSortedOnColumns() const {
+    vector<size_t> cols;
+    for (const auto& sortIndex : _sortIndices) {
+      if (sortIndex.second) {
+        break;
+      }
+      cols.push_back(sortIndex.first);
+    }
+    return cols;
+  }
+
+  virtual void setTextLimit(size_t limit) { _subtree->setTextLimit(limit); }
+
+  virtual size_t getSizeEstimate() {
+    return std::min(_k, _subtree->getSizeEstimate());
+  }
+
+  virtual float getMultiplicity(size_t col) {
+    return _subtree->getMultiplicity(col);
+  }
+
+  virtual size_t getCostEstimate() {
+    size_t size = _subtree->getSizeEstimate();
+    size_t logK = std::max(
+        size_t(1),
+        static_cast<size_t>(logb(static_cast<double>(std::max(
+            size_t(1), std::min(_k, size))))));
+    size_t subcost = _subtree->getCostEstimate();
+    return size * logK + subcost;
+  }
+
+  virtual bool knownEmptyResult() {
+    return _k == 0 || _subtree->knownEmptyResult();
+  }
+
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_subtree.get()};
+  }
+
+  size_t getK() const { return _k; }
+
+ private:
+  std::shared_ptr<QueryExecutionTree> _subtree;
+  vector<pair<size_t, bool>> _sortIndices;
+  size_t _k;
+
+  virtual void computeResult(ResultTable* result) const;
+};
@@ -89,8 +89,12 @@ void TwoColumnJoin::computeResult(ResultTable* result) const {
     bool rightFilter =
         (_right->getResultWidth() == 2 && _jc1Right == 0 && _jc2Right == 1);
     const auto& v = rightFilter ? _left : _right;
-    const auto leftResult = _left->getResult();
-    const auto rightResult = _right->getResult();
+    // The subtrees are independent, compute them concurrently.
+    shared_ptr<const ResultTable> leftResult;
+    shared_ptr<const ResultTable> rightResult;
+    computeChildrenConcurrently(
+        {[this, &leftResult] { leftResult = _left->getResult(); },
+         [this, &rightResult] { rightResult = _right->getResult(); }});
     const auto& filter = *static_cast<vector<array<Id, 2>>*>(
         rightFilter ? rightResult->_fixedSizeData : leftResult->_fixedSizeData);
     size_t jc1 = rightFilter ? _jc1Left : _jc1Right;
@@ -116,28 +120,32 @@ void TwoColumnJoin::computeResult(ResultTable* result) const {
       result->_fixedSizeData = new ResType();
       getEngine().filter(*static_cast<ResType*>(toFilter->_fixedSizeData), jc1,
                          jc2, filter,
-                         static_cast<ResType*>(result->_fixedSizeData));
+                         static_cast<ResType*>(result->_fixedSizeData),
+                         getCancellationHandle());
     } else if (result->_nofColumns == 3) {
       using ResType = vector<array<Id, 3>>;
       result->_fixedSizeData = new ResType();
       getEngine().filter(*static_cast<ResType*>(toFilter->_fixedSizeData), jc1,
                          jc2, filter,
-                         static_cast<ResType*>(result->_fixedSizeData));
+                         static_cast<ResType*>(result->_fixedSizeData),
+                         getCancellationHandle());
     } else if (result->_nofColumns == 4) {
       using ResType = vector<array<Id, 4>>;
       result->_fixedSizeData = new ResType();
       getEngine().filter(*static_cast<ResType*>(toFilter->_fixedSizeData), jc1,
                          jc2, filter,
-                         static_cast<ResType*>(result->_fixedSizeData));
+                         static_cast<ResType*>(result->_fixedSizeData),
+                         getCancellationHandle());
     } else if (result->_nofColumns == 5) {
       using ResType = vector<array<Id, 5>>;
       result->_fixedSizeData = new ResType();
       getEngine().filter(*static_cast<ResType*>(toFilter->_fixedSizeData), jc1,
                          jc2, filter,
-                         static_cast<ResType*>(result->_fixedSizeData));
+                         static_cast<ResType*>(result->_fixedSizeData),
+                         getCancellationHandle());
     } else {
       getEngine().filter(toFilter->_varSizeData, jc1, jc2, filter,
-                         &result->_varSizeData);
+                         &result->_varSizeData, getCancellationHandle());
     }
 
     result->finish();
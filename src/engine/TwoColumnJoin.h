@@ -48,6 +48,10 @@ class TwoColumnJoin : public Operation {
     return _left->knownEmptyResult() || _right->knownEmptyResult();
   }
 
+  virtual vector<QueryExecutionTree*> getChildren() const {
+    return {_left.get(), _right.get()};
+  }
+
   virtual float getMultiplicity(size_t col);
 
  private:
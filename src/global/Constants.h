@@ -7,13 +7,33 @@ static const int STXXL_MEMORY_TO_USE = 1024 * 1024 * 1024;
 static const int STXXL_DISK_SIZE_INDEX_BUILDER = 500 * 1000;
 static const int STXXL_DISK_SIZE_INDEX_TEST = 10;
 
-static const size_t NOF_SUBTREES_TO_CACHE = 100;
+// The results of subtrees are cached until they use more than the cache
+// memory. The number of results only bounds the bookkeeping.
+static const size_t NOF_SUBTREES_TO_CACHE = 100000;
+// Number of query shapes whose join orders are cached.
+static const size_t NOF_PLANS_TO_CACHE = 1000;
+// Number of subtrees whose actual result sizes are remembered for planning.
+static const size_t NOF_CARDINALITIES_TO_CACHE = 100000;
+// A cached join order is planned again once a subtree it was chosen for
+// turned out to be larger or smaller than estimated by more than this factor.
+static const double MAX_PLAN_ESTIMATE_ERROR = 2;
 static const size_t MAX_NOF_ROWS_IN_RESULT = 100000;
 static const size_t MIN_WORD_PREFIX_SIZE = 4;
 static const char PREFIX_CHAR = '*';
 static const char EXTERNALIZED_LITERALS_PREFIX = 127;
 static const size_t MAX_NOF_NODES = 64;
 static const size_t MAX_NOF_FILTERS = 64;
+// Graph patterns with more triples (and optional parts) are planned with
+// iterative dynamic programming, which only considers all join orders for
+// IDP_BLOCK_SIZE of them at a time.
+static const size_t MAX_NOF_NODES_FOR_EXHAUSTIVE_PLANNING = 12;
+static const size_t IDP_BLOCK_SIZE = 5;
+// If planning a graph pattern exhaustively takes longer, it continues
+// greedily.
+static const size_t MAX_EXHAUSTIVE_PLANNING_TIME_IN_MS = 200;
+// The joins between two levels of the dynamic programming are enumerated by
+// several threads if there are at least that many pairs of plans.
+static const size_t MIN_NOF_PAIRS_FOR_PARALLEL_PLANNING = 256;
 
 static const size_t BUFFER_SIZE_RELATION_SIZE = 1000 * 1000 * 1000;
 static const size_t BUFFER_SIZE_DOCSFILE_LINE = 1024 * 1024 * 100;
@@ -22,7 +42,54 @@ static const size_t USE_BLOCKS_INDEX_SIZE_TRESHOLD = 20 * 1000;
 
 static const size_t TEXT_PREDICATE_CARDINALITY_ESTIMATE = 1000 * 1000 * 1000;
 
-static const size_t GALLOP_THRESHOLD = 1000;
+// Cost of one galloping step relative to one step of a merge. Used to
+// decide between merging and galloping based on the actual input sizes.
+static const size_t GALLOP_STEP_COST = 4;
+
+// Number of rows read at once when a scan is restricted by a filter.
+static const size_t FILTERED_SCAN_BLOCK_SIZE = 64 * 1024;
+
+// Number of rows produced at once by operations that compute their result
+// incrementally.
+static const size_t RESULT_BLOCK_SIZE = 16 * 1024;
+
+// Minimum number of rows per partition for a parallel hash distinct.
+static const size_t HASH_DISTINCT_PARTITION_MIN_SIZE = 256 * 1024;
+// The pattern trick counts inputs with at least this many rows per thread in
+// parallel. Pattern counts are kept in dense arrays instead of hash maps if
+// the input has at least 1 / PATTERN_TRICK_DENSE_RATIO rows per pattern.
+static const size_t PATTERN_TRICK_PARTITION_MIN_SIZE = 256 * 1024;
+static const size_t PATTERN_TRICK_DENSE_RATIO = 16;
+// Number of rows the pattern trick looks ahead to prefetch pattern ids.
+static const size_t PATTERN_TRICK_PREFETCH_DISTANCE = 16;
+
+// A join passes the keys of its smaller input into an index scan of the
+// other input if that is this many times larger.
+static const size_t JOIN_KEY_FILTER_MIN_SIZE_RATIO = 100;
+// Index scans of at least this size are only computed after the other input
+// of a join, so that the decision above is based on its actual size.
+static const size_t ADAPTIVE_JOIN_MIN_SCAN_SIZE = 100 * 1000;
+// The inputs of a join are computed one after the other if one of them is
+// estimated to be this many times cheaper than the other (or empty). If it
+// turns out empty, the other one is not needed.
+static const size_t SEQUENTIAL_JOIN_COST_RATIO = 10;
+// Size of the Bloom filter for the join keys. Keys are stored in an exact
+// bitmap instead if that needs at most as many bits per key.
+static const size_t JOIN_KEY_FILTER_BITS_PER_KEY = 16;
+static const size_t JOIN_KEY_FILTER_NOF_HASHES = 4;
+
+// Default limit for the memory of the results computed for a single query
+// by the server, in GB.
+static const size_t DEFAULT_MEMORY_LIMIT_PER_QUERY_IN_GB = 16;
+// Default time limit for a single query. Clients can only lower it.
+static const double DEFAULT_QUERY_TIMEOUT_IN_SECONDS = 300;
+// Sorts and groupings whose input is estimated to need more memory than this
+// sort it externally, in runs of this size that are written to a temporary
+// file in the given directory.
+static const size_t DEFAULT_SORT_MEMORY_IN_GB = 4;
+static const char DEFAULT_SORT_DIRECTORY[] = "/tmp";
+// Default limit for the memory of all cached results, in GB.
+static const size_t DEFAULT_CACHE_MEMORY_IN_GB = 8;
 
 static const char CONTAINS_ENTITY_PREDICATE[] =
     "<QLever-internal-function/contains-entity>";
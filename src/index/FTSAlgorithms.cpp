@@ -9,6 +9,7 @@
 #include <utility>
 #include "../util/HashMap.h"
 #include "../util/HashSet.h"
+#include "../util/Intersection.h"
 
 using std::pair;
 
@@ -54,66 +55,23 @@ void FTSAlgorithms::intersect(const vector<Id>& matchingContexts,
              << "so that only matching ones remain\n";
   LOG(DEBUG) << "matchingContexts size: " << matchingContexts.size() << '\n';
   LOG(DEBUG) << "eBlockCids size: " << eBlockCids.size() << '\n';
-  resultCids.reserve(eBlockCids.size() + 2);
-  resultEids.reserve(eBlockCids.size() + 2);
-  resultScores.reserve(eBlockCids.size() + 2);
-  resultCids.resize(eBlockCids.size());
-  resultEids.resize(eBlockCids.size());
-  resultScores.resize(eBlockCids.size());
-  // Cast away constness so we can add sentinels that will be removed
-  // in the end and create and add those sentinels.
-  // Note: this is only efficient if capacity + 2 >= size for the input
-  // context lists. For now, we assume that all lists are read from disk
-  // where they had more than enough size allocated.
-  auto& l1 = const_cast<vector<Id>&>(matchingContexts);
-  auto& l2 = const_cast<vector<Id>&>(eBlockCids);
-  // The two below are needed for the final sentinel match
-  auto& wids = const_cast<vector<Id>&>(eBlockWids);
-  auto& scores = const_cast<vector<Score>&>(eBlockScores);
-
-  Id sent1 = std::numeric_limits<Id>::max();
-  Id sent2 = std::numeric_limits<Id>::max() - 1;
-  Id sentMatch = std::numeric_limits<Id>::max() - 2;
-
-  l1.push_back(sentMatch);
-  l2.push_back(sentMatch);
-  l1.push_back(sent1);
-  l2.push_back(sent2);
-  wids.push_back(0);
-  scores.push_back(0);
-
-  size_t i = 0;
-  size_t j = 0;
-  size_t n = 0;
-
-  while (l1[i] < sent1) {
-    while (l1[i] < l2[j]) {
-      ++i;
-    }
-    while (l2[j] < l1[i]) {
-      ++j;
-    }
-    while (l1[i] == l2[j]) {
-      // Make sure we get all matching elements from the entity list (l2)
-      // that match the current context.
-      // If there are multiple elements for that context in l1,
-      // we can safely skip them unless we want to incorporate the scores
-      // later on.
-      resultCids[n] = l2[j];
-      resultEids[n] = wids[j];
-      resultScores[n++] = scores[j++];
-    }
-    ++i;
-  }
-
-  // Remove sentinels
-  l1.resize(l1.size() - 2);
-  l2.resize(l2.size() - 2);
-  wids.resize(wids.size() - 1);
-  scores.resize(scores.size() - 1);
-  resultCids.resize(n - 1);
-  resultEids.resize(n - 1);
-  resultScores.resize(n - 1);
+  resultCids.clear();
+  resultEids.clear();
+  resultScores.clear();
+  resultCids.reserve(eBlockCids.size());
+  resultEids.reserve(eBlockCids.size());
+  resultScores.reserve(eBlockCids.size());
+  // Keep all entity postings whose context matches, no matter how often the
+  // context occurs in the matching contexts.
+  ad_utility::forEachMatch(
+      ad_utility::IdColumn(matchingContexts), ad_utility::IdColumn(eBlockCids),
+      [&](size_t, size_t, size_t begin, size_t end) {
+        for (size_t j = begin; j < end; ++j) {
+          resultCids.push_back(eBlockCids[j]);
+          resultEids.push_back(eBlockWids[j]);
+          resultScores.push_back(eBlockScores[j]);
+        }
+      });
   LOG(DEBUG) << "Intersection done. Size: " << resultCids.size() << "\n";
 }
 
@@ -126,59 +84,20 @@ void FTSAlgorithms::intersectTwoPostingLists(const vector<Id>& cids1,
                                              vector<Score>& resultScores) {
   LOG(DEBUG) << "Intersection of words lists of sizes " << cids1.size()
              << " and " << cids2.size() << '\n';
-  resultCids.reserve(cids1.size() + 2);
-  resultScores.reserve(cids1.size() + 2);
-  resultCids.resize(cids1.size());
-  resultScores.resize(cids1.size());
-  // Cast away constness so we can add sentinels that will be removed
-  // in the end and create and add those sentinels.
-  // Note: this is only efficient if capacity + 2 >= size for the input
-  // context lists. For now, we assume that all lists are read from disk
-  // where they had more than enough size allocated.
-  auto& l1 = const_cast<vector<Id>&>(cids1);
-  auto& l2 = const_cast<vector<Id>&>(cids2);
-  // The two below are needed for the final sentinel match
-  auto& s1 = const_cast<vector<Score>&>(scores1);
-  auto& s2 = const_cast<vector<Score>&>(scores2);
-
-  Id sent1 = std::numeric_limits<Id>::max();
-  Id sent2 = std::numeric_limits<Id>::max() - 1;
-  Id sentMatch = std::numeric_limits<Id>::max() - 2;
-
-  l1.push_back(sentMatch);
-  l2.push_back(sentMatch);
-  l1.push_back(sent1);
-  l2.push_back(sent2);
-  s1.push_back(0);
-  s2.push_back(0);
-
-  size_t i = 0;
-  size_t j = 0;
-  size_t n = 0;
-
-  while (l1[i] < sent1) {
-    while (l1[i] < l2[j]) {
-      ++i;
-    }
-    while (l2[j] < l1[i]) {
-      ++j;
-    }
-    while (l1[i] == l2[j]) {
-      resultCids[n] = l2[j];
-      resultScores[n++] = s1[i] + s2[j];
-      ++i;
-      ++j;
-    }
-  }
-
-  // Remove sentinels
-  l1.resize(l1.size() - 2);
-  l2.resize(l2.size() - 2);
-  s1.resize(s1.size() - 1);
-  s2.resize(s2.size() - 1);
-  resultCids.resize(n - 1);
-  resultScores.resize(n - 1);
-
+  resultCids.clear();
+  resultScores.clear();
+  resultCids.reserve(std::min(cids1.size(), cids2.size()));
+  resultScores.reserve(std::min(cids1.size(), cids2.size()));
+  // Postings for the same context are paired up one by one.
+  ad_utility::forEachMatch(
+      ad_utility::IdColumn(cids1), ad_utility::IdColumn(cids2),
+      [&](size_t begin1, size_t end1, size_t begin2, size_t end2) {
+        size_t n = std::min(end1 - begin1, end2 - begin2);
+        for (size_t k = 0; k < n; ++k) {
+          resultCids.push_back(cids2[begin2 + k]);
+          resultScores.push_back(scores1[begin1 + k] + scores2[begin2 + k]);
+        }
+      });
   LOG(DEBUG) << "Intersection done. Size: " << resultCids.size() << "\n";
 }
 
@@ -509,12 +428,14 @@ void FTSAlgorithms::aggScoresAndTakeTopContext(const vector<Id>& cids,
 // _____________________________________________________________________________
 void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
     const vector<Id>& cids, const vector<Id>& eids, const vector<Score>& scores,
-    size_t nofVars, size_t kLimit, VarWidthList& result) {
+    size_t nofVars, size_t kLimit, VarWidthList& result,
+    const ad_utility::CancellationHandle* cancellation) {
   if (cids.size() == 0) {
     return;
   }
   if (kLimit == 1) {
-    multVarsAggScoresAndTakeTopContext(cids, eids, scores, nofVars, result);
+    multVarsAggScoresAndTakeTopContext(cids, eids, scores, nofVars, result,
+                                       cancellation);
   } else {
     // Go over contexts.
     // For each context build a cross product of width 2.
@@ -534,7 +455,9 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
     Id currentCid = cids[0];
     Score cscore = scores[0];
 
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
     for (size_t i = 0; i < cids.size(); ++i) {
+      checkpoint();
       if (cids[i] == currentCid) {
         entitiesInContext.push_back(eids[i]);
         // cscore += scores[i];
@@ -623,9 +546,11 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
 // _____________________________________________________________________________
 void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
     const vector<Id>& cids, const vector<Id>& eids, const vector<Score>& scores,
-    size_t nofVars, size_t kLimit, WidthFourList& result) {
+    size_t nofVars, size_t kLimit, WidthFourList& result,
+    const ad_utility::CancellationHandle* cancellation) {
   if (kLimit == 1) {
-    multVarsAggScoresAndTakeTopContext(cids, eids, scores, nofVars, result);
+    multVarsAggScoresAndTakeTopContext(cids, eids, scores, nofVars, result,
+                                       cancellation);
   } else {
     // Go over contexts.
     // For each context build a cross product of width 2.
@@ -648,7 +573,9 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
     Id currentCid = cids[0];
     Score cscore = scores[0];
 
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
     for (size_t i = 0; i < cids.size(); ++i) {
+      checkpoint();
       if (cids[i] == currentCid) {
         entitiesInContext.push_back(eids[i]);
         // cscore = std::max(cscore, scores[i]);
@@ -722,10 +649,12 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
 // _____________________________________________________________________________
 void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
     const vector<Id>& cids, const vector<Id>& eids, const vector<Score>& scores,
-    size_t nofVars, size_t kLimit, WidthFiveList& result) {
+    size_t nofVars, size_t kLimit, WidthFiveList& result,
+    const ad_utility::CancellationHandle* cancellation) {
   if (cids.size() == 0) return;
   if (kLimit == 1) {
-    multVarsAggScoresAndTakeTopContext(cids, eids, scores, nofVars, result);
+    multVarsAggScoresAndTakeTopContext(cids, eids, scores, nofVars, result,
+                                       cancellation);
   } else {
     // Go over contexts.
     // For each context build a cross product of width 2.
@@ -751,7 +680,9 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
     Id currentCid = cids[0];
     Score cscore = scores[0];
 
+    ad_utility::CancellationCheckpoint checkpoint(cancellation);
     for (size_t i = 0; i < cids.size(); ++i) {
+      checkpoint();
       if (cids[i] == currentCid) {
         entitiesInContext.push_back(eids[i]);
         // cscore = std::max(cscore, scores[i]);;
@@ -833,7 +764,8 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
 // _____________________________________________________________________________
 void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
     const vector<Id>& cids, const vector<Id>& eids, const vector<Score>& scores,
-    size_t nofVars, FTSAlgorithms::WidthFourList& result) {
+    size_t nofVars, FTSAlgorithms::WidthFourList& result,
+    const ad_utility::CancellationHandle* cancellation) {
   LOG(DEBUG) << "Special case with 1 contexts per entity...\n";
   if (cids.size() == 0) return;
   AD_CHECK_EQ(nofVars, 2);
@@ -851,7 +783,9 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
   vector<Id> entitiesInContext;
   Id currentCid = cids[0];
   Score cscore = scores[0];
+  ad_utility::CancellationCheckpoint checkpoint(cancellation);
   for (size_t i = 0; i < cids.size(); ++i) {
+    checkpoint();
     if (cids[i] == currentCid) {
       entitiesInContext.push_back(eids[i]);
       // cscore = std::max(cscore, scores[i]);
@@ -912,7 +846,8 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
 // _____________________________________________________________________________
 void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
     const vector<Id>& cids, const vector<Id>& eids, const vector<Score>& scores,
-    size_t nofVars, FTSAlgorithms::WidthFiveList& result) {
+    size_t nofVars, FTSAlgorithms::WidthFiveList& result,
+    const ad_utility::CancellationHandle* cancellation) {
   LOG(DEBUG) << "Special case with 1 contexts per entity...\n";
   AD_CHECK_EQ(nofVars, 3);
   // Go over contexts.
@@ -933,7 +868,9 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
   vector<Id> entitiesInContext;
   Id currentCid = cids[0];
   Score cscore = scores[0];
+  ad_utility::CancellationCheckpoint checkpoint(cancellation);
   for (size_t i = 0; i < cids.size(); ++i) {
+    checkpoint();
     if (cids[i] == currentCid) {
       entitiesInContext.push_back(eids[i]);
       // cscore = std::max(cscore, scores[i]);
@@ -1002,7 +939,8 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
 // _____________________________________________________________________________
 void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
     const vector<Id>& cids, const vector<Id>& eids, const vector<Score>& scores,
-    size_t nofVars, FTSAlgorithms::VarWidthList& result) {
+    size_t nofVars, FTSAlgorithms::VarWidthList& result,
+    const ad_utility::CancellationHandle* cancellation) {
   LOG(DEBUG) << "Special case with 1 contexts per entity...\n";
   // Go over contexts.
   // For each context build a cross product of width 2.
@@ -1018,7 +956,9 @@ void FTSAlgorithms::multVarsAggScoresAndTakeTopContext(
   Id currentCid = cids[0];
   Score cscore = scores[0];
 
+  ad_utility::CancellationCheckpoint checkpoint(cancellation);
   for (size_t i = 0; i < cids.size(); ++i) {
+    checkpoint();
     if (cids[i] == currentCid) {
       entitiesInContext.push_back(eids[i]);
       // cscore = std::max(cscore, scores[i]);
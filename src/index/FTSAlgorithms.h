@@ -9,6 +9,7 @@
 #include "../engine/IndexSequence.h"
 #include "../engine/ResultTable.h"
 #include "../global/Id.h"
+#include "../util/CancellationHandle.h"
 #include "../util/HashMap.h"
 #include "../util/HashSet.h"
 #include "./Vocabulary.h"
@@ -108,44 +109,41 @@ class FTSAlgorithms {
                                            const vector<Score>& scores,
                                            size_t k, WidthThreeList& result);
 
-  static void multVarsAggScoresAndTakeTopKContexts(const vector<Id>& cids,
-                                                   const vector<Id>& eids,
-                                                   const vector<Score>& scores,
-                                                   size_t nofVars, size_t k,
-                                                   WidthFourList& result);
+  static void multVarsAggScoresAndTakeTopKContexts(
+      const vector<Id>& cids, const vector<Id>& eids,
+      const vector<Score>& scores, size_t nofVars, size_t k,
+      WidthFourList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
-  static void multVarsAggScoresAndTakeTopKContexts(const vector<Id>& cids,
-                                                   const vector<Id>& eids,
-                                                   const vector<Score>& scores,
-                                                   size_t nofVars, size_t k,
-                                                   WidthFiveList& result);
+  static void multVarsAggScoresAndTakeTopKContexts(
+      const vector<Id>& cids, const vector<Id>& eids,
+      const vector<Score>& scores, size_t nofVars, size_t k,
+      WidthFiveList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
-  static void multVarsAggScoresAndTakeTopKContexts(const vector<Id>& cids,
-                                                   const vector<Id>& eids,
-                                                   const vector<Score>& scores,
-                                                   size_t nofVars, size_t k,
-                                                   VarWidthList& result);
+  static void multVarsAggScoresAndTakeTopKContexts(
+      const vector<Id>& cids, const vector<Id>& eids,
+      const vector<Score>& scores, size_t nofVars, size_t k,
+      VarWidthList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
   // Special case with only top-1 context(s).
-  static void multVarsAggScoresAndTakeTopContext(const vector<Id>& cids,
-                                                 const vector<Id>& eids,
-                                                 const vector<Score>& scores,
-                                                 size_t nofVars,
-                                                 WidthFourList& result);
+  static void multVarsAggScoresAndTakeTopContext(
+      const vector<Id>& cids, const vector<Id>& eids,
+      const vector<Score>& scores, size_t nofVars, WidthFourList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
   // Special case with only top-1 context(s).
-  static void multVarsAggScoresAndTakeTopContext(const vector<Id>& cids,
-                                                 const vector<Id>& eids,
-                                                 const vector<Score>& scores,
-                                                 size_t nofVars,
-                                                 WidthFiveList& result);
+  static void multVarsAggScoresAndTakeTopContext(
+      const vector<Id>& cids, const vector<Id>& eids,
+      const vector<Score>& scores, size_t nofVars, WidthFiveList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
   // Special case with only top-1 context(s).
-  static void multVarsAggScoresAndTakeTopContext(const vector<Id>& cids,
-                                                 const vector<Id>& eids,
-                                                 const vector<Score>& scores,
-                                                 size_t nofVars,
-                                                 VarWidthList& result);
+  static void multVarsAggScoresAndTakeTopContext(
+      const vector<Id>& cids, const vector<Id>& eids,
+      const vector<Score>& scores, size_t nofVars, VarWidthList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr);
 
   template <typename Row>
   static void aggScoresAndTakeTopKContexts(vector<Row>& nonAggRes, size_t k,
@@ -681,29 +681,33 @@ void Index::getECListForWords(const string& words, size_t limit,
 
 // _____________________________________________________________________________
 template <typename Result>
-void Index::getECListForWords(const string& words, size_t nofVars, size_t limit,
-                              Result& result) const {
+void Index::getECListForWords(
+    const string& words, size_t nofVars, size_t limit, Result& result,
+    const ad_utility::CancellationHandle* cancellation) const {
   LOG(DEBUG) << "In getECListForWords...\n";
   vector<Id> cids;
   vector<Id> eids;
   vector<Score> scores;
   getContextEntityScoreListsForWords(words, cids, eids, scores);
-  FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(cids, eids, scores,
-                                                      nofVars, limit, result);
+  FTSAlgorithms::multVarsAggScoresAndTakeTopKContexts(
+      cids, eids, scores, nofVars, limit, result, cancellation);
   LOG(DEBUG) << "Done with getECListForWords. Result size: " << result.size()
              << "\n";
 }
 
 // _____________________________________________________________________________
 // Instantiate for width 4, 5 and var lists. 3 is covered by the simple case.
-template void Index::getECListForWords(const string&, size_t, size_t,
-                                       Index::WidthFourList& result) const;
+template void Index::getECListForWords(
+    const string&, size_t, size_t, Index::WidthFourList& result,
+    const ad_utility::CancellationHandle*) const;
 
-template void Index::getECListForWords(const string&, size_t, size_t,
-                                       Index::WidthFiveList& result) const;
+template void Index::getECListForWords(
+    const string&, size_t, size_t, Index::WidthFiveList& result,
+    const ad_utility::CancellationHandle*) const;
 
-template void Index::getECListForWords(const string&, size_t, size_t,
-                                       Index::VarWidthList& result) const;
+template void Index::getECListForWords(
+    const string&, size_t, size_t, Index::VarWidthList& result,
+    const ad_utility::CancellationHandle*) const;
 
 // _____________________________________________________________________________
 template <typename FilterTable, typename ResultList>
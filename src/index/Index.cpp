@@ -15,7 +15,7 @@
 
 using std::array;
 
-const uint32_t Index::PATTERNS_FILE_VERSION = 0;
+const uint32_t Index::PATTERNS_FILE_VERSION = 1;
 
 // _____________________________________________________________________________
 Index::Index()
@@ -60,7 +60,8 @@ void Index::createFromTsvFile(const string& tsvFile, bool allPermutations) {
       createPatterns(indexFilename + ".patterns", v, _hasRelation, _hasPattern,
                      _patterns, _fullHasRelationMultiplicityEntities,
                      _fullHasRelationMultiplicityPredicates,
-                     _fullHasRelationSize, _maxNumPatterns);
+                     _fullHasRelationSize, _fullPredicateCounts,
+                     _maxNumPatterns);
     }
     // SOP permutation
     LOG(INFO) << "Sorting for SOP permutation..." << std::endl;
@@ -84,7 +85,7 @@ void Index::createFromTsvFile(const string& tsvFile, bool allPermutations) {
     createPatterns(indexFilename + ".patterns", v, _hasRelation, _hasPattern,
                    _patterns, _fullHasRelationMultiplicityEntities,
                    _fullHasRelationMultiplicityPredicates, _fullHasRelationSize,
-                   _maxNumPatterns);
+                   _fullPredicateCounts, _maxNumPatterns);
   }
   openFileHandles();
 }
@@ -162,7 +163,8 @@ void Index::createFromNTriplesFile(const string& ntFile, bool allPermutations) {
       createPatterns(indexFilename + ".patterns", v, _hasRelation, _hasPattern,
                      _patterns, _fullHasRelationMultiplicityEntities,
                      _fullHasRelationMultiplicityPredicates,
-                     _fullHasRelationSize, _maxNumPatterns);
+                     _fullHasRelationSize, _fullPredicateCounts,
+                     _maxNumPatterns);
     }
     // SOP permutation
     LOG(INFO) << "Sorting for SOP permutation..." << std::endl;
@@ -186,7 +188,7 @@ void Index::createFromNTriplesFile(const string& ntFile, bool allPermutations) {
     createPatterns(indexFilename + ".patterns", v, _hasRelation, _hasPattern,
                    _patterns, _fullHasRelationMultiplicityEntities,
                    _fullHasRelationMultiplicityPredicates, _fullHasRelationSize,
-                   _maxNumPatterns);
+                   _fullPredicateCounts, _maxNumPatterns);
   }
   openFileHandles();
 }
@@ -423,7 +425,9 @@ void Index::createPatterns(const string& fileName, const ExtVec& vec,
                            CompactStringVector<size_t, Id>& patterns,
                            double& fullHasRelationMultiplicityEntities,
                            double& fullHasRelationMultiplicityPredicates,
-                           size_t& fullHasRelationSize, size_t maxNumPatterns) {
+                           size_t& fullHasRelationSize,
+                           vector<array<Id, 2>>& fullPredicateCounts,
+                           size_t maxNumPatterns) {
   if (vec.size() == 0) {
     LOG(WARN) << "Attempt to write an empty index!" << std::endl;
     return;
@@ -575,6 +579,9 @@ void Index::createPatterns(const string& fileName, const ExtVec& vec,
   // the input triple list is in spo order, we only need a hash map for
   // predicates
   ad_utility::HashSet<Id> predicateHashSet;
+  // For every predicate the number of entities that have it, this is the
+  // result of counting the available predicates of all entities.
+  ad_utility::HashMap<Id, size_t> predicateCounts;
 
   pattern.clear();
   currentRel = vec[0][0];
@@ -595,6 +602,9 @@ void Index::createPatterns(const string& fileName, const ExtVec& vec,
       // listed once per entity (otherwise it woul always be the same as
       // vec.size()
       fullHasRelationSize += pattern.size();
+      for (size_t i = 0; i < patternIndex; i++) {
+        predicateCounts[pattern[i]]++;
+      }
       if (it == patternSet.end()) {
         numEntitiesWithoutPatterns++;
         // The pattern does not exist, use the has-relation predicate instead
@@ -634,6 +644,18 @@ void Index::createPatterns(const string& fileName, const ExtVec& vec,
   }
   // process the last element
   fullHasRelationSize += pattern.size();
+  for (size_t i = 0; i < patternIndex; i++) {
+    predicateCounts[pattern[i]]++;
+  }
+  fullPredicateCounts.clear();
+  fullPredicateCounts.reserve(predicateCounts.size());
+  for (const auto& it : predicateCounts) {
+    fullPredicateCounts.push_back(array<Id, 2>{{it.first, it.second}});
+  }
+  std::sort(fullPredicateCounts.begin(), fullPredicateCounts.end(),
+            [](const array<Id, 2>& a, const array<Id, 2>& b) {
+              return a[0] < b[0];
+            });
   fullHasRelationEntitiesDistinctSize++;
   std::unordered_map<Pattern, Id>::iterator it;
   if (isValidPattern) {
@@ -720,6 +742,11 @@ void Index::createPatterns(const string& fileName, const ExtVec& vec,
   file.write(&numHasRelations, sizeof(size_t));
   file.write(entityHasRelation.data(), sizeof(Id) * numHasRelations * 2);
 
+  // write the predicate counts of all entities
+  size_t numPredicateCounts = fullPredicateCounts.size();
+  file.write(&numPredicateCounts, sizeof(size_t));
+  file.write(fullPredicateCounts.data(), sizeof(Id) * numPredicateCounts * 2);
+
   // write the patterns
   patterns.write(file);
   file.close();
@@ -997,6 +1024,15 @@ void Index::createFromOnDiskIndex(const string& onDiskBase,
                         hasRelationSize * sizeof(Id) * 2, off);
       off += hasRelationSize * sizeof(Id) * 2;
 
+      // read the predicate counts of all entities
+      size_t numPredicateCounts;
+      patternsFile.read(&numPredicateCounts, sizeof(size_t), off);
+      off += sizeof(size_t);
+      _fullPredicateCounts.resize(numPredicateCounts);
+      patternsFile.read(_fullPredicateCounts.data(),
+                        numPredicateCounts * sizeof(Id) * 2, off);
+      off += numPredicateCounts * sizeof(Id) * 2;
+
       // read the patterns
       _patterns.load(patternsFile, off);
 
@@ -1061,19 +1097,25 @@ void Index::openFileHandles() {
 }
 
 // _____________________________________________________________________________
-void Index::scanPSO(const string& predicate, WidthTwoList* result) const {
+void Index::scanPSO(const string& predicate, WidthTwoList* result,
+                    const ScanFilter& filter) const {
   LOG(DEBUG) << "Performing PSO scan for full relation: " << predicate << "\n";
   Id relId;
   if (_vocab.getId(predicate, &relId)) {
     LOG(TRACE) << "Successfully got key ID.\n";
-    scanPSO(relId, result);
+    if (filter.empty()) {
+      scanPSO(relId, result);
+    } else {
+      scanFiltered(_psoMeta, _psoFile, relId, filter, result);
+    }
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
 
 // _____________________________________________________________________________
 void Index::scanPSO(const string& predicate, const string& subject,
-                    WidthOneList* result) const {
+                    WidthOneList* result,
+                    const ScanFilter& filter) const {
   LOG(DEBUG) << "Performing PSO scan of relation " << predicate
              << " with fixed subject: " << subject << "...\n";
   Id relId;
@@ -1087,12 +1129,13 @@ void Index::scanPSO(const string& predicate, const string& subject,
         // Functional relations have blocks point into the pair index,
         // non-functional relations have them point into lhs lists
         if (rmd.isFunctional()) {
-          scanFunctionalRelation(blockOff, subjId, _psoFile, result);
+          scanFunctionalRelation(blockOff, subjId, _psoFile, result, filter);
         } else {
           pair<off_t, size_t> block2 =
               rmd._rmdBlocks->getFollowBlockForLhs(subjId);
           scanNonFunctionalRelation(blockOff, block2, subjId, _psoFile,
-                                    rmd._rmdBlocks->_offsetAfter, result);
+                                    rmd._rmdBlocks->_offsetAfter, result,
+                                    filter);
         }
       } else {
         // If we don't have blocks, scan the whole relation and filter /
@@ -1103,6 +1146,13 @@ void Index::scanPSO(const string& predicate, const string& subject,
                       rmd.getNofElements() * 2 * sizeof(Id),
                       rmd._rmdPairs._startFullIndex);
         getRhsForSingleLhs(fullRelation, subjId, result);
+        if (!filter.empty()) {
+          result->erase(std::remove_if(result->begin(), result->end(),
+                                       [&filter](const array<Id, 1>& row) {
+                                         return !filter.accepts(row);
+                                       }),
+                        result->end());
+        }
       }
     } else {
       LOG(DEBUG) << "No such relation.\n";
@@ -1114,19 +1164,25 @@ void Index::scanPSO(const string& predicate, const string& subject,
 }
 
 // _____________________________________________________________________________
-void Index::scanPOS(const string& predicate, WidthTwoList* result) const {
+void Index::scanPOS(const string& predicate, WidthTwoList* result,
+                    const ScanFilter& filter) const {
   LOG(DEBUG) << "Performing POS scan for full relation: " << predicate << "\n";
   Id relId;
   if (_vocab.getId(predicate, &relId)) {
     LOG(TRACE) << "Successfully got key ID.\n";
-    scanPOS(relId, result);
+    if (filter.empty()) {
+      scanPOS(relId, result);
+    } else {
+      scanFiltered(_posMeta, _posFile, relId, filter, result);
+    }
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
 
 // _____________________________________________________________________________
 void Index::scanPOS(const string& predicate, const string& object,
-                    WidthOneList* result) const {
+                    WidthOneList* result,
+                    const ScanFilter& filter) const {
   LOG(DEBUG) << "Performing POS scan of relation " << predicate
              << " with fixed object: " << object << "...\n";
   Id relId;
@@ -1140,12 +1196,13 @@ void Index::scanPOS(const string& predicate, const string& object,
         // Functional relations have blocks point into the pair index,
         // non-functional relations have them point into lhs lists
         if (rmd.isFunctional()) {
-          scanFunctionalRelation(blockOff, objId, _posFile, result);
+          scanFunctionalRelation(blockOff, objId, _posFile, result, filter);
         } else {
           pair<off_t, size_t> block2 =
               rmd._rmdBlocks->getFollowBlockForLhs(objId);
           scanNonFunctionalRelation(blockOff, block2, objId, _posFile,
-                                    rmd._rmdBlocks->_offsetAfter, result);
+                                    rmd._rmdBlocks->_offsetAfter, result,
+                                    filter);
         }
       } else {
         // If we don't have blocks, scan the whole relation and filter /
@@ -1156,6 +1213,13 @@ void Index::scanPOS(const string& predicate, const string& object,
                       rmd.getNofElements() * 2 * sizeof(Id),
                       rmd._rmdPairs._startFullIndex);
         getRhsForSingleLhs(fullRelation, objId, result);
+        if (!filter.empty()) {
+          result->erase(std::remove_if(result->begin(), result->end(),
+                                       [&filter](const array<Id, 1>& row) {
+                                         return !filter.accepts(row);
+                                       }),
+                        result->end());
+        }
       }
     } else {
       LOG(DEBUG) << "No such relation.\n";
@@ -1168,7 +1232,8 @@ void Index::scanPOS(const string& predicate, const string& object,
 
 // _____________________________________________________________________________
 void Index::scanSOP(const string& subject, const string& object,
-                    WidthOneList* result) const {
+                    WidthOneList* result,
+                    const ScanFilter& filter) const {
   if (!_sopFile.isOpen()) {
     AD_THROW(ad_semsearch::Exception::BAD_INPUT,
              "Cannot use predicate variables without the required "
@@ -1188,12 +1253,13 @@ void Index::scanSOP(const string& subject, const string& object,
         // Functional relations have blocks point into the pair index,
         // non-functional relations have them point into lhs lists
         if (rmd.isFunctional()) {
-          scanFunctionalRelation(blockOff, objId, _sopFile, result);
+          scanFunctionalRelation(blockOff, objId, _sopFile, result, filter);
         } else {
           pair<off_t, size_t> block2 =
               rmd._rmdBlocks->getFollowBlockForLhs(objId);
           scanNonFunctionalRelation(blockOff, block2, objId, _sopFile,
-                                    rmd._rmdBlocks->_offsetAfter, result);
+                                    rmd._rmdBlocks->_offsetAfter, result,
+                                    filter);
         }
       } else {
         // If we don't have blocks, scan the whole relation and filter /
@@ -1204,6 +1270,13 @@ void Index::scanSOP(const string& subject, const string& object,
                       rmd.getNofElements() * 2 * sizeof(Id),
                       rmd._rmdPairs._startFullIndex);
         getRhsForSingleLhs(fullRelation, objId, result);
+        if (!filter.empty()) {
+          result->erase(std::remove_if(result->begin(), result->end(),
+                                       [&filter](const array<Id, 1>& row) {
+                                         return !filter.accepts(row);
+                                       }),
+                        result->end());
+        }
       }
     } else {
       LOG(DEBUG) << "No such relation.\n";
@@ -1215,7 +1288,8 @@ void Index::scanSOP(const string& subject, const string& object,
 }
 
 // _____________________________________________________________________________
-void Index::scanSPO(const string& subject, WidthTwoList* result) const {
+void Index::scanSPO(const string& subject, WidthTwoList* result,
+                    const ScanFilter& filter) const {
   if (!_spoFile.isOpen()) {
     AD_THROW(ad_semsearch::Exception::BAD_INPUT,
              "Cannot use predicate variables without the required "
@@ -1226,13 +1300,18 @@ void Index::scanSPO(const string& subject, WidthTwoList* result) const {
   Id relId;
   if (_vocab.getId(subject, &relId)) {
     LOG(TRACE) << "Successfully got key ID.\n";
-    scanSPO(relId, result);
+    if (filter.empty()) {
+      scanSPO(relId, result);
+    } else {
+      scanFiltered(_spoMeta, _spoFile, relId, filter, result);
+    }
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
 
 // _____________________________________________________________________________
-void Index::scanSOP(const string& subject, WidthTwoList* result) const {
+void Index::scanSOP(const string& subject, WidthTwoList* result,
+                    const ScanFilter& filter) const {
   if (!_sopFile.isOpen()) {
     AD_THROW(ad_semsearch::Exception::BAD_INPUT,
              "Cannot use predicate variables without the required "
@@ -1243,13 +1322,18 @@ void Index::scanSOP(const string& subject, WidthTwoList* result) const {
   Id relId;
   if (_vocab.getId(subject, &relId)) {
     LOG(TRACE) << "Successfully got key ID.\n";
-    scanSOP(relId, result);
+    if (filter.empty()) {
+      scanSOP(relId, result);
+    } else {
+      scanFiltered(_sopMeta, _sopFile, relId, filter, result);
+    }
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
 
 // _____________________________________________________________________________
-void Index::scanOPS(const string& object, WidthTwoList* result) const {
+void Index::scanOPS(const string& object, WidthTwoList* result,
+                    const ScanFilter& filter) const {
   if (!_opsFile.isOpen()) {
     AD_THROW(ad_semsearch::Exception::BAD_INPUT,
              "Cannot use predicate variables without the required "
@@ -1260,13 +1344,18 @@ void Index::scanOPS(const string& object, WidthTwoList* result) const {
   Id relId;
   if (_vocab.getId(object, &relId)) {
     LOG(TRACE) << "Successfully got key ID.\n";
-    scanOPS(relId, result);
+    if (filter.empty()) {
+      scanOPS(relId, result);
+    } else {
+      scanFiltered(_opsMeta, _opsFile, relId, filter, result);
+    }
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
 
 // _____________________________________________________________________________
-void Index::scanOSP(const string& object, WidthTwoList* result) const {
+void Index::scanOSP(const string& object, WidthTwoList* result,
+                    const ScanFilter& filter) const {
   if (!_ospFile.isOpen()) {
     AD_THROW(ad_semsearch::Exception::BAD_INPUT,
              "Cannot use predicate variables without the required "
@@ -1277,7 +1366,11 @@ void Index::scanOSP(const string& object, WidthTwoList* result) const {
   Id relId;
   if (_vocab.getId(object, &relId)) {
     LOG(TRACE) << "Successfully got key ID.\n";
-    scanOSP(relId, result);
+    if (filter.empty()) {
+      scanOSP(relId, result);
+    } else {
+      scanFiltered(_ospMeta, _ospFile, relId, filter, result);
+    }
   }
   LOG(DEBUG) << "Scan done, got " << result->size() << " elements.\n";
 }
@@ -1348,6 +1441,46 @@ void Index::scanOPS(Id object, Index::WidthTwoList* result) const {
   }
 }
 
+// _____________________________________________________________________________
+void Index::scanFiltered(const IndexMetaData& meta,
+                         ad_utility::File& indexFile, Id key,
+                         const ScanFilter& filter,
+                         Index::WidthTwoList* result) const {
+  if (meta.relationExists(key)) {
+    const FullRelationMetaData& rmd = meta.getRmd(key)._rmdPairs;
+    readFiltered(indexFile, rmd._startFullIndex, rmd.getNofElements(), filter,
+                 result);
+  }
+}
+
+// _____________________________________________________________________________
+template <size_t N>
+void Index::readFiltered(ad_utility::File& indexFile, off_t from,
+                         size_t nofElements, const ScanFilter& filter,
+                         vector<array<Id, N>>* result) const {
+  LOG(TRACE) << "Reading " << nofElements << " rows with filter "
+             << filter.asString() << "...\n";
+  vector<array<Id, N>> buffer;
+  size_t done = 0;
+  while (done < nofElements && !filter.acceptsNothing()) {
+    size_t n = std::min(FILTERED_SCAN_BLOCK_SIZE, nofElements - done);
+    buffer.resize(n);
+    indexFile.read(buffer.data(), n * N * sizeof(Id),
+                   from + static_cast<off_t>(done * N * sizeof(Id)));
+    for (const auto& row : buffer) {
+      if (filter.accepts(row)) {
+        result->push_back(row);
+      } else if (filter.isAboveRange(row)) {
+        // The first column of every list is sorted, no further row can be
+        // accepted.
+        LOG(TRACE) << "Left the range of the filter, stopping early.\n";
+        return;
+      }
+    }
+    done += n;
+  }
+}
+
 // _____________________________________________________________________________
 const vector<PatternID>& Index::getHasPattern() const { return _hasPattern; }
 
@@ -1374,6 +1507,20 @@ double Index::getHasRelationMultiplicityPredicates() const {
 // _____________________________________________________________________________
 size_t Index::getHasRelationFullSize() const { return _fullHasRelationSize; }
 
+// _____________________________________________________________________________
+const vector<array<Id, 2>>& Index::getFullPredicateCounts() const {
+  return _fullPredicateCounts;
+}
+
+// _____________________________________________________________________________
+vector<pair<string, size_t>> Index::getPredicateSizes() const {
+  vector<pair<string, size_t>> sizes;
+  for (const auto& rel : _psoMeta.getRelationSizes()) {
+    sizes.push_back(std::make_pair(idToString(rel.first), rel.second));
+  }
+  return sizes;
+}
+
 // _____________________________________________________________________________
 string Index::idToString(Id id) const {
   if (id < _vocab.size()) {
@@ -1391,7 +1538,8 @@ string Index::idToString(Id id) const {
 // _____________________________________________________________________________
 void Index::scanFunctionalRelation(const pair<off_t, size_t>& blockOff,
                                    Id lhsId, ad_utility::File& indexFile,
-                                   WidthOneList* result) const {
+                                   WidthOneList* result,
+                                   const ScanFilter& filter) const {
   LOG(TRACE) << "Scanning functional relation ...\n";
   WidthTwoList block;
   block.resize(blockOff.second / (2 * sizeof(Id)));
@@ -1399,7 +1547,7 @@ void Index::scanFunctionalRelation(const pair<off_t, size_t>& blockOff,
   auto it = std::lower_bound(
       block.begin(), block.end(), lhsId,
       [](const array<Id, 2>& elem, Id key) { return elem[0] < key; });
-  if ((*it)[0] == lhsId) {
+  if ((*it)[0] == lhsId && filter.accepts(array<Id, 1>{{(*it)[1]}})) {
     result->push_back(array<Id, 1>{(*it)[1]});
   }
   LOG(TRACE) << "Read " << result->size() << " RHS.\n";
@@ -1410,7 +1558,8 @@ void Index::scanNonFunctionalRelation(const pair<off_t, size_t>& blockOff,
                                       const pair<off_t, size_t>& followBlock,
                                       Id lhsId, ad_utility::File& indexFile,
                                       off_t upperBound,
-                                      Index::WidthOneList* result) const {
+                                      Index::WidthOneList* result,
+                                      const ScanFilter& filter) const {
   LOG(TRACE) << "Scanning non-functional relation ...\n";
   vector<pair<Id, off_t>> block;
   block.resize(blockOff.second / (sizeof(Id) + sizeof(off_t)));
@@ -1435,9 +1584,14 @@ void Index::scanNonFunctionalRelation(const pair<off_t, size_t>& blockOff,
         nofBytes = static_cast<size_t>(follower.second - it->second);
       }
     }
-    result->reserve((nofBytes / sizeof(Id)) + 2);
-    result->resize(nofBytes / sizeof(Id));
-    indexFile.read(result->data(), nofBytes, it->second);
+    if (filter.empty()) {
+      result->reserve((nofBytes / sizeof(Id)) + 2);
+      result->resize(nofBytes / sizeof(Id));
+      indexFile.read(result->data(), nofBytes, it->second);
+    } else {
+      readFiltered(indexFile, it->second, nofBytes / sizeof(Id), filter,
+                   result);
+    }
   } else {
     LOG(TRACE) << "Could not find LHS in block. Result will be empty.\n";
   }
@@ -10,10 +10,12 @@
 #include <vector>
 #include "../engine/ResultTable.h"
 #include "../global/Pattern.h"
+#include "../util/CancellationHandle.h"
 #include "../util/File.h"
 #include "./ConstantsIndexCreation.h"
 #include "./DocsDB.h"
 #include "./IndexMetaData.h"
+#include "./ScanFilter.h"
 #include "./StxxlSortFunctors.h"
 #include "./TextMetaData.h"
 #include "./Vocabulary.h"
@@ -95,26 +97,37 @@ class Index {
 
   string idToString(Id id) const;
 
-  void scanPSO(const string& predicate, WidthTwoList* result) const;
+  // The optional filter is applied while reading, rows it rejects are never
+  // added to the result.
+  void scanPSO(const string& predicate, WidthTwoList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
   void scanPSO(const string& predicate, const string& subject,
-               WidthOneList* result) const;
+               WidthOneList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
-  void scanPOS(const string& predicate, WidthTwoList* result) const;
+  void scanPOS(const string& predicate, WidthTwoList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
   void scanPOS(const string& predicate, const string& object,
-               WidthOneList* result) const;
+               WidthOneList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
   void scanSOP(const string& subject, const string& object,
-               WidthOneList* result) const;
+               WidthOneList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
-  void scanSPO(const string& subject, WidthTwoList* result) const;
+  void scanSPO(const string& subject, WidthTwoList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
-  void scanSOP(const string& subject, WidthTwoList* result) const;
+  void scanSOP(const string& subject, WidthTwoList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
-  void scanOPS(const string& object, WidthTwoList* result) const;
+  void scanOPS(const string& object, WidthTwoList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
-  void scanOSP(const string& object, WidthTwoList* result) const;
+  void scanOSP(const string& object, WidthTwoList* result,
+               const ScanFilter& filter = ScanFilter()) const;
 
   void scanPSO(Id predicate, WidthTwoList* result) const;
   void scanPOS(Id predicate, WidthTwoList* result) const;
@@ -144,6 +157,13 @@ class Index {
    */
   size_t getHasRelationFullSize() const;
 
+  /**
+   * @return For every predicate the number of entities that have it, sorted
+   *         by the predicate ids. This is the result of counting the
+   *         available predicates of all entities.
+   */
+  const vector<array<Id, 2>>& getFullPredicateCounts() const;
+
   // Get multiplicities with given var (SCAN for 2 cols)
   vector<float> getPSOMultiplicities(const string& key) const;
   vector<float> getPOSMultiplicities(const string& key) const;
@@ -174,8 +194,9 @@ class Index {
 
   // With two or more variables.
   template <typename ResultList>
-  void getECListForWords(const string& words, size_t nofVars, size_t limit,
-                         ResultList& result) const;
+  void getECListForWords(
+      const string& words, size_t nofVars, size_t limit, ResultList& result,
+      const ad_utility::CancellationHandle* cancellation = nullptr) const;
 
   // With filtering. Needs many template instantiations but
   // only nofVars truly makes a difference. Others are just data types
@@ -284,6 +305,9 @@ class Index {
 
   size_t getNofPredicates() const { return _psoMeta.getNofDistinctC1(); }
 
+  // All predicates with their number of triples.
+  vector<pair<string, size_t>> getPredicateSizes() const;
+
   bool hasAllPermutations() const { return _spoFile.isOpen(); }
 
  private:
@@ -317,6 +341,7 @@ class Index {
   double _fullHasRelationMultiplicityEntities;
   double _fullHasRelationMultiplicityPredicates;
   size_t _fullHasRelationSize;
+  vector<array<Id, 2>> _fullPredicateCounts;
   /**
    * @brief Maps pattern ids to sets of predicate ids.
    */
@@ -368,6 +393,7 @@ class Index {
                              double& fullHasRelationMultiplicityEntities,
                              double& fullHasRelationMultiplicityPredicates,
                              size_t& fullHasRelationSize,
+                             vector<array<Id, 2>>& fullPredicateCounts,
                              size_t maxNumPatterns);
 
   void createTextIndex(const string& filename, const TextVec& vec);
@@ -393,13 +419,27 @@ class Index {
   void openTextFileHandle();
 
   void scanFunctionalRelation(const pair<off_t, size_t>& blockOff, Id lhsId,
-                              ad_utility::File& indexFile,
-                              WidthOneList* result) const;
+                              ad_utility::File& indexFile, WidthOneList* result,
+                              const ScanFilter& filter) const;
 
   void scanNonFunctionalRelation(const pair<off_t, size_t>& blockOff,
                                  const pair<off_t, size_t>& followBlock,
                                  Id lhsId, ad_utility::File& indexFile,
-                                 off_t upperBound, WidthOneList* result) const;
+                                 off_t upperBound, WidthOneList* result,
+                                 const ScanFilter& filter) const;
+
+  // Reads the pairs of a full relation (or list) of the given permutation,
+  // keeping only those accepted by the filter.
+  void scanFiltered(const IndexMetaData& meta, ad_utility::File& indexFile,
+                    Id key, const ScanFilter& filter,
+                    WidthTwoList* result) const;
+
+  // Reads nofElements rows starting at the given offset block by block and
+  // appends those accepted by the filter to the result.
+  template <size_t N>
+  void readFiltered(ad_utility::File& indexFile, off_t from, size_t nofElements,
+                    const ScanFilter& filter,
+                    vector<array<Id, N>>* result) const;
 
   void addContextToVector(TextVec::bufwriter_type& writer, Id context,
                           const ad_utility::HashMap<Id, Score>& words,
@@ -149,6 +149,16 @@ size_t IndexMetaData::getTotalBytesForRelation(
 // _____________________________________________________________________________
 size_t IndexMetaData::getNofDistinctC1() const { return _data.size(); }
 
+// _____________________________________________________________________________
+vector<pair<Id, size_t>> IndexMetaData::getRelationSizes() const {
+  vector<pair<Id, size_t>> sizes;
+  sizes.reserve(_data.size());
+  for (auto it = _data.begin(); it != _data.end(); ++it) {
+    sizes.push_back(std::make_pair(it->first, it->second.getNofElements()));
+  }
+  return sizes;
+}
+
 // _____________________________________________________________________________
 FullRelationMetaData::FullRelationMetaData()
     : _relId(0), _startFullIndex(0), _typeMultAndNofElements(0) {}
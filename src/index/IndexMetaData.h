@@ -199,6 +199,9 @@ class IndexMetaData {
 
   size_t getNofDistinctC1() const;
 
+  // The ids of all relations together with their number of elements.
+  vector<pair<Id, size_t>> getRelationSizes() const;
+
  private:
   off_t _offsetAfter;
   size_t _nofTriples;
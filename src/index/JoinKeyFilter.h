@@ -0,0 +1,102 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <stdint.h>
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../global/Constants.h"
+#include "../global/Id.h"
+
+using std::string;
+using std::vector;
+
+// Approximate set of the join keys of an already computed join input. Used
+// to drop rows of the other input that can not have a join partner while
+// they are read from the index (a semi-join reduction). If the keys are
+// dense, they are stored exactly as a bitmap over the range of keys,
+// otherwise as a Bloom filter. mayContain never returns false for a key of
+// the set, but may return true for other keys.
+class JoinKeyFilter {
+ public:
+  explicit JoinKeyFilter(const vector<Id>& keys)
+      : _min(std::numeric_limits<Id>::max()),
+        _max(0),
+        _nofKeys(keys.size()),
+        _isBitmap(true) {
+    for (Id key : keys) {
+      _min = std::min(_min, key);
+      _max = std::max(_max, key);
+    }
+    if (keys.empty()) {
+      return;
+    }
+    // Not the size of the range, which overflows if it covers all ids.
+    Id span = _max - _min;
+    _isBitmap = span / JOIN_KEY_FILTER_BITS_PER_KEY < keys.size();
+    size_t nofBits = _isBitmap ? span + 1
+                               : keys.size() * JOIN_KEY_FILTER_BITS_PER_KEY;
+    _bits.resize(nofBits / 64 + 1, 0);
+    _nofBits = _bits.size() * 64;
+    for (Id key : keys) {
+      if (_isBitmap) {
+        setBit(key - _min);
+      } else {
+        for (size_t i = 0; i < JOIN_KEY_FILTER_NOF_HASHES; ++i) {
+          setBit(hash(key, i));
+        }
+      }
+    }
+  }
+
+  bool mayContain(Id key) const {
+    if (_nofKeys == 0 || key < _min || key > _max) {
+      return false;
+    }
+    if (_isBitmap) {
+      return getBit(key - _min);
+    }
+    for (size_t i = 0; i < JOIN_KEY_FILTER_NOF_HASHES; ++i) {
+      if (!getBit(hash(key, i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool empty() const { return _nofKeys == 0; }
+
+  // No key larger than this one is contained.
+  Id max() const { return _max; }
+
+  string asString() const {
+    std::ostringstream os;
+    os << _nofKeys << " join keys in [" << _min << ", " << _max << "]";
+    return os.str();
+  }
+
+ private:
+  Id _min;
+  Id _max;
+  size_t _nofKeys;
+  bool _isBitmap;
+  size_t _nofBits;
+  vector<uint64_t> _bits;
+
+  // Double hashing, the i-th hash function is h1 + i * h2.
+  size_t hash(Id key, size_t i) const {
+    uint64_t k = static_cast<uint64_t>(key);
+    uint64_t h1 = k * 0x9E3779B97F4A7C15ull;
+    uint64_t h2 = ((k ^ (k >> 29)) * 0xBF58476D1CE4E5B9ull) | 1;
+    return static_cast<size_t>(((h1 >> 17) + i * (h2 >> 17)) % _nofBits);
+  }
+
+  void setBit(size_t i) { _bits[i / 64] |= uint64_t(1) << (i % 64); }
+
+  bool getBit(size_t i) const {
+    return (_bits[i / 64] >> (i % 64)) & uint64_t(1);
+  }
+};
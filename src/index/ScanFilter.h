@@ -0,0 +1,154 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../global/Id.h"
+#include "../parser/ParsedQuery.h"
+#include "./JoinKeyFilter.h"
+
+using std::array;
+using std::string;
+using std::vector;
+
+// A conjunction of comparisons of one column of a scan result with constant
+// ids. Equality and range constraints are collapsed into a single closed
+// interval, inequalities are kept as a (small) sorted set of excluded ids.
+// This allows the index to drop rows while reading a relation instead of
+// materializing the full relation and filtering it afterwards.
+// Additionally, the values of one column can be restricted to the keys of a
+// JoinKeyFilter.
+class ScanFilter {
+ public:
+  ScanFilter()
+      : _column(0),
+        _lower(0),
+        _upper(std::numeric_limits<Id>::max()),
+        _acceptsNothing(false),
+        _isUsed(false),
+        _excluded(),
+        _keyColumn(0),
+        _keys() {}
+
+  // Restricts the filter further. Returns false (and leaves the filter
+  // unchanged) if the filter type can not be expressed on ids or if the
+  // filter already restricts a different column.
+  bool add(size_t column, SparqlFilter::FilterType type, Id value) {
+    if (_isUsed && column != _column) {
+      return false;
+    }
+    switch (type) {
+      case SparqlFilter::EQ:
+        _lower = std::max(_lower, value);
+        _upper = std::min(_upper, value);
+        break;
+      case SparqlFilter::NE:
+        _excluded.insert(
+            std::lower_bound(_excluded.begin(), _excluded.end(), value),
+            value);
+        break;
+      case SparqlFilter::LT:
+        if (value == 0) {
+          _acceptsNothing = true;
+        } else {
+          _upper = std::min(_upper, value - 1);
+        }
+        break;
+      case SparqlFilter::LE:
+        _upper = std::min(_upper, value);
+        break;
+      case SparqlFilter::GT:
+        if (value == std::numeric_limits<Id>::max()) {
+          _acceptsNothing = true;
+        } else {
+          _lower = std::max(_lower, value + 1);
+        }
+        break;
+      case SparqlFilter::GE:
+        _lower = std::max(_lower, value);
+        break;
+      default:
+        return false;
+    }
+    if (_lower > _upper) {
+      _acceptsNothing = true;
+    }
+    _column = column;
+    _isUsed = true;
+    return true;
+  }
+
+  // Only keeps rows whose value in the given column may be one of the keys.
+  void setJoinKeys(size_t column, std::shared_ptr<const JoinKeyFilter> keys) {
+    _keyColumn = column;
+    _keys = keys;
+  }
+
+  bool accepts(Id id) const {
+    return !_acceptsNothing && id >= _lower && id <= _upper &&
+           !std::binary_search(_excluded.begin(), _excluded.end(), id);
+  }
+
+  template <size_t N>
+  bool accepts(const array<Id, N>& row) const {
+    return (!_isUsed || accepts(row[_column])) &&
+           (!_keys || _keys->mayContain(row[_keyColumn]));
+  }
+
+  // True iff no id can be larger than the given one and still be accepted.
+  // Used to stop early when reading a column in sorted order.
+  bool isAboveRange(Id id) const { return _acceptsNothing || id > _upper; }
+
+  // True iff no row with a larger value in the (sorted) first column can be
+  // accepted.
+  template <size_t N>
+  bool isAboveRange(const array<Id, N>& row) const {
+    return (_isUsed && _column == 0 && isAboveRange(row[0])) ||
+           (_keys && _keyColumn == 0 && row[0] > _keys->max());
+  }
+
+  bool empty() const { return !_isUsed && !_keys; }
+
+  bool acceptsNothing() const {
+    return _acceptsNothing || (_keys && _keys->empty());
+  }
+
+  bool isEquality() const { return _isUsed && _lower == _upper; }
+
+  bool isRange() const {
+    return _lower > 0 || _upper < std::numeric_limits<Id>::max();
+  }
+
+  size_t getColumn() const { return _column; }
+
+  string asString() const {
+    std::ostringstream os;
+    os << "col " << _column << " in [" << _lower << ", " << _upper << "]";
+    if (_acceptsNothing) {
+      os << " (empty)";
+    }
+    for (size_t i = 0; i < _excluded.size(); ++i) {
+      os << (i == 0 ? " except " : ", ") << _excluded[i];
+    }
+    if (_keys) {
+      os << ", col " << _keyColumn << " in " << _keys->asString();
+    }
+    return os.str();
+  }
+
+ private:
+  size_t _column;
+  Id _lower;
+  Id _upper;
+  bool _acceptsNothing;
+  bool _isUsed;
+  vector<Id> _excluded;
+  size_t _keyColumn;
+  std::shared_ptr<const JoinKeyFilter> _keys;
+};
@@ -0,0 +1,96 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <sstream>
+#include "./Exception.h"
+#include "./MemoryTracker.h"
+
+namespace ad_utility {
+//! Signals to a running query that it should stop, either because it has
+//! been cancelled explicitly or because its deadline has passed. Long running
+//! loops check the handle cooperatively and abort by throwing an exception.
+class CancellationHandle {
+ public:
+  typedef std::chrono::steady_clock Clock;
+
+  //! A handle without deadline, only cancelled explicitly.
+  CancellationHandle() : _hasDeadline(false), _timeout(0), _cancelled(false) {}
+
+  //! A handle that is cancelled timeoutInSeconds after its creation.
+  explicit CancellationHandle(double timeoutInSeconds)
+      : _hasDeadline(true),
+        _timeout(timeoutInSeconds),
+        _deadline(Clock::now() +
+                  std::chrono::duration_cast<Clock::duration>(
+                      std::chrono::duration<double>(timeoutInSeconds))),
+        _cancelled(false) {}
+
+  CancellationHandle(const CancellationHandle&) = delete;
+  CancellationHandle& operator=(const CancellationHandle&) = delete;
+
+  void cancel() { _cancelled = true; }
+
+  bool isCancelled() const {
+    return _cancelled || (_hasDeadline && Clock::now() >= _deadline);
+  }
+
+  //! Throws if the query has been cancelled or its deadline has passed.
+  void check() const {
+    if (_cancelled) {
+      AD_THROW(ad_semsearch::Exception::QUERY_CANCELLED,
+               "The query has been cancelled.");
+    }
+    if (_hasDeadline && Clock::now() >= _deadline) {
+      std::ostringstream os;
+      os << "The query exceeded its time limit of " << _timeout
+         << " seconds.";
+      AD_THROW(ad_semsearch::Exception::QUERY_CANCELLED, os.str());
+    }
+  }
+
+ private:
+  bool _hasDeadline;
+  double _timeout;
+  Clock::time_point _deadline;
+  std::atomic<bool> _cancelled;
+};
+
+//! Checks a cancellation handle only every CHECK_INTERVAL calls, so that it
+//! can be used inside tight loops. A null handle is never cancelled. The
+//! same checks account for the growth of the result computed by the current
+//! thread, see GrowingMemory, and throw if it exceeds its memory limit.
+class CancellationCheckpoint {
+ public:
+  static const size_t CHECK_INTERVAL = 16 * 1024;
+
+  explicit CancellationCheckpoint(const CancellationHandle* handle)
+      : _handle(handle), _count(0) {}
+
+  //! Throws if a check is due and the handle is cancelled.
+  void operator()() {
+    if (++_count % CHECK_INTERVAL == 0) {
+      check();
+    }
+  }
+
+  //! Variant that does not throw, for loops that have to restore their
+  //! input before they can be left. Call check() afterwards.
+  bool shouldStop() {
+    return _handle && ++_count % CHECK_INTERVAL == 0 && _handle->isCancelled();
+  }
+
+  void check() const {
+    if (_handle) {
+      _handle->check();
+    }
+    GrowingMemory::updateCurrent();
+  }
+
+ private:
+  const CancellationHandle* _handle;
+  size_t _count;
+};
+}  // namespace ad_utility
@@ -124,6 +124,7 @@ class Exception {
     // memory allocation errors
     REALLOC_FAILED = 16 * 3 + 1,
     NEW_FAILED = 16 * 3 + 2,
+    MEMORY_LIMIT_EXCEEDED = 16 * 3 + 3,
 
     // intersect errors
 
@@ -142,6 +143,7 @@ class Exception {
     NOT_YET_IMPLEMENTED = 16 * 9 + 5,
     INVALID_PARAMETER_VALUE = 16 * 9 + 6,
     CHECK_FAILED = 16 * 9 + 7,
+    QUERY_CANCELLED = 16 * 9 + 8,
     // unknown error
     OTHER = 0
   };
@@ -164,6 +166,8 @@ class Exception {
         return "MEMORY ALLOCATION ERROR: Realloc failed";
       case NEW_FAILED:
         return "MEMORY ALLOCATION ERROR: new failed";
+      case MEMORY_LIMIT_EXCEEDED:
+        return "MEMORY LIMIT EXCEEDED";
       case ERROR_PASSED_ON:
         return "PASSING ON ERROR";
         return "QUERY EXCEPTION: "
@@ -185,6 +189,8 @@ class Exception {
         return "INVALID PARAMETER VALUE";
       case CHECK_FAILED:
         return "CHECK FAILED";
+      case QUERY_CANCELLED:
+        return "QUERY CANCELLED";
       case OTHER:
         return "ERROR";
       default:
@@ -0,0 +1,306 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "./CancellationHandle.h"
+#include "./Exception.h"
+#include "./Log.h"
+
+namespace ad_utility {
+//! Sorts rows of a fixed number of values of type T which together may not
+//! fit into memory. Rows are collected until they fill the memory budget,
+//! then they are sorted and written as a run to a temporary file. When the
+//! sorted rows are read, the runs are merged on the fly. If all rows fit
+//! into the budget nothing is written to disk.
+template <typename T>
+class ExternalSorter {
+ public:
+  typedef std::function<bool(const T*, const T*)> Comparator;
+
+  // Size of the blocks in which runs are written.
+  static const size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+  //! The temporary file is created in directory and removed automatically.
+  ExternalSorter(size_t width, Comparator lessThan, size_t memoryBudget,
+                 const std::string& directory,
+                 const CancellationHandle* cancellation = nullptr)
+      : _width(width),
+        _lessThan(lessThan),
+        _directory(directory),
+        _checkpoint(cancellation),
+        _rowsPerRead(0),
+        _fd(-1),
+        _fileSize(0),
+        _nofRows(0),
+        _merging(false),
+        _pos(0),
+        _lastRun(NO_RUN) {
+    AD_CHECK_GT(width, 0);
+    // Sorting a run needs a permutation in addition to the rows.
+    _rowsPerRun = std::max<size_t>(
+        1, memoryBudget / (width * sizeof(T) + sizeof(size_t)));
+  }
+
+  ~ExternalSorter() {
+    if (_fd >= 0) {
+      close(_fd);
+    }
+  }
+
+  ExternalSorter(const ExternalSorter&) = delete;
+  ExternalSorter& operator=(const ExternalSorter&) = delete;
+
+  //! Adds a row of width values. Not possible once reading has started.
+  void push(const T* row) {
+    AD_CHECK(!_merging);
+    if (_buffer.size() == _buffer.capacity()) {
+      // Grow like a vector would, but never beyond a run. Otherwise the
+      // buffer could take up to twice the memory budget before it is full.
+      size_t capacity =
+          std::max(2 * _buffer.size(), WRITE_BUFFER_SIZE / sizeof(T));
+      _buffer.reserve(std::min(capacity, _rowsPerRun * _width));
+    }
+    _buffer.insert(_buffer.end(), row, row + _width);
+    ++_nofRows;
+    if (_buffer.size() / _width == _rowsPerRun) {
+      writeRun();
+    }
+  }
+
+  //! Returns the next row in sorted order or a null pointer if all rows have
+  //! been returned. The row stays valid until the next call.
+  const T* next() {
+    if (!_merging) {
+      startMerge();
+    }
+    _checkpoint();
+    if (_runs.empty()) {
+      if (_pos == _order.size()) {
+        return nullptr;
+      }
+      return &_buffer[_order[_pos++] * _width];
+    }
+    if (_lastRun != NO_RUN) {
+      if (advance(&_runs[_lastRun])) {
+        _heap.push_back(_lastRun);
+        std::push_heap(_heap.begin(), _heap.end(), HeapOrder(this));
+      }
+      _lastRun = NO_RUN;
+    }
+    if (_heap.empty()) {
+      return nullptr;
+    }
+    std::pop_heap(_heap.begin(), _heap.end(), HeapOrder(this));
+    _lastRun = _heap.back();
+    _heap.pop_back();
+    return _runs[_lastRun].row(_width);
+  }
+
+  size_t size() const { return _nofRows; }
+
+  //! The number of runs written to disk, 0 if the rows were sorted in memory.
+  size_t getNofRuns() const { return _runs.size(); }
+
+ private:
+  static const size_t NO_RUN = std::numeric_limits<size_t>::max();
+
+  // A sorted run in the temporary file and the part of it read last.
+  struct Run {
+    Run(off_t offset, size_t nofRows)
+        : _offset(offset), _remaining(nofRows), _pos(0) {}
+
+    const T* row(size_t width) const { return &_block[_pos * width]; }
+
+    off_t _offset;
+    size_t _remaining;
+    std::vector<T> _block;
+    size_t _pos;
+  };
+
+  // Orders runs by their current rows such that a heap built with it has
+  // the smallest row on top. Ties are broken by the run, so that equal rows
+  // are returned in the order in which they were pushed.
+  class HeapOrder {
+   public:
+    explicit HeapOrder(const ExternalSorter* sorter) : _sorter(sorter) {}
+
+    bool operator()(size_t a, size_t b) const {
+      const T* rowA = _sorter->_runs[a].row(_sorter->_width);
+      const T* rowB = _sorter->_runs[b].row(_sorter->_width);
+      if (_sorter->_lessThan(rowB, rowA)) {
+        return true;
+      }
+      return !_sorter->_lessThan(rowA, rowB) && a > b;
+    }
+
+   private:
+    const ExternalSorter* _sorter;
+  };
+
+  void sortBuffer() {
+    _order.resize(_buffer.size() / _width);
+    for (size_t i = 0; i < _order.size(); ++i) {
+      _order[i] = i;
+    }
+    const T* rows = _buffer.data();
+    size_t width = _width;
+    const Comparator& lessThan = _lessThan;
+    CancellationCheckpoint& checkpoint = _checkpoint;
+    std::sort(_order.begin(), _order.end(),
+              [rows, width, &lessThan, &checkpoint](size_t a, size_t b) {
+                checkpoint();
+                return lessThan(rows + a * width, rows + b * width) ||
+                       (!lessThan(rows + b * width, rows + a * width) &&
+                        a < b);
+              });
+  }
+
+  void writeRun() {
+    sortBuffer();
+    if (_fd < 0) {
+      openFile();
+    }
+    _runs.push_back(Run(_fileSize, _order.size()));
+    size_t rowsPerWrite =
+        std::max<size_t>(1, WRITE_BUFFER_SIZE / (_width * sizeof(T)));
+    std::vector<T> block;
+    block.reserve(rowsPerWrite * _width);
+    for (size_t i = 0; i < _order.size(); ++i) {
+      const T* row = &_buffer[_order[i] * _width];
+      block.insert(block.end(), row, row + _width);
+      if (block.size() == rowsPerWrite * _width || i + 1 == _order.size()) {
+        writeToFile(block);
+        block.clear();
+      }
+    }
+    _buffer.clear();
+    _order.clear();
+    LOG(DEBUG) << "Wrote run " << _runs.size() << " of an external sort"
+               << std::endl;
+  }
+
+  void openFile() {
+    std::string name = _directory + "/qlever-sort-XXXXXX";
+    std::vector<char> nameBuffer(name.begin(), name.end());
+    nameBuffer.push_back('\0');
+    _fd = mkstemp(nameBuffer.data());
+    if (_fd < 0) {
+      throwIoError("Could not create a temporary file in " + _directory);
+    }
+    // The file is removed as soon as it is closed.
+    unlink(nameBuffer.data());
+  }
+
+  void writeToFile(const std::vector<T>& values) {
+    const char* bytes = reinterpret_cast<const char*>(values.data());
+    size_t nofBytes = values.size() * sizeof(T);
+    while (nofBytes > 0) {
+      ssize_t written = write(_fd, bytes, nofBytes);
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        throwIoError("Could not write a run of an external sort");
+      }
+      bytes += written;
+      nofBytes -= written;
+      _fileSize += written;
+    }
+  }
+
+  // Reads the next block of the run. Returns false if the run is exhausted.
+  bool fill(Run* run) {
+    if (run->_remaining == 0) {
+      return false;
+    }
+    size_t nofRows = std::min(run->_remaining, _rowsPerRead);
+    run->_block.resize(nofRows * _width);
+    char* bytes = reinterpret_cast<char*>(run->_block.data());
+    size_t nofBytes = nofRows * _width * sizeof(T);
+    while (nofBytes > 0) {
+      ssize_t nofRead = pread(_fd, bytes, nofBytes, run->_offset);
+      if (nofRead <= 0) {
+        if (nofRead < 0 && errno == EINTR) {
+          continue;
+        }
+        throwIoError("Could not read a run of an external sort");
+      }
+      bytes += nofRead;
+      nofBytes -= nofRead;
+      run->_offset += nofRead;
+    }
+    run->_remaining -= nofRows;
+    run->_pos = 0;
+    return true;
+  }
+
+  bool advance(Run* run) {
+    ++run->_pos;
+    if (run->_pos * _width < run->_block.size()) {
+      return true;
+    }
+    return fill(run);
+  }
+
+  void startMerge() {
+    _merging = true;
+    if (_runs.empty()) {
+      sortBuffer();
+      _pos = 0;
+      return;
+    }
+    if (!_buffer.empty()) {
+      writeRun();
+    }
+    std::vector<T>().swap(_buffer);
+    std::vector<size_t>().swap(_order);
+    // The blocks read from all runs together fill the memory budget.
+    _rowsPerRead = std::max<size_t>(1, _rowsPerRun / _runs.size());
+    for (size_t i = 0; i < _runs.size(); ++i) {
+      if (fill(&_runs[i])) {
+        _heap.push_back(i);
+      }
+    }
+    std::make_heap(_heap.begin(), _heap.end(), HeapOrder(this));
+  }
+
+  void throwIoError(const std::string& message) const {
+    std::ostringstream os;
+    os << message << ": " << strerror(errno);
+    AD_THROW(ad_semsearch::Exception::OTHER, os.str());
+  }
+
+  size_t _width;
+  Comparator _lessThan;
+  std::string _directory;
+  CancellationCheckpoint _checkpoint;
+  size_t _rowsPerRun;
+  size_t _rowsPerRead;
+  int _fd;
+  off_t _fileSize;
+  size_t _nofRows;
+  bool _merging;
+
+  // The rows of the current run and their sorted order.
+  std::vector<T> _buffer;
+  std::vector<size_t> _order;
+  // Position in _order if all rows fit into memory.
+  size_t _pos;
+
+  std::vector<Run> _runs;
+  std::vector<size_t> _heap;
+  // The run of the row returned last, advanced on the next call.
+  size_t _lastRun;
+};
+}  // namespace ad_utility
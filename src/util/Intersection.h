@@ -0,0 +1,275 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "../global/Constants.h"
+#include "../global/Id.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+#define QLEVER_INTERSECTION_SIMD
+#endif
+
+namespace ad_utility {
+//! A sorted column of ids. Either a plain id list (stride 1) or one column
+//! of a table of fixed width rows (stride = row width).
+class IdColumn {
+ public:
+  IdColumn(const Id* data, size_t size, size_t stride = 1)
+      : _data(data), _size(size), _stride(stride) {}
+
+  template <size_t N>
+  IdColumn(const std::vector<std::array<Id, N>>& rows, size_t column)
+      : _data(rows.empty() ? nullptr : rows[0].data() + column),
+        _size(rows.size()),
+        _stride(N) {
+    static_assert(sizeof(std::array<Id, N>) == N * sizeof(Id),
+                  "Rows are expected to be stored without padding.");
+  }
+
+  explicit IdColumn(const std::vector<Id>& ids)
+      : _data(ids.data()), _size(ids.size()), _stride(1) {}
+
+  Id operator[](size_t i) const { return _data[i * _stride]; }
+
+  size_t size() const { return _size; }
+
+  size_t stride() const { return _stride; }
+
+  const Id* data() const { return _data; }
+
+ private:
+  const Id* _data;
+  size_t _size;
+  size_t _stride;
+};
+
+//! One column of a table whose rows are not stored contiguously, e.g. a
+//! vector<vector<Id>>. Has the interface of IdColumn, but is only scanned
+//! one id at a time.
+template <typename Rows>
+class RowColumn {
+ public:
+  RowColumn(const Rows& rows, size_t column) : _rows(&rows), _column(column) {}
+
+  Id operator[](size_t i) const { return (*_rows)[i][_column]; }
+
+  size_t size() const { return _rows->size(); }
+
+ private:
+  const Rows* _rows;
+  size_t _column;
+};
+
+//! The given column of a table. Tables with rows of a fixed width use an
+//! IdColumn, which the SIMD scans support.
+template <size_t N>
+IdColumn column(const std::vector<std::array<Id, N>>& rows, size_t col) {
+  return IdColumn(rows, col);
+}
+
+template <typename Rows>
+RowColumn<Rows> column(const Rows& rows, size_t col) {
+  return RowColumn<Rows>(rows, col);
+}
+
+namespace detail {
+inline size_t skipLessScalar(const IdColumn& col, size_t pos, Id value) {
+  while (pos < col.size() && col[pos] < value) {
+    ++pos;
+  }
+  return pos;
+}
+
+#ifdef QLEVER_INTERSECTION_SIMD
+// The SIMD instructions only compare signed integers, flipping the sign bit
+// of both operands yields the unsigned order.
+static const long long SIGN_BIT = static_cast<long long>(1ull << 63);
+
+__attribute__((target("sse4.2"))) inline size_t skipLessSse42(
+    const IdColumn& col, size_t pos, Id value) {
+  if (col.stride() != 1) {
+    return skipLessScalar(col, pos, value);
+  }
+  const __m128i bias = _mm_set1_epi64x(SIGN_BIT);
+  const __m128i v =
+      _mm_xor_si128(_mm_set1_epi64x(static_cast<long long>(value)), bias);
+  const Id* data = col.data();
+  for (; pos + 2 <= col.size(); pos += 2) {
+    __m128i keys = _mm_xor_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)), bias);
+    // Bit k is set iff key k is smaller than the value. The column is sorted,
+    // so the set bits form a prefix.
+    int less = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpgt_epi64(v, keys)));
+    if (less != 0x3) {
+      return pos + __builtin_popcount(less);
+    }
+  }
+  return skipLessScalar(col, pos, value);
+}
+
+__attribute__((target("avx2"))) inline size_t skipLessAvx2(
+    const IdColumn& col, size_t pos, Id value) {
+  const __m256i bias = _mm256_set1_epi64x(SIGN_BIT);
+  const __m256i v = _mm256_xor_si256(
+      _mm256_set1_epi64x(static_cast<long long>(value)), bias);
+  const long long stride = static_cast<long long>(col.stride());
+  const __m256i offsets = _mm256_set_epi64x(3 * stride, 2 * stride, stride, 0);
+  const long long* data = reinterpret_cast<const long long*>(col.data());
+  for (; pos + 4 <= col.size(); pos += 4) {
+    __m256i keys;
+    if (stride == 1) {
+      keys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos));
+    } else {
+      // One column of a table, gather the keys of four rows.
+      keys = _mm256_i64gather_epi64(data + pos * stride, offsets, 8);
+    }
+    keys = _mm256_xor_si256(keys, bias);
+    int less =
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpgt_epi64(v, keys)));
+    if (less != 0xF) {
+      return pos + __builtin_popcount(less);
+    }
+  }
+  return skipLessScalar(col, pos, value);
+}
+#endif
+
+typedef size_t (*SkipLessFunction)(const IdColumn&, size_t, Id);
+
+// Picks the best implementation supported by the CPU we are running on.
+inline SkipLessFunction selectSkipLess() {
+#ifdef QLEVER_INTERSECTION_SIMD
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return &skipLessAvx2;
+  }
+  if (__builtin_cpu_supports("sse4.2")) {
+    return &skipLessSse42;
+  }
+#endif
+  return &skipLessScalar;
+}
+}  // namespace detail
+
+//! Returns the first position >= pos whose id is not smaller than the value
+//! (or the size of the column). Scans linearly, several ids at once if the
+//! CPU supports it. Meant for short distances.
+inline size_t skipLess(const IdColumn& col, size_t pos, Id value) {
+  static const detail::SkipLessFunction impl = detail::selectSkipLess();
+  return impl(col, pos, value);
+}
+
+template <typename Column>
+size_t skipLess(const Column& col, size_t pos, Id value) {
+  while (pos < col.size() && col[pos] < value) {
+    ++pos;
+  }
+  return pos;
+}
+
+//! Same as skipLess, but uses exponential search followed by binary search.
+//! Meant for long distances.
+template <typename Column>
+size_t gallop(const Column& col, size_t pos, Id value) {
+  size_t lo = pos;
+  size_t hi = pos;
+  size_t step = 1;
+  while (hi < col.size() && col[hi] < value) {
+    lo = hi + 1;
+    hi += step;
+    step *= 2;
+  }
+  hi = std::min(hi, col.size());
+  while (lo < hi) {
+    size_t mid = lo + (hi - lo) / 2;
+    if (col[mid] < value) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+enum IntersectionStrategy { MERGE = 0, GALLOP_A = 1, GALLOP_B = 2 };
+
+//! Chooses how to intersect columns of the given sizes. A merge costs one
+//! step per id of both columns, galloping through the larger column costs
+//! about 2 * log2(large / small) + 1 (more expensive) steps per id of the
+//! smaller one.
+inline IntersectionStrategy chooseIntersectionStrategy(size_t sizeA,
+                                                       size_t sizeB) {
+  size_t small = std::min(sizeA, sizeB);
+  size_t large = std::max(sizeA, sizeB);
+  if (small == 0) {
+    return MERGE;
+  }
+  double gallopCost =
+      small * GALLOP_STEP_COST *
+      (2 * std::log2(static_cast<double>(large) / small) + 1);
+  if (gallopCost >= static_cast<double>(small + large)) {
+    return MERGE;
+  }
+  return sizeA > sizeB ? GALLOP_A : GALLOP_B;
+}
+
+//! Intersects two sorted columns (IdColumn or RowColumn). For every id
+//! contained in both, calls onMatch(beginA, endA, beginB, endB) with the
+//! ranges of positions holding that id, in increasing order of the ids. If
+//! one column is much larger than the other, its matching positions are
+//! found by galloping. onStep() is called once per step of the merge or
+//! galloping loop, e.g. to check whether the computation was cancelled.
+//! Returns the strategy that was used.
+template <typename A, typename B, typename F, typename S>
+IntersectionStrategy forEachMatch(const A& a, const B& b, F onMatch,
+                                  S onStep) {
+  return forEachMatch(a, b, chooseIntersectionStrategy(a.size(), b.size()),
+                      onMatch, onStep);
+}
+
+//! Same as above with the given strategy instead of the one chosen from the
+//! sizes of the columns.
+template <typename A, typename B, typename F, typename S>
+IntersectionStrategy forEachMatch(const A& a, const B& b,
+                                  IntersectionStrategy strategy, F onMatch,
+                                  S onStep) {
+  const bool gallopA = strategy == GALLOP_A;
+  const bool gallopB = strategy == GALLOP_B;
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    onStep();
+    if (a[i] < b[j]) {
+      i = gallopA ? gallop(a, i, b[j]) : skipLess(a, i, b[j]);
+    } else if (b[j] < a[i]) {
+      j = gallopB ? gallop(b, j, a[i]) : skipLess(b, j, a[i]);
+    } else {
+      Id key = a[i];
+      size_t endI = i + 1;
+      while (endI < a.size() && a[endI] == key) {
+        ++endI;
+      }
+      size_t endJ = j + 1;
+      while (endJ < b.size() && b[endJ] == key) {
+        ++endJ;
+      }
+      onMatch(i, endI, j, endJ);
+      i = endI;
+      j = endJ;
+    }
+  }
+  return strategy;
+}
+
+//! Same as above without a callback per step.
+template <typename A, typename B, typename F>
+IntersectionStrategy forEachMatch(const A& a, const B& b, F onMatch) {
+  return forEachMatch(a, b, onMatch, [] {});
+}
+}  // namespace ad_utility
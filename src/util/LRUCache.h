@@ -5,10 +5,19 @@
 #pragma once
 
 #include <assert.h>
+#include <ctype.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
 #include <list>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <string>
 #include <utility>
+#include "./Exception.h"
 #include "./HashMap.h"
 
 using std::list;
@@ -17,13 +26,67 @@ using std::pair;
 using std::shared_ptr;
 
 namespace ad_utility {
+//! Which entries a cache evicts first when it is full.
+enum class EvictionPolicy {
+  //! The least recently used entry.
+  LRU,
+  //! Greedy Dual Size Frequency: the entry with the lowest priority
+  //! L + frequency * cost / size, where L is the priority of the entry evicted
+  //! last. Entries that are used often or are expensive to compute relative to
+  //! their size are kept, the growing L ages out entries that are not used
+  //! anymore.
+  GDSF
+};
+
+//! Parses "lru" or "gdsf" (in any case). Throws for other names.
+inline EvictionPolicy evictionPolicyFromString(const std::string& name) {
+  std::string lower;
+  for (char c : name) {
+    lower += static_cast<char>(tolower(c));
+  }
+  if (lower == "lru") {
+    return EvictionPolicy::LRU;
+  }
+  if (lower == "gdsf") {
+    return EvictionPolicy::GDSF;
+  }
+  AD_THROW(ad_semsearch::Exception::BAD_INPUT,
+           "Unknown eviction policy \"" + name + "\", expected lru or gdsf.");
+}
+
+//! An entry of an LRUCache with the size of its value when it was measured
+//! last and what is needed to compute its GDSF priority.
+template <class Key, class Value>
+struct LRUCacheEntry {
+  LRUCacheEntry(const Key& key, shared_ptr<const Value> value, size_t size)
+      : _key(key),
+        _value(value),
+        _size(size),
+        _cost(1),
+        _frequency(1),
+        _priority(0) {}
+
+  Key _key;
+  shared_ptr<const Value> _value;
+  size_t _size;
+  // The cost of computing the value again.
+  double _cost;
+  size_t _frequency;
+  double _priority;
+};
+
 //! Associative array for almost arbitrary keys and values that acts as a cache.
 //! Hash a fixed capacity and applies a least recently used (LRU) strategy
-//! for removing elements once the capacity is exceeded.
+//! for removing elements once the capacity is exceeded, or the cost aware
+//! GDSF strategy if that is chosen with setEvictionPolicy.
 //! Keys have to be proper keys for the underlying AccessMap and value types
 //! have to provide a default constructor.
-//! Currently capacity relates to numbers of elements. May be changed
-//! to bytes and checking entry sizes in the future.
+//! The capacity is a number of elements. Optionally the cache is also bounded
+//! by the total size of its values, e.g. in bytes. Values added with insert
+//! are measured by a size function, values that are filled after they have
+//! been emplaced are measured by the caller, who passes the size to
+//! updateSize once the value is complete. Values are never measured while
+//! the cache is locked.
 //! An AccessMap can be provided in order to achieve a matching other than
 //! exact matching. An example application for that is using the LRUCache
 //! as full-text-query cache where one might want to get the best fit of any
@@ -35,17 +98,45 @@ namespace ad_utility {
 //! that deletes do not free in-use memory.
 template <class Key, class Value,
           class AccessMap = ad_utility::HashMap<
-              Key, typename list<pair<Key, shared_ptr<const Value>>>::iterator>>
+              Key, typename list<LRUCacheEntry<Key, Value>>::iterator>>
 class LRUCache {
  private:
-  typedef pair<Key, shared_ptr<const Value>> Entry;
+  typedef LRUCacheEntry<Key, Value> Entry;
   typedef pair<shared_ptr<Value>, shared_ptr<const Value>> EmplacePair;
   typedef list<Entry> EntryList;
 
  public:
+  typedef std::function<size_t(const Value&)> SizeFunction;
+
   //! Typical constructor. A default value may be added in time.
   explicit LRUCache(size_t capacity)
-      : _capacity(capacity), _data(), _accessMap(), _lock() {}
+      : _capacity(capacity),
+        _sizeOf(),
+        _maxSize(std::numeric_limits<size_t>::max()),
+        _totalSize(0),
+        _policy(EvictionPolicy::LRU),
+        _inflation(0),
+        _data(),
+        _accessMap(),
+        _lock() {}
+
+  //! A cache whose values may in total have at most maxSize. Their sizes
+  //! are only known from updateSize.
+  LRUCache(size_t capacity, size_t maxSize)
+      : LRUCache(capacity, SizeFunction(), maxSize) {}
+
+  //! A cache whose values may in total have at most maxSize, values added
+  //! with insert are measured with sizeOf.
+  LRUCache(size_t capacity, SizeFunction sizeOf, size_t maxSize)
+      : _capacity(capacity),
+        _sizeOf(sizeOf),
+        _maxSize(maxSize),
+        _totalSize(0),
+        _policy(EvictionPolicy::LRU),
+        _inflation(0),
+        _data(),
+        _accessMap(),
+        _lock() {}
 
   // tryEmplace allows for race-free adding of items to the cache. Iff no item
   // in the cache is associated with the key a new item is created and
@@ -69,25 +160,13 @@ class LRUCache {
       // Insert without taking mutex recursively
       shared_ptr<Value> emplaced =
           make_shared<Value>(std::forward<Args>(args)...);
-      _data.emplace_front(key, emplaced);
-      _accessMap[key] = _data.begin();
-      if (_data.size() > _capacity) {
-        // Remove the last element.
-        // Since we are using shared_ptr this does not free the underlying
-        // memory if it is still accessible through a previously returned
-        // shared_ptr
-        _accessMap.erase(_data.back().first);
-        _data.pop_back();
-      }
-      assert(_data.size() <= _capacity);
+      // The value is still being filled, its size is set by updateSize.
+      pushFront(key, emplaced, 0, false);
       result = EmplacePair(emplaced, emplaced);
       return result;
     }
-    // Move it to the front.
-    typename EntryList::iterator listIt = mapIt->second;
-    _data.splice(_data.begin(), _data, listIt);
-    _accessMap[key] = _data.begin();
-    result = EmplacePair(shared_ptr<Value>(nullptr), _data.begin()->second);
+    touch(mapIt->second);
+    result = EmplacePair(shared_ptr<Value>(nullptr), _data.begin()->_value);
     return result;
   }
 
@@ -104,43 +183,81 @@ class LRUCache {
       return result;
     }
 
-    // Move it to the front.
-    typename EntryList::iterator listIt = mapIt->second;
-    _data.splice(_data.begin(), _data, listIt);
-    _accessMap[key] = _data.begin();
-    result = _data.front().second;
+    touch(mapIt->second);
+    result = _data.front()._value;
     return result;
   }
 
-  //! Insert a key value pair to the cache.
+  //! Insert a key value pair to the cache, replacing an existing value.
   void insert(const Key& key, Value value) {
+    size_t size = _sizeOf ? _sizeOf(value) : 0;
+    shared_ptr<const Value> inserted =
+        make_shared<const Value>(std::move(value));
     std::lock_guard<std::mutex> lock(_lock);
-    _data.emplace_front(key, make_shared<const Value>(std::move(value)));
-    _accessMap[key] = _data.begin();
-    if (_data.size() > _capacity) {
-      // Remove the last element.
-      // Since we are using shared_ptr this does not free the underlying
-      // memory if it is still accessible through a previously returned
-      // shared_ptr
-      _accessMap.erase(_data.back().first);
-      _data.pop_back();
+    typename AccessMap::const_iterator mapIt = _accessMap.find(key);
+    if (mapIt != _accessMap.end()) {
+      remove(mapIt->second);
     }
-    assert(_data.size() <= _capacity);
+    pushFront(key, inserted, size, true);
   }
 
   //! Set the capacity.
   void setCapacity(const size_t nofElements) {
     std::lock_guard<std::mutex> lock(_lock);
     _capacity = nofElements;
-    while (_data.size() > _capacity) {
-      // Remove the last element.
-      // Since we are using shared_ptr this does not free the underlying
-      // memory if it is still accessible through a previously returned
-      // shared_ptr
-      _accessMap.erase(_data.back().first);
-      _data.pop_back();
+    evictIfNeeded();
+  }
+
+  //! Set the maximum total size of the values. Only has an effect if the
+  //! cache was created with a size function.
+  void setMaxSize(const size_t maxSize) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _maxSize = maxSize;
+    evictIfNeeded();
+  }
+
+  //! Set the policy by which entries are evicted.
+  void setEvictionPolicy(EvictionPolicy policy) {
+    std::lock_guard<std::mutex> lock(_lock);
+    _policy = policy;
+    _priorities.clear();
+    if (_policy == EvictionPolicy::GDSF) {
+      for (Entry& entry : _data) {
+        entry._priority = computePriority(entry);
+        _priorities.insert(std::make_pair(entry._priority, entry._key));
+      }
     }
-    assert(_data.size() <= _capacity);
+  }
+
+  //! Sets the size of the value with the given key, e.g. after it has been
+  //! filled by the caller of tryEmplace, and the cost of computing it, which
+  //! only matters for GDSF. If the cache then exceeds its maximum size,
+  //! entries are evicted, possibly including this one if it is larger than
+  //! the maximum size on its own.
+  void updateSize(const Key& key, size_t size, double cost = 1) {
+    std::lock_guard<std::mutex> lock(_lock);
+    typename AccessMap::const_iterator mapIt = _accessMap.find(key);
+    if (mapIt == _accessMap.end()) {
+      return;
+    }
+    Entry& entry = *mapIt->second;
+    _totalSize -= entry._size;
+    entry._size = size;
+    _totalSize += entry._size;
+    entry._cost = cost;
+    setPriority(&entry, computePriority(entry));
+    evictIfNeeded();
+  }
+
+  //! The total size of all values as it was last measured.
+  size_t getTotalSize() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _totalSize;
+  }
+
+  size_t size() {
+    std::lock_guard<std::mutex> lock(_lock);
+    return _data.size();
   }
 
   //! Checks if there is an entry with the given key.
@@ -149,6 +266,30 @@ class LRUCache {
     return _accessMap.count(key) > 0;
   }
 
+  //! Removes the entry with the given key if there is one.
+  //! Since we are using shared_ptr this does not free the underlying memory
+  //! if it is still accessible through a previously returned shared_ptr.
+  void erase(const Key& key) {
+    std::lock_guard<std::mutex> lock(_lock);
+    typename AccessMap::const_iterator mapIt = _accessMap.find(key);
+    if (mapIt == _accessMap.end()) {
+      return;
+    }
+    remove(mapIt->second);
+  }
+
+  //! Removes the entry with the given key only if its value is still value.
+  //! Unlike erase this never removes an entry that has replaced the one the
+  //! caller knows, e.g. after that was evicted.
+  void erase(const Key& key, const shared_ptr<const Value>& value) {
+    std::lock_guard<std::mutex> lock(_lock);
+    typename AccessMap::const_iterator mapIt = _accessMap.find(key);
+    if (mapIt == _accessMap.end() || mapIt->second->_value != value) {
+      return;
+    }
+    remove(mapIt->second);
+  }
+
   //! Clear the cache
   void clear() {
     std::lock_guard<std::mutex> lock(_lock);
@@ -157,10 +298,89 @@ class LRUCache {
     // shared_ptr
     _data.clear();
     _accessMap.clear();
+    _priorities.clear();
+    _totalSize = 0;
   }
 
  private:
+  // Adds a new entry as the most recently used one. Under GDSF an entry that
+  // is not complete yet is not evicted before any complete one. The caller
+  // holds the lock.
+  void pushFront(const Key& key, shared_ptr<const Value> value, size_t size,
+                 bool complete) {
+    _data.emplace_front(key, value, size);
+    _accessMap[key] = _data.begin();
+    _totalSize += size;
+    if (_policy == EvictionPolicy::GDSF) {
+      _data.front()._priority =
+          complete ? computePriority(_data.front())
+                   : std::numeric_limits<double>::infinity();
+      _priorities.insert(std::make_pair(_data.front()._priority, key));
+    }
+    evictIfNeeded();
+  }
+
+  // Makes the entry the most recently used one and counts the use.
+  void touch(typename EntryList::iterator it) {
+    _data.splice(_data.begin(), _data, it);
+    _accessMap[it->_key] = _data.begin();
+    ++it->_frequency;
+    if (std::isfinite(it->_priority)) {
+      setPriority(&*it, computePriority(*it));
+    }
+  }
+
+  double computePriority(const Entry& entry) const {
+    return _inflation +
+           entry._frequency * entry._cost / std::max<size_t>(entry._size, 1);
+  }
+
+  void setPriority(Entry* entry, double priority) {
+    if (_policy == EvictionPolicy::GDSF) {
+      _priorities.erase(std::make_pair(entry->_priority, entry->_key));
+      _priorities.insert(std::make_pair(priority, entry->_key));
+    }
+    entry->_priority = priority;
+  }
+
+  // Evicts entries until the cache is within its capacity and maximum size.
+  // Since we are using shared_ptr this does not free the underlying memory
+  // if it is still accessible through a previously returned shared_ptr.
+  void evictIfNeeded() {
+    while (!_data.empty() &&
+           (_data.size() > _capacity || _totalSize > _maxSize)) {
+      if (_policy == EvictionPolicy::LRU) {
+        remove(std::prev(_data.end()));
+        continue;
+      }
+      const pair<double, Key>& lowest = *_priorities.begin();
+      if (std::isfinite(lowest.first)) {
+        _inflation = lowest.first;
+      }
+      remove(_accessMap.find(lowest.second)->second);
+    }
+    assert(_data.size() <= _capacity);
+  }
+
+  void remove(typename EntryList::iterator it) {
+    _totalSize -= it->_size;
+    if (_policy == EvictionPolicy::GDSF) {
+      _priorities.erase(std::make_pair(it->_priority, it->_key));
+    }
+    _accessMap.erase(it->_key);
+    _data.erase(it);
+  }
+
   size_t _capacity;
+  SizeFunction _sizeOf;
+  size_t _maxSize;
+  // The sum of the sizes of all entries.
+  size_t _totalSize;
+  EvictionPolicy _policy;
+  // The priority of the entry evicted last under GDSF.
+  double _inflation;
+  // The priorities of all entries under GDSF, lowest first.
+  std::set<pair<double, Key>> _priorities;
   EntryList _data;
   AccessMap _accessMap;
   // TODO(schnelle): Once we switch to C++17
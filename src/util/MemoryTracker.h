@@ -0,0 +1,133 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "./Exception.h"
+
+namespace ad_utility {
+//! Thread-safe accounting of the bytes held by some consumer, e.g. the
+//! results of a single query, with an optional hard limit.
+class MemoryTracker {
+ public:
+  static const size_t UNLIMITED = std::numeric_limits<size_t>::max();
+
+  explicit MemoryTracker(size_t limit = UNLIMITED, const std::string& name = "")
+      : _name(name), _limit(limit), _bytesUsed(0), _peakBytesUsed(0) {}
+
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+  //! Accounts for bytes more memory. If this would exceed the limit nothing
+  //! is accounted and an exception is thrown instead.
+  void allocate(size_t bytes) {
+    size_t used = _bytesUsed.load();
+    do {
+      if (bytes > _limit || used > _limit - bytes) {
+        std::ostringstream os;
+        os << "Memory limit exceeded";
+        if (!_name.empty()) {
+          os << " for " << _name;
+        }
+        os << ": " << used << " bytes in use, " << bytes
+           << " bytes requested, limit is " << _limit << " bytes.";
+        AD_THROW(ad_semsearch::Exception::MEMORY_LIMIT_EXCEEDED, os.str());
+      }
+    } while (!_bytesUsed.compare_exchange_weak(used, used + bytes));
+    size_t peak = _peakBytesUsed.load();
+    while (used + bytes > peak &&
+           !_peakBytesUsed.compare_exchange_weak(peak, used + bytes)) {
+    }
+  }
+
+  //! Releases bytes previously accounted for by allocate.
+  void free(size_t bytes) { _bytesUsed -= bytes; }
+
+  size_t getBytesUsed() const { return _bytesUsed; }
+
+  size_t getPeakBytesUsed() const { return _peakBytesUsed; }
+
+  size_t getLimit() const { return _limit; }
+
+ private:
+  std::string _name;
+  size_t _limit;
+  std::atomic<size_t> _bytesUsed;
+  std::atomic<size_t> _peakBytesUsed;
+};
+
+//! Returns a pointer to the same object as value that frees bytes from the
+//! tracker once it and all of its copies are gone, e.g. to release the
+//! charge of a query for a result when the query does not use it anymore.
+//! Other pointers to the object, e.g. held by a cache, still keep it alive.
+template <typename T>
+std::shared_ptr<T> freeWhenReleased(std::shared_ptr<T> value,
+                                    std::shared_ptr<MemoryTracker> tracker,
+                                    size_t bytes) {
+  T* object = value.get();
+  return std::shared_ptr<T>(object, [value, tracker, bytes](T*) {
+    tracker->free(bytes);
+  });
+}
+
+//! Accounts for memory while it is being filled, e.g. for a result while it
+//! is computed, so that the limit of the tracker holds before the memory is
+//! complete. Its size is measured by a function and the growth since the
+//! last measurement is allocated from the tracker. The growing memory
+//! created last by the current thread is measured by updateCurrent, which
+//! long running loops call through their CancellationCheckpoint.
+class GrowingMemory {
+ public:
+  GrowingMemory(MemoryTracker* tracker, std::function<size_t()> measure)
+      : _tracker(tracker),
+        _measure(measure),
+        _accountedBytes(0),
+        _previous(current()) {
+    current() = this;
+  }
+
+  ~GrowingMemory() { current() = _previous; }
+
+  GrowingMemory(const GrowingMemory&) = delete;
+  GrowingMemory& operator=(const GrowingMemory&) = delete;
+
+  //! Allocates the growth since the last measurement. Throws if this
+  //! exceeds the limit of the tracker.
+  void update() { accountFor(_measure()); }
+
+  //! Allocates the rest of bytes, the exact size of the complete memory.
+  void finish(size_t bytes) { accountFor(bytes); }
+
+  size_t getAccountedBytes() const { return _accountedBytes; }
+
+  //! Updates the growing memory of the current thread, if there is one.
+  static void updateCurrent() {
+    if (current()) {
+      current()->update();
+    }
+  }
+
+ private:
+  void accountFor(size_t bytes) {
+    if (bytes > _accountedBytes) {
+      _tracker->allocate(bytes - _accountedBytes);
+      _accountedBytes = bytes;
+    }
+  }
+
+  static GrowingMemory*& current() {
+    static thread_local GrowingMemory* current = nullptr;
+    return current;
+  }
+
+  MemoryTracker* _tracker;
+  std::function<size_t()> _measure;
+  size_t _accountedBytes;
+  GrowingMemory* _previous;
+};
+}  // namespace ad_utility
@@ -0,0 +1,177 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ad_utility {
+//! A pool of worker threads that executes tasks, shared by all queries.
+//! A thread that waits for a task which has not been started yet executes it
+//! itself. Hence tasks may spawn and wait for further tasks (e.g. the
+//! children of a join that are joins themselves) without the danger of
+//! running out of workers: a waiting thread only ever blocks on a task that
+//! is already being executed by another thread.
+class TaskScheduler {
+ public:
+  class Task {
+   public:
+    explicit Task(std::function<void()> function)
+        : _function(function), _state(PENDING) {}
+
+   private:
+    enum State { PENDING = 0, RUNNING = 1, DONE = 2 };
+
+    // Runs the task unless another thread has already claimed it. Returns
+    // true iff this thread ran the task.
+    bool tryRun() {
+      int expected = PENDING;
+      if (!_state.compare_exchange_strong(expected, RUNNING)) {
+        return false;
+      }
+      try {
+        _function();
+      } catch (...) {
+        _exception = std::current_exception();
+      }
+      std::lock_guard<std::mutex> lock(_mutex);
+      _state = DONE;
+      _done.notify_all();
+      return true;
+    }
+
+    void awaitDone() {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _done.wait(lock, [this] { return _state == DONE; });
+    }
+
+    std::function<void()> _function;
+    std::atomic<int> _state;
+    std::exception_ptr _exception;
+    std::mutex _mutex;
+    std::condition_variable _done;
+
+    friend class TaskScheduler;
+  };
+
+  explicit TaskScheduler(size_t nofThreads) : _shutdown(false) {
+    for (size_t i = 0; i < nofThreads; ++i) {
+      _workers.emplace_back([this] { work(); });
+    }
+  }
+
+  ~TaskScheduler() {
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _shutdown = true;
+    }
+    _newTask.notify_all();
+    for (auto& worker : _workers) {
+      worker.join();
+    }
+  }
+
+  TaskScheduler(const TaskScheduler&) = delete;
+  TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+  //! The scheduler shared by all threads of the process, with one worker
+  //! per hardware thread. Used unless the number of workers is configured,
+  //! see QueryExecutionContext::setNofWorkers.
+  static TaskScheduler& get() {
+    static TaskScheduler scheduler(
+        std::max(1u, std::thread::hardware_concurrency()));
+    return scheduler;
+  }
+
+  size_t getNofWorkers() const { return _workers.size(); }
+
+  //! Schedules the function for execution by one of the workers.
+  std::shared_ptr<Task> spawn(std::function<void()> function) {
+    std::shared_ptr<Task> task = std::make_shared<Task>(function);
+    if (_workers.empty()) {
+      task->tryRun();
+      return task;
+    }
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      _queue.push_back(task);
+    }
+    _newTask.notify_one();
+    return task;
+  }
+
+  //! Waits until the task is done, executing it in the calling thread if no
+  //! worker has started it yet. Rethrows exceptions thrown by the task.
+  void wait(const std::shared_ptr<Task>& task) {
+    if (!task->tryRun()) {
+      task->awaitDone();
+    }
+    if (task->_exception) {
+      std::rethrow_exception(task->_exception);
+    }
+  }
+
+  //! Executes all functions, concurrently if workers are available, and
+  //! returns when all of them are done. The first function is executed by
+  //! the calling thread. If functions throw, the first exception is
+  //! rethrown after all functions are done.
+  void runInParallel(const std::vector<std::function<void()>>& functions) {
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (size_t i = 1; i < functions.size(); ++i) {
+      tasks.push_back(spawn(functions[i]));
+    }
+    std::exception_ptr exception;
+    if (!functions.empty()) {
+      try {
+        functions[0]();
+      } catch (...) {
+        exception = std::current_exception();
+      }
+    }
+    for (const auto& task : tasks) {
+      try {
+        wait(task);
+      } catch (...) {
+        if (!exception) {
+          exception = std::current_exception();
+        }
+      }
+    }
+    if (exception) {
+      std::rethrow_exception(exception);
+    }
+  }
+
+ private:
+  void work() {
+    while (true) {
+      std::shared_ptr<Task> task;
+      {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _newTask.wait(lock, [this] { return _shutdown || !_queue.empty(); });
+        if (_queue.empty()) {
+          return;
+        }
+        task = _queue.front();
+        _queue.pop_front();
+      }
+      // Might have been run by a waiting thread already.
+      task->tryRun();
+    }
+  }
+
+  std::vector<std::thread> _workers;
+  std::deque<std::shared_ptr<Task>> _queue;
+  std::mutex _mutex;
+  std::condition_variable _newTask;
+  bool _shutdown;
+};
+}  // namespace ad_utility
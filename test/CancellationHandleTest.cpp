@@ -0,0 +1,58 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include "../src/util/CancellationHandle.h"
+
+using ad_utility::CancellationCheckpoint;
+using ad_utility::CancellationHandle;
+
+TEST(CancellationHandleTest, cancel) {
+  CancellationHandle handle;
+  ASSERT_FALSE(handle.isCancelled());
+  handle.check();
+  handle.cancel();
+  ASSERT_TRUE(handle.isCancelled());
+  ASSERT_THROW(handle.check(), ad_semsearch::Exception);
+}
+
+TEST(CancellationHandleTest, deadline) {
+  CancellationHandle expired(0);
+  ASSERT_TRUE(expired.isCancelled());
+  ASSERT_THROW(expired.check(), ad_semsearch::Exception);
+  CancellationHandle running(3600);
+  ASSERT_FALSE(running.isCancelled());
+  running.check();
+}
+
+TEST(CancellationHandleTest, checkpoint) {
+  CancellationHandle handle;
+  handle.cancel();
+  const size_t interval = CancellationCheckpoint::CHECK_INTERVAL;
+  CancellationCheckpoint checkpoint(&handle);
+  // Only every CHECK_INTERVAL-th call actually checks the handle.
+  for (size_t i = 1; i < interval; ++i) {
+    checkpoint();
+  }
+  ASSERT_THROW(checkpoint(), ad_semsearch::Exception);
+
+  CancellationCheckpoint nonThrowing(&handle);
+  size_t calls = 1;
+  while (!nonThrowing.shouldStop()) {
+    ++calls;
+  }
+  ASSERT_EQ(interval, calls);
+
+  // A null handle is never cancelled.
+  CancellationCheckpoint none(nullptr);
+  for (size_t i = 0; i < 2 * interval; ++i) {
+    none();
+    ASSERT_FALSE(none.shouldStop());
+  }
+  none.check();
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
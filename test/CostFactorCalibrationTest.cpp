@@ -0,0 +1,55 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include "../src/engine/CostFactorCalibration.h"
+
+typedef CostFactorCalibration::Measurement Measurement;
+typedef CostFactorCalibration::TwoTermMeasurement TwoTermMeasurement;
+
+TEST(CostFactorCalibrationTest, fitCoefficient) {
+  ASSERT_DOUBLE_EQ(0, CostFactorCalibration::fitCoefficient({}));
+  ASSERT_DOUBLE_EQ(0, CostFactorCalibration::fitCoefficient(
+                          {Measurement(0, 1), Measurement(0, 2)}));
+  ASSERT_DOUBLE_EQ(0.5, CostFactorCalibration::fitCoefficient(
+                            {Measurement(2, 1), Measurement(10, 5)}));
+  // Large measurements dominate the fit.
+  double c = CostFactorCalibration::fitCoefficient(
+      {Measurement(1, 10), Measurement(1000, 1000)});
+  ASSERT_GT(c, 1.0);
+  ASSERT_LT(c, 1.01);
+}
+
+TEST(CostFactorCalibrationTest, fitCoefficients) {
+  pair<double, double> c = CostFactorCalibration::fitCoefficients({});
+  ASSERT_DOUBLE_EQ(0, c.first);
+  ASSERT_DOUBLE_EQ(0, c.second);
+  // seconds = 2 * work1 + 3 * work2.
+  c = CostFactorCalibration::fitCoefficients(
+      {TwoTermMeasurement(1, 0, 2), TwoTermMeasurement(0, 1, 3),
+       TwoTermMeasurement(10, 100, 320)});
+  ASSERT_NEAR(2, c.first, 1e-9);
+  ASSERT_NEAR(3, c.second, 1e-9);
+  // The two kinds of work always occur in the same ratio.
+  c = CostFactorCalibration::fitCoefficients(
+      {TwoTermMeasurement(1, 2, 5), TwoTermMeasurement(10, 20, 50)});
+  ASSERT_DOUBLE_EQ(0, c.first);
+  ASSERT_DOUBLE_EQ(0, c.second);
+}
+
+TEST(CostFactorCalibrationTest, choosePredicates) {
+  vector<pair<string, size_t>> sizes = {
+      {"<a>", 5}, {"<b>", 900}, {"<c>", 20000}, {"<d>", 0}, {"<e>", 1100}};
+  vector<string> chosen =
+      CostFactorCalibration::choosePredicates(sizes, {1000, 10000, 1000000});
+  ASSERT_EQ(3u, chosen.size());
+  ASSERT_EQ("<e>", chosen[0]);
+  ASSERT_EQ("<c>", chosen[1]);
+  // The closest one is taken already.
+  ASSERT_EQ("<b>", chosen[2]);
+
+  // Every predicate is chosen at most once and empty ones never.
+  chosen = CostFactorCalibration::choosePredicates({{"<a>", 10}, {"<b>", 0}},
+                                                   {10, 100, 1000});
+  ASSERT_EQ(vector<string>({"<a>"}), chosen);
+}
@@ -5,6 +5,9 @@
 #include <gtest/gtest.h>
 #include <cstdio>
 #include <fstream>
+#include <functional>
+#include <tuple>
+#include "../src/engine/Comparators.h"
 #include "../src/engine/Engine.h"
 
 TEST(EngineTest, joinTest) {
@@ -21,7 +24,7 @@ TEST(EngineTest, joinTest) {
   b.push_back(array<Id, 2>{{3, 1}});
   b.push_back(array<Id, 2>{{4, 2}});
   vector<array<Id, 3>> res;
-  e.join(a, 0, b, 0, &res);
+  ASSERT_EQ(string("merge"), e.join(a, 0, b, 0, &res));
 
   ASSERT_EQ(1u, res[0][0]);
   ASSERT_EQ(1u, res[0][1]);
@@ -51,8 +54,11 @@ TEST(EngineTest, joinTest) {
   }
   a.push_back(array<Id, 2>{{400000, 200000}});
   b.push_back(array<Id, 2>{{400000, 200000}});
-  e.join(a, 0, b, 0, &res);
+  ASSERT_EQ(string("gallop through right"), e.join(a, 0, b, 0, &res));
   ASSERT_EQ(6u, res.size());
+  vector<array<Id, 3>> merged;
+  ASSERT_EQ(string("merge"), e.join(a, 0, b, 0, &merged, nullptr, false));
+  ASSERT_EQ(res, merged);
 
   a.clear();
   b.clear();
@@ -69,10 +75,33 @@ TEST(EngineTest, joinTest) {
   }
   a.push_back(array<Id, 2>{{4000001, 200000}});
   b.push_back(array<Id, 2>{{4000001, 200000}});
-  e.join(a, 0, b, 0, &res);
+  ASSERT_EQ(string("gallop through left"), e.join(a, 0, b, 0, &res));
   ASSERT_EQ(2u, res.size());
+
+  vector<array<Id, 3>> selfJoined;
+  ASSERT_EQ(string("self join"), e.join(b, 0, b, 0, &selfJoined));
+  ASSERT_EQ(2u, selfJoined.size());
 };
 
+TEST(EngineTest, twoColumnFilterTest) {
+  vector<vector<Id>> v = {{1, 1, 5}, {1, 3, 6}, {1, 3, 7}, {2, 2, 8},
+                          {4, 1, 9}, {4, 2, 10}};
+  vector<array<Id, 2>> filter = {{{1, 2}}, {{1, 3}}, {{3, 3}}, {{4, 2}}};
+  v.shrink_to_fit();
+  filter.shrink_to_fit();
+  const vector<Id>* vData = v.data();
+  const array<Id, 2>* filterData = filter.data();
+  vector<vector<Id>> res;
+  Engine::filter(v, 0, 1, filter, &res);
+  ASSERT_EQ((vector<vector<Id>>{{1, 3, 6}, {1, 3, 7}, {4, 2, 10}}), res);
+  // The inputs may be cached results used by other queries at the same
+  // time, they are not touched.
+  ASSERT_EQ(6u, v.size());
+  ASSERT_EQ(vData, v.data());
+  ASSERT_EQ(4u, filter.size());
+  ASSERT_EQ(filterData, filter.data());
+}
+
 TEST(EngineTest, optionalJoinTest) {
   Engine e;
   vector<array<Id, 3>> a;
@@ -163,6 +192,43 @@ TEST(EngineTest, optionalJoinTest) {
   ASSERT_EQ(r, vres[4]);
 }
 
+TEST(EngineTest, concurrentUseOfSharedInputs) {
+  // Cached results are used by several operations at the same time, the
+  // joins and filters must only read them.
+  vector<vector<Id>> a;
+  vector<array<Id, 2>> b;
+  for (Id i = 0; i < 10000; ++i) {
+    a.push_back({i / 2, i % 2});
+    b.push_back({{i, i % 3}});
+  }
+  vector<array<size_t, 2>> jcls = {{{0, 0}}};
+  auto run = [&a, &b, &jcls]() {
+    vector<vector<Id>> joined;
+    Engine::join(a, 0, b, 0, &joined);
+    vector<vector<Id>> filtered;
+    Engine::filter(a, 0, 1, b, &filtered);
+    vector<vector<Id>> optional;
+    Engine::optionalJoin<vector<vector<Id>>, vector<array<Id, 2>>,
+                         vector<Id>, 3>(a, b, false, true, jcls, &optional,
+                                        3);
+    return std::make_tuple(joined, filtered, optional);
+  };
+  auto expected = run();
+  ASSERT_EQ(10000u, std::get<0>(expected).size());
+  ASSERT_EQ(10000u, std::get<2>(expected).size());
+  vector<decltype(expected)> results(8);
+  vector<std::function<void()>> functions;
+  for (size_t i = 0; i < results.size(); ++i) {
+    functions.push_back([&results, &run, i] { results[i] = run(); });
+  }
+  ad_utility::TaskScheduler::get().runInParallel(functions);
+  for (const auto& result : results) {
+    ASSERT_EQ(expected, result);
+  }
+  ASSERT_EQ(10000u, a.size());
+  ASSERT_EQ(10000u, b.size());
+}
+
 TEST(EngineTest, patternTrickTest) {
   // The input table containing entity ids
   std::vector<std::array<Id, 1>> input = {{0}, {1}, {2}, {3}, {4}, {6}, {7}};
@@ -215,6 +281,159 @@ TEST(EngineTest, patternTrickTest) {
   ASSERT_EQ(3u, result[4][1]);
 }
 
+TEST(EngineTest, patternTrickPartitionedTest) {
+  // Subjects occur repeatedly, partitions must not count them twice.
+  std::vector<std::array<Id, 1>> input = {{0}, {0}, {1}, {3}, {3},
+                                          {3}, {4}, {6}, {6}, {7}};
+  vector<PatternID> hasPattern = {0, NO_PATTERN, NO_PATTERN, 1, 0};
+  vector<vector<Id>> hasRelationSrc = {{},     {0, 3}, {0},    {}, {},
+                                       {0, 3}, {3, 4}, {2, 4}, {3}};
+  vector<vector<Id>> patternsSrc = {{0, 2, 3}, {1, 3, 4, 2, 0}};
+  CompactStringVector<Id, Id> hasRelation(hasRelationSrc);
+  CompactStringVector<size_t, Id> densePatterns(patternsSrc);
+  // With many more patterns than input rows they are counted in a hash map.
+  patternsSrc.resize(1000);
+  CompactStringVector<size_t, Id> sparsePatterns(patternsSrc);
+
+  vector<array<Id, 2>> expected = {
+      {{0, 4}}, {{1, 1}}, {{2, 4}}, {{3, 5}}, {{4, 3}}};
+  for (size_t nofPartitions = 1; nofPartitions <= 4; ++nofPartitions) {
+    vector<array<Id, 2>> result;
+    Engine::computePatternTrick(&input, &result, hasPattern, hasRelation,
+                                densePatterns, 0, nofPartitions);
+    ASSERT_EQ(expected, result);
+    result.clear();
+    Engine::computePatternTrick(&input, &result, hasPattern, hasRelation,
+                                sparsePatterns, 0, nofPartitions);
+    ASSERT_EQ(expected, result);
+  }
+}
+
+TEST(EngineTest, topKTest) {
+  vector<array<Id, 2>> input = {{{5, 1}}, {{3, 2}}, {{9, 3}}, {{1, 4}},
+                                {{7, 5}}, {{3, 6}}, {{8, 7}}};
+  vector<array<Id, 2>> result;
+  // Descending on the first column.
+  Engine::topK(input, OBComp<array<Id, 2>>({{0, true}}), 3, &result);
+  ASSERT_EQ(3u, result.size());
+  ASSERT_EQ((array<Id, 2>{{9, 3}}), result[0]);
+  ASSERT_EQ((array<Id, 2>{{8, 7}}), result[1]);
+  ASSERT_EQ((array<Id, 2>{{7, 5}}), result[2]);
+
+  // Ascending on the first column, then descending on the second one.
+  Engine::topK(input, OBComp<array<Id, 2>>({{0, false}, {1, true}}), 3,
+               &result);
+  ASSERT_EQ(3u, result.size());
+  ASSERT_EQ((array<Id, 2>{{1, 4}}), result[0]);
+  ASSERT_EQ((array<Id, 2>{{3, 6}}), result[1]);
+  ASSERT_EQ((array<Id, 2>{{3, 2}}), result[2]);
+
+  // k larger than the input.
+  vector<vector<Id>> varInput = {{4, 0}, {2, 0}, {3, 0}};
+  vector<vector<Id>> varResult;
+  Engine::topK(varInput, OBComp<vector<Id>>({{0, false}}), 10, &varResult);
+  ASSERT_EQ(3u, varResult.size());
+  ASSERT_EQ(2u, varResult[0][0]);
+  ASSERT_EQ(3u, varResult[1][0]);
+  ASSERT_EQ(4u, varResult[2][0]);
+
+  Engine::topK(input, OBComp<array<Id, 2>>({{0, false}}), 0, &result);
+  ASSERT_EQ(0u, result.size());
+}
+
+TEST(EngineTest, hashDistinctTest) {
+  vector<array<Id, 3>> input = {{{5, 1, 0}}, {{3, 2, 1}}, {{5, 1, 2}},
+                                {{1, 4, 3}}, {{3, 2, 4}}, {{3, 3, 5}}};
+  vector<array<Id, 3>> result;
+  Engine::hashDistinct(input, {0, 1}, &result);
+  // The first occurrence is kept and the input order is preserved.
+  ASSERT_EQ(4u, result.size());
+  ASSERT_EQ((array<Id, 3>{{5, 1, 0}}), result[0]);
+  ASSERT_EQ((array<Id, 3>{{3, 2, 1}}), result[1]);
+  ASSERT_EQ((array<Id, 3>{{1, 4, 3}}), result[2]);
+  ASSERT_EQ((array<Id, 3>{{3, 3, 5}}), result[3]);
+
+  vector<vector<Id>> varInput = {{2, 0}, {1, 1}, {2, 2}, {2, 3}};
+  vector<vector<Id>> varResult;
+  Engine::hashDistinct(varInput, {0}, &varResult);
+  ASSERT_EQ(2u, varResult.size());
+  ASSERT_EQ((vector<Id>{2, 0}), varResult[0]);
+  ASSERT_EQ((vector<Id>{1, 1}), varResult[1]);
+
+  // The partitioned variant yields exactly the same result.
+  vector<array<Id, 2>> large;
+  for (Id i = 0; i < 10000; ++i) {
+    large.push_back({{(i * 7919) % 1000, i}});
+  }
+  vector<array<Id, 2>> sequential;
+  vector<array<Id, 2>> partitioned;
+  Engine::hashDistinct(large, {0}, 1, &sequential);
+  Engine::hashDistinct(large, {0}, 4, &partitioned);
+  ASSERT_EQ(1000u, sequential.size());
+  ASSERT_EQ(sequential, partitioned);
+
+  // The partitions are computed by the calling thread if the scheduler has
+  // no workers.
+  ad_utility::TaskScheduler noWorkers(0);
+  partitioned.clear();
+  Engine::hashDistinct(large, {0}, 4, &partitioned, noWorkers);
+  ASSERT_EQ(sequential, partitioned);
+}
+
+TEST(EngineTest, cancellationTest) {
+  ad_utility::CancellationHandle cancelled;
+  cancelled.cancel();
+
+  // Large enough for the periodic checks to happen.
+  vector<array<Id, 2>> a;
+  vector<array<Id, 2>> b;
+  for (Id i = 0; i < 100000; ++i) {
+    a.push_back({{i, i}});
+    b.push_back({{i, i + 1}});
+  }
+  vector<array<Id, 3>> res;
+  ASSERT_THROW(Engine::join(a, 0, b, 0, &res, &cancelled),
+               ad_semsearch::Exception);
+  // Also without any matches, i.e. only in the merge loop.
+  vector<array<Id, 2>> odd;
+  for (Id i = 0; i < 100000; ++i) {
+    odd.push_back({{2 * i + 1, i}});
+  }
+  vector<array<Id, 2>> even;
+  for (Id i = 0; i < 100000; ++i) {
+    even.push_back({{2 * i, i}});
+  }
+  ASSERT_THROW(Engine::join(odd, 0, even, 0, &res, &cancelled),
+               ad_semsearch::Exception);
+  vector<array<Id, 2>> filtered;
+  ASSERT_THROW(Engine::filter(a, [](const array<Id, 2>&) { return true; },
+                              &filtered, &cancelled),
+               ad_semsearch::Exception);
+  vector<array<Id, 2>> toSort = b;
+  size_t sortCol = 1;
+  ASSERT_THROW(Engine::sort(toSort, sortCol, &cancelled),
+               ad_semsearch::Exception);
+
+  // Cancelled joins leave their inputs unchanged.
+  vector<vector<Id>> varA;
+  vector<vector<Id>> varB;
+  for (Id i = 0; i < 100000; ++i) {
+    varA.push_back({i, i});
+    varB.push_back({i, i + 1});
+  }
+  vector<vector<Id>> varRes;
+  ASSERT_THROW(Engine::join(varA, 0, varB, 0, &varRes, &cancelled),
+               ad_semsearch::Exception);
+  ASSERT_EQ(100000u, varA.size());
+  ASSERT_EQ(100000u, varB.size());
+
+  // Without cancellation the results are unchanged.
+  ad_utility::CancellationHandle notCancelled(3600);
+  res.clear();
+  Engine::join(a, 0, b, 0, &res, &notCancelled);
+  ASSERT_EQ(a.size(), res.size());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
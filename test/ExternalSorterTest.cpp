@@ -0,0 +1,106 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <vector>
+#include "../src/util/ExternalSorter.h"
+
+using ad_utility::ExternalSorter;
+using std::vector;
+
+namespace {
+bool lessOnFirst(const uint64_t* a, const uint64_t* b) { return a[0] < b[0]; }
+
+// Pushes the rows (i * 7919 % n, i) for i < n and returns them sorted.
+vector<vector<uint64_t>> sortPermutation(size_t n, size_t memoryBudget,
+                                         size_t* nofRuns) {
+  ExternalSorter<uint64_t> sorter(2, lessOnFirst, memoryBudget, ".");
+  for (uint64_t i = 0; i < n; ++i) {
+    uint64_t row[2] = {i * 7919 % n, i};
+    sorter.push(row);
+  }
+  EXPECT_EQ(n, sorter.size());
+  vector<vector<uint64_t>> rows;
+  const uint64_t* row;
+  while ((row = sorter.next())) {
+    rows.emplace_back(row, row + 2);
+  }
+  EXPECT_EQ(nullptr, sorter.next());
+  *nofRuns = sorter.getNofRuns();
+  return rows;
+}
+}  // namespace
+
+TEST(ExternalSorterTest, inMemory) {
+  size_t nofRuns;
+  vector<vector<uint64_t>> rows = sortPermutation(1000, 1 << 20, &nofRuns);
+  ASSERT_EQ(0u, nofRuns);
+  ASSERT_EQ(1000u, rows.size());
+  for (uint64_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(i, rows[i][0]);
+    ASSERT_EQ(i, rows[i][1] * 7919 % 1000);
+  }
+}
+
+TEST(ExternalSorterTest, manyRuns) {
+  size_t nofRuns;
+  // 24 bytes per row including the permutation, 100 rows per run.
+  vector<vector<uint64_t>> rows = sortPermutation(10007, 2400, &nofRuns);
+  ASSERT_EQ(101u, nofRuns);
+  ASSERT_EQ(10007u, rows.size());
+  for (uint64_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(i, rows[i][0]);
+    ASSERT_EQ(i, rows[i][1] * 7919 % 10007);
+  }
+}
+
+TEST(ExternalSorterTest, equalRowsKeepTheirOrder) {
+  ExternalSorter<uint64_t> sorter(2, lessOnFirst, 240, ".");
+  for (uint64_t i = 0; i < 1000; ++i) {
+    uint64_t row[2] = {i % 3, i};
+    sorter.push(row);
+  }
+  vector<vector<uint64_t>> rows;
+  const uint64_t* row;
+  while ((row = sorter.next())) {
+    rows.emplace_back(row, row + 2);
+  }
+  ASSERT_GT(sorter.getNofRuns(), 1u);
+  ASSERT_EQ(1000u, rows.size());
+  for (size_t i = 1; i < rows.size(); ++i) {
+    ASSERT_LE(rows[i - 1][0], rows[i][0]);
+    if (rows[i - 1][0] == rows[i][0]) {
+      ASSERT_LT(rows[i - 1][1], rows[i][1]);
+    }
+  }
+}
+
+TEST(ExternalSorterTest, empty) {
+  ExternalSorter<uint64_t> sorter(3, lessOnFirst, 1024, ".");
+  ASSERT_EQ(nullptr, sorter.next());
+  ASSERT_EQ(0u, sorter.size());
+}
+
+TEST(ExternalSorterTest, cancellation) {
+  ad_utility::CancellationHandle handle;
+  handle.cancel();
+  ExternalSorter<uint64_t> sorter(1, lessOnFirst, 1024, ".", &handle);
+  auto pushAll = [&sorter]() {
+    for (uint64_t i = 0; i < 1000 * 1000; ++i) {
+      sorter.push(&i);
+    }
+  };
+  ASSERT_THROW(pushAll(), ad_semsearch::Exception);
+}
+
+TEST(ExternalSorterTest, invalidDirectory) {
+  ExternalSorter<uint64_t> sorter(1, lessOnFirst, 8, "/nonexistent/dir");
+  uint64_t row = 1;
+  ASSERT_THROW(sorter.push(&row), ad_semsearch::Exception);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
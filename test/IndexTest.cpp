@@ -5,6 +5,7 @@
 #include <gtest/gtest.h>
 #include <cstdio>
 #include <fstream>
+#include <limits>
 #include "../src/global/Pattern.h"
 #include "../src/index/Index.h"
 
@@ -388,6 +389,9 @@ TEST_F(CreatePatternsFixture, createPatterns) {
 
     ASSERT_FLOAT_EQ(4.0 / 2, index.getHasRelationMultiplicityEntities());
     ASSERT_FLOAT_EQ(4.0 / 3, index.getHasRelationMultiplicityPredicates());
+    // b is used by a, b2 by a and a2, d by a2.
+    vector<array<Id, 2>> predicateCounts = {{{2, 1}}, {{3, 2}}, {{6, 1}}};
+    ASSERT_EQ(predicateCounts, index.getFullPredicateCounts());
   }
   {
     LOG(DEBUG) << "Testing createPatterns with existing index..." << std::endl;
@@ -411,6 +415,9 @@ TEST_F(CreatePatternsFixture, createPatterns) {
 
     ASSERT_FLOAT_EQ(4.0 / 2, index.getHasRelationMultiplicityEntities());
     ASSERT_FLOAT_EQ(4.0 / 3, index.getHasRelationMultiplicityPredicates());
+    // b is used by a, b2 by a and a2, d by a2.
+    vector<array<Id, 2>> predicateCounts = {{{2, 1}}, {{3, 2}}, {{6, 1}}};
+    ASSERT_EQ(predicateCounts, index.getFullPredicateCounts());
   }
 }
 
@@ -647,6 +654,71 @@ TEST(IndexTest, scanTest) {
     ASSERT_EQ(2u, wol.size());
     ASSERT_EQ(1u, wol[0][0]);
     ASSERT_EQ(2u, wol[1][0]);
+
+    // Filters are applied while reading.
+    ScanFilter filter;
+    filter.add(1, SparqlFilter::GT, 1);
+    wtl.clear();
+    index.scanPSO("is-a", &wtl, filter);
+    ASSERT_EQ(3u, wtl.size());
+    ASSERT_EQ(4u, wtl[0][0]);
+    ASSERT_EQ(2u, wtl[0][1]);
+    ASSERT_EQ(5u, wtl[1][0]);
+    ASSERT_EQ(3u, wtl[1][1]);
+    ASSERT_EQ(6u, wtl[2][0]);
+    ASSERT_EQ(2u, wtl[2][1]);
+
+    filter = ScanFilter();
+    filter.add(0, SparqlFilter::LE, 1);
+    filter.add(0, SparqlFilter::NE, 0);
+    wtl.clear();
+    index.scanPOS("is-a", &wtl, filter);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(1u, wtl[0][0]);
+    ASSERT_EQ(4u, wtl[0][1]);
+    ASSERT_EQ(1u, wtl[1][0]);
+    ASSERT_EQ(6u, wtl[1][1]);
+
+    filter = ScanFilter();
+    filter.add(0, SparqlFilter::GE, 3);
+    wol.clear();
+    index.scanPSO("is-a", "b", &wol, filter);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(3u, wol[0][0]);
+
+    filter = ScanFilter();
+    filter.add(0, SparqlFilter::EQ, 7);
+    wol.clear();
+    index.scanPOS("is-a", "0", &wol, filter);
+    ASSERT_EQ(0u, wol.size());
+
+    // Only rows with one of the join keys are read.
+    filter = ScanFilter();
+    filter.setJoinKeys(
+        0, std::make_shared<const JoinKeyFilter>(vector<Id>{6, 4}));
+    wtl.clear();
+    index.scanPSO("is-a", &wtl, filter);
+    ASSERT_EQ(5u, wtl.size());
+    ASSERT_EQ(4u, wtl[0][0]);
+    ASSERT_EQ(4u, wtl[2][0]);
+    ASSERT_EQ(6u, wtl[3][0]);
+    ASSERT_EQ(6u, wtl[4][0]);
+
+    filter.add(1, SparqlFilter::GT, 1);
+    wtl.clear();
+    index.scanPSO("is-a", &wtl, filter);
+    ASSERT_EQ(2u, wtl.size());
+    ASSERT_EQ(4u, wtl[0][0]);
+    ASSERT_EQ(2u, wtl[0][1]);
+    ASSERT_EQ(6u, wtl[1][0]);
+    ASSERT_EQ(2u, wtl[1][1]);
+
+    filter = ScanFilter();
+    filter.setJoinKeys(0, std::make_shared<const JoinKeyFilter>(vector<Id>{5}));
+    wol.clear();
+    index.scanPOS("is-a", "0", &wol, filter);
+    ASSERT_EQ(1u, wol.size());
+    ASSERT_EQ(5u, wol[0][0]);
   }
   remove("_testtmp2.tsv");
   std::remove(stxxlFileName.c_str());
@@ -654,6 +726,47 @@ TEST(IndexTest, scanTest) {
   remove("_testindex.index.pos");
 };
 
+TEST(IndexTest, joinKeyFilterTest) {
+  // Dense keys are stored exactly.
+  JoinKeyFilter dense(vector<Id>{10, 12, 14, 12});
+  ASSERT_TRUE(dense.mayContain(10));
+  ASSERT_TRUE(dense.mayContain(12));
+  ASSERT_TRUE(dense.mayContain(14));
+  ASSERT_FALSE(dense.mayContain(11));
+  ASSERT_FALSE(dense.mayContain(9));
+  ASSERT_FALSE(dense.mayContain(15));
+  ASSERT_EQ(14u, dense.max());
+
+  // Sparse keys are stored in a Bloom filter, which never misses a key and
+  // rejects most other ids.
+  vector<Id> keys;
+  for (Id i = 0; i < 1000; ++i) {
+    keys.push_back(i * 1000003);
+  }
+  JoinKeyFilter sparse(keys);
+  for (Id key : keys) {
+    ASSERT_TRUE(sparse.mayContain(key));
+  }
+  size_t falsePositives = 0;
+  for (Id i = 1; i < 100000; ++i) {
+    if (i % 1000003 != 0 && sparse.mayContain(i * 7919)) {
+      ++falsePositives;
+    }
+  }
+  ASSERT_LT(falsePositives, 1000u);
+
+  JoinKeyFilter empty((vector<Id>()));
+  ASSERT_TRUE(empty.empty());
+  ASSERT_FALSE(empty.mayContain(0));
+
+  // Keys that span all ids are stored in a Bloom filter.
+  Id maxId = std::numeric_limits<Id>::max();
+  JoinKeyFilter extremes(vector<Id>{0, maxId});
+  ASSERT_TRUE(extremes.mayContain(0));
+  ASSERT_TRUE(extremes.mayContain(maxId));
+  ASSERT_EQ(maxId, extremes.max());
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
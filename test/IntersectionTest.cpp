@@ -0,0 +1,138 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <array>
+#include <vector>
+#include "../src/util/Intersection.h"
+
+using ad_utility::IdColumn;
+using std::array;
+using std::vector;
+
+namespace {
+vector<array<size_t, 4>> collectMatches(const IdColumn& a,
+                                        const IdColumn& b) {
+  vector<array<size_t, 4>> matches;
+  ad_utility::forEachMatch(a, b, [&matches](size_t ba, size_t ea, size_t bb,
+                                            size_t eb) {
+    matches.push_back(array<size_t, 4>{{ba, ea, bb, eb}});
+  });
+  return matches;
+}
+}  // namespace
+
+TEST(IntersectionTest, skipLess) {
+  vector<Id> ids;
+  for (Id i = 0; i < 100; ++i) {
+    ids.push_back(i * 2);
+  }
+  // Large ids must be compared unsigned.
+  ids.push_back(std::numeric_limits<Id>::max() - 1);
+  ids.push_back(std::numeric_limits<Id>::max());
+  IdColumn col(ids);
+  for (size_t pos = 0; pos < ids.size(); pos += 7) {
+    for (Id value : {Id(0), Id(1), Id(51), Id(150), Id(198), Id(199),
+                     std::numeric_limits<Id>::max()}) {
+      size_t expected = ad_utility::detail::skipLessScalar(col, pos, value);
+      ASSERT_EQ(expected, ad_utility::skipLess(col, pos, value));
+      ASSERT_EQ(expected, ad_utility::gallop(col, pos, value));
+#ifdef QLEVER_INTERSECTION_SIMD
+      if (__builtin_cpu_supports("sse4.2")) {
+        ASSERT_EQ(expected,
+                  ad_utility::detail::skipLessSse42(col, pos, value));
+      }
+      if (__builtin_cpu_supports("avx2")) {
+        ASSERT_EQ(expected, ad_utility::detail::skipLessAvx2(col, pos, value));
+      }
+#endif
+    }
+  }
+}
+
+TEST(IntersectionTest, stridedColumn) {
+  vector<array<Id, 3>> rows;
+  for (Id i = 0; i < 50; ++i) {
+    rows.push_back(array<Id, 3>{{100 - i, i * 3, 7}});
+  }
+  IdColumn col(rows, 1);
+  ASSERT_EQ(50u, col.size());
+  ASSERT_EQ(9u, col[3]);
+  for (Id value = 0; value < 160; value += 5) {
+    size_t expected = ad_utility::detail::skipLessScalar(col, 0, value);
+    ASSERT_EQ(expected, ad_utility::skipLess(col, 0, value));
+#ifdef QLEVER_INTERSECTION_SIMD
+    if (__builtin_cpu_supports("avx2")) {
+      ASSERT_EQ(expected, ad_utility::detail::skipLessAvx2(col, 0, value));
+    }
+#endif
+  }
+}
+
+TEST(IntersectionTest, forEachMatch) {
+  vector<Id> a = {1, 3, 3, 5, 8, 9, 9, 9};
+  vector<Id> b = {0, 3, 4, 5, 5, 9, 10};
+  auto matches = collectMatches(IdColumn(a), IdColumn(b));
+  ASSERT_EQ(3u, matches.size());
+  ASSERT_EQ((array<size_t, 4>{{1, 3, 1, 2}}), matches[0]);
+  ASSERT_EQ((array<size_t, 4>{{3, 4, 3, 5}}), matches[1]);
+  ASSERT_EQ((array<size_t, 4>{{5, 8, 5, 6}}), matches[2]);
+
+  ASSERT_EQ(0u, collectMatches(IdColumn(a), IdColumn(vector<Id>())).size());
+
+  // Galloping through the large list gives the same result.
+  vector<Id> large;
+  for (Id i = 0; i < 10000; ++i) {
+    large.push_back(i / 2);
+  }
+  vector<Id> small = {7, 2000, 4999, 6000};
+  matches = collectMatches(IdColumn(large), IdColumn(small));
+  ASSERT_EQ(3u, matches.size());
+  ASSERT_EQ((array<size_t, 4>{{14, 16, 0, 1}}), matches[0]);
+  ASSERT_EQ((array<size_t, 4>{{4000, 4002, 1, 2}}), matches[1]);
+  ASSERT_EQ((array<size_t, 4>{{9998, 10000, 2, 3}}), matches[2]);
+  matches = collectMatches(IdColumn(small), IdColumn(large));
+  ASSERT_EQ(3u, matches.size());
+  ASSERT_EQ((array<size_t, 4>{{1, 2, 4000, 4002}}), matches[1]);
+}
+
+TEST(IntersectionTest, rowColumn) {
+  vector<vector<Id>> rows;
+  for (Id i = 0; i < 10000; ++i) {
+    rows.push_back({7, i / 2});
+  }
+  vector<array<Id, 2>> small = {
+      {{1, 7}}, {{2, 2000}}, {{3, 4999}}, {{4, 6000}}};
+  auto col = ad_utility::column(rows, 1);
+  ASSERT_EQ(10000u, col.size());
+  ASSERT_EQ(3u, col[7]);
+  ASSERT_EQ(14u, ad_utility::skipLess(col, 0, 7));
+  ASSERT_EQ(14u, ad_utility::gallop(col, 0, 7));
+
+  // Var size rows can be intersected with fixed width ones.
+  vector<array<size_t, 4>> matches;
+  ad_utility::forEachMatch(
+      col, ad_utility::column(small, 1),
+      [&matches](size_t ba, size_t ea, size_t bb, size_t eb) {
+        matches.push_back(array<size_t, 4>{{ba, ea, bb, eb}});
+      });
+  ASSERT_EQ(3u, matches.size());
+  ASSERT_EQ((array<size_t, 4>{{14, 16, 0, 1}}), matches[0]);
+  ASSERT_EQ((array<size_t, 4>{{4000, 4002, 1, 2}}), matches[1]);
+  ASSERT_EQ((array<size_t, 4>{{9998, 10000, 2, 3}}), matches[2]);
+}
+
+TEST(IntersectionTest, chooseIntersectionStrategy) {
+  using ad_utility::chooseIntersectionStrategy;
+  ASSERT_EQ(ad_utility::MERGE, chooseIntersectionStrategy(1000, 1000));
+  ASSERT_EQ(ad_utility::MERGE, chooseIntersectionStrategy(1000, 10000));
+  ASSERT_EQ(ad_utility::MERGE, chooseIntersectionStrategy(0, 10000));
+  ASSERT_EQ(ad_utility::GALLOP_B, chooseIntersectionStrategy(10, 100000));
+  ASSERT_EQ(ad_utility::GALLOP_A, chooseIntersectionStrategy(100000, 10));
+  ASSERT_EQ(ad_utility::GALLOP_A, chooseIntersectionStrategy(1000000, 1));
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -87,6 +87,130 @@ TEST(LRUCacheTest, testDecreasingCapacity) {
   ASSERT_EQ(*cache["9"], "x");
   ASSERT_EQ(*cache["10"], "x");
 }
+
+// _____________________________________________________________________________
+TEST(LRUCacheTest, testErase) {
+  LRUCache<string, string> cache(2);
+  cache.insert("1", "x");
+  cache.insert("2", "y");
+  shared_ptr<const string> one = cache["1"];
+  cache.erase("1");
+  cache.erase("3");
+  ASSERT_FALSE(cache.contains("1"));
+  ASSERT_EQ(*one, "x");
+  ASSERT_EQ(*cache["2"], "y");
+  // The erased entry does not count towards the capacity anymore.
+  cache.insert("3", "z");
+  ASSERT_EQ(*cache["2"], "y");
+  ASSERT_EQ(*cache["3"], "z");
+
+  // Only the value the caller knows is erased, not one that replaced it.
+  shared_ptr<const string> two = cache["2"];
+  cache.insert("2", "w");
+  cache.erase("2", two);
+  ASSERT_EQ(*cache["2"], "w");
+  cache.erase("2", cache["2"]);
+  ASSERT_FALSE(cache.contains("2"));
+}
+
+// _____________________________________________________________________________
+TEST(LRUCacheTest, testMaxSize) {
+  LRUCache<string, string> cache(
+      10, [](const string& value) { return value.size(); }, 6);
+  cache.insert("1", "xx");
+  cache.insert("2", "xx");
+  cache.insert("3", "xx");
+  ASSERT_EQ(6u, cache.getTotalSize());
+  // The least recently used entry is evicted to make room.
+  ASSERT_EQ(*cache["1"], "xx");
+  cache.insert("4", "x");
+  ASSERT_FALSE(cache.contains("2"));
+  ASSERT_TRUE(cache.contains("1"));
+  ASSERT_EQ(5u, cache.getTotalSize());
+  // Replacing a value does not count it twice.
+  cache.insert("4", "xx");
+  ASSERT_EQ(6u, cache.getTotalSize());
+  ASSERT_EQ(3u, cache.size());
+
+  // Values filled after they were emplaced are sized by updateSize.
+  auto emplaced = cache.tryEmplace("5").first;
+  ASSERT_EQ(4u, cache.size());
+  ASSERT_EQ(6u, cache.getTotalSize());
+  *emplaced = "xxxx";
+  cache.updateSize("5", emplaced->size());
+  ASSERT_EQ(6u, cache.getTotalSize());
+  ASSERT_TRUE(cache.contains("5"));
+  ASSERT_TRUE(cache.contains("4"));
+  ASSERT_FALSE(cache.contains("1"));
+
+  // A value larger than the maximum size is not kept.
+  emplaced = cache.tryEmplace("6").first;
+  *emplaced = "xxxxxxx";
+  cache.updateSize("6", emplaced->size());
+  ASSERT_EQ(0u, cache.size());
+  ASSERT_EQ(0u, cache.getTotalSize());
+  ASSERT_EQ(*emplaced, "xxxxxxx");
+
+  cache.insert("7", "xxx");
+  cache.setMaxSize(2);
+  ASSERT_FALSE(cache.contains("7"));
+  cache.insert("8", "xx");
+  cache.erase("8");
+  ASSERT_EQ(0u, cache.getTotalSize());
+}
+
+// _____________________________________________________________________________
+TEST(LRUCacheTest, testGreedyDualSizeFrequency) {
+  LRUCache<string, string> cache(
+      10, [](const string& value) { return value.size(); }, 6);
+  cache.setEvictionPolicy(EvictionPolicy::GDSF);
+  auto add = [&cache](const string& key, double cost) {
+    auto emplaced = cache.tryEmplace(key).first;
+    *emplaced = "xx";
+    cache.updateSize(key, emplaced->size(), cost);
+  };
+  add("expensive", 100);
+  add("frequent", 1);
+  // Cheap results that are used once do not evict the expensive one or the
+  // one that is used often, unlike with LRU.
+  for (size_t i = 0; i < 10; ++i) {
+    ASSERT_TRUE(cache["frequent"]);
+    add("cheap" + std::to_string(i), 1);
+  }
+  ASSERT_TRUE(cache.contains("expensive"));
+  ASSERT_TRUE(cache.contains("frequent"));
+  ASSERT_TRUE(cache.contains("cheap9"));
+  ASSERT_FALSE(cache.contains("cheap8"));
+  ASSERT_EQ(3u, cache.size());
+
+  // Results that are not used anymore age out eventually.
+  for (size_t i = 10; i < 1000; ++i) {
+    add("cheap" + std::to_string(i), 1);
+  }
+  ASSERT_FALSE(cache.contains("expensive"));
+  ASSERT_FALSE(cache.contains("frequent"));
+  ASSERT_EQ(6u, cache.getTotalSize());
+
+  // Entries that are still being filled are evicted last.
+  cache.clear();
+  auto incomplete = cache.tryEmplace("incomplete").first;
+  add("a", 1);
+  add("b", 1);
+  add("c", 1);
+  add("d", 1);
+  ASSERT_TRUE(cache.contains("incomplete"));
+  ASSERT_FALSE(cache.contains("a"));
+  *incomplete = "xx";
+  cache.updateSize("incomplete", incomplete->size(), 1);
+  ASSERT_EQ(6u, cache.getTotalSize());
+}
+
+// _____________________________________________________________________________
+TEST(LRUCacheTest, testEvictionPolicyFromString) {
+  ASSERT_EQ(EvictionPolicy::LRU, evictionPolicyFromString("lru"));
+  ASSERT_EQ(EvictionPolicy::GDSF, evictionPolicyFromString("GDSF"));
+  ASSERT_THROW(evictionPolicyFromString("fifo"), ad_semsearch::Exception);
+}
 }  // namespace ad_utility
 
 int main(int argc, char** argv) {
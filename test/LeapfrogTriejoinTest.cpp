@@ -0,0 +1,51 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "../src/engine/LeapfrogTriejoin.h"
+
+TEST(LeapfrogTriejoinTest, triangle) {
+  // Edges of a small directed graph, sorted lexicographically.
+  vector<array<Id, 2>> edges = {
+      {{1, 2}}, {{1, 3}}, {{2, 3}}, {{2, 4}}, {{3, 4}}, {{3, 5}}, {{4, 6}}};
+  // ?a -> ?b . ?b -> ?c . ?a -> ?c
+  vector<const vector<array<Id, 2>>*> lists = {&edges, &edges, &edges};
+  vector<array<size_t, 2>> columns = {{{0, 1}}, {{1, 2}}, {{0, 2}}};
+  vector<vector<Id>> result;
+  LeapfrogTriejoin::join(lists, columns, 3, &result);
+  ASSERT_EQ(2u, result.size());
+  ASSERT_EQ((vector<Id>{1, 2, 3}), result[0]);
+  ASSERT_EQ((vector<Id>{2, 3, 4}), result[1]);
+}
+
+TEST(LeapfrogTriejoinTest, fourCycleWithDistinctRelations) {
+  vector<array<Id, 2>> r = {{{1, 10}}, {{1, 11}}, {{2, 10}}, {{3, 12}}};
+  vector<array<Id, 2>> s = {{{10, 20}}, {{11, 21}}, {{12, 22}}};
+  vector<array<Id, 2>> t = {{{1, 30}}, {{2, 30}}, {{3, 31}}};
+  vector<array<Id, 2>> u = {{{20, 30}}, {{21, 30}}, {{22, 32}}};
+  // ?a r ?b . ?b s ?c . ?a t ?d . ?c u ?d with order ?a ?b ?c ?d
+  vector<const vector<array<Id, 2>>*> lists = {&r, &s, &t, &u};
+  vector<array<size_t, 2>> columns = {{{0, 1}}, {{1, 2}}, {{0, 3}}, {{2, 3}}};
+  vector<vector<Id>> result;
+  LeapfrogTriejoin::join(lists, columns, 4, &result);
+  ASSERT_EQ(3u, result.size());
+  ASSERT_EQ((vector<Id>{1, 10, 20, 30}), result[0]);
+  ASSERT_EQ((vector<Id>{1, 11, 21, 30}), result[1]);
+  ASSERT_EQ((vector<Id>{2, 10, 20, 30}), result[2]);
+}
+
+TEST(LeapfrogTriejoinTest, emptyInput) {
+  vector<array<Id, 2>> edges = {{{1, 2}}, {{2, 3}}};
+  vector<array<Id, 2>> empty;
+  vector<const vector<array<Id, 2>>*> lists = {&edges, &edges, &empty};
+  vector<array<size_t, 2>> columns = {{{0, 1}}, {{1, 2}}, {{0, 2}}};
+  vector<vector<Id>> result;
+  LeapfrogTriejoin::join(lists, columns, 3, &result);
+  ASSERT_EQ(0u, result.size());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
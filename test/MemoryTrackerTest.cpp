@@ -0,0 +1,122 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <memory>
+#include <thread>
+#include "../src/engine/ResultTable.h"
+#include "../src/util/CancellationHandle.h"
+#include "../src/util/MemoryTracker.h"
+
+using ad_utility::GrowingMemory;
+using ad_utility::MemoryTracker;
+
+TEST(MemoryTrackerTest, allocateAndFree) {
+  MemoryTracker tracker(100, "test");
+  tracker.allocate(60);
+  tracker.allocate(40);
+  ASSERT_EQ(100u, tracker.getBytesUsed());
+  ASSERT_THROW(tracker.allocate(1), ad_semsearch::Exception);
+  // A failed allocation does not count.
+  ASSERT_EQ(100u, tracker.getBytesUsed());
+  tracker.free(70);
+  ASSERT_EQ(30u, tracker.getBytesUsed());
+  ASSERT_EQ(100u, tracker.getPeakBytesUsed());
+  tracker.allocate(70);
+  ASSERT_THROW(tracker.allocate(MemoryTracker::UNLIMITED),
+               ad_semsearch::Exception);
+}
+
+TEST(MemoryTrackerTest, unlimited) {
+  MemoryTracker tracker;
+  tracker.allocate(size_t(1) << 50);
+  tracker.allocate(size_t(1) << 50);
+  ASSERT_EQ(size_t(1) << 51, tracker.getBytesUsed());
+}
+
+TEST(MemoryTrackerTest, resultTableReleasesMemory) {
+  auto tracker = std::make_shared<MemoryTracker>();
+  {
+    ResultTable table;
+    table._nofColumns = 2;
+    auto data = new vector<array<Id, 2>>();
+    data->resize(1000);
+    table._fixedSizeData = data;
+    table.finish();
+    ASSERT_GE(table.getMemoryUsage(), 1000 * 2 * sizeof(Id));
+    table.trackMemory(tracker, table.getMemoryUsage());
+    ASSERT_EQ(table.getMemoryUsage(), tracker->getBytesUsed());
+  }
+  ASSERT_EQ(0u, tracker->getBytesUsed());
+}
+
+TEST(MemoryTrackerTest, abortWakesWaiters) {
+  ResultTable table;
+  std::thread waiter([&table] { table.awaitFinished(); });
+  table.abort();
+  waiter.join();
+  ASSERT_TRUE(table.isAborted());
+  ASSERT_FALSE(table.isFinished());
+
+  // Aborting a finished result has no effect.
+  ResultTable finished;
+  finished.finish();
+  finished.abort();
+  ASSERT_TRUE(finished.isFinished());
+}
+
+TEST(MemoryTrackerTest, growingMemory) {
+  MemoryTracker tracker(1 << 20, "test");
+  vector<Id> data;
+  GrowingMemory growing(&tracker,
+                        [&data]() { return data.capacity() * sizeof(Id); });
+  {
+    // Only the memory created last by this thread is measured.
+    vector<Id> inner(100);
+    GrowingMemory innerGrowing(
+        &tracker, [&inner]() { return inner.capacity() * sizeof(Id); });
+    GrowingMemory::updateCurrent();
+    ASSERT_EQ(100 * sizeof(Id), tracker.getBytesUsed());
+  }
+  // The loop is stopped by its checkpoints long before it is done.
+  ad_utility::CancellationCheckpoint checkpoint(nullptr);
+  auto fill = [&data, &checkpoint]() {
+    for (Id i = 0; i < (1 << 20); ++i) {
+      data.push_back(i);
+      checkpoint();
+    }
+  };
+  ASSERT_THROW(fill(), ad_semsearch::Exception);
+  ASSERT_LT(data.size(), 200u * 1000);
+  ASSERT_LE(tracker.getBytesUsed(), tracker.getLimit());
+
+  // The exact size in the end is only charged for what is not accounted
+  // for already.
+  MemoryTracker other;
+  GrowingMemory finished(&other, []() { return 100; });
+  finished.update();
+  finished.finish(150);
+  finished.finish(120);
+  ASSERT_EQ(150u, other.getBytesUsed());
+  ASSERT_EQ(150u, finished.getAccountedBytes());
+}
+
+TEST(MemoryTrackerTest, freeWhenReleased) {
+  auto tracker = std::make_shared<MemoryTracker>();
+  tracker->allocate(100);
+  auto value = std::make_shared<int>(42);
+  std::shared_ptr<int> charged = freeWhenReleased(value, tracker, 100);
+  std::shared_ptr<int> copy = charged;
+  charged.reset();
+  ASSERT_EQ(100u, tracker->getBytesUsed());
+  ASSERT_EQ(42, *copy);
+  copy.reset();
+  ASSERT_EQ(0u, tracker->getBytesUsed());
+  // The value itself is still alive.
+  ASSERT_EQ(42, *value);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,86 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "../src/engine/MultiwayJoin.h"
+
+TEST(MultiwayJoinTest, threeInputs) {
+  ResultTable a;
+  a._nofColumns = 2;
+  a._sortedBy = 0;
+  a._fixedSizeData = new vector<array<Id, 2>>{
+      {{1, 10}}, {{2, 20}}, {{2, 21}}, {{4, 40}}, {{5, 50}}};
+  ResultTable b;
+  b._nofColumns = 1;
+  b._sortedBy = 0;
+  b._fixedSizeData = new vector<array<Id, 1>>{{{2}}, {{3}}, {{4}}, {{5}}};
+  ResultTable c;
+  c._nofColumns = 2;
+  c._sortedBy = 1;
+  c._fixedSizeData =
+      new vector<array<Id, 2>>{{{7, 1}}, {{8, 2}}, {{9, 2}}, {{6, 5}}};
+
+  ResultTable res;
+  MultiwayJoin::join({&a, &b, &c}, {0, 0, 1}, &res);
+  ASSERT_EQ(3u, res._nofColumns);
+  ASSERT_EQ(0u, res._sortedBy);
+  const auto& data = *static_cast<vector<array<Id, 3>>*>(res._fixedSizeData);
+  ASSERT_EQ(5u, data.size());
+  ASSERT_EQ((array<Id, 3>{{2, 20, 8}}), data[0]);
+  ASSERT_EQ((array<Id, 3>{{2, 20, 9}}), data[1]);
+  ASSERT_EQ((array<Id, 3>{{2, 21, 8}}), data[2]);
+  ASSERT_EQ((array<Id, 3>{{2, 21, 9}}), data[3]);
+  ASSERT_EQ((array<Id, 3>{{5, 50, 6}}), data[4]);
+}
+
+TEST(MultiwayJoinTest, wideResult) {
+  ResultTable a;
+  a._nofColumns = 3;
+  a._sortedBy = 1;
+  a._fixedSizeData = new vector<array<Id, 3>>{{{100, 1, 101}}, {{200, 3, 201}}};
+  ResultTable b;
+  b._nofColumns = 2;
+  b._sortedBy = 0;
+  b._fixedSizeData = new vector<array<Id, 2>>{{{1, 11}}, {{3, 33}}};
+  ResultTable c;
+  c._nofColumns = 3;
+  c._sortedBy = 0;
+  c._fixedSizeData = new vector<array<Id, 3>>{{{0, 1, 2}}, {{3, 4, 5}}};
+  ResultTable d;
+  d._nofColumns = 2;
+  d._sortedBy = 0;
+  d._fixedSizeData = new vector<array<Id, 2>>{{{3, 7}}};
+
+  ResultTable res;
+  MultiwayJoin::join({&a, &b, &c, &d}, {1, 0, 0, 0}, &res);
+  ASSERT_EQ(7u, res._nofColumns);
+  ASSERT_EQ(1u, res._sortedBy);
+  ASSERT_EQ(1u, res._varSizeData.size());
+  ASSERT_EQ((vector<Id>{200, 3, 201, 33, 4, 5, 7}), res._varSizeData[0]);
+}
+
+TEST(MultiwayJoinTest, emptyInput) {
+  ResultTable a;
+  a._nofColumns = 1;
+  a._sortedBy = 0;
+  a._fixedSizeData = new vector<array<Id, 1>>{{{1}}, {{2}}};
+  ResultTable b;
+  b._nofColumns = 1;
+  b._sortedBy = 0;
+  b._fixedSizeData = new vector<array<Id, 1>>();
+  ResultTable c;
+  c._nofColumns = 1;
+  c._sortedBy = 0;
+  c._fixedSizeData = new vector<array<Id, 1>>{{{1}}};
+
+  ResultTable res;
+  MultiwayJoin::join({&a, &b, &c}, {0, 0, 0}, &res);
+  ASSERT_EQ(1u, res._nofColumns);
+  ASSERT_EQ(0u, res.size());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -4,7 +4,11 @@
 
 #include <gtest/gtest.h>
 
+#include "../src/engine/Filter.h"
+#include "../src/engine/Join.h"
 #include "../src/engine/QueryPlanner.h"
+#include "../src/engine/Sort.h"
+#include "../src/engine/TopK.h"
 #include "../src/parser/SparqlParser.h"
 
 TEST(QueryPlannerTest, createTripleGraph) {
@@ -484,15 +488,13 @@ TEST(QueryPlannerTest, testStarTwoFree) {
       QueryPlanner qp(nullptr);
       QueryExecutionTree qet = qp.createExecutionTree(pq);
       ASSERT_EQ(
-          "{\n  JOIN\n  {\n    JOIN\n    {\n      SCAN POS with P = \""
-          "<http://rdf.myprefix.com/myrel>\"\n      qet-width: 2 \n "
-          "   } join-column: [0]\n    |X|\n    {\n      SCAN PSO wit"
-          "h P = \"<http://rdf.myprefix.com/ns/myrel>\"\n      qet-"
-          "width: 2 \n    } join-column: [0]\n    qet-width: 3 \n  "
-          "} join-column: [0]\n  |X|\n  {\n    SCAN POS with P = "
-          "\"<http://rdf.myprefix.com/xxx/rel2>\", O = \"<http://a"
-          "bc.de>\"\n    qet-width: 1 \n  } join-column: [0]\n  qet"
-          "-width: 3 \n}",
+          "{\n  MULTIWAY_JOIN\n  {\n    SCAN POS with P = \""
+          "<http://rdf.myprefix.com/myrel>\"\n    qet-width: 2 \n  } "
+          "join-column: [0]\n  {\n    SCAN POS with P = \"<http://rdf."
+          "myprefix.com/xxx/rel2>\", O = \"<http://abc.de>\"\n    qet-"
+          "width: 1 \n  } join-column: [0]\n  {\n    SCAN PSO with P = "
+          "\"<http://rdf.myprefix.com/ns/myrel>\"\n    qet-width: 2 \n"
+          "  } join-column: [0]\n  qet-width: 3 \n}",
           qet.asString());
     }
   } catch (const ad_semsearch::Exception& e) {
@@ -529,6 +531,29 @@ TEST(QueryPlannerTest, testFilterAfterSeed) {
   }
 }
 
+TEST(QueryPlannerTest, testFilterPushedIntoScan) {
+  try {
+    ParsedQuery pq = SparqlParser::parse(
+        "SELECT ?x ?y WHERE {"
+        "?x <r> ?y . ?y <s> <o> . "
+        "FILTER(?y != <a>) }");
+    QueryPlanner qp(nullptr);
+    QueryExecutionTree qet = qp.createExecutionTree(pq);
+    ASSERT_EQ(
+        "{\n  JOIN\n  {\n    SCAN POS with P = \"<r>\"\n    qet-width: 2 "
+        "\n  } join-column: [0]\n  |X|\n  {\n    SCAN POS with P = \"<s>\", "
+        "O = \"<o>\" with FILTER col 0 in [0, 18446744073709551615] except "
+        "0\n    qet-width: 1 \n  } join-column: [0]\n  qet-width: 2 \n}",
+        qet.asString());
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
 TEST(QueryPlannerTest, testFilterAfterJoin) {
   try {
     ParsedQuery pq = SparqlParser::parse(
@@ -937,17 +962,12 @@ TEST(QueryExecutionTreeTest, testCyclicQuery) {
     QueryPlanner qp(nullptr);
     QueryExecutionTree qet = qp.createExecutionTree(pq);
     ASSERT_EQ(
-        "{\n  TWO_COLUMN_JOIN\n    {\n    OrderBy     {\n      JOIN\n"
-        "      {\n        SCAN PSO with P = \"<Film_performance>\"\n"
-        "        qet-width: 2 \n      } join-column: [0]\n      |X|\n"
-        "      {\n        "
-        "SCAN PSO with P = \"<Spouse_(or_domestic_partner)>\"\n    "
-        "    qet-width: 2 \n      } join-column: [0]\n "
-        "     qet-width: 3 \n    }\n    order on asc(2) asc(1) \n"
-        "    qet-width: 3 \n  }\n  join-columns: [2 & 1]\n  |X|\n"
-        "    {\n    SCAN PSO with P = \"<Film_performance>\"\n"
-        "    qet-width: 2 \n  }\n  join-columns: [0 & 1]\n"
-        "  qet-width: 3 \n}",
+        "{\n  LEAPFROG_TRIEJOIN on ?m ?x ?y\n  {\n    SCAN POS with P = "
+        "\"<Film_performance>\"\n    qet-width: 2 \n  } vars: [0 & 1]\n"
+        "  {\n    SCAN POS with P = \"<Film_performance>\"\n    qet-width: 2 "
+        "\n  } vars: [0 & 2]\n  {\n    SCAN PSO with P = "
+        "\"<Spouse_(or_domestic_partner)>\"\n    qet-width: 2 \n  } vars: "
+        "[1 & 2]\n  qet-width: 3 \n}",
         qet.asString());
   } catch (const ad_semsearch::Exception& e) {
     std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
@@ -1048,6 +1068,571 @@ TEST(QueryPlannerTest, testSimpleOptional) {
   }
 }
 
+TEST(QueryPlannerTest, testTriangleJoinedWithOtherTriple) {
+  try {
+    ParsedQuery pq = SparqlParser::parse(
+        "SELECT ?a ?b ?c ?n WHERE { ?a <knows> ?b . ?b <knows> ?c . "
+        "?a <knows> ?c . ?a <name> ?n }");
+    pq.expandPrefixes();
+    QueryPlanner qp(nullptr);
+    QueryExecutionTree qet = qp.createExecutionTree(pq);
+    ASSERT_EQ(QueryExecutionTree::JOIN, qet.getType());
+    ASSERT_NE(string::npos,
+              qet.asString().find("LEAPFROG_TRIEJOIN on ?a ?b ?c"));
+    ASSERT_EQ(4u, qet.getResultWidth());
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testOrderByWithLimitUsesTopK) {
+  try {
+    QueryPlanner qp(nullptr);
+    {
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?x ?y WHERE {"
+          "?x <population> ?y } ORDER BY DESC(?y) LIMIT 10 OFFSET 5");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::TOP_K, qet.getType());
+      ASSERT_EQ(15u,
+                static_cast<TopK*>(qet.getRootOperation().get())->getK());
+    }
+    {
+      // Without a limit the full result has to be ordered.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?x ?y WHERE {"
+          "?x <population> ?y } ORDER BY DESC(?y)");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::ORDER_BY, qet.getType());
+    }
+    {
+      // A distinct is applied after the ordering and may remove rows.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT DISTINCT ?y WHERE {"
+          "?x <population> ?y } ORDER BY DESC(?y) LIMIT 10");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::DISTINCT, qet.getType());
+      ASSERT_EQ(string::npos, qet.asString().find("TopK"));
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testDistinctWithoutSortUsesHashing) {
+  try {
+    QueryPlanner qp(nullptr);
+    {
+      // The scan is sorted on ?x, deduplicating ?y would require a sort.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT DISTINCT ?y WHERE {?x <is-a> ?y }");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::HASH_DISTINCT, qet.getType());
+      ASSERT_EQ(string::npos, qet.asString().find("Sort"));
+    }
+    {
+      // Already sorted on the distinct variable.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT DISTINCT ?x WHERE {?x <is-a> ?y }");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::DISTINCT, qet.getType());
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testCountPredicatesOfAllEntities) {
+  try {
+    QueryPlanner qp(nullptr);
+    {
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?r (COUNT(?r) as ?count) WHERE {"
+          "?a ql:has-relation ?r }"
+          "GROUP BY ?r");
+      pq.expandPrefixes();
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::COUNT_AVAILABLE_PREDICATES,
+                qet.getType());
+      ASSERT_NE(string::npos, qet.asString().find("for all entities"));
+      ASSERT_EQ(0u, qet.getVariableColumn("?r"));
+      ASSERT_EQ(1u, qet.getVariableColumn("?count"));
+    }
+    {
+      // With another triple only the predicates of its subjects are counted.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?r (COUNT(?r) as ?count) WHERE {"
+          "?a <is-a> <Actor> ."
+          "?a ql:has-relation ?r }"
+          "GROUP BY ?r");
+      pq.expandPrefixes();
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::COUNT_AVAILABLE_PREDICATES,
+                qet.getType());
+      ASSERT_EQ(string::npos, qet.asString().find("for all entities"));
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testSortedOnMultipleColumns) {
+  try {
+    QueryPlanner qp(nullptr);
+    {
+      // Scans are sorted by both columns.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?x ?y WHERE {?x <is-a> ?y } ORDER BY ?x ?y");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::SCAN, qet.getType());
+      ASSERT_EQ(vector<size_t>({0, 1}), qet.resultSortedOnColumns());
+    }
+    {
+      // The groups are adjacent without ordering the scan first.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?x (COUNT(?y) as ?count) WHERE {?x <is-a> ?y }"
+          "GROUP BY ?x");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::GROUP_BY, qet.getType());
+      ASSERT_EQ(string::npos, qet.asString().find("OrderBy"));
+    }
+    {
+      // The join is only sorted on ?y, equal rows need not be adjacent.
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT DISTINCT ?y ?z WHERE {?x <a> ?y . ?y <b> ?z }");
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryExecutionTree::HASH_DISTINCT, qet.getType());
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+namespace {
+// Collects the filters of a plan made of joins, sorts, filters and scans.
+void findFilters(const std::shared_ptr<QueryExecutionTree>& tree,
+                 vector<std::shared_ptr<QueryExecutionTree>>* filters) {
+  if (tree->getType() == QueryExecutionTree::FILTER) {
+    filters->push_back(tree);
+    findFilters(
+        static_cast<Filter*>(tree->getRootOperation().get())->getSubtree(),
+        filters);
+  } else if (tree->getType() == QueryExecutionTree::SORT) {
+    findFilters(
+        static_cast<Sort*>(tree->getRootOperation().get())->getSubtree(),
+        filters);
+  } else if (tree->getType() == QueryExecutionTree::JOIN) {
+    Join* join = static_cast<Join*>(tree->getRootOperation().get());
+    findFilters(join->getLeft(), filters);
+    findFilters(join->getRight(), filters);
+  }
+}
+}  // namespace
+
+TEST(QueryPlannerTest, testEarlyFilterWithTwoVariables) {
+  try {
+    QueryPlanner qp(nullptr);
+    ParsedQuery pq = SparqlParser::parse(
+        "SELECT ?x ?y ?n1 ?n2 WHERE {"
+        "?x <mother> ?m . ?y <mother> ?m ."
+        "?x <name> ?n1 . ?y <name> ?n2 . FILTER(?x != ?y) }");
+    auto qet = std::make_shared<QueryExecutionTree>(qp.createExecutionTree(pq));
+    // The filter is applied directly to the first join that brings ?x and ?y
+    // together, whatever the join order.
+    vector<std::shared_ptr<QueryExecutionTree>> filters;
+    findFilters(qet, &filters);
+    ASSERT_EQ(1u, filters.size());
+    auto filtered =
+        static_cast<Filter*>(filters[0]->getRootOperation().get())
+            ->getSubtree();
+    ASSERT_EQ(QueryExecutionTree::JOIN, filtered->getType());
+    Join* join = static_cast<Join*>(filtered->getRootOperation().get());
+    for (const auto& child : {join->getLeft(), join->getRight()}) {
+      ASSERT_FALSE(child->varCovered("?x") && child->varCovered("?y"));
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testPlanCache) {
+  try {
+    ParsedQuery pq1 = SparqlParser::parse(
+        "SELECT ?x ?z WHERE {"
+        "?x <is-a> <Actor> . ?x <born-in> ?y . ?y <located-in> <Europe> ."
+        "?x <friend-of> ?z }");
+    // Same shape, other constants and variable names.
+    ParsedQuery pq2 = SparqlParser::parse(
+        "SELECT ?a ?c WHERE {"
+        "?a <is-a> <Singer> . ?a <born-in> ?b . ?b <located-in> <Africa> ."
+        "?a <friend-of> ?c }");
+    ParsedQuery pq3 = SparqlParser::parse(
+        "SELECT ?a ?c WHERE {"
+        "?a <is-a> <Singer> . ?a <born-in> ?b . ?b <located-in> <Africa> ."
+        "?a <enemy-of> ?c }");
+    ASSERT_EQ(QueryPlanner::getQueryShape(pq1),
+              QueryPlanner::getQueryShape(pq2));
+    ASSERT_NE(QueryPlanner::getQueryShape(pq1),
+              QueryPlanner::getQueryShape(pq3));
+
+    PlanCache cache(10);
+    QueryPlanner qp(nullptr);
+    qp.setPlanCache(&cache);
+    string plan1 = qp.createExecutionTree(pq1).asString();
+    string key = QueryPlanner::getQueryShape(pq1) + " #0";
+    ASSERT_TRUE(cache.contains(key));
+    // The root joins all four triples.
+    ASSERT_EQ(uint64_t(15), cache[key]->_joinOrder.back());
+
+    // The cached join order is used with the constants of the new query,
+    // even though other constants lead to another order when planning from
+    // scratch.
+    string cached = qp.createExecutionTree(pq2).asString();
+    plan1.replace(plan1.find("<Actor>"), 7, "<Singer>");
+    plan1.replace(plan1.find("<Europe>"), 8, "<Africa>");
+    ASSERT_EQ(plan1, cached);
+    QueryPlanner uncachedPlanner(nullptr);
+    string uncached = uncachedPlanner.createExecutionTree(pq2).asString();
+    ASSERT_NE(uncached, cached);
+
+    // A join order that does not fit the query is ignored.
+    cache.erase(key);
+    cache.insert(key, CachedPlan{{3, 7}, {}});
+    ASSERT_EQ(uncached, qp.createExecutionTree(pq2).asString());
+    // It is replaced by the join order planned instead.
+    ASSERT_EQ(uint64_t(15), cache[key]->_joinOrder.back());
+    ASSERT_EQ(uncached, qp.createExecutionTree(pq2).asString());
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, planAfterPlanningTimeoutIsNotCached) {
+  try {
+    ParsedQuery pq = SparqlParser::parse(
+        "SELECT ?x ?z WHERE {"
+        "?x <is-a> <Actor> . ?x <born-in> ?y . ?y <located-in> <Europe> ."
+        "?x <friend-of> ?z }");
+    string key = QueryPlanner::getQueryShape(pq) + " #0";
+    PlanCache cache(10);
+    QueryPlanner qp(nullptr);
+    qp.setPlanCache(&cache);
+    // Without any time for exhaustive planning it continues greedily.
+    qp.setMaxExhaustivePlanningTime(0);
+    QueryExecutionTree qet = qp.createExecutionTree(pq);
+    ASSERT_EQ(QueryPlanner::PlanningAlgorithm::ITERATIVE_DYNAMIC_PROGRAMMING,
+              qp.getPlanningAlgorithm());
+    ASSERT_EQ(3u, qet.getResultWidth());
+    ASSERT_FALSE(cache.contains(key));
+
+    // With enough time the plan is cached.
+    qp.setMaxExhaustivePlanningTime(3600 * 1000);
+    qp.createExecutionTree(pq);
+    ASSERT_EQ(QueryPlanner::PlanningAlgorithm::DYNAMIC_PROGRAMMING,
+              qp.getPlanningAlgorithm());
+    ASSERT_TRUE(cache.contains(key));
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+// An operation whose estimated size is far from its actual size.
+class MisestimatedOperation : public Operation {
+ public:
+  explicit MisestimatedOperation(QueryExecutionContext* qec)
+      : Operation(qec) {}
+
+  virtual void computeResult(ResultTable* result) const {
+    result->_nofColumns = 1;
+    result->_resultTypes.push_back(ResultTable::ResultType::KB);
+    auto data = new vector<array<Id, 1>>();
+    for (Id i = 0; i < 10; ++i) {
+      data->push_back({{i}});
+    }
+    result->_fixedSizeData = data;
+    result->_sortedBy = 0;
+    result->finish();
+  }
+
+  virtual string asString(size_t indent = 0) const {
+    (void)indent;
+    return "misestimated";
+  }
+
+  virtual size_t getResultWidth() const { return 1; }
+
+  virtual size_t resultSortedOn() const { return 0; }
+
+  virtual void setTextLimit(size_t limit) { (void)limit; }
+
+  virtual size_t getCostEstimate() { return 1000; }
+
+  virtual size_t getSizeEstimate() { return 1000; }
+
+  virtual float getMultiplicity(size_t col) {
+    (void)col;
+    return 1;
+  }
+
+  virtual bool knownEmptyResult() { return false; }
+};
+
+TEST(QueryPlannerTest, observedResultSizeTest) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  auto makeTree = [&qec]() {
+    auto tree = std::make_shared<QueryExecutionTree>(&qec);
+    tree->setOperation(QueryExecutionTree::SORT,
+                       std::make_shared<MisestimatedOperation>(&qec));
+    return tree;
+  };
+  ASSERT_EQ(1000u, makeTree()->getSizeEstimate());
+  ASSERT_EQ(10u, makeTree()->getResult()->size());
+  // Trees planned later use the observed size, also once the result itself
+  // has been evicted from the cache.
+  qec.clearCache();
+  ASSERT_EQ(10u, makeTree()->getSizeEstimate());
+  size_t size = 0;
+  ASSERT_TRUE(qec.getObservedResultSize("misestimated", &size));
+  ASSERT_EQ(10u, size);
+  ASSERT_FALSE(qec.getObservedResultSize("unknown", &size));
+}
+
+TEST(QueryPlannerTest, misestimatedPlanTest) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  auto tree = std::make_shared<QueryExecutionTree>(&qec);
+  tree->setOperation(QueryExecutionTree::SORT,
+                     std::make_shared<MisestimatedOperation>(&qec));
+  CachedPlan plan;
+  plan._sizeEstimates.emplace_back("misestimated",
+                                   tree->getSizeEstimate());
+  // Nothing about the plan is known before its subtrees are computed.
+  ASSERT_FALSE(qec.isMisestimated(plan));
+  tree->getResult();
+  ASSERT_TRUE(qec.isMisestimated(plan));
+  // Small deviations from the estimate are expected.
+  plan._sizeEstimates.back().second = 15;
+  ASSERT_FALSE(qec.isMisestimated(plan));
+  plan._sizeEstimates.back().second = 5;
+  ASSERT_FALSE(qec.isMisestimated(plan));
+  plan._sizeEstimates.back().second = 0;
+  ASSERT_TRUE(qec.isMisestimated(plan));
+}
+
+TEST(QueryPlannerTest, runtimeInformationTest) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  auto makeTree = [&qec]() {
+    auto child = std::make_shared<QueryExecutionTree>(&qec);
+    child->setOperation(QueryExecutionTree::FILTER,
+                        std::make_shared<MisestimatedOperation>(&qec));
+    child->setVariableColumn("?x", 0);
+    auto tree = std::make_shared<QueryExecutionTree>(&qec);
+    tree->setOperation(QueryExecutionTree::SORT,
+                       std::make_shared<Sort>(&qec, child, 0));
+    tree->setVariableColumn("?x", 0);
+    return tree;
+  };
+  // Like the planner, this records the size estimates before the execution.
+  // They are kept although the sizes observed afterwards differ.
+  auto tree = makeTree();
+  tree->recordSizeEstimates();
+  ASSERT_EQ(RuntimeInformation::Status::NOT_COMPUTED,
+            tree->getRuntimeInfo().getStatus());
+  tree->getResult();
+  RuntimeInformation info = tree->getRuntimeInfo();
+  ASSERT_EQ(RuntimeInformation::Status::COMPUTED, info.getStatus());
+  ASSERT_EQ(10u, info.getNofRows());
+  ASSERT_EQ(1u, info.getNofColumns());
+  ASSERT_EQ(1000u, info.getSizeEstimate());
+  ASSERT_LT(0u, info.getMemoryUsage());
+  ASSERT_LE(info.getOwnTime(), info.getTotalTime());
+  ASSERT_EQ(1u, info.getChildren().size());
+  const RuntimeInformation& childInfo = info.getChildren()[0];
+  ASSERT_EQ(RuntimeInformation::Status::COMPUTED, childInfo.getStatus());
+  ASSERT_EQ(10u, childInfo.getNofRows());
+  ASSERT_EQ(1000u, childInfo.getSizeEstimate());
+  ASSERT_TRUE(childInfo.getChildren().empty());
+
+  std::ostringstream json;
+  info.writeJson(json);
+  ASSERT_NE(string::npos, json.str().find("\"operation\": \"SORT\""));
+  ASSERT_NE(string::npos, json.str().find("\"operation\": \"FILTER\""));
+  ASSERT_NE(string::npos, json.str().find("\"description\": "
+                                          "\"misestimated\""));
+  ASSERT_NE(string::npos, json.str().find("\"columns\": [\"?x\"]"));
+  ASSERT_NE(string::npos, json.str().find("\"rows\": 10,"));
+
+  // The same tree planned again takes its result from the cache, its
+  // children are not computed at all.
+  // It is planned with the size observed before.
+  auto cachedTree = makeTree();
+  cachedTree->recordSizeEstimates();
+  cachedTree->getResult();
+  info = cachedTree->getRuntimeInfo();
+  ASSERT_EQ(RuntimeInformation::Status::CACHED, info.getStatus());
+  ASSERT_EQ(10u, info.getNofRows());
+  ASSERT_EQ(10u, info.getSizeEstimate());
+  ASSERT_EQ(info.getMemoryUsage(),
+            qec.getQueryTreeCache()[tree->getRootOperation()->asString()]
+                ->getTrackedMemoryUsage());
+  ASSERT_EQ(RuntimeInformation::Status::NOT_COMPUTED,
+            info.getChildren()[0].getStatus());
+}
+
+TEST(QueryPlannerTest, runtimeInformationOfStreamedResults) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  auto child = std::make_shared<QueryExecutionTree>(&qec);
+  child->setOperation(QueryExecutionTree::FILTER,
+                      std::make_shared<MisestimatedOperation>(&qec));
+  auto tree = std::make_shared<QueryExecutionTree>(&qec);
+  tree->setOperation(QueryExecutionTree::SORT,
+                     std::make_shared<Sort>(&qec, child, 0));
+  // The estimate of 1000 rows does not fit, the rows are sorted externally.
+  qec.setSortOptions(100, ".");
+  std::ostringstream out;
+  tree->writeResultToStream(out, {}, 5);
+  RuntimeInformation info = tree->getRuntimeInfo();
+  ASSERT_EQ(RuntimeInformation::Status::COMPUTED, info.getStatus());
+  ASSERT_EQ(10u, info.getNofRows());
+  ASSERT_EQ("streamed", info.getDetails().at("result"));
+  ASSERT_EQ(RuntimeInformation::Status::COMPUTED,
+            info.getChildren()[0].getStatus());
+  ASSERT_FALSE(qec.getQueryTreeCache().contains(
+      tree->getRootOperation()->asString()));
+}
+
+TEST(QueryPlannerTest, runtimeInformationOwnTime) {
+  RuntimeInformation first;
+  first.setComputed(4, 1, 1, 0);
+  RuntimeInformation second;
+  second.setComputed(5, 1, 1, 0);
+  RuntimeInformation cached;
+  cached.setCached(1, 1, 0);
+  RuntimeInformation info;
+  info.setComputed(10, 1, 1, 0);
+  info.addChild(first);
+  info.addChild(second);
+  info.addChild(cached);
+  ASSERT_FLOAT_EQ(1, info.getOwnTime());
+  // Only the slowest of concurrently computed children counts.
+  info.setChildrenComputedConcurrently();
+  ASSERT_FLOAT_EQ(5, info.getOwnTime());
+}
+
+TEST(QueryPlannerTest, testIterativePlanningOfLargePatterns) {
+  try {
+    QueryPlanner qp(nullptr);
+    {
+      ParsedQuery pq = SparqlParser::parse(
+          "SELECT ?x WHERE {?x <is-a> <Actor> . ?x <born-in> ?y }");
+      qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryPlanner::PlanningAlgorithm::DYNAMIC_PROGRAMMING,
+                qp.getPlanningAlgorithm());
+    }
+    {
+      // A chain of 20 triples.
+      std::ostringstream query;
+      query << "SELECT ?x0 WHERE {";
+      for (size_t i = 0; i < 20; ++i) {
+        query << "?x" << i << " <p" << i << "> ?x" << i + 1 << " . ";
+      }
+      query << "}";
+      ParsedQuery pq = SparqlParser::parse(query.str());
+      QueryExecutionTree qet = qp.createExecutionTree(pq);
+      ASSERT_EQ(QueryPlanner::PlanningAlgorithm::ITERATIVE_DYNAMIC_PROGRAMMING,
+                qp.getPlanningAlgorithm());
+      ASSERT_EQ("iterative dynamic programming",
+                qp.getPlanningAlgorithmName());
+      // All triples are joined.
+      ASSERT_EQ(21u, qet.getResultWidth());
+      for (size_t i = 0; i < 20; ++i) {
+        ASSERT_NE(string::npos, qet.asString().find(
+                                    "<p" + std::to_string(i) + ">\""));
+      }
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
+TEST(QueryPlannerTest, testParallelPlanEnumeration) {
+  try {
+    // A star of eight triples, the levels of the dynamic programming have
+    // enough pairs of plans to be enumerated by several threads.
+    std::ostringstream query;
+    query << "SELECT ?x WHERE {";
+    for (size_t i = 0; i < 8; ++i) {
+      query << "?x <p" << i << "> ?y" << i << " . ";
+    }
+    query << "}";
+    ParsedQuery pq = SparqlParser::parse(query.str());
+    QueryPlanner qp(nullptr);
+    QueryExecutionTree qet = qp.createExecutionTree(pq);
+    ASSERT_EQ(QueryPlanner::PlanningAlgorithm::DYNAMIC_PROGRAMMING,
+              qp.getPlanningAlgorithm());
+    ASSERT_EQ(9u, qet.getResultWidth());
+    for (size_t i = 0; i < 8; ++i) {
+      ASSERT_NE(string::npos,
+                qet.asString().find("<p" + std::to_string(i) + ">\""));
+    }
+    // The candidates of the threads are merged in a fixed order, so the
+    // chosen plan is always the same.
+    for (size_t i = 0; i < 3; ++i) {
+      QueryPlanner other(nullptr);
+      ASSERT_EQ(qet.asString(), other.createExecutionTree(pq).asString());
+    }
+  } catch (const ad_semsearch::Exception& e) {
+    std::cout << "Caught: " << e.getFullErrorMessage() << std::endl;
+    FAIL() << e.getFullErrorMessage();
+  } catch (const std::exception& e) {
+    std::cout << "Caught: " << e.what() << std::endl;
+    FAIL() << e.what();
+  }
+}
+
 int main(int argc, char** argv) {
   ::testing::InitGoogleTest(&argc, argv);
   return RUN_ALL_TESTS();
@@ -0,0 +1,325 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <vector>
+#include "../src/engine/QueryExecutionTree.h"
+#include "../src/engine/ResultIterator.h"
+#include "../src/engine/Sort.h"
+
+namespace {
+shared_ptr<const ResultTable> makeTable(const vector<array<Id, 2>>& rows) {
+  std::shared_ptr<ResultTable> table = std::make_shared<ResultTable>();
+  table->_nofColumns = 2;
+  table->_sortedBy = 0;
+  table->_resultTypes.resize(2, ResultTable::ResultType::KB);
+  table->_fixedSizeData = new vector<array<Id, 2>>(rows);
+  table->finish();
+  return table;
+}
+
+vector<vector<Id>> collect(ResultIterator* it) {
+  vector<vector<Id>> rows;
+  ResultBlock block;
+  while (it->nextBlock(&block)) {
+    EXPECT_GT(block.size(), 0u);
+    for (size_t i = 0; i < block.size(); ++i) {
+      rows.emplace_back(block[i], block[i] + block.width());
+    }
+  }
+  return rows;
+}
+}  // namespace
+
+TEST(ResultIteratorTest, materialized) {
+  vector<array<Id, 2>> rows;
+  for (Id i = 0; i < 2 * RESULT_BLOCK_SIZE + 3; ++i) {
+    rows.push_back({{i, i * 2}});
+  }
+  MaterializedResultIterator it(makeTable(rows));
+  ASSERT_EQ(2u, it.width());
+  vector<vector<Id>> res = collect(&it);
+  ASSERT_EQ(rows.size(), res.size());
+  ASSERT_EQ((vector<Id>{7, 14}), res[7]);
+  ASSERT_EQ((vector<Id>{2 * RESULT_BLOCK_SIZE + 2, 4 * RESULT_BLOCK_SIZE + 4}),
+            res.back());
+}
+
+TEST(ResultIteratorTest, rowAccess) {
+  ResultTable fixed;
+  fixed._nofColumns = 3;
+  fixed._fixedSizeData =
+      new vector<array<Id, 3>>{{{1, 2, 3}}, {{4, 5, 6}}, {{7, 8, 9}}};
+  RowAccess fixedRows(fixed);
+  ASSERT_EQ(3u, fixedRows.size());
+  ASSERT_EQ(3u, fixedRows.width());
+  ASSERT_EQ(5u, fixedRows[1][1]);
+  ASSERT_EQ(9u, fixedRows[2][2]);
+
+  ResultTable varSize;
+  varSize._nofColumns = 6;
+  varSize._varSizeData = {{1, 2, 3, 4, 5, 6}, {7, 8, 9, 10, 11, 12}};
+  RowAccess varSizeRows(varSize);
+  ASSERT_EQ(2u, varSizeRows.size());
+  ASSERT_EQ(12u, varSizeRows[1][5]);
+
+  ResultTable empty;
+  empty._nofColumns = 2;
+  empty._fixedSizeData = new vector<array<Id, 2>>();
+  ASSERT_EQ(0u, RowAccess(empty).size());
+}
+
+TEST(ResultIteratorTest, filter) {
+  vector<array<Id, 2>> rows;
+  for (Id i = 0; i < 3 * RESULT_BLOCK_SIZE; ++i) {
+    rows.push_back({{i, i % 7}});
+  }
+  // Only rows in the last block pass the filter, the empty blocks in between
+  // must not end the iteration.
+  FilterResultIterator it(
+      std::make_shared<MaterializedResultIterator>(makeTable(rows)),
+      [](const Id* row) {
+        return row[0] >= 2 * RESULT_BLOCK_SIZE && row[1] == 0;
+      });
+  vector<vector<Id>> res = collect(&it);
+  ASSERT_GT(res.size(), 0u);
+  for (const auto& row : res) {
+    ASSERT_EQ(0u, row[1]);
+    ASSERT_GE(row[0], 2 * RESULT_BLOCK_SIZE);
+  }
+}
+
+TEST(ResultIteratorTest, mergeJoin) {
+  vector<array<Id, 2>> left = {{{1, 10}}, {{2, 20}}, {{2, 21}}, {{4, 40}}};
+  vector<array<Id, 2>> right = {{{5, 1}}, {{6, 2}}, {{7, 2}}, {{8, 3}}};
+  MergeJoinResultIterator it(
+      std::make_shared<MaterializedResultIterator>(makeTable(left)),
+      std::make_shared<MaterializedResultIterator>(makeTable(right)), 0, 1);
+  ASSERT_EQ(3u, it.width());
+  vector<vector<Id>> res = collect(&it);
+  ASSERT_EQ(5u, res.size());
+  ASSERT_EQ((vector<Id>{1, 10, 5}), res[0]);
+  ASSERT_EQ((vector<Id>{2, 20, 6}), res[1]);
+  ASSERT_EQ((vector<Id>{2, 20, 7}), res[2]);
+  ASSERT_EQ((vector<Id>{2, 21, 6}), res[3]);
+  ASSERT_EQ((vector<Id>{2, 21, 7}), res[4]);
+}
+
+TEST(ResultIteratorTest, mergeJoinGroupAcrossBlocks) {
+  // The rows with key 1 of the left input span more than one block.
+  vector<array<Id, 2>> left;
+  for (Id i = 0; i < RESULT_BLOCK_SIZE + 10; ++i) {
+    left.push_back({{1, i}});
+  }
+  left.push_back({{3, 0}});
+  vector<array<Id, 2>> right = {{{1, 100}}, {{3, 300}}};
+  MergeJoinResultIterator it(
+      std::make_shared<MaterializedResultIterator>(makeTable(left)),
+      std::make_shared<MaterializedResultIterator>(makeTable(right)), 0, 0);
+  vector<vector<Id>> res = collect(&it);
+  ASSERT_EQ(left.size(), res.size());
+  ASSERT_EQ((vector<Id>{1, RESULT_BLOCK_SIZE + 9, 100}),
+            res[RESULT_BLOCK_SIZE + 9]);
+  ASSERT_EQ((vector<Id>{3, 0, 300}), res.back());
+}
+
+TEST(ResultIteratorTest, materializePrefix) {
+  vector<array<Id, 2>> rows;
+  for (Id i = 0; i < 100; ++i) {
+    rows.push_back({{i, i}});
+  }
+  FilterResultIterator it(
+      std::make_shared<MaterializedResultIterator>(makeTable(rows)),
+      [](const Id* row) { return row[0] % 2 == 1; });
+  shared_ptr<const ResultTable> res = it.materialize(10, 0);
+  ASSERT_EQ(2u, res->_nofColumns);
+  ASSERT_EQ(10u, res->size());
+  ASSERT_EQ(0u, res->_sortedBy);
+  const auto& data = *static_cast<vector<array<Id, 2>>*>(res->_fixedSizeData);
+  ASSERT_EQ(1u, data[0][0]);
+  ASSERT_EQ(19u, data[9][0]);
+
+  auto varSize = std::make_shared<ResultTable>();
+  varSize->_nofColumns = 6;
+  for (Id i = 0; i < 100; ++i) {
+    varSize->_varSizeData.push_back(vector<Id>(6, i));
+  }
+  varSize->finish();
+  FilterResultIterator varSizeIt(
+      std::make_shared<MaterializedResultIterator>(varSize),
+      [](const Id* row) { return row[5] % 2 == 0; });
+  res = varSizeIt.materialize(3, 6);
+  ASSERT_EQ(3u, res->size());
+  ASSERT_EQ(vector<Id>(6, 4), res->_varSizeData[2]);
+}
+
+TEST(ResultIteratorTest, externalSort) {
+  vector<array<Id, 2>> rows;
+  for (Id i = 0; i < 3 * RESULT_BLOCK_SIZE; ++i) {
+    rows.push_back({{i, (i * 7919) % 1000}});
+  }
+  // Runs of about 1000 rows.
+  ExternalSortResultIterator it(
+      std::make_shared<MaterializedResultIterator>(makeTable(rows)),
+      [](const Id* a, const Id* b) { return a[1] < b[1]; },
+      1000 * (2 * sizeof(Id) + sizeof(size_t)), ".", nullptr);
+  ASSERT_EQ(2u, it.width());
+  vector<vector<Id>> res = collect(&it);
+  ASSERT_EQ(rows.size(), res.size());
+  ASSERT_GT(it.getNofRuns(), 40u);
+  for (size_t i = 1; i < res.size(); ++i) {
+    ASSERT_LE(res[i - 1][1], res[i][1]);
+  }
+  ASSERT_EQ((vector<Id>{0, 0}), res[0]);
+}
+
+// An operation whose rows can be iterated without computing its result.
+class StreamingOperation : public Operation {
+ public:
+  StreamingOperation(QueryExecutionContext* qec, size_t nofRows)
+      : Operation(qec), _nofRows(nofRows), _nofComputations(0) {}
+
+  virtual shared_ptr<ResultIterator> getResultIterator(
+      bool cacheResult = true) const {
+    (void)cacheResult;
+    return std::make_shared<FilterResultIterator>(
+        std::make_shared<MaterializedResultIterator>(makeRows()),
+        [](const Id*) { return true; });
+  }
+
+  virtual void computeResult(ResultTable* result) const {
+    ++_nofComputations;
+    shared_ptr<const ResultTable> rows = makeRows();
+    result->_nofColumns = 2;
+    result->_sortedBy = 0;
+    result->_resultTypes = rows->_resultTypes;
+    result->_fixedSizeData = new vector<array<Id, 2>>(
+        *static_cast<vector<array<Id, 2>>*>(rows->_fixedSizeData));
+    result->finish();
+  }
+
+  virtual string asString(size_t indent = 0) const {
+    (void)indent;
+    return "streaming " + std::to_string(_nofRows);
+  }
+
+  virtual size_t getResultWidth() const { return 2; }
+  virtual size_t resultSortedOn() const { return 0; }
+  virtual void setTextLimit(size_t limit) { (void)limit; }
+  virtual size_t getCostEstimate() { return _nofRows; }
+  virtual size_t getSizeEstimate() { return _nofRows; }
+  virtual float getMultiplicity(size_t col) {
+    (void)col;
+    return 1;
+  }
+  virtual bool knownEmptyResult() { return _nofRows == 0; }
+
+  size_t getNofComputations() const { return _nofComputations; }
+
+ private:
+  shared_ptr<const ResultTable> makeRows() const {
+    vector<array<Id, 2>> rows;
+    for (Id i = 0; i < _nofRows; ++i) {
+      rows.push_back({{i, i}});
+    }
+    return makeTable(rows);
+  }
+
+  size_t _nofRows;
+  mutable size_t _nofComputations;
+};
+
+TEST(ResultIteratorTest, writeLimitedResult) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  const size_t nofRows = 10 * RESULT_BLOCK_SIZE;
+  auto op = std::make_shared<StreamingOperation>(&qec, nofRows);
+  QueryExecutionTree tree(&qec);
+  tree.setOperation(QueryExecutionTree::SCAN, op);
+  std::ostringstream out;
+  // With a limit only the rows up to it are computed, the result itself
+  // is neither computed nor cached.
+  size_t nofWritten = tree.writeResultToStream(out, {}, 10, 5);
+  ASSERT_GE(nofWritten, 15u);
+  ASSERT_LT(nofWritten, nofRows);
+  nofWritten = tree.writeResultToStreamAsJson(out, {}, 10, 5);
+  ASSERT_GE(nofWritten, 15u);
+  ASSERT_LT(nofWritten, nofRows);
+  ASSERT_EQ(0u, op->getNofComputations());
+  ASSERT_EQ(nofRows, tree.writeResultToStream(out, {}));
+  ASSERT_EQ(1u, op->getNofComputations());
+}
+
+TEST(ResultIteratorTest, sortOfLargeInput) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  const size_t nofRows = 3 * RESULT_BLOCK_SIZE;
+  auto input = std::make_shared<QueryExecutionTree>(&qec);
+  input->setOperation(QueryExecutionTree::SCAN,
+                      std::make_shared<StreamingOperation>(&qec, nofRows));
+  auto sort = std::make_shared<Sort>(&qec, input, 1);
+  // The input is cached, its actual size decides how it is sorted.
+  input->getResult();
+
+  // Sorted in memory, the result is cached.
+  qec.setSortOptions(nofRows * 2 * sizeof(Id), ".");
+  ASSERT_EQ(nofRows, collect(sort->getResultIterator().get()).size());
+  ASSERT_TRUE(qec.getQueryTreeCache().contains(sort->asString()));
+
+  // Sorted externally, the result is streamed and not cached.
+  qec.clearCache();
+  input->getResult();
+  qec.setSortOptions(nofRows * 2 * sizeof(Id) - 1, ".");
+  vector<vector<Id>> res = collect(sort->getResultIterator().get());
+  ASSERT_EQ(nofRows, res.size());
+  for (size_t i = 0; i < res.size(); ++i) {
+    ASSERT_EQ(i, res[i][1]);
+  }
+  ASSERT_FALSE(qec.getQueryTreeCache().contains(sort->asString()));
+
+  // Read only once, the result sorted in memory is not cached either.
+  qec.clearCache();
+  input->getResult();
+  qec.setSortOptions(nofRows * 2 * sizeof(Id), ".");
+  ASSERT_EQ(nofRows, collect(sort->getResultIterator(false).get()).size());
+  ASSERT_FALSE(qec.getQueryTreeCache().contains(sort->asString()));
+}
+
+TEST(ResultIteratorTest, materializedSortOfLargeInput) {
+  Index index;
+  Engine engine;
+  QueryExecutionContext qec(index, engine);
+  const size_t nofRows = 3 * RESULT_BLOCK_SIZE;
+  auto op = std::make_shared<StreamingOperation>(&qec, nofRows);
+  auto input = std::make_shared<QueryExecutionTree>(&qec);
+  input->setOperation(QueryExecutionTree::SCAN, op);
+  auto sort = std::make_shared<Sort>(&qec, input, 1);
+  // A materialized sort, e.g. the input of a join or a complete result, is
+  // sorted externally as well. The input is streamed and never cached.
+  qec.setSortOptions(RESULT_BLOCK_SIZE * 2 * sizeof(Id), ".");
+  shared_ptr<const ResultTable> res = sort->getResult();
+  ASSERT_EQ(nofRows, res->size());
+  ASSERT_EQ(1u, res->_sortedBy);
+  const auto& rows = *static_cast<vector<array<Id, 2>>*>(res->_fixedSizeData);
+  for (size_t i = 0; i < rows.size(); ++i) {
+    ASSERT_EQ(i, rows[i][1]);
+  }
+  ASSERT_EQ(0u, op->getNofComputations());
+  ASSERT_FALSE(qec.getQueryTreeCache().contains(input->asString()));
+  ASSERT_TRUE(qec.getQueryTreeCache().contains(sort->asString()));
+
+  // The query is charged for the result until it drops it, the cache keeps
+  // it nonetheless.
+  ASSERT_LE(res->getTrackedMemoryUsage(),
+            qec.getQueryMemoryTracker()->getBytesUsed());
+  res.reset();
+  ASSERT_EQ(0u, qec.getQueryMemoryTracker()->getBytesUsed());
+  ASSERT_TRUE(qec.getQueryTreeCache()[sort->asString()]);
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,62 @@
+// Copyright 2018, University of Freiburg,
+// Chair of Algorithms and Data Structures.
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+#include "../src/util/TaskScheduler.h"
+
+using ad_utility::TaskScheduler;
+
+TEST(TaskSchedulerTest, runInParallel) {
+  TaskScheduler scheduler(2);
+  std::vector<int> results(10, 0);
+  std::vector<std::function<void()>> functions;
+  for (int i = 0; i < 10; ++i) {
+    functions.push_back([i, &results] { results[i] = i * i; });
+  }
+  scheduler.runInParallel(functions);
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_EQ(i * i, results[i]);
+  }
+}
+
+// Recursive splitting as done by nested joins. With a single worker this
+// only terminates because waiting threads execute pending tasks themselves.
+int sum(TaskScheduler* scheduler, int from, int to) {
+  if (to - from <= 1) {
+    return to > from ? from : 0;
+  }
+  int mid = (from + to) / 2;
+  int left = 0;
+  int right = 0;
+  scheduler->runInParallel(
+      {[&] { left = sum(scheduler, from, mid); },
+       [&] { right = sum(scheduler, mid, to); }});
+  return left + right;
+}
+
+TEST(TaskSchedulerTest, nestedTasks) {
+  TaskScheduler scheduler(1);
+  ASSERT_EQ(499500, sum(&scheduler, 0, 1000));
+  TaskScheduler noWorkers(0);
+  ASSERT_EQ(4950, sum(&noWorkers, 0, 100));
+}
+
+TEST(TaskSchedulerTest, exceptionIsRethrown) {
+  TaskScheduler scheduler(2);
+  std::atomic<int> done(0);
+  ASSERT_THROW(
+      scheduler.runInParallel({[&done] { ++done; },
+                               [] { throw std::runtime_error("failed"); },
+                               [&done] { ++done; }}),
+      std::runtime_error);
+  // All other functions have completed anyway.
+  ASSERT_EQ(2, done.load());
+}
+
+int main(int argc, char** argv) {
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}